@@ -25,6 +25,9 @@ import android.os.Build;
 import android.util.Log;
 
 import java.lang.reflect.Method;
+import java.util.Collections;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
 
 import static android.os.Build.VERSION.SDK_INT;
 
@@ -32,27 +35,41 @@ public class SystemLoader {
 
     private static final String TAG = "byOpen";
 
+    // the sdk version provider, it can be replaced for testing on the plain jvm
+    interface SdkVersion {
+        int get();
+    }
+
+    static SdkVersion sdkVersion = new SdkVersion() {
+        @Override
+        public int get() {
+            return SDK_INT;
+        }
+    };
+
+    // the class name of the loader methods, it can be replaced for testing on the plain jvm
+    static String systemClassName = "java.lang.System";
+
+    // the cached System.load/loadLibrary methods, we get them only once by reflection
+    private static volatile Method loadMethod;
+    private static volatile Method loadLibraryMethod;
+
+    // the library paths/names which need to be loaded by the bypass path
+    private static final Set<String> bypassNames = Collections.newSetFromMap(new ConcurrentHashMap<String, Boolean>());
+
     static public boolean load(String libraryPath) {
         if (libraryPath == null) {
             return false;
         }
+        if (bypassNames.contains(libraryPath)) {
+            return bypassLoad(libraryPath, false);
+        }
         try {
             System.load(libraryPath);
             return true;
         } catch (Throwable e) {
-            if (SDK_INT >= Build.VERSION_CODES.P) {
-                try {
-
-                    Method forName = Class.class.getDeclaredMethod("forName", String.class);
-                    Method getDeclaredMethod = Class.class.getDeclaredMethod("getDeclaredMethod", String.class, Class[].class);
-                    Class<?> systemClass = (Class<?>) forName.invoke(null, "java.lang.System");
-                    Method load = (Method) getDeclaredMethod.invoke(systemClass, "load", new Class[]{String.class});
-                    load.invoke(systemClass, libraryPath);
-                    return true;
-
-                } catch (Throwable ex) {
-                    Log.e(TAG, "load library failed:", ex);
-                }
+            if (canBypass()) {
+                return bypassLoad(libraryPath, false);
             } else {
                 Log.e(TAG, "load library failed:", e);
             }
@@ -64,27 +81,78 @@ public class SystemLoader {
         if (libraryName == null) {
             return false;
         }
+        if (bypassNames.contains(libraryName)) {
+            return bypassLoad(libraryName, true);
+        }
         try {
             System.loadLibrary(libraryName);
             return true;
         } catch (Throwable e) {
-            if (SDK_INT >= Build.VERSION_CODES.P) {
-                try {
-
-                    Method forName = Class.class.getDeclaredMethod("forName", String.class);
-                    Method getDeclaredMethod = Class.class.getDeclaredMethod("getDeclaredMethod", String.class, Class[].class);
-                    Class<?> systemClass = (Class<?>) forName.invoke(null, "java.lang.System");
-                    Method loadLibrary = (Method) getDeclaredMethod.invoke(systemClass, "loadLibrary", new Class[]{String.class});
-                    loadLibrary.invoke(systemClass, libraryName);
-                    return true;
-
-                } catch (Throwable ex) {
-                    Log.e(TAG, "load library failed:", ex);
-                }
+            if (canBypass()) {
+                return bypassLoad(libraryName, true);
             } else {
                 Log.e(TAG, "load library failed:", e);
             }
         }
         return false;
     }
+
+    /**
+     * load the given libraries, the library path (contains '/') is loaded by load(), otherwise by loadLibrary()
+     *
+     * the libraries which are already known to need the bypass path will be loaded by it directly.
+     *
+     * @param names     the library paths or names
+     * @return          the result of each library
+     */
+    static public boolean[] loadLibraries(String... names) {
+        boolean[] results = new boolean[names != null ? names.length : 0];
+        for (int i = 0; i < results.length; i++) {
+            String name = names[i];
+            if (name != null) {
+                results[i] = name.indexOf('/') >= 0 ? load(name) : loadLibrary(name);
+            }
+        }
+        return results;
+    }
+
+    // can we load it by the bypass path?
+    static boolean canBypass() {
+        return sdkVersion.get() >= Build.VERSION_CODES.P;
+    }
+
+    // load it from the system class (boot class loader) by the double reflection
+    private static boolean bypassLoad(String name, boolean isLibrary) {
+        try {
+            Method method = isLibrary ? loadLibraryMethod : loadMethod;
+            if (method == null) {
+                method = getSystemMethod(isLibrary ? "loadLibrary" : "load");
+                if (isLibrary) {
+                    loadLibraryMethod = method;
+                } else {
+                    loadMethod = method;
+                }
+            }
+            method.invoke(null, name);
+            bypassNames.add(name);
+            return true;
+        } catch (Throwable e) {
+            Log.e(TAG, "load library failed:", e);
+        }
+        return false;
+    }
+
+    private static Method getSystemMethod(String methodName) throws Exception {
+        Method forName = Class.class.getDeclaredMethod("forName", String.class);
+        Method getDeclaredMethod = Class.class.getDeclaredMethod("getDeclaredMethod", String.class, Class[].class);
+        Class<?> systemClass = (Class<?>) forName.invoke(null, systemClassName);
+        return (Method) getDeclaredMethod.invoke(systemClass, methodName, new Class[]{String.class});
+    }
+
+    // reset the cached states, only for testing
+    static void reset() {
+        loadMethod = null;
+        loadLibraryMethod = null;
+        bypassNames.clear();
+    }
 }
@@ -0,0 +1,92 @@
+package dyopen.lib;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import static org.junit.Assert.*;
+
+/**
+ * SystemLoader local unit test, the bypass path is redirected to FakeSystem.
+ */
+public class SystemLoaderTest {
+
+    public static class FakeSystem {
+        static final List<String> calls = new ArrayList<String>();
+
+        public static void load(String libraryPath) {
+            calls.add("load:" + libraryPath);
+            if (libraryPath.contains("bad")) {
+                throw new UnsatisfiedLinkError(libraryPath);
+            }
+        }
+
+        public static void loadLibrary(String libraryName) {
+            calls.add("loadLibrary:" + libraryName);
+            if (libraryName.contains("bad")) {
+                throw new UnsatisfiedLinkError(libraryName);
+            }
+        }
+    }
+
+    private static SystemLoader.SdkVersion sdk(final int version) {
+        return new SystemLoader.SdkVersion() {
+            @Override
+            public int get() {
+                return version;
+            }
+        };
+    }
+
+    @Before
+    public void setUp() {
+        SystemLoader.reset();
+        SystemLoader.systemClassName = FakeSystem.class.getName();
+        SystemLoader.sdkVersion = sdk(28);
+        FakeSystem.calls.clear();
+    }
+
+    @After
+    public void tearDown() {
+        SystemLoader.reset();
+        SystemLoader.systemClassName = "java.lang.System";
+    }
+
+    @Test
+    public void bypass_isSkippedBeforeP() {
+        SystemLoader.sdkVersion = sdk(27);
+        assertFalse(SystemLoader.loadLibrary("byopen_notfound"));
+        assertTrue(FakeSystem.calls.isEmpty());
+    }
+
+    @Test
+    public void bypass_isUsedFromP() {
+        assertTrue(SystemLoader.loadLibrary("byopen_notfound"));
+        assertTrue(SystemLoader.load("/byopen/notfound.so"));
+        assertEquals(2, FakeSystem.calls.size());
+        assertEquals("loadLibrary:byopen_notfound", FakeSystem.calls.get(0));
+        assertEquals("load:/byopen/notfound.so", FakeSystem.calls.get(1));
+    }
+
+    @Test
+    public void loadLibraries_returnsEachResult() {
+        boolean[] results = SystemLoader.loadLibraries("byopen_a", "/byopen/b.so", "byopen_bad", null);
+        assertArrayEquals(new boolean[]{true, true, false, false}, results);
+        assertEquals(0, SystemLoader.loadLibraries().length);
+    }
+
+    @Test
+    public void loadLibraries_bypassesKnownNamesDirectly() {
+        assertTrue(SystemLoader.loadLibrary("byopen_a"));
+
+        // disable the fallback, only the known names can be loaded by the bypass path now
+        SystemLoader.sdkVersion = sdk(27);
+        boolean[] results = SystemLoader.loadLibraries("byopen_a", "byopen_c");
+        assertArrayEquals(new boolean[]{true, false}, results);
+        assertEquals(2, FakeSystem.calls.size());
+        assertEquals("loadLibrary:byopen_a", FakeSystem.calls.get(1));
+    }
+}
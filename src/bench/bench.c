@@ -0,0 +1,740 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        bench.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen.h"
+#include "elfgen.h"
+#include "byopen_macho_image.h"
+#include <dlfcn.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifdef __GLIBC__
+#   include <execinfo.h>
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the minimum measure time of each case (ns)
+#define BY_BENCH_MINTIME        (50 * 1000 * 1000ULL)
+
+// the maximum iterations of each case
+#define BY_BENCH_MAXITER        (1 << 20)
+
+// the max thread count of the index scaling bench
+#define BY_BENCH_INDEX_THREADS  (16)
+
+// the symbol count of each batch of the remote lookups
+#define BY_BENCH_REMOTE_BATCH   (1024)
+
+// the max stack depth of the backtrace bench
+#define BY_BENCH_BACKTRACE_MAXN (128)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the bench function type
+typedef by_void_t               (*by_bench_func_t)(by_pointer_t priv);
+
+// the bench context type
+typedef struct _by_bench_t
+{
+    // the library path
+    by_char_t                   libpath[256];
+
+    // the library name
+    by_char_t const*            libname;
+
+    // the exported and local symbol count
+    by_size_t                   exports;
+    by_size_t                   locals;
+
+    // the byopen and system handles
+    by_pointer_t                handle;
+    by_pointer_t                syshandle;
+
+    // the symbol name of the current case
+    by_char_t                   symbol[64];
+
+}by_bench_t, *by_bench_ref_t;
+
+// the backtrace bench context type
+typedef struct _by_bench_stack_t
+{
+    // the bench context
+    by_bench_ref_t              bench;
+
+    // the captured frames and their exact flags
+    by_pointer_t                pcs[BY_BENCH_BACKTRACE_MAXN];
+    by_bool_t                   exacts[BY_BENCH_BACKTRACE_MAXN];
+    by_size_t                   count;
+
+    // the frame names
+    by_char_t const*            names[BY_BENCH_BACKTRACE_MAXN];
+
+}by_bench_stack_t, *by_bench_stack_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// output json? or csv
+static by_bool_t                g_json = by_false;
+
+// the output row count
+static by_size_t                g_rows = 0;
+
+// the result sink, avoid being optimized
+static by_pointer_t volatile    g_sink = by_null;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_uint64_t by_bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (by_uint64_t)ts.tv_sec * 1000000000ULL + (by_uint64_t)ts.tv_nsec;
+}
+
+// measure the average time of the given function (ns)
+static by_double_t by_bench_measure(by_bench_func_t func, by_pointer_t priv)
+{
+    by_size_t   n = 1;
+    by_size_t   iters = 0;
+    by_uint64_t total = 0;
+    while (total < BY_BENCH_MINTIME && iters < BY_BENCH_MAXITER)
+    {
+        by_uint64_t t = by_bench_now();
+        for (by_size_t i = 0; i < n; i++)
+            func(priv);
+        total += by_bench_now() - t;
+        iters += n;
+        n <<= 1;
+    }
+    return (by_double_t)total / iters;
+}
+
+// get the mapped and resident memory of the current process (bytes)
+static by_bool_t by_bench_statm(by_size_t* mapped, by_size_t* resident)
+{
+    by_bool_t ok = by_false;
+    FILE*     fp = fopen("/proc/self/statm", "r");
+    if (fp)
+    {
+        by_ulong_t size = 0;
+        by_ulong_t rss = 0;
+        if (2 == fscanf(fp, "%lu %lu", &size, &rss))
+        {
+            by_size_t pagesize = (by_size_t)sysconf(_SC_PAGESIZE);
+            *mapped   = size * pagesize;
+            *resident = rss * pagesize;
+            ok = by_true;
+        }
+        fclose(fp);
+    }
+    return ok;
+}
+
+// report a result row
+static by_void_t by_bench_report(by_bench_ref_t bench, by_char_t const* impl, by_char_t const* metric, by_double_t value, by_char_t const* unit)
+{
+    if (g_json)
+    {
+        printf("%s\n  {\"library\": \"%s\", \"exports\": %lu, \"locals\": %lu, \"impl\": \"%s\", \"metric\": \"%s\", \"value\": %.1f, \"unit\": \"%s\"}",
+            g_rows? "," : "[", bench->libname, (by_ulong_t)bench->exports, (by_ulong_t)bench->locals, impl, metric, value, unit);
+    }
+    else
+    {
+        if (!g_rows) printf("library,exports,locals,impl,metric,value,unit\n");
+        printf("%s,%lu,%lu,%s,%s,%.1f,%s\n", bench->libname, (by_ulong_t)bench->exports, (by_ulong_t)bench->locals, impl, metric, value, unit);
+    }
+    fflush(stdout);
+    g_rows++;
+}
+
+// the bench cases
+static by_void_t by_bench_sys_dlopen(by_pointer_t priv)
+{
+    // it will be loaded and unloaded each time, because we do not hold it now
+    by_bench_ref_t bench = (by_bench_ref_t)priv;
+    by_pointer_t handle = dlopen(bench->libpath, RTLD_NOW);
+    if (handle) dlclose(handle);
+    g_sink = handle;
+}
+static by_void_t by_bench_sys_dlsym(by_pointer_t priv)
+{
+    by_bench_ref_t bench = (by_bench_ref_t)priv;
+    g_sink = dlsym(bench->syshandle, bench->symbol);
+}
+static by_void_t by_bench_by_dlopen(by_pointer_t priv)
+{
+    by_bench_ref_t bench = (by_bench_ref_t)priv;
+    by_pointer_t handle = by_dlopen(bench->libpath, BY_RTLD_NOW);
+    if (handle) by_dlclose(handle);
+    g_sink = handle;
+}
+static by_void_t by_bench_by_dlopen_into(by_pointer_t priv)
+{
+    by_bench_ref_t bench = (by_bench_ref_t)priv;
+    by_pointer_t storage[BY_DLOPEN_STORAGE_SIZE / sizeof(by_pointer_t)];
+    by_pointer_t handle = by_dlopen_into(storage, sizeof(storage), bench->libpath, BY_RTLD_NOW);
+    if (handle) by_dlclose(handle);
+    g_sink = handle;
+}
+static by_void_t by_bench_by_dlopen_compact(by_pointer_t priv)
+{
+    by_bench_ref_t bench = (by_bench_ref_t)priv;
+    by_pointer_t handle = by_dlopen(bench->libpath, BY_RTLD_NOW | BY_RTLD_COMPACT);
+    if (handle) by_dlclose(handle);
+    g_sink = handle;
+}
+static by_void_t by_bench_by_dlsym(by_pointer_t priv)
+{
+    by_bench_ref_t bench = (by_bench_ref_t)priv;
+    g_sink = by_dlsym(bench->handle, bench->symbol);
+}
+
+// bench dlsym for the given symbol
+static by_void_t by_bench_dlsym(by_bench_ref_t bench, by_char_t const* metric, by_bool_t exported, by_size_t index)
+{
+    // get symbol name
+    if (index != (by_size_t)-1) by_elfgen_name(bench->symbol, sizeof(bench->symbol), exported, index);
+    else snprintf(bench->symbol, sizeof(bench->symbol), "by_bench_missing");
+
+    // check result, local symbols can be only found by byopen
+    by_pointer_t addr = by_dlsym(bench->handle, bench->symbol);
+    if (exported && addr != dlsym(bench->syshandle, bench->symbol))
+        fprintf(stderr, "%s: %s mismatch, %p != %p\n", bench->libname, bench->symbol, addr, dlsym(bench->syshandle, bench->symbol));
+
+    // bench them
+    by_bench_report(bench, "byopen", metric, by_bench_measure(by_bench_by_dlsym, bench), "ns");
+    if (exported) by_bench_report(bench, "system", metric, by_bench_measure(by_bench_sys_dlsym, bench), "ns");
+}
+
+// bench the batched symbol lookups of the forked child process
+static by_void_t by_bench_remote(by_bench_ref_t bench)
+{
+    // fork a child process, it has loaded the same library at the same address
+    pid_t pid = fork();
+    if (pid < 0) return ;
+    if (!pid)
+    {
+        pause();
+        _exit(0);
+    }
+
+    // make the symbol names of one batch
+    static by_char_t  s_names[BY_BENCH_REMOTE_BATCH][64];
+    by_char_t const*  symbols[BY_BENCH_REMOTE_BATCH];
+    by_pointer_t      addrs[BY_BENCH_REMOTE_BATCH];
+    by_size_t         count = bench->exports < BY_BENCH_REMOTE_BATCH? bench->exports : BY_BENCH_REMOTE_BATCH;
+    for (by_size_t i = 0; i < count; i++)
+    {
+        by_elfgen_name(s_names[i], sizeof(s_names[i]), by_true, i * (bench->exports / count));
+        symbols[i] = s_names[i];
+    }
+
+    // open the library of the child process
+    by_uint64_t  t = by_bench_now();
+    by_pointer_t handle = by_dlopen_remote(pid, bench->libpath, BY_RTLD_COMPACT);
+    by_bench_report(bench, "byopen_remote", "dlopen", (by_double_t)(by_bench_now() - t), "ns");
+    if (handle)
+    {
+        // check result
+        by_size_t found = by_dlsym_remote(handle, symbols, addrs, count);
+        for (by_size_t i = 0; i < count; i++)
+        {
+            if (addrs[i] != dlsym(bench->syshandle, symbols[i]))
+            {
+                fprintf(stderr, "%s: remote %s mismatch, %p != %p\n", bench->libname, symbols[i], addrs[i], dlsym(bench->syshandle, symbols[i]));
+                break;
+            }
+        }
+
+        // bench the batched lookups
+        by_size_t n = 0;
+        t = by_bench_now();
+        while (by_bench_now() - t < BY_BENCH_MINTIME)
+        {
+            found = by_dlsym_remote(handle, symbols, addrs, count);
+            n += count;
+        }
+        by_bench_report(bench, "byopen_remote", "dlsym_batch", (by_double_t)(by_bench_now() - t) / (n? n : 1), "ns");
+        g_sink = (by_pointer_t)found;
+        by_dlclose(handle);
+    }
+
+    // exit the child process
+    kill(pid, SIGKILL);
+    waitpid(pid, by_null, 0);
+}
+
+// bench the linear symbol scan kernels on the large .symtab with hits and misses
+static by_void_t by_bench_symscan(by_bench_ref_t bench)
+{
+    static by_char_t const* s_kernels[] = {"scalar", "sse2", "avx2", "neon"};
+    for (by_size_t i = 0; i < sizeof(s_kernels) / sizeof(s_kernels[0]); i++)
+    {
+        if (by_symscan_set(s_kernels[i]))
+        {
+            by_char_t impl[64];
+            snprintf(impl, sizeof(impl), "byopen_%s", s_kernels[i]);
+
+            // the last local symbol, all .dynsym and .symtab entries will be scanned
+            by_elfgen_name(bench->symbol, sizeof(bench->symbol), by_false, bench->locals - 1);
+            by_bench_report(bench, impl, "symscan_hit", by_bench_measure(by_bench_by_dlsym, bench), "ns");
+
+            // the missing symbol with the same prefix
+            snprintf(bench->symbol, sizeof(bench->symbol), "by_bench_local_missing");
+            by_bench_report(bench, impl, "symscan_miss", by_bench_measure(by_bench_by_dlsym, bench), "ns");
+        }
+    }
+    by_symscan_set("auto");
+}
+
+// bench the compact index mode
+static by_void_t by_bench_compact(by_bench_ref_t bench)
+{
+    // get the memory usage of the full handle
+    by_dlstat_t stat;
+    if (by_dlstat(bench->handle, &stat))
+    {
+        by_bench_report(bench, "byopen", "stat_mapped", (by_double_t)stat.mapped, "bytes");
+        by_bench_report(bench, "byopen", "stat_resident", (by_double_t)stat.resident, "bytes");
+        by_bench_report(bench, "byopen", "stat_heap", (by_double_t)stat.heap, "bytes");
+    }
+
+    // open the compact handle
+    by_pointer_t handle = by_dlopen(bench->libpath, BY_RTLD_NOW | BY_RTLD_COMPACT);
+    if (handle)
+    {
+        // get the memory usage of the compact handle
+        if (by_dlstat(handle, &stat))
+        {
+            by_bench_report(bench, "byopen_compact", "stat_mapped", (by_double_t)stat.mapped, "bytes");
+            by_bench_report(bench, "byopen_compact", "stat_resident", (by_double_t)stat.resident, "bytes");
+            by_bench_report(bench, "byopen_compact", "stat_heap", (by_double_t)stat.heap, "bytes");
+        }
+
+        // bench dlsym
+        by_pointer_t full = bench->handle;
+        bench->handle = handle;
+        by_elfgen_name(bench->symbol, sizeof(bench->symbol), by_false, bench->locals - 1);
+        by_bench_report(bench, "byopen_compact", "dlsym_local_last", by_bench_measure(by_bench_by_dlsym, bench), "ns");
+        snprintf(bench->symbol, sizeof(bench->symbol), "by_bench_missing");
+        by_bench_report(bench, "byopen_compact", "dlsym_miss", by_bench_measure(by_bench_by_dlsym, bench), "ns");
+        bench->handle = full;
+        by_dlclose(handle);
+    }
+}
+
+// bench the compact index building with 1 - N threads
+static by_void_t by_bench_index(by_bench_ref_t bench)
+{
+    // the small tables are always indexed in the current thread
+    by_check_return(bench->exports + bench->locals >= 65536);
+
+    // bench it with 1, 2, 4, .. threads and the cpu count
+    by_long_t nproc = sysconf(_SC_NPROCESSORS_ONLN);
+    by_size_t maxn = nproc > 1? (by_size_t)nproc : 1;
+    if (maxn > BY_BENCH_INDEX_THREADS) maxn = BY_BENCH_INDEX_THREADS;
+    for (by_size_t n = 1; n <= maxn; n = n < maxn && n * 2 > maxn? maxn : n * 2)
+    {
+        by_char_t metric[64];
+        snprintf(metric, sizeof(metric), "index_threads_%lu", (by_ulong_t)n);
+        by_index_threads_set(n);
+        by_bench_report(bench, "byopen_compact", metric, by_bench_measure(by_bench_by_dlopen_compact, bench), "ns");
+        by_check_break(n < maxn);
+    }
+    by_index_threads_set(0);
+}
+
+// the backtrace bench cases
+static by_void_t by_bench_by_backtrace(by_pointer_t priv)
+{
+    by_bench_stack_ref_t stack = (by_bench_stack_ref_t)priv;
+    stack->count = by_backtrace(stack->pcs, stack->exacts, BY_BENCH_BACKTRACE_MAXN);
+}
+static by_void_t by_bench_by_backtrace_symbols(by_pointer_t priv)
+{
+    by_bench_stack_ref_t stack = (by_bench_stack_ref_t)priv;
+    g_sink = (by_pointer_t)by_backtrace_symbols(stack->pcs, stack->exacts, stack->names, by_null, stack->count);
+}
+#ifdef __GLIBC__
+static by_void_t by_bench_sys_backtrace(by_pointer_t priv)
+{
+    by_bench_stack_ref_t stack = (by_bench_stack_ref_t)priv;
+    stack->count = (by_size_t)backtrace(stack->pcs, BY_BENCH_BACKTRACE_MAXN);
+}
+static by_void_t by_bench_sys_backtrace_symbols(by_pointer_t priv)
+{
+    by_bench_stack_ref_t stack = (by_bench_stack_ref_t)priv;
+    by_char_t**          names = backtrace_symbols(stack->pcs, (by_int_t)stack->count);
+    g_sink = (by_pointer_t)names;
+    free(names);
+}
+#endif
+
+// recurse to the given depth and bench the stack capture in the innermost frame
+static __attribute__((noinline)) by_size_t by_bench_backtrace_recurse(by_bench_stack_ref_t stack, by_size_t depth, by_size_t maxn)
+{
+    // not the innermost frame? it's not a tail call, so each level keeps its frame
+    if (depth < maxn) return by_bench_backtrace_recurse(stack, depth + 1, maxn) + (by_size_t)g_sink;
+
+    // bench it
+    by_char_t metric[64];
+    snprintf(metric, sizeof(metric), "backtrace_%lu", (by_ulong_t)maxn);
+    by_bench_report(stack->bench, "byopen", metric, by_bench_measure(by_bench_by_backtrace, stack), "ns");
+    snprintf(metric, sizeof(metric), "backtrace_symbols_%lu", (by_ulong_t)maxn);
+    by_bench_report(stack->bench, "byopen", metric, by_bench_measure(by_bench_by_backtrace_symbols, stack), "ns");
+#ifdef __GLIBC__
+    snprintf(metric, sizeof(metric), "backtrace_%lu", (by_ulong_t)maxn);
+    by_bench_report(stack->bench, "system", metric, by_bench_measure(by_bench_sys_backtrace, stack), "ns");
+    snprintf(metric, sizeof(metric), "backtrace_symbols_%lu", (by_ulong_t)maxn);
+    by_bench_report(stack->bench, "system", metric, by_bench_measure(by_bench_sys_backtrace_symbols, stack), "ns");
+#endif
+    return stack->count;
+}
+
+// bench the stack capture latency with the short and deep stacks
+static by_void_t by_bench_backtrace()
+{
+    by_bench_t       bench;
+    by_bench_stack_t stack;
+    memset(&bench, 0, sizeof(bench));
+    memset(&stack, 0, sizeof(stack));
+    bench.libname = "backtrace";
+    stack.bench   = &bench;
+    by_bench_backtrace_recurse(&stack, 0, 16);
+    by_bench_backtrace_recurse(&stack, 0, 64);
+}
+
+// the mach-o bench context type
+typedef struct _by_bench_macho_t
+{
+    // the image
+    by_macho_image_t            image;
+
+    // the file data
+    by_byte_t const*            data;
+    by_size_t                   size;
+
+    // the symbol name of the current case
+    by_char_t const*            symbol;
+
+}by_bench_macho_t, *by_bench_macho_ref_t;
+
+// the mach-o bench cases
+static by_void_t by_bench_macho_open(by_pointer_t priv)
+{
+    by_bench_macho_ref_t macho = (by_bench_macho_ref_t)priv;
+    by_macho_image_t     image;
+    if (by_macho_image_init(&image, macho->data, macho->size, 0))
+        by_macho_image_exit(&image);
+}
+static by_void_t by_bench_macho_hash(by_pointer_t priv)
+{
+    // the nlist hash table will be built at the first lookup
+    by_bench_macho_ref_t macho = (by_bench_macho_ref_t)priv;
+    by_macho_image_t     image;
+    if (by_macho_image_init(&image, macho->data, macho->size, 0))
+    {
+        g_sink = by_macho_image_dlsym(&image, macho->symbol);
+        by_macho_image_exit(&image);
+    }
+}
+static by_void_t by_bench_macho_dlsym(by_pointer_t priv)
+{
+    by_bench_macho_ref_t macho = (by_bench_macho_ref_t)priv;
+    g_sink = by_macho_image_dlsym(&macho->image, macho->symbol);
+}
+static by_void_t by_bench_macho_linear(by_pointer_t priv)
+{
+    // the linear nlist scan, it's the old by_dlsym() implementation
+    by_bench_macho_ref_t macho = (by_bench_macho_ref_t)priv;
+    by_char_t const*     symbol = macho->symbol;
+    if (*symbol == '_') symbol++;
+    g_sink = by_null;
+    for (by_uint32_t i = 0; i < macho->image.symbols_num; i++)
+    {
+        by_ulong_t       value = 0;
+        by_char_t const* name = by_macho_image_symbol(&macho->image, i, by_null, &value);
+        if (name && value)
+        {
+            if (*name == '_') name++;
+            if (*name != '0' && !strcmp(symbol, name))
+            {
+                g_sink = (by_pointer_t)value;
+                break;
+            }
+        }
+    }
+}
+
+// get the nth exported or local symbol, and return the symbol count
+static by_size_t by_bench_macho_symbol(by_bench_macho_ref_t macho, by_bool_t exported, by_size_t nth, by_char_t const** pname)
+{
+    by_size_t count = 0;
+    for (by_uint32_t i = 0; i < macho->image.symbols_num; i++)
+    {
+        // only the defined symbols, and skip the stab entries
+        by_uint8_t       type = 0;
+        by_ulong_t       value = 0;
+        by_char_t const* name = by_macho_image_symbol(&macho->image, i, &type, &value);
+        if (name && *name && value && !(type & 0xe0) && (exported == !!(type & 0x01)))
+        {
+            if (count++ == nth)
+            {
+                *pname = name;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+// bench the lookup of the mach-o file buffer, e.g. the framework binary copied from device
+static by_bool_t by_bench_macho(by_char_t const* filepath)
+{
+    // init bench
+    by_bench_t bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.libname = strrchr(filepath, '/')? strrchr(filepath, '/') + 1 : filepath;
+
+    by_bench_macho_t macho;
+    memset(&macho, 0, sizeof(macho));
+
+    by_bool_t  ok = by_false;
+    by_byte_t* data = by_null;
+    FILE*      fp = fopen(filepath, "rb");
+    do
+    {
+        // read file
+        by_check_break(fp && !fseek(fp, 0, SEEK_END));
+        by_long_t size = ftell(fp);
+        by_check_break(size > 0 && !fseek(fp, 0, SEEK_SET));
+        data = malloc(size);
+        by_check_break(data && fread(data, 1, size, fp) == (by_size_t)size);
+        macho.data = data;
+        macho.size = (by_size_t)size;
+
+        // init image
+        if (!by_macho_image_init(&macho.image, macho.data, macho.size, 0))
+        {
+            fprintf(stderr, "%s is not a thin mach-o file!\n", filepath);
+            break;
+        }
+
+        // get the middle exported and local symbols
+        bench.exports = by_bench_macho_symbol(&macho, by_true, (by_size_t)-1, by_null);
+        bench.locals  = by_bench_macho_symbol(&macho, by_false, (by_size_t)-1, by_null);
+        by_char_t const* exported = by_null;
+        by_char_t const* local = by_null;
+        by_bench_macho_symbol(&macho, by_true, bench.exports / 2, &exported);
+        by_bench_macho_symbol(&macho, by_false, bench.locals / 2, &local);
+
+        // bench open
+        by_bench_report(&bench, "byopen", "macho_open", by_bench_measure(by_bench_macho_open, &macho), "ns");
+
+        // bench the exported symbol
+        if (exported)
+        {
+            macho.symbol = exported;
+            by_bench_report(&bench, "byopen", "macho_dlsym_export", by_bench_measure(by_bench_macho_dlsym, &macho), "ns");
+            by_bench_report(&bench, "linear", "macho_dlsym_export", by_bench_measure(by_bench_macho_linear, &macho), "ns");
+        }
+
+        // bench the local symbol
+        if (local)
+        {
+            macho.symbol = local;
+            by_bench_report(&bench, "byopen", "macho_hash_build", by_bench_measure(by_bench_macho_hash, &macho), "ns");
+            by_bench_report(&bench, "byopen", "macho_dlsym_local", by_bench_measure(by_bench_macho_dlsym, &macho), "ns");
+            by_bench_report(&bench, "linear", "macho_dlsym_local", by_bench_measure(by_bench_macho_linear, &macho), "ns");
+        }
+
+        // bench the missing symbol
+        macho.symbol = "by_bench_missing";
+        by_bench_report(&bench, "byopen", "macho_dlsym_miss", by_bench_measure(by_bench_macho_dlsym, &macho), "ns");
+        by_bench_report(&bench, "linear", "macho_dlsym_miss", by_bench_measure(by_bench_macho_linear, &macho), "ns");
+
+        // ok
+        ok = by_true;
+
+    } while (0);
+
+    // exit
+    by_macho_image_exit(&macho.image);
+    if (data) free(data);
+    if (fp) fclose(fp);
+    return ok;
+}
+
+// bench the synthetic library with the given symbol count
+static by_bool_t by_bench_run(by_char_t const* dir, by_size_t count)
+{
+    // init bench
+    by_bench_t bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.exports = count;
+    bench.locals  = count;
+    snprintf(bench.libpath, sizeof(bench.libpath), "%s/libbybench_%lu.so", dir, (by_ulong_t)count);
+    bench.libname = strrchr(bench.libpath, '/') + 1;
+
+    // generate library
+    by_uint64_t t = by_bench_now();
+    if (!by_elfgen_make(bench.libpath, bench.exports, bench.locals))
+    {
+        fprintf(stderr, "generate %s failed!\n", bench.libpath);
+        return by_false;
+    }
+    by_bench_report(&bench, "elfgen", "generate", (by_double_t)(by_bench_now() - t), "ns");
+
+    // bench the cold system dlopen
+    by_bench_report(&bench, "system", "dlopen", by_bench_measure(by_bench_sys_dlopen, &bench), "ns");
+
+    // load it to maps first, because by_dlopen only finds the loaded libraries
+    by_bool_t ok = by_false;
+    do
+    {
+        bench.syshandle = dlopen(bench.libpath, RTLD_NOW);
+        if (!bench.syshandle)
+        {
+            fprintf(stderr, "dlopen %s failed: %s\n", bench.libpath, dlerror());
+            break;
+        }
+
+        // bench by_dlopen
+        by_bench_report(&bench, "byopen", "dlopen", by_bench_measure(by_bench_by_dlopen, &bench), "ns");
+        by_bench_report(&bench, "byopen", "dlopen_into", by_bench_measure(by_bench_by_dlopen_into, &bench), "ns");
+
+        // the open/close cycles should reuse the first static slab of the handle pool
+        by_dlpool_stat_t poolstat;
+        if (by_dlpool_stat(&poolstat))
+        {
+            by_bench_report(&bench, "byopen", "pool_slabs", (by_double_t)poolstat.slabs, "slabs");
+            by_bench_report(&bench, "byopen", "pool_peak", (by_double_t)poolstat.peak, "handles");
+        }
+
+        // get the memory mapped by handle
+        by_size_t mapped0 = 0, mapped1 = 0;
+        by_size_t resident0 = 0, resident1 = 0;
+        by_bench_statm(&mapped0, &resident0);
+        bench.handle = by_dlopen(bench.libpath, BY_RTLD_NOW);
+        if (!bench.handle)
+        {
+            fprintf(stderr, "by_dlopen %s failed!\n", bench.libpath);
+            break;
+        }
+        by_bench_statm(&mapped1, &resident1);
+        by_bench_report(&bench, "byopen", "handle_mapped", (by_double_t)(mapped1 - mapped0), "bytes");
+
+        // bench dlsym
+        by_bench_dlsym(&bench, "dlsym_first", by_true, 0);
+        by_bench_dlsym(&bench, "dlsym_middle", by_true, count / 2);
+        by_bench_dlsym(&bench, "dlsym_last", by_true, count - 1);
+        by_bench_dlsym(&bench, "dlsym_miss", by_true, (by_size_t)-1);
+        by_bench_dlsym(&bench, "dlsym_local_first", by_false, 0);
+        by_bench_dlsym(&bench, "dlsym_local_middle", by_false, count / 2);
+        by_bench_dlsym(&bench, "dlsym_local_last", by_false, count - 1);
+
+        // bench the symbol scan kernels
+        by_bench_symscan(&bench);
+
+        // bench the compact index mode
+        by_bench_compact(&bench);
+
+        // bench the parallel index building
+        by_bench_index(&bench);
+
+        // bench the lookups of the remote process
+        by_bench_remote(&bench);
+
+        // get the resident memory of handle after all lookups
+        by_bench_statm(&mapped1, &resident1);
+        by_bench_report(&bench, "byopen", "handle_resident", (by_double_t)(resident1 > resident0? resident1 - resident0 : 0), "bytes");
+
+        // ok
+        ok = by_true;
+
+    } while (0);
+
+    // exit
+    if (bench.handle) by_dlclose(bench.handle);
+    if (bench.syshandle) dlclose(bench.syshandle);
+    unlink(bench.libpath);
+    return ok;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * main
+ */
+by_int_t main(by_int_t argc, by_char_t** argv)
+{
+    // parse arguments
+#ifdef __ANDROID__
+    by_char_t const* dir = "/data/local/tmp";
+#else
+    by_char_t const* dir = "/tmp";
+#endif
+    by_size_t        maxcount = 1000000;
+    by_char_t const* macho = by_null;
+    for (by_int_t i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--json")) g_json = by_true;
+        else if (!strcmp(argv[i], "--macho") && i + 1 < argc) macho = argv[++i];
+        else if (!strcmp(argv[i], "--max") && i + 1 < argc) maxcount = (by_size_t)strtoul(argv[++i], by_null, 10);
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else
+        {
+            printf("usage: %s [--json] [--max symbols] [--dir tmpdir] [--macho file]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    // bench the given mach-o file only
+    by_int_t ok = 0;
+    if (macho)
+    {
+        ok = by_bench_macho(macho)? 0 : -1;
+        if (g_json) printf("%s]\n", g_rows? "\n" : "[");
+        return ok;
+    }
+
+    // bench the stack unwinder
+    by_bench_backtrace();
+
+    // bench the synthetic libraries with 1k - 1m exported and local symbols
+    for (by_size_t count = 1000; count <= maxcount; count *= 10)
+    {
+        if (!by_bench_run(dir, count))
+            ok = -1;
+    }
+    if (g_json) printf("%s]\n", g_rows? "\n" : "[");
+    return ok;
+}
@@ -0,0 +1,379 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        elfgen.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "elfgen.h"
+#include <elf.h>
+#include <link.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the segment alignment, we use 64K to support all page sizes
+#define BY_ELFGEN_PAGESIZE      (65536)
+
+// the function size in .text
+#define BY_ELFGEN_FUNCSIZE      (4)
+
+// the section indices
+#define BY_ELFGEN_SHN_HASH      (1)
+#define BY_ELFGEN_SHN_DYNSYM    (2)
+#define BY_ELFGEN_SHN_DYNSTR    (3)
+#define BY_ELFGEN_SHN_TEXT      (4)
+#define BY_ELFGEN_SHN_DYNAMIC   (5)
+#define BY_ELFGEN_SHN_SYMTAB    (6)
+#define BY_ELFGEN_SHN_STRTAB    (7)
+#define BY_ELFGEN_SHN_SHSTRTAB  (8)
+#define BY_ELFGEN_SHN_MAXN      (9)
+
+// the dynamic entry count
+#define BY_ELFGEN_DYN_MAXN      (7)
+
+// make st_info
+#define BY_ELFGEN_ST_INFO(b, t) (((b) << 4) + ((t) & 0xf))
+
+// the elf class and machine
+#ifdef __LP64__
+#   define BY_ELFGEN_CLASS      ELFCLASS64
+#else
+#   define BY_ELFGEN_CLASS      ELFCLASS32
+#endif
+#if defined(BY_ARCH_x64)
+#   define BY_ELFGEN_MACHINE    EM_X86_64
+#elif defined(BY_ARCH_x86)
+#   define BY_ELFGEN_MACHINE    EM_386
+#elif defined(BY_ARCH_ARM64)
+#   define BY_ELFGEN_MACHINE    EM_AARCH64
+#else
+#   define BY_ELFGEN_MACHINE    EM_ARM
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the file writer type
+typedef struct _by_elfgen_writer_t
+{
+    // the file
+    FILE*           fp;
+
+    // the written size
+    by_size_t       size;
+
+    // is failed?
+    by_bool_t       failed;
+
+}by_elfgen_writer_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_size_t by_elfgen_align(by_size_t value, by_size_t align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+static by_uint32_t by_elfgen_hash(by_char_t const* name)
+{
+    // the sysv elf hash
+    by_uint32_t h = 0;
+    by_uint32_t g;
+    while (*name)
+    {
+        h = (h << 4) + (by_uint8_t)*name++;
+        g = h & 0xf0000000;
+        h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
+static by_void_t by_elfgen_write(by_elfgen_writer_t* writer, by_cpointer_t data, by_size_t size)
+{
+    if (size && !writer->failed && fwrite(data, 1, size, writer->fp) != size)
+        writer->failed = by_true;
+    writer->size += size;
+}
+static by_void_t by_elfgen_pad(by_elfgen_writer_t* writer, by_size_t offset)
+{
+    static by_byte_t s_zeros[256];
+    while (!writer->failed && writer->size < offset)
+    {
+        by_size_t size = offset - writer->size;
+        by_elfgen_write(writer, s_zeros, size < sizeof(s_zeros)? size : sizeof(s_zeros));
+    }
+}
+static by_void_t by_elfgen_write_sym(by_elfgen_writer_t* writer, by_size_t name, by_size_t value, by_size_t size, by_int_t bind, by_uint16_t shndx)
+{
+    ElfW(Sym) sym;
+    memset(&sym, 0, sizeof(sym));
+    sym.st_name  = (by_uint32_t)name;
+    sym.st_value = value;
+    sym.st_size  = size;
+    sym.st_info  = shndx? BY_ELFGEN_ST_INFO(bind, STT_FUNC) : 0;
+    sym.st_shndx = shndx;
+    by_elfgen_write(writer, &sym, sizeof(sym));
+}
+static by_void_t by_elfgen_write_shdr(by_elfgen_writer_t* writer, by_size_t name, by_uint32_t type, by_size_t flags, by_size_t offset, by_size_t size, by_uint32_t link, by_uint32_t info, by_size_t align, by_size_t entsize)
+{
+    ElfW(Shdr) shdr;
+    memset(&shdr, 0, sizeof(shdr));
+    shdr.sh_name      = (by_uint32_t)name;
+    shdr.sh_type      = type;
+    shdr.sh_flags     = flags;
+    shdr.sh_addr      = (flags & SHF_ALLOC)? offset : 0;
+    shdr.sh_offset    = offset;
+    shdr.sh_size      = size;
+    shdr.sh_link      = link;
+    shdr.sh_info      = info;
+    shdr.sh_addralign = align;
+    shdr.sh_entsize   = entsize;
+    by_elfgen_write(writer, &shdr, sizeof(shdr));
+}
+static by_void_t by_elfgen_write_phdr(by_elfgen_writer_t* writer, by_uint32_t type, by_uint32_t flags, by_size_t offset, by_size_t size, by_size_t align)
+{
+    ElfW(Phdr) phdr;
+    memset(&phdr, 0, sizeof(phdr));
+    phdr.p_type   = type;
+    phdr.p_flags  = flags;
+    phdr.p_offset = offset;
+    phdr.p_vaddr  = offset;
+    phdr.p_paddr  = offset;
+    phdr.p_filesz = size;
+    phdr.p_memsz  = size;
+    phdr.p_align  = align;
+    by_elfgen_write(writer, &phdr, sizeof(phdr));
+}
+static by_void_t by_elfgen_write_dyn(by_elfgen_writer_t* writer, by_size_t tag, by_size_t value)
+{
+    ElfW(Dyn) dyn;
+    dyn.d_tag      = tag;
+    dyn.d_un.d_val = value;
+    by_elfgen_write(writer, &dyn, sizeof(dyn));
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_char_t const* by_elfgen_name(by_char_t* name, by_size_t maxn, by_bool_t exported, by_size_t index)
+{
+    snprintf(name, maxn, "%s_%lu", exported? "by_bench_export" : "by_bench_local", (by_ulong_t)index);
+    return name;
+}
+by_bool_t by_elfgen_make(by_char_t const* filepath, by_size_t exports, by_size_t locals)
+{
+    // check
+    by_assert_and_check_return_val(filepath, by_false);
+
+    // get soname
+    by_char_t const* soname = strrchr(filepath, '/');
+    soname = soname? soname + 1 : filepath;
+
+    // compute the string table sizes
+    by_size_t i = 0;
+    by_char_t name[64];
+    by_size_t exports_strsize = 0;
+    by_size_t locals_strsize = 0;
+    for (i = 0; i < exports; i++)
+        exports_strsize += strlen(by_elfgen_name(name, sizeof(name), by_true, i)) + 1;
+    for (i = 0; i < locals; i++)
+        locals_strsize += strlen(by_elfgen_name(name, sizeof(name), by_false, i)) + 1;
+
+    // the section names
+    static by_char_t const s_shstrtab[] = "\0.hash\0.dynsym\0.dynstr\0.text\0.dynamic\0.symtab\0.strtab\0.shstrtab";
+
+    // compute layout
+    by_size_t dynsym_num   = 1 + exports;
+    by_size_t symtab_num   = 1 + locals + exports;
+    by_size_t nbucket      = exports / 2 + 1;
+    by_size_t hash_off     = by_elfgen_align(sizeof(ElfW(Ehdr)) + 3 * sizeof(ElfW(Phdr)), 8);
+    by_size_t hash_size    = sizeof(by_uint32_t) * (2 + nbucket + dynsym_num);
+    by_size_t dynsym_off   = by_elfgen_align(hash_off + hash_size, 8);
+    by_size_t dynstr_off   = dynsym_off + dynsym_num * sizeof(ElfW(Sym));
+    by_size_t dynstr_size  = 1 + strlen(soname) + 1 + exports_strsize;
+    by_size_t text_off     = by_elfgen_align(dynstr_off + dynstr_size, 16);
+    by_size_t text_size    = (locals + exports + 1) * BY_ELFGEN_FUNCSIZE;
+    by_size_t dynamic_off  = by_elfgen_align(text_off + text_size, BY_ELFGEN_PAGESIZE);
+    by_size_t dynamic_size = BY_ELFGEN_DYN_MAXN * sizeof(ElfW(Dyn));
+    by_size_t symtab_off   = by_elfgen_align(dynamic_off + dynamic_size, 8);
+    by_size_t strtab_off   = symtab_off + symtab_num * sizeof(ElfW(Sym));
+    by_size_t strtab_size  = 1 + locals_strsize + exports_strsize;
+    by_size_t shstr_off    = strtab_off + strtab_size;
+    by_size_t shoff        = by_elfgen_align(shstr_off + sizeof(s_shstrtab), 8);
+
+    // build the hash buckets and chains of .dynsym
+    by_uint32_t* buckets = calloc(nbucket + dynsym_num, sizeof(by_uint32_t));
+    by_assert_and_check_return_val(buckets, by_false);
+
+    by_uint32_t* chains = buckets + nbucket;
+    for (i = 1; i < dynsym_num; i++)
+    {
+        by_size_t h = by_elfgen_hash(by_elfgen_name(name, sizeof(name), by_true, i - 1)) % nbucket;
+        chains[i]  = buckets[h];
+        buckets[h] = (by_uint32_t)i;
+    }
+
+    // open file
+    by_elfgen_writer_t writer;
+    writer.fp     = fopen(filepath, "wb");
+    writer.size   = 0;
+    writer.failed = by_false;
+    if (!writer.fp)
+    {
+        free(buckets);
+        return by_false;
+    }
+
+    // write elf header
+    ElfW(Ehdr) ehdr;
+    memset(&ehdr, 0, sizeof(ehdr));
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS]   = BY_ELFGEN_CLASS;
+    ehdr.e_ident[EI_DATA]    = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI]   = ELFOSABI_SYSV;
+    ehdr.e_type              = ET_DYN;
+    ehdr.e_machine           = BY_ELFGEN_MACHINE;
+    ehdr.e_version           = EV_CURRENT;
+    ehdr.e_phoff             = sizeof(ElfW(Ehdr));
+    ehdr.e_shoff             = shoff;
+#if BY_ELFGEN_MACHINE == EM_ARM
+#   ifdef __ARM_PCS_VFP
+    ehdr.e_flags             = 0x05000400;
+#   else
+    ehdr.e_flags             = 0x05000200;
+#   endif
+#endif
+    ehdr.e_ehsize            = sizeof(ElfW(Ehdr));
+    ehdr.e_phentsize         = sizeof(ElfW(Phdr));
+    ehdr.e_phnum             = 3;
+    ehdr.e_shentsize         = sizeof(ElfW(Shdr));
+    ehdr.e_shnum             = BY_ELFGEN_SHN_MAXN;
+    ehdr.e_shstrndx          = BY_ELFGEN_SHN_SHSTRTAB;
+    by_elfgen_write(&writer, &ehdr, sizeof(ehdr));
+
+    // write program headers
+    by_elfgen_write_phdr(&writer, PT_LOAD, PF_R | PF_X, 0, text_off + text_size, BY_ELFGEN_PAGESIZE);
+    by_elfgen_write_phdr(&writer, PT_LOAD, PF_R | PF_W, dynamic_off, dynamic_size, BY_ELFGEN_PAGESIZE);
+    by_elfgen_write_phdr(&writer, PT_DYNAMIC, PF_R | PF_W, dynamic_off, dynamic_size, sizeof(by_size_t));
+
+    // write .hash
+    by_uint32_t counts[2];
+    counts[0] = (by_uint32_t)nbucket;
+    counts[1] = (by_uint32_t)dynsym_num;
+    by_elfgen_pad(&writer, hash_off);
+    by_elfgen_write(&writer, counts, sizeof(counts));
+    by_elfgen_write(&writer, buckets, (nbucket + dynsym_num) * sizeof(by_uint32_t));
+
+    // write .dynsym, the exported functions are placed after the local functions in .text
+    by_size_t strpos = 1 + strlen(soname) + 1;
+    by_elfgen_pad(&writer, dynsym_off);
+    by_elfgen_write_sym(&writer, 0, 0, 0, 0, SHN_UNDEF);
+    for (i = 0; i < exports; i++)
+    {
+        by_elfgen_write_sym(&writer, strpos, text_off + (locals + i) * BY_ELFGEN_FUNCSIZE, BY_ELFGEN_FUNCSIZE, STB_GLOBAL, BY_ELFGEN_SHN_TEXT);
+        strpos += strlen(by_elfgen_name(name, sizeof(name), by_true, i)) + 1;
+    }
+
+    // write .dynstr
+    by_elfgen_write(&writer, "", 1);
+    by_elfgen_write(&writer, soname, strlen(soname) + 1);
+    for (i = 0; i < exports; i++)
+    {
+        by_elfgen_name(name, sizeof(name), by_true, i);
+        by_elfgen_write(&writer, name, strlen(name) + 1);
+    }
+
+    // write .text, all functions only return
+    by_elfgen_pad(&writer, text_off);
+    for (i = 0; i < locals + exports + 1; i++)
+    {
+#if defined(BY_ARCH_x64) || defined(BY_ARCH_x86)
+        static by_byte_t const s_ret[BY_ELFGEN_FUNCSIZE] = {0xc3, 0x90, 0x90, 0x90};
+#elif defined(BY_ARCH_ARM64)
+        static by_byte_t const s_ret[BY_ELFGEN_FUNCSIZE] = {0xc0, 0x03, 0x5f, 0xd6};
+#else
+        static by_byte_t const s_ret[BY_ELFGEN_FUNCSIZE] = {0x1e, 0xff, 0x2f, 0xe1};
+#endif
+        by_elfgen_write(&writer, s_ret, sizeof(s_ret));
+    }
+
+    // write .dynamic
+    by_elfgen_pad(&writer, dynamic_off);
+    by_elfgen_write_dyn(&writer, DT_HASH, hash_off);
+    by_elfgen_write_dyn(&writer, DT_STRTAB, dynstr_off);
+    by_elfgen_write_dyn(&writer, DT_SYMTAB, dynsym_off);
+    by_elfgen_write_dyn(&writer, DT_STRSZ, dynstr_size);
+    by_elfgen_write_dyn(&writer, DT_SYMENT, sizeof(ElfW(Sym)));
+    by_elfgen_write_dyn(&writer, DT_SONAME, 1);
+    by_elfgen_write_dyn(&writer, DT_NULL, 0);
+
+    // write .symtab, the local symbols must be placed before the global symbols
+    strpos = 1;
+    by_elfgen_pad(&writer, symtab_off);
+    by_elfgen_write_sym(&writer, 0, 0, 0, 0, SHN_UNDEF);
+    for (i = 0; i < locals; i++)
+    {
+        by_elfgen_write_sym(&writer, strpos, text_off + i * BY_ELFGEN_FUNCSIZE, BY_ELFGEN_FUNCSIZE, STB_LOCAL, BY_ELFGEN_SHN_TEXT);
+        strpos += strlen(by_elfgen_name(name, sizeof(name), by_false, i)) + 1;
+    }
+    for (i = 0; i < exports; i++)
+    {
+        by_elfgen_write_sym(&writer, strpos, text_off + (locals + i) * BY_ELFGEN_FUNCSIZE, BY_ELFGEN_FUNCSIZE, STB_GLOBAL, BY_ELFGEN_SHN_TEXT);
+        strpos += strlen(by_elfgen_name(name, sizeof(name), by_true, i)) + 1;
+    }
+
+    // write .strtab
+    by_elfgen_write(&writer, "", 1);
+    for (i = 0; i < locals; i++)
+    {
+        by_elfgen_name(name, sizeof(name), by_false, i);
+        by_elfgen_write(&writer, name, strlen(name) + 1);
+    }
+    for (i = 0; i < exports; i++)
+    {
+        by_elfgen_name(name, sizeof(name), by_true, i);
+        by_elfgen_write(&writer, name, strlen(name) + 1);
+    }
+
+    // write .shstrtab
+    by_elfgen_write(&writer, s_shstrtab, sizeof(s_shstrtab));
+
+    // write section headers
+    by_elfgen_pad(&writer, shoff);
+    by_elfgen_write_shdr(&writer, 0, SHT_NULL, 0, 0, 0, 0, 0, 0, 0);
+    by_elfgen_write_shdr(&writer, 1, SHT_HASH, SHF_ALLOC, hash_off, hash_size, BY_ELFGEN_SHN_DYNSYM, 0, 4, 4);
+    by_elfgen_write_shdr(&writer, 7, SHT_DYNSYM, SHF_ALLOC, dynsym_off, dynsym_num * sizeof(ElfW(Sym)), BY_ELFGEN_SHN_DYNSTR, 1, 8, sizeof(ElfW(Sym)));
+    by_elfgen_write_shdr(&writer, 15, SHT_STRTAB, SHF_ALLOC, dynstr_off, dynstr_size, 0, 0, 1, 0);
+    by_elfgen_write_shdr(&writer, 23, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, text_off, text_size, 0, 0, 16, 0);
+    by_elfgen_write_shdr(&writer, 29, SHT_DYNAMIC, SHF_ALLOC | SHF_WRITE, dynamic_off, dynamic_size, BY_ELFGEN_SHN_DYNSTR, 0, 8, sizeof(ElfW(Dyn)));
+    by_elfgen_write_shdr(&writer, 38, SHT_SYMTAB, 0, symtab_off, symtab_num * sizeof(ElfW(Sym)), BY_ELFGEN_SHN_STRTAB, (by_uint32_t)(1 + locals), 8, sizeof(ElfW(Sym)));
+    by_elfgen_write_shdr(&writer, 46, SHT_STRTAB, 0, strtab_off, strtab_size, 0, 0, 1, 0);
+    by_elfgen_write_shdr(&writer, 54, SHT_STRTAB, 0, shstr_off, sizeof(s_shstrtab), 0, 0, 1, 0);
+
+    // exit
+    by_bool_t ok = !writer.failed;
+    if (fclose(writer.fp) != 0) ok = by_false;
+    free(buckets);
+    return ok;
+}
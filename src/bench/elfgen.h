@@ -0,0 +1,66 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        elfgen.h
+ *
+ */
+#ifndef BY_BENCH_ELFGEN_H
+#define BY_BENCH_ELFGEN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "prefix.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * interfaces
+ */
+
+/*! get the symbol name of the synthetic library
+ *
+ * @param name      the name buffer
+ * @param maxn      the name buffer size
+ * @param exported  is exported symbol? (.dynsym and .symtab), or local symbol (.symtab only)
+ * @param index     the symbol index
+ *
+ * @return          the symbol name
+ */
+by_char_t const*    by_elfgen_name(by_char_t* name, by_size_t maxn, by_bool_t exported, by_size_t index);
+
+/*! generate a synthetic shared library for the current arch
+ *
+ * all symbols are small functions (only return) in .text,
+ * the exported symbols are in .dynsym/.hash and .symtab, the local symbols are only in .symtab.
+ *
+ * the generated library can be loaded by the system dlopen, so it can be also opened by by_dlopen.
+ *
+ * @param filepath  the library file path
+ * @param exports   the exported symbol count
+ * @param locals    the local symbol count
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_elfgen_make(by_char_t const* filepath, by_size_t exports, by_size_t locals);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,8 @@
+target("bench")
+    set_kind("binary")
+    set_default(false)
+    add_deps("byopen")
+    add_files("*.c")
+    if is_plat("linux") then
+        add_syslinks("dl", "pthread")
+    end
@@ -29,9 +29,17 @@
  */
 by_int_t main(by_int_t argc, by_char_t** argv)
 {
-    // only for macosx, iphoneos
+    // get the library and function names of the current platform
+#if defined(__APPLE__)
     by_char_t const* libname = "/usr/lib/libz.1.dylib";
     by_char_t const* libfunc = "_zlibVersion";
+#elif defined(__ANDROID__)
+    by_char_t const* libname = "libz.so";
+    by_char_t const* libfunc = "zlibVersion";
+#else
+    by_char_t const* libname = "libz.so.1";
+    by_char_t const* libfunc = "zlibVersion";
+#endif
     by_pointer_t handle = by_dlopen(libname, BY_RTLD_LAZY);
     if (handle)
     {
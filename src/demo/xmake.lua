@@ -2,3 +2,6 @@ target("demo")
     set_kind("binary")
     add_deps("byopen")
     add_files("*.c")
+    if is_plat("linux") then
+        add_syslinks("dl", "pthread")
+    end
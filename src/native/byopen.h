@@ -30,6 +30,13 @@ extern "C" {
  */
 #include "prefix.h"
 
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+/// the minimum size of the caller-provided storage for by_dlopen_into()
+#define BY_DLOPEN_STORAGE_SIZE  (256)
+
 /* //////////////////////////////////////////////////////////////////////////////////////
  * types
  */
@@ -39,14 +46,62 @@ typedef enum __by_dlopen_flag_e
 {
     BY_RTLD_LAZY    = 1
 ,   BY_RTLD_NOW     = 2
+,   BY_RTLD_COMPACT = 4     //!< build the compact symbol index and release the file mapping, only for fake dlopen
 
 }by_dlopen_flag_e;
 
+/// the memory usage of the dynamic library handle
+typedef struct __by_dlstat_t
+{
+    /// the mapped size of the library file
+    by_size_t           mapped;
+
+    /// the resident size of the mapped library file
+    by_size_t           resident;
+
+    /// the heap size of the handle and symbol index
+    by_size_t           heap;
+
+}by_dlstat_t;
+
+/// the statistics of the handle pool
+typedef struct __by_dlpool_stat_t
+{
+    /// the slab count, the first slab is static
+    by_size_t           slabs;
+
+    /// the total handle count of all slabs
+    by_size_t           total;
+
+    /// the used handle count
+    by_size_t           used;
+
+    /// the peak used handle count
+    by_size_t           peak;
+
+    /// the handle count allocated from the pool
+    by_size_t           allocs;
+
+    /// the handle count opened in the caller-provided storage
+    by_size_t           storages;
+
+}by_dlpool_stat_t;
+
+/*! the library loaded callback type
+ *
+ * @param handle    the dynamic library handle, it should be closed by by_dlclose()
+ * @param filename  the loaded library name (dlpi_name), it's only valid in the callback
+ * @param udata     the user data
+ */
+typedef by_void_t       (*by_dlnotify_func_t)(by_pointer_t handle, by_char_t const* filename, by_pointer_t udata);
+
 /* //////////////////////////////////////////////////////////////////////////////////////
  * interfaces
  */
 
 /*! The function dlopen() loads the dynamic library and returns an opaque "handle".
+ *
+ * the loaded image can be also found by the basename or framework name on apple platforms, e.g. "libz.1.dylib" and "UIKit"
  *
  * @param filename  the dynamic library file named by the null-terminated string filename 
  * @param flag      the load flag
@@ -55,7 +110,33 @@ typedef enum __by_dlopen_flag_e
  */
 by_pointer_t        by_dlopen(by_char_t const* filename, by_int_t flag);
 
+/*! dlopen the dynamic library in the caller-provided storage, it's same as by_dlopen() but does not allocate the handle
+ *
+ * it's usually used in the allocator hooks or early initialization, where re-entering malloc() is unsafe,
+ * the storage should be aligned by the pointer size and it should be valid until the handle is closed by by_dlclose().
+ *
+ * @param storage   the handle storage
+ * @param size      the storage size, it should be >= BY_DLOPEN_STORAGE_SIZE
+ * @param filename  the dynamic library file named by the null-terminated string filename
+ * @param flag      the load flag
+ *
+ * @return          the dynamic library handle, it's the given storage
+ */
+by_pointer_t        by_dlopen_into(by_pointer_t storage, by_size_t size, by_char_t const* filename, by_int_t flag);
+
+/*! get the statistics of the handle pool
+ *
+ * the handles of by_dlopen() are allocated from the fixed-size slab pool, so the open/close cycle does not allocate heap memory.
+ *
+ * @param stat      the pool statistics
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_dlpool_stat(by_dlpool_stat_t* stat);
+
 /*! get the address where that symbol is loaded into memory
+ *
+ * the ifunc symbol (STT_GNU_IFUNC) is resolved by calling its resolver like the linker, e.g. memcpy of glibc.
  *
  * @param handle    the dynamic library handle
  *
@@ -72,6 +153,364 @@ by_pointer_t        by_dlsym(by_pointer_t handle, by_char_t const* symbol);
  */
 by_int_t            by_dlclose(by_pointer_t handle);
 
+#if !defined(__APPLE__)
+/*! load the dynamic library with the compact symbol index
+ *
+ * we only keep the name hashes and values of the given symbols (or all symbols if symbols is null),
+ * and unmap the library file, so the long-lived handle will use less memory.
+ *
+ * the symbols which are not in the given list cannot be found by by_dlsym() later.
+ *
+ * @param filename  the dynamic library file named by the null-terminated string filename
+ * @param flag      the load flag
+ * @param symbols   the wanted symbol names
+ * @param count     the wanted symbol count
+ *
+ * @return          the dynamic library handle
+ */
+by_pointer_t        by_dlopen_compact(by_char_t const* filename, by_int_t flag, by_char_t const** symbols, by_size_t count);
+
+/*! get the symbol address with the given version, e.g. by_dlvsym(handle, "memcpy", "GLIBC_2.14")
+ *
+ * by_dlsym() only returns the default version of the symbol like the linker,
+ * and we can use it to get the other versions from .gnu.version and .gnu.version_d.
+ *
+ * @param handle    the dynamic library handle
+ * @param symbol    the symbol name
+ * @param version   the version name
+ *
+ * @return          the symbol address
+ */
+by_pointer_t        by_dlvsym(by_pointer_t handle, by_char_t const* symbol, by_char_t const* version);
+
+/*! get the symbol address by the demangled c++ name
+ *
+ * the name can be the full demangled name, e.g. android::AndroidRuntime::getJNIEnv(),
+ * or the qualified name without parameters, e.g. android::AndroidRuntime::getJNIEnv,
+ * and any one of the overloaded functions will be returned if the parameters are not given.
+ *
+ * the demangled name index is built once at the first lookup, and it's not supported for the compact handle.
+ *
+ * @param handle    the dynamic library handle
+ * @param name      the demangled name
+ *
+ * @return          the symbol address
+ */
+by_pointer_t        by_dlsym_demangled(by_pointer_t handle, by_char_t const* name);
+
+/*! get the address of the calling thread's instance of the thread-local (STT_TLS) symbol
+ *
+ * the tls block of the library will be allocated for the calling thread if it has not been allocated.
+ *
+ * @param handle    the dynamic library handle
+ * @param symbol    the tls symbol name
+ *
+ * @return          the symbol address of the calling thread
+ */
+by_pointer_t        by_dlsym_tls(by_pointer_t handle, by_char_t const* symbol);
+
+/*! get the data of the given section without copying it, e.g. .rodata, .note.gnu.build-id or the custom section
+ *
+ * it returns the runtime address if the section is in a loaded segment, otherwise the file-mapped data,
+ * which is valid until the handle is closed. it's not supported for the compact and remote handles.
+ *
+ * @param handle    the dynamic library handle
+ * @param name      the section name, e.g. ".rodata"
+ * @param paddr     the section address
+ * @param psize     the section size, it's optional
+ *
+ * @return          by_true if it's found
+ */
+by_bool_t           by_dlsection(by_pointer_t handle, by_char_t const* name, by_pointer_t* paddr, by_size_t* psize);
+
+/*! get the data of the given segment (program header) without copying it
+ *
+ * it returns the runtime address if the segment is in a loaded segment, otherwise the file-mapped data.
+ *
+ * @param handle    the dynamic library handle
+ * @param type      the segment type, e.g. PT_LOAD, PT_NOTE, PT_DYNAMIC
+ * @param index     the index of the segments with the same type, e.g. 1 for the second PT_LOAD
+ * @param paddr     the segment address
+ * @param psize     the segment size, it's optional
+ *
+ * @return          by_true if it's found
+ */
+by_bool_t           by_dlsegment(by_pointer_t handle, by_size_t type, by_size_t index, by_pointer_t* paddr, by_size_t* psize);
+
+/*! load the dynamic library containing the given address, e.g. a function pointer from the callback or stack frame
+ *
+ * the module is found by the binary search in the address range table of the loaded modules,
+ * and we use PROCMAP_QUERY ioctl (linux 6.11+) instead of parsing maps to get its path if dlpi_name is not full path.
+ *
+ * @param addr      the address in the dynamic library
+ * @param flag      the load flag
+ *
+ * @return          the dynamic library handle
+ */
+by_pointer_t        by_dlopen_by_addr(by_cpointer_t addr, by_int_t flag);
+
+/*! open the dynamic library loaded in the remote process
+ *
+ * the load bias address is found from /proc/<pid>/maps, and the symbol tables are read from the library file.
+ * the dynamic symbols are read from PT_DYNAMIC of the remote process by process_vm_readv() if the file cannot be opened, e.g. [vdso].
+ *
+ * the handle can be used by by_dlsym() and by_dlsym_remote(), the returned addresses are in the remote process.
+ * it's better to use BY_RTLD_COMPACT if we need find lots of symbols.
+ *
+ * @note the ifunc resolvers cannot be called for the remote process, so the resolver addresses are returned for the ifunc symbols.
+ *
+ * @param pid       the remote process id
+ * @param filename  the library name or path
+ * @param flag      the load flag
+ *
+ * @return          the dynamic library handle
+ */
+by_pointer_t        by_dlopen_remote(by_int_t pid, by_char_t const* filename, by_int_t flag);
+
+/*! get the addresses of the given symbols in the remote process
+ *
+ * all symbols are found from the local tables, so it need not any system calls.
+ *
+ * @param handle    the remote dynamic library handle
+ * @param symbols   the symbol names
+ * @param addrs     the symbol addresses in the remote process, it's null if the symbol is not found
+ * @param count     the symbol count
+ *
+ * @return          the found symbol count
+ */
+by_size_t           by_dlsym_remote(by_pointer_t handle, by_char_t const** symbols, by_pointer_t* addrs, by_size_t count);
+
+/*! call the given function once a library matching the pattern is loaded
+ *
+ * it's called immediately if the library has been loaded, otherwise it's called by by_dlnotify_poll() or the background thread.
+ * the loaded libraries are only iterated if the load generation (dlpi_adds) has been changed, so it's cheap to poll it.
+ *
+ * @param pattern   the wildcard pattern of fnmatch(), e.g. "libfoo*.so", it's matched with the basename if it has not any '/'
+ * @param func      the callback, it will be called only once
+ * @param udata     the user data
+ *
+ * @return          the listener id, 0 on failure
+ */
+by_size_t           by_on_library_loaded(by_char_t const* pattern, by_dlnotify_func_t func, by_pointer_t udata);
+
+/*! cancel the pending listener
+ *
+ * the matched listener that is about to be notified by the other checking is suppressed.
+ * if its callback is running in the other thread, it waits for the callback to return,
+ * so the user data can be released safely after it returns. but it does not wait if it's
+ * called in the callback itself, e.g. the listener cancels itself.
+ *
+ * @param id        the listener id
+ *
+ * @return          by_true if it has not been notified and it will never be notified
+ */
+by_bool_t           by_dlnotify_cancel(by_size_t id);
+
+/*! check the loaded libraries and notify the matched listeners, it's usually called at the controlled points
+ *
+ * @return          the notified listener count
+ */
+by_size_t           by_dlnotify_poll(by_void_t);
+
+/*! start the background thread to call by_dlnotify_poll() periodically, the callbacks will be called in it
+ *
+ * @param interval  the checking interval (ms)
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_dlnotify_start(by_size_t interval);
+
+/*! stop the background thread
+ *
+ * it waits for the background thread to exit, but if it's called in the callback of the background thread,
+ * the thread is detached and it will exit after the callback returns.
+ */
+by_void_t           by_dlnotify_stop(by_void_t);
+
+/*! get the memory usage of the dynamic library handle
+ *
+ * @param handle    the dynamic library handle
+ * @param stat      the memory usage
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_dlstat(by_pointer_t handle, by_dlstat_t* stat);
+
+/*! build the shared symbol index of the given libraries
+ *
+ * the compact indexes are written to a sealed memfd (or the anonymous shared mapping if memfd is not supported or cannot be sealed),
+ * we can call it in the parent process (e.g. zygote), and the child processes will inherit it after fork(),
+ * so they can open these libraries by by_dlopen_shared() without parsing the library files.
+ *
+ * @param filenames the library names
+ * @param count     the library count
+ *
+ * @return          the shared index handle
+ */
+by_pointer_t        by_dlshare_init(by_char_t const** filenames, by_size_t count);
+
+/*! attach the shared symbol index from the given memfd, e.g. it's passed from the other process
+ *
+ * the memfd must be sealed with F_SEAL_WRITE and F_SEAL_SHRINK, otherwise it will be rejected.
+ *
+ * @param fd        the memfd of the shared index
+ *
+ * @return          the shared index handle
+ */
+by_pointer_t        by_dlshare_attach(by_int_t fd);
+
+/*! get the memfd of the shared symbol index
+ *
+ * @param share     the shared index handle
+ *
+ * @return          the memfd, -1 if it uses the anonymous shared mapping
+ */
+by_int_t            by_dlshare_fd(by_pointer_t share);
+
+/*! load the dynamic library with the shared symbol index
+ *
+ * the returned handle only uses the read-only shared index, so we must close it before by_dlshare_exit().
+ *
+ * @param share     the shared index handle
+ * @param filename  the library name passed to by_dlshare_init() or its real path
+ * @param flag      the load flag
+ *
+ * @return          the dynamic library handle
+ */
+by_pointer_t        by_dlopen_shared(by_pointer_t share, by_char_t const* filename, by_int_t flag);
+
+/*! exit the shared symbol index
+ *
+ * @param share     the shared index handle
+ */
+by_void_t           by_dlshare_exit(by_pointer_t share);
+
+/*! enable the resolution journal and replay the journal file of the last run
+ *
+ * the journal records the resolved symbols (the bias-relative offsets) of the opened libraries,
+ * and each library is identified by its real path, file size and build-id.
+ *
+ * the journaled symbols will be found directly by by_dlsym(), and the library file will be loaded only at the first journal miss.
+ * all symbols of the library will be discarded if it has been changed.
+ *
+ * @param filepath  the journal file path, it's ok if it does not exist
+ *
+ * @return          the count of the replayed symbols, -1 on error
+ */
+by_int_t            by_journal_replay(by_char_t const* filepath);
+
+/*! save the resolution journal to the given file
+ *
+ * @param filepath  the journal file path
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_journal_save(by_char_t const* filepath);
+
+/*! set the thread count of building the compact index and the demangled name index
+ *
+ * the large symbol tables are split to the chunks, which are hashed and sorted in parallel and then merged.
+ *
+ * @param count     the thread count, it's selected by the cpu count (<= 8) if it's 0, and it's 16 at most
+ */
+by_void_t           by_index_threads_set(by_size_t count);
+
+/*! set the kernel of the linear symbol scan, it's selected at runtime based on the cpu features by default
+ *
+ * it's usually used to compare the kernels in benchmark.
+ *
+ * @param name      the kernel name, e.g. auto, scalar, sse2, avx2, neon
+ *
+ * @return          by_true if it's supported on the current cpu
+ */
+by_bool_t           by_symscan_set(by_char_t const* name);
+
+/*! export the symbols of the dynamic library to the perf map file (/tmp/perf-<pid>.map),
+ * so the system profiler (e.g. perf) can symbolize the frames in the stripped libraries.
+ *
+ * the symbols are read from .symtab, or .dynsym if it has been stripped.
+ *
+ * @param handle    the dynamic library handle, export all loaded libraries if it's null
+ * @param minsize   only export the functions whose size >= minsize, export all symbols if it's 0
+ *
+ * @return          the exported symbol count, -1 on error
+ */
+by_int_t            by_perfmap_export(by_pointer_t handle, by_size_t minsize);
+
+/*! get the source file and line of the given address in the dynamic library
+ *
+ * the line table is parsed from .debug_line of the library or its separate debug file (build-id or .gnu_debuglink),
+ * and it's built at the first lookup and cached in the handle.
+ *
+ * @param handle    the dynamic library handle
+ * @param addr      the address in the library
+ * @param pfile     the source file path, it's valid until the handle is closed
+ * @param pline     the line
+ *
+ * @return          by_true if it's found
+ */
+by_bool_t           by_addr2line(by_pointer_t handle, by_cpointer_t addr, by_char_t const** pfile, by_size_t* pline);
+
+/*! get the source files and lines of the given addresses, e.g. all frames of the stack
+ *
+ * the addresses are sorted and found in one merge pass of the line table.
+ *
+ * @param handle    the dynamic library handle
+ * @param addrs     the addresses
+ * @param files     the source file paths, it's null if it's not found
+ * @param lines     the lines, it's 0 if it's not found
+ * @param count     the address count
+ *
+ * @return          the found count
+ */
+by_size_t           by_addr2line_batch(by_pointer_t handle, by_cpointer_t const* addrs, by_char_t const** files, by_size_t* lines, by_size_t count);
+
+/*! capture the call stack of the current thread, it's only supported on x86_64 and arm64
+ *
+ * the stack is unwound by .eh_frame of the loaded libraries, which is found by the binary search table
+ * of PT_GNU_EH_FRAME, and the parsed call frames are cached, so it need not the frame pointers.
+ *
+ * @param pcs       the return addresses, the first one is the caller of by_backtrace()
+ * @param exacts    is each pc exact (e.g. the interrupted pc of the signal frame) or the return address? it's optional
+ * @param maxn      the max frame count
+ *
+ * @return          the frame count
+ */
+by_size_t           by_backtrace(by_pointer_t* pcs, by_bool_t* exacts, by_size_t maxn);
+
+/*! capture the call stack of the interrupted frame in the signal handler
+ *
+ * it never allocates memory or rebuilds the module table, so we should call by_backtrace() once
+ * before installing the signal handler, and it returns 0 if the module table is being rebuilt.
+ *
+ * @param context   the ucontext_t pointer passed to the signal handler (SA_SIGINFO)
+ * @param pcs       the return addresses, the first one is the interrupted pc, so it's always exact
+ * @param exacts    is each pc exact or the return address? it's optional
+ * @param maxn      the max frame count
+ *
+ * @return          the frame count
+ */
+by_size_t           by_backtrace_context(by_cpointer_t context, by_pointer_t* pcs, by_bool_t* exacts, by_size_t maxn);
+
+/*! get the function names of all frames of the call stack
+ *
+ * the symbols are read from .symtab, or .dynsym if it has been stripped, and each library is opened
+ * and cached at the first lookup. it cannot be called in the signal handler.
+ *
+ * the return addresses are looked up by pc - 1, because the call may be the last instruction of the function,
+ * but the exact pcs are looked up as is, e.g. the first pc of by_backtrace_context().
+ *
+ * @param pcs       the return addresses
+ * @param exacts    the exact flags of by_backtrace() or by_backtrace_context(), all pcs are the return addresses if it's null
+ * @param names     the function names, it's null if it's not found, they are always valid
+ * @param offsets   the offsets from the function addresses, it's optional
+ * @param count     the frame count
+ *
+ * @return          the found count
+ */
+by_size_t           by_backtrace_symbols(by_pointer_t const* pcs, by_bool_t const* exacts, by_char_t const** names, by_size_t* offsets, by_size_t count);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,17 +22,8 @@
 /* //////////////////////////////////////////////////////////////////////////////////////
  * includes
  */
-#include "byopen.h"
+#include "byopen_elf.h"
 #include <dlfcn.h>
-#include <errno.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/mman.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <inttypes.h>
-#include <elf.h>
-#include <link.h>
 #include <pthread.h>
 #include <sys/system_properties.h>
 
@@ -40,65 +31,65 @@
  * macros
  */
 
-// the fake dlopen magic
-#define BY_FAKE_DLCTX_MAGIC      (0xfaddfadd)
-
 /* g_dl_mutex in linker
  *
  * @see http://androidxref.com/5.0.0_r2/xref/bionic/linker/dlfcn.cpp#32
  */
 #define BY_LINKER_MUTEX         "__dl__ZL10g_dl_mutex"
 
-// the linker name
-#ifndef __LP64__
-#   define BY_LINKER_NAME       "linker"
-#else
-#   define BY_LINKER_NAME       "linker64"
-#endif
-
 /* //////////////////////////////////////////////////////////////////////////////////////
  * types
  */
 
-// the dynamic library context type for fake dlopen
-typedef struct _by_fake_dlctx_t
+/* the jni cache type of the System.load/loadLibrary fallback
+ *
+ * all classes and reflected methods are global references of the given java vm,
+ * they will be resolved at the first loading and reused for the next loadings.
+ */
+typedef struct _by_jni_cache_t
 {
-    // magic, mark handle for fake dlopen
-    by_uint32_t     magic;
-
-    // the load bias address of the dynamic library
-    by_pointer_t    biasaddr;
+    // the java vm of the cached references
+    JavaVM*         jvm;
 
-    // the .dynsym and .dynstr sections
-    by_pointer_t    dynstr;
-    by_pointer_t    dynsym;
-    by_int_t        dynsym_num;
+    // the classes
+    jclass          class_clazz;
+    jclass          object_clazz;
+    jclass          string_clazz;
+    jclass          system_clazz;
 
-    // the .symtab and .strtab sections
-    by_pointer_t    strtab;
-    by_pointer_t    symtab;
-    by_int_t        symtab_num;
+    // the method ids, Method.invoke, System.load and System.loadLibrary
+    jmethodID       invoke_id;
+    jmethodID       load_id;
+    jmethodID       loadLibrary_id;
 
-    // the file data and size
-    by_pointer_t    filedata;
-    by_size_t       filesize;
+    // the reflected methods, Class.getDeclaredMethod, System.load and System.loadLibrary
+    jobject         getDeclaredMethod_method;
+    jobject         load_method;
+    jobject         loadLibrary_method;
 
-}by_fake_dlctx_t, *by_fake_dlctx_ref_t;
+}by_jni_cache_t;
 
 /* //////////////////////////////////////////////////////////////////////////////////////
  * globals
  */
 
-// the jni environment on tls
+// the jni environment on tls and its java vm
 __thread JNIEnv*        g_tls_jnienv = by_null;
+static __thread JavaVM* g_tls_jnivm = by_null;
 static JavaVM*          g_jvm = by_null;
 static by_int_t         g_jversion = JNI_VERSION_1_4;
-static pthread_mutex_t* g_linker_mutex = by_null;
 
-/* //////////////////////////////////////////////////////////////////////////////////////
- * declaration
- */
-extern __attribute((weak)) by_int_t dl_iterate_phdr(by_int_t (*)(struct dl_phdr_info*, size_t, by_pointer_t), by_pointer_t);
+// the jni cache and lock
+static by_jni_cache_t   g_jni_cache;
+static pthread_mutex_t  g_jni_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the thread key to detach the attached threads when they exit
+static pthread_key_t    g_jni_detach_key;
+static pthread_once_t   g_jni_detach_once = PTHREAD_ONCE_INIT;
+
+// the AndroidRuntime::getJNIEnv() function, it's resolved once per process
+static by_pointer_t     g_jni_getJNIEnv = by_null;
+static pthread_once_t   g_jni_getJNIEnv_once = PTHREAD_ONCE_INIT;
 
 /* //////////////////////////////////////////////////////////////////////////////////////
  * declaration
@@ -201,499 +192,161 @@ static by_int_t by_rt_api_level()
     return s_api_level;
 }
 
-// find the load bias address from the base address
-static by_pointer_t by_fake_find_biasaddr_from_baseaddr(by_pointer_t baseaddr)
+static by_void_t by_jni_clearException(JNIEnv* env, by_bool_t report)
 {
-    // check
-    by_assert_and_check_return_val(baseaddr, by_null);
-
-    // find load bias from program header
-    ElfW(Ehdr)*       ehdr = (ElfW(Ehdr)*)baseaddr;
-    ElfW(Phdr) const* dlpi_phdr = (ElfW(Phdr) const*)(baseaddr + ehdr->e_phoff);
-    by_int_t          dlpi_phnum = ehdr->e_phnum;
-    uintptr_t         min_vaddr = UINTPTR_MAX;
-    for (by_int_t i = 0; i < dlpi_phnum; i++)
+    jthrowable e = report? (*env)->ExceptionOccurred(env) : by_null;
+    (*env)->ExceptionClear(env);
+    if (e)
     {
-        ElfW(Phdr) const* phdr = &(dlpi_phdr[i]);
-        if (PT_LOAD == phdr->p_type)
-        {
-            if (min_vaddr > phdr->p_vaddr)
-                min_vaddr = phdr->p_vaddr;
-        }
+        jclass clazz = (*env)->GetObjectClass(env, e);
+        jmethodID printStackTrace_id = (*env)->GetMethodID(env, clazz, "printStackTrace", "()V");
+        if (!(*env)->ExceptionCheck(env) && printStackTrace_id)
+            (*env)->CallVoidMethod(env, e, printStackTrace_id);
+        if ((*env)->ExceptionCheck(env))
+            (*env)->ExceptionClear(env);
     }
-    return min_vaddr != UINTPTR_MAX? baseaddr - min_vaddr : by_null;
 }
-
-// find the load bias address and real path from the maps
-static by_pointer_t by_fake_find_biasaddr_from_maps(by_char_t const* filename, by_char_t* realpath, by_size_t realmaxn)
+// make the global reference of the local reference
+static jobject by_jni_global(JNIEnv* env, jobject local)
 {
-    // check
-    by_assert_and_check_return_val(filename && realpath && realmaxn, by_null);
-
-    // trace
-    by_trace("find biasaddr of %s from maps", filename);
-
-    // find it
-    by_char_t    line[512];
-    by_char_t    page_attr[10];
-    by_pointer_t biasaddr = by_null;
-    FILE* fp = fopen("/proc/self/maps", "r");
-    if (fp)
-    {
-        while (fgets(line, sizeof(line), fp))
-        {
-            if (strstr(line, filename))
-            {
-                int       pos = 0;
-                uintptr_t start = 0;
-                uintptr_t offset = 0;
-                // 7372a68000-7372bc1000 --xp 000fe000 fd:06 39690571                       /system/lib64/libandroid_runtime.so
-                if (3 == sscanf(line, "%"SCNxPTR"-%*"SCNxPTR" %4s %"SCNxPTR" %*x:%*x %*d%n", &start, page_attr, &offset, &pos))
-                {
-                    // check permission and offset
-                    if (page_attr[0] != 'r') continue;
-                    if (page_attr[3] != 'p') continue;
-                    if (0 != offset) continue;
-
-                    // get load bias address
-                    biasaddr = by_fake_find_biasaddr_from_baseaddr((by_pointer_t)start);
-
-                    // get real path
-                    if (filename[0] == '/')
-                        strlcpy(realpath, filename, realmaxn);
-                    else if (pos < sizeof(line))
-                    {
-                        by_char_t* p = line + pos;
-                        by_char_t* e = p + strlen(p);
-                        while (p < e && isspace((by_int_t)*p)) p++;
-                        while (p < e && isspace((by_int_t)(*(e - 1)))) e--;
-                        *e = '\0';
-                        if (p < e) strlcpy(realpath, p, realmaxn);
-                        else realpath[0] = '\0';
-                    }
-                    else realpath[0] = '\0';
-
-                    // trace
-                    by_trace("realpath: %s, biasaddr: %p found!", realpath, biasaddr);
-                }
-                break;
-            }
-        }
-        fclose(fp);
-    }
-    return biasaddr;
+    jobject global = (local && !(*env)->ExceptionCheck(env))? (*env)->NewGlobalRef(env, local) : by_null;
+    if (local) (*env)->DeleteLocalRef(env, local);
+    return global;
 }
 
-// the callback of dl_iterate_phdr()
-static by_int_t by_fake_find_biasaddr_from_linker_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+/* init the jni cache, it need be called in lock
+ *
+ * the cached references will be dropped by by_jni_javavm_set() if the java vm has been changed.
+ */
+static by_bool_t by_jni_cache_init(JNIEnv* env)
 {
-    // check
-    by_cpointer_t* args = (by_cpointer_t*)udata;
-    by_check_return_val(args, 1);
-    by_check_return_val(info && info->dlpi_addr && info->dlpi_name && info->dlpi_name[0] != '\0', 0);
-
-    // get filename
-    by_char_t const* filename = by_null;
-    by_char_t const* filepath = (by_char_t const*)args[0];
-    by_assert_and_check_return_val(filepath, 1);
-    if (filepath[0] == '/')
-    {
-        by_char_t const* p = filepath + strlen(filepath);
-        while (p >= filepath && *p != '/')
-            p--;
-        if (p >= filepath && *p == '/') filename = p + 1;
-    }
-
-    // find library, we can also get full path of dlpi_name from maps
-    by_pointer_t*    pbiasaddr = (by_pointer_t*)&args[3];
-    by_char_t*       realpath  = (by_char_t*)args[1];
-    by_size_t        realmaxn  = (by_size_t)args[2];
-    if ((filepath && strstr(info->dlpi_name, filepath)) ||
-        (filename && !strcmp(info->dlpi_name, filename))) // dlpi_name ma ybe not full path, e.g. libart.so
-    {
-        // save load bias address
-        *pbiasaddr = (by_pointer_t)info->dlpi_addr;
-
-        // get real path
-        if (filepath[0] == '/')
-            strlcpy(realpath, filepath, realmaxn);
-        else if (info->dlpi_name[0] == '/')
-            strlcpy(realpath, info->dlpi_name, realmaxn);
-        else
-        {
-            // we only find real path
-            if (!by_fake_find_biasaddr_from_maps(filepath, realpath, realmaxn))
-                realpath[0] = '\0';
-        }
-
-        // trace
-        by_trace("realpath: %s, biasaddr: %p found!", realpath, (by_pointer_t)info->dlpi_addr);
-
-        // found, stop it
-        return 1;
-    }
-    return 0;
+    // get the java vm of the cached references
+    if (!g_jni_cache.jvm && (*env)->GetJavaVM(env, &g_jni_cache.jvm) != JNI_OK)
+        g_jni_cache.jvm = by_null;
+
+    // get classes
+    if (!g_jni_cache.class_clazz)
+        g_jni_cache.class_clazz = (jclass)by_jni_global(env, (*env)->FindClass(env, "java/lang/Class"));
+    if (!g_jni_cache.object_clazz)
+        g_jni_cache.object_clazz = (jclass)by_jni_global(env, (*env)->FindClass(env, "java/lang/Object"));
+    if (!g_jni_cache.string_clazz)
+        g_jni_cache.string_clazz = (jclass)by_jni_global(env, (*env)->FindClass(env, "java/lang/String"));
+    if (!g_jni_cache.system_clazz)
+        g_jni_cache.system_clazz = (jclass)by_jni_global(env, (*env)->FindClass(env, "java/lang/System"));
+    by_check_return_val(!(*env)->ExceptionCheck(env), by_false);
+    return g_jni_cache.class_clazz && g_jni_cache.object_clazz && g_jni_cache.string_clazz && g_jni_cache.system_clazz;
 }
 
-// find the load bias address and real path from the maps
-static by_pointer_t by_fake_find_biasaddr_from_linker(by_char_t const* filepath, by_char_t* realpath, by_size_t realmaxn)
+/* get the reflected Class.getDeclaredMethod, it need be called in lock
+ *
+ * Method getDeclaredMethod = Class.class.getDeclaredMethod("getDeclaredMethod", String.class, Class[].class);
+ */
+static jobject by_jni_Class_getDeclaredMethod(JNIEnv* env)
 {
     // check
-    by_assert_and_check_return_val(dl_iterate_phdr && filepath && realpath && realmaxn, by_null);
-
-    // trace
-    by_trace("find biasaddr of %s from linker", filepath);
-
-    // find biasaddr
-    by_cpointer_t args[4];
-    args[0] = (by_cpointer_t)filepath;
-    args[1] = (by_cpointer_t)realpath;
-    args[2] = (by_cpointer_t)realmaxn;
-    args[3] = by_null;
-    if (g_linker_mutex) pthread_mutex_lock(g_linker_mutex);
-    dl_iterate_phdr(by_fake_find_biasaddr_from_linker_cb, args);
-    if (g_linker_mutex) pthread_mutex_unlock(g_linker_mutex);
-    return (by_pointer_t)args[3];
-}
+    by_assert_and_check_return_val(env, by_null);
 
-// find the load bias address and real path
-static by_pointer_t by_fake_find_biasaddr(by_char_t const* filename, by_char_t* realpath, by_size_t realmaxn)
-{
-    by_assert_and_check_return_val(filename && realpath, by_null);
-    by_pointer_t biasaddr = by_null;
-    if (dl_iterate_phdr && 0 != strcmp(filename, BY_LINKER_NAME))
-        biasaddr = by_fake_find_biasaddr_from_linker(filename, realpath, realmaxn);
-    if (!biasaddr)
-        biasaddr = by_fake_find_biasaddr_from_maps(filename, realpath, realmaxn);
-    return biasaddr;
-}
+    // has been cached?
+    by_check_return_val(!g_jni_cache.getDeclaredMethod_method, g_jni_cache.getDeclaredMethod_method);
 
-// open map file
-static by_pointer_t by_fake_open_file(by_char_t const* filepath, by_size_t* pfilesize)
-{
-    // check
-    by_assert_and_check_return_val(filepath && pfilesize, by_null);
+    // push
+    if ((*env)->PushLocalFrame(env, 10) < 0) return by_null;
 
-    // open it
-    by_int_t     fd = -1;
-    by_pointer_t filedata = by_null;
+    // get getDeclaredMethod method
+    jobject getDeclaredMethod_method = by_null;
     do
     {
-        // open file
-        fd = open(filepath, O_RDONLY | O_CLOEXEC);
-        if (fd < 0 && errno == EINTR)
-            fd = open(filepath, O_RDONLY | O_CLOEXEC);
-        by_check_break(fd > 0);
-
-        // get file size
-        struct stat st;
-        if (0 != fstat(fd, &st) || 0 == st.st_size) break;
-
-        // mmap the file data
-        filedata = mmap(by_null, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-        by_assert_and_check_break(filedata && filedata != MAP_FAILED);
-
-        // save the file size
-        if (pfilesize) *pfilesize = (by_size_t)st.st_size;
-
-    } while (0);
-
-    // close the fd first
-    if (fd > 0) close(fd);
-    fd = -1;
-
-    // ok?
-    return filedata;
-}
-
-// get symbol address from the fake dlopen context
-static by_pointer_t by_fake_dlsym(by_fake_dlctx_ref_t dlctx, by_char_t const* symbol)
-{
-    // check
-    by_assert_and_check_return_val(dlctx && dlctx->filedata && dlctx->filesize && symbol, by_null);
-
-    // find the symbol address from the .dynsym first
-    by_int_t         i = 0;
-    by_pointer_t     end = dlctx->filedata + dlctx->filesize;
-    by_char_t const* dynstr = (by_char_t const*)dlctx->dynstr;
-    ElfW(Sym)*       dynsym = (ElfW(Sym)*)dlctx->dynsym;
-    by_int_t         dynsym_num = dlctx->dynsym_num;
-    if (dynsym && dynstr)
-    {
-        for (i = 0; i < dynsym_num; i++, dynsym++)
+        // get Method.invoke id
+        if (!g_jni_cache.invoke_id)
         {
-            by_char_t const* name = dynstr + dynsym->st_name;
-            if ((by_pointer_t)name < end && strcmp(name, symbol) == 0)
-            {
-                /* NB: sym->st_value is an offset into the section for relocatables,
-                 * but a VMA for shared libs or exe files, so we have to subtract the bias
-                 */
-                by_pointer_t symboladdr = (by_pointer_t)(dlctx->biasaddr + dynsym->st_value);
-                by_trace("dlsym(%s): found at .dynsym/%p = %p + %x", symbol, symboladdr, dlctx->biasaddr, (by_int_t)dynsym->st_value);
-                return symboladdr;
-            }
-        }
-    }
+            jclass method_clazz = (*env)->FindClass(env, "java/lang/reflect/Method");
+            by_assert_and_check_break(!(*env)->ExceptionCheck(env) && method_clazz);
 
-    // find the symbol address from the .symtab
-    by_char_t const* strtab = (by_char_t const*)dlctx->strtab;
-    ElfW(Sym)*       symtab = (ElfW(Sym)*)dlctx->symtab;
-    by_int_t         symtab_num = dlctx->symtab_num;
-    if (symtab && strtab)
-    {
-        for (i = 0; i < symtab_num; i++, symtab++)
-        {
-            by_char_t const* name = strtab + symtab->st_name;
-            if ((by_pointer_t)name < end && strcmp(name, symbol) == 0)
-            {
-                by_pointer_t symboladdr = (by_pointer_t)(dlctx->biasaddr + symtab->st_value);
-                by_trace("dlsym(%s): found at .symtab/%p = %p + %x", symbol, symboladdr, dlctx->biasaddr, (by_int_t)symtab->st_value);
-                return symboladdr;
-            }
+            g_jni_cache.invoke_id = (*env)->GetMethodID(env, method_clazz, "invoke", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+            by_assert_and_check_break(!(*env)->ExceptionCheck(env) && g_jni_cache.invoke_id);
         }
-    }
-    return by_null;
-}
-
-// close the fake dlopen context
-static by_int_t by_fake_dlclose(by_fake_dlctx_ref_t dlctx)
-{
-    // check
-    by_assert_and_check_return_val(dlctx, -1);
-
-    // clear data
-    dlctx->biasaddr   = by_null;
-    dlctx->dynsym     = by_null;
-    dlctx->dynstr     = by_null;
-    dlctx->dynsym_num = 0;
-    dlctx->strtab     = by_null;
-    dlctx->symtab     = by_null;
-    dlctx->symtab_num = 0;
-
-    // unmap file data
-    if (dlctx->filedata) munmap(dlctx->filedata, dlctx->filesize);
-    dlctx->filedata = by_null;
-    dlctx->filesize = 0;
-
-    // free context
-    free(dlctx);
-    return 0;
-}
-
-/* @see https://www.sunmoonblog.com/2019/06/04/fake-dlopen/
- * https://github.com/avs333/Nougat_dlfunctions
- */
-static by_fake_dlctx_ref_t by_fake_dlopen_impl(by_char_t const* filename, by_int_t flag)
-{
-    // check
-    by_assert_and_check_return_val(filename, by_null);
-
-    // do open
-    by_bool_t           ok = by_false;
-    by_char_t           realpath[512];
-    by_fake_dlctx_ref_t dlctx = by_null;
-    do
-    {
-        // attempt to find the load bias address and real path
-        by_pointer_t biasaddr = by_fake_find_biasaddr(filename, realpath, sizeof(realpath));
-        by_check_break(biasaddr);
-
-        // init context
-        dlctx = calloc(1, sizeof(by_fake_dlctx_t));
-        by_assert_and_check_break(dlctx);
-
-        dlctx->magic    = BY_FAKE_DLCTX_MAGIC;
-        dlctx->biasaddr = biasaddr;
 
-        // open file
-        dlctx->filedata = by_fake_open_file(realpath, &dlctx->filesize);
-        by_assert_and_check_break(dlctx->filedata && dlctx->filesize);
-
-        // trace
-        by_trace("fake_dlopen: biasaddr: %p, realpath: %s, filesize: %d", biasaddr, realpath, (by_int_t)dlctx->filesize);
-
-        // get elf
-        ElfW(Ehdr)*  elf = (ElfW(Ehdr)*)dlctx->filedata;
-        by_pointer_t end = dlctx->filedata + dlctx->filesize;
-        by_assert_and_check_break((by_pointer_t)(elf + 1) < end);
-
-        // get .shstrtab section
-        by_pointer_t shoff = dlctx->filedata + elf->e_shoff;
-        ElfW(Shdr)*  shstrtab = (ElfW(Shdr)*)(shoff + elf->e_shstrndx * elf->e_shentsize);
-        by_assert_and_check_break((by_pointer_t)(shstrtab + 1) <= end);
+        // get class/array class
+        jclass classarray_clazz = (*env)->FindClass(env, "[Ljava/lang/Class;");
+        by_assert_and_check_break(!(*env)->ExceptionCheck(env) && classarray_clazz);
 
-        by_pointer_t shstr = dlctx->filedata + shstrtab->sh_offset;
-        by_assert_and_check_break(shstr < end);
+        // get getDeclaredMethod id
+        jmethodID getDeclaredMethod_id = (*env)->GetMethodID(env, g_jni_cache.class_clazz, "getDeclaredMethod", "(Ljava/lang/String;[Ljava/lang/Class;)Ljava/lang/reflect/Method;");
+        by_assert_and_check_break(!(*env)->ExceptionCheck(env) && getDeclaredMethod_id);
 
-        // parse elf sections
-        by_int_t  i = 0;
-        by_bool_t broken = by_false;
-        for (i = 0; !broken && i < elf->e_shnum && shoff; i++, shoff += elf->e_shentsize)
-        {
-            // get section
-            ElfW(Shdr)* sh = (ElfW(Shdr)*)shoff;
-            by_assert_and_check_break((by_pointer_t)(sh + 1) <= end && shstr + sh->sh_name < end);
-            by_assert_and_check_break(dlctx->filedata + sh->sh_offset < end);
+        // get getDeclaredMethod name
+        jstring getDeclaredMethod_name = (*env)->NewStringUTF(env, "getDeclaredMethod");
+        by_assert_and_check_break(!(*env)->ExceptionCheck(env) && getDeclaredMethod_name);
 
-            // trace
-            by_trace("elf section(%d): type: %d, name: %s", i, sh->sh_type, shstr + sh->sh_name);
+        // get getDeclaredMethod args
+        jobjectArray getDeclaredMethod_args = (*env)->NewObjectArray(env, 2, g_jni_cache.class_clazz, by_null);
+        by_assert_and_check_break(!(*env)->ExceptionCheck(env) && getDeclaredMethod_args);
 
-            // get .dynsym and .symtab sections
-            switch(sh->sh_type)
-            {
-            case SHT_DYNSYM:
-                // get .dynsym
-                if (dlctx->dynsym)
-                {
-                    by_trace("%s: duplicate .dynsym sections", realpath);
-                    broken = by_true;
-                    break;
-                }
-                dlctx->dynsym     = dlctx->filedata + sh->sh_offset;
-                dlctx->dynsym_num = (sh->sh_size / sizeof(ElfW(Sym)));
-                by_trace(".dynsym: %p %d", dlctx->dynsym, dlctx->dynsym_num);
-                break;
-            case SHT_SYMTAB:
-                // get .symtab
-                if (dlctx->symtab)
-                {
-                    by_trace("%s: duplicate .symtab sections", realpath);
-                    broken = by_true;
-                    break;
-                }
-                dlctx->symtab     = dlctx->filedata + sh->sh_offset;
-                dlctx->symtab_num = (sh->sh_size / sizeof(ElfW(Sym)));
-                by_trace(".symtab: %p %d", dlctx->symtab, dlctx->symtab_num);
-                break;
-            case SHT_STRTAB:
-                // get .dynstr
-                if (!strcmp(shstr + sh->sh_name, ".dynstr"))
-                {
-                    // .dynstr is guaranteed to be the first STRTAB
-                    if (dlctx->dynstr) break;
-                    dlctx->dynstr = dlctx->filedata + sh->sh_offset;
-                    by_trace(".dynstr: %p", dlctx->dynstr);
-                }
-                // get .strtab
-                else if (!strcmp(shstr + sh->sh_name, ".strtab"))
-                {
-                    if (dlctx->strtab) break;
-                    dlctx->strtab = dlctx->filedata + sh->sh_offset;
-                    by_trace(".strtab: %p", dlctx->strtab);
-                }
-                break;
-            default:
-                break;
-            }
-        }
-        by_check_break(!broken && dlctx->dynstr && dlctx->dynsym);
+        (*env)->SetObjectArrayElement(env, getDeclaredMethod_args, 0, g_jni_cache.string_clazz);
+        (*env)->SetObjectArrayElement(env, getDeclaredMethod_args, 1, classarray_clazz);
 
-        // ok
-        ok = by_true;
+        // Method getDeclaredMethod = Class.class.getDeclaredMethod("getDeclaredMethod", String.class, Class[].class);
+        getDeclaredMethod_method = (jobject)(*env)->CallObjectMethod(env, g_jni_cache.class_clazz, getDeclaredMethod_id, getDeclaredMethod_name, getDeclaredMethod_args);
+        getDeclaredMethod_method = by_jni_global(env, getDeclaredMethod_method);
 
     } while (0);
 
-    // failed?
-    if (!ok)
-    {
-        if (dlctx) by_fake_dlclose(dlctx);
-        dlctx = by_null;
-    }
-    return dlctx;
-}
-static by_void_t by_linker_init()
-{
-    static by_bool_t s_inited = by_false;
-    if (!s_inited)
-    {
-        // we need linker mutex only for android 5.0 and 5.1
-        by_size_t apilevel = by_rt_api_level();
-        if (apilevel == __ANDROID_API_L__ || apilevel == __ANDROID_API_L_MR1__)
-        {
-            by_fake_dlctx_ref_t linker = by_fake_dlopen_impl(BY_LINKER_NAME, BY_RTLD_NOW);
-            by_trace("init linker: %p", linker);
-            if (linker)
-            {
-                g_linker_mutex = (pthread_mutex_t*)by_fake_dlsym(linker, BY_LINKER_MUTEX);
-                by_trace("load g_dl_mutex: %p", g_linker_mutex);
-                by_fake_dlclose(linker);
-            }
-        }
-        s_inited = by_true;
-    }
-}
-static by_fake_dlctx_ref_t by_fake_dlopen(by_char_t const* filename, by_int_t flag)
-{
-    by_linker_init();
-    return by_fake_dlopen_impl(filename, flag);
-}
-static by_void_t by_jni_clearException(JNIEnv* env, by_bool_t report)
-{
-    jthrowable e = report? (*env)->ExceptionOccurred(env) : by_null;
-    (*env)->ExceptionClear(env);
-    if (e)
-    {
-        jclass clazz = (*env)->GetObjectClass(env, e);
-        jmethodID printStackTrace_id = (*env)->GetMethodID(env, clazz, "printStackTrace", "()V");
-        if (!(*env)->ExceptionCheck(env) && printStackTrace_id)
-            (*env)->CallVoidMethod(env, e, printStackTrace_id);
-        if ((*env)->ExceptionCheck(env))
-            (*env)->ExceptionClear(env);
-    }
+    // pop
+    (*env)->PopLocalFrame(env, by_null);
+
+    // save it
+    g_jni_cache.getDeclaredMethod_method = getDeclaredMethod_method;
+    return getDeclaredMethod_method;
 }
-static jobject by_jni_Class_getDeclaredMethod(JNIEnv* env)
+
+/* get the reflected System.load or System.loadLibrary, it need be called in lock
+ *
+ * Method load = (Method)getDeclaredMethod.invoke(systemClass, "load", new Class[]{String.class});
+ */
+static jobject by_jni_System_load_or_loadLibrary_method(JNIEnv* env, by_char_t const* loadName)
 {
-    // check
-    by_assert_and_check_return_val(env, by_null);
+    // has been cached?
+    jobject* pmethod = !strcmp(loadName, "load")? &g_jni_cache.load_method : &g_jni_cache.loadLibrary_method;
+    by_check_return_val(!*pmethod, *pmethod);
+
+    // get getDeclaredMethod method
+    jobject getDeclaredMethod_method = by_jni_Class_getDeclaredMethod(env);
+    by_check_return_val(getDeclaredMethod_method, by_null);
 
     // push
     if ((*env)->PushLocalFrame(env, 10) < 0) return by_null;
 
-    // get unreachable memory info
-    jboolean check = by_false;
-    jobject  getDeclaredMethod_method = by_null;
+    // get load method
+    jobject load_method = by_null;
     do
     {
-        // get class
-        jclass clazz = (*env)->FindClass(env, "java/lang/Class");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && clazz);
-
-        // get string class
-        jclass string_clazz = (*env)->FindClass(env, "java/lang/String");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && string_clazz);
-
-        // get class/array class
-        jclass classarray_clazz = (*env)->FindClass(env, "[Ljava/lang/Class;");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && classarray_clazz);
-
-        // get getDeclaredMethod id
-        jmethodID getDeclaredMethod_id = (*env)->GetMethodID(env, clazz, "getDeclaredMethod", "(Ljava/lang/String;[Ljava/lang/Class;)Ljava/lang/reflect/Method;");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && getDeclaredMethod_id);
+        // get load name
+        jstring load_name = (*env)->NewStringUTF(env, loadName);
+        by_assert_and_check_break(!(*env)->ExceptionCheck(env) && load_name);
 
-        // get getDeclaredMethod name
-        jstring getDeclaredMethod_name = (*env)->NewStringUTF(env, "getDeclaredMethod");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && getDeclaredMethod_name);
+        // get invoke args
+        jobjectArray invoke_args = (*env)->NewObjectArray(env, 2, g_jni_cache.object_clazz, by_null);
+        by_assert_and_check_break(!(*env)->ExceptionCheck(env) && invoke_args);
 
-        // get getDeclaredMethod args
-        jobjectArray getDeclaredMethod_args = (*env)->NewObjectArray(env, 2, clazz, by_null);
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && getDeclaredMethod_args);
+        // get load args
+        jobjectArray load_args = (*env)->NewObjectArray(env, 1, g_jni_cache.class_clazz, g_jni_cache.string_clazz);
+        by_assert_and_check_break(!(*env)->ExceptionCheck(env) && load_args);
 
-        (*env)->SetObjectArrayElement(env, getDeclaredMethod_args, 0, string_clazz);
-        (*env)->SetObjectArrayElement(env, getDeclaredMethod_args, 1, classarray_clazz);
+        (*env)->SetObjectArrayElement(env, invoke_args, 0, load_name);
+        (*env)->SetObjectArrayElement(env, invoke_args, 1, load_args);
 
-        // Method getDeclaredMethod = Class.class.getDeclaredMethod("getDeclaredMethod", String.class, Class[].class);
-        getDeclaredMethod_method = (jobject)(*env)->CallObjectMethod(env, clazz, getDeclaredMethod_id, getDeclaredMethod_name, getDeclaredMethod_args);
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && getDeclaredMethod_method);
+        // Method load = (Method)getDeclaredMethod.invoke(systemClass, "load", new Class[]{String.class});
+        load_method = (jobject)(*env)->CallObjectMethod(env, getDeclaredMethod_method, g_jni_cache.invoke_id, g_jni_cache.system_clazz, invoke_args);
+        load_method = by_jni_global(env, load_method);
 
     } while (0);
 
-    // exception? clear it
-    if (check)
-    {
-        getDeclaredMethod_method = by_null;
-        by_jni_clearException(env, by_true);
-    }
-    return (jstring)(*env)->PopLocalFrame(env, getDeclaredMethod_method);
+    // pop
+    (*env)->PopLocalFrame(env, by_null);
+
+    // save it
+    *pmethod = load_method;
+    return load_method;
 }
 
 /* load library via system call
@@ -720,71 +373,44 @@ static jobject by_jni_Class_getDeclaredMethod(JNIEnv* env)
     Method loadLibrary = (Method)getDeclaredMethod.invoke(systemClass, "loadLibrary", new Class[]{String.class});
     loadLibrary.invoke(systemClass, libraryName);
  * @endcode
+ *
+ * the reflected methods are cached, so we only need call load.invoke() for the next loadings.
  */
 static by_bool_t by_jni_System_load_or_loadLibrary_from_sys(JNIEnv* env, by_char_t const* loadName, by_char_t const* libraryPath)
 {
     // check
     by_assert_and_check_return_val(env && loadName && libraryPath, by_false);
 
+    /* get the cached references
+     *
+     * we cannot keep the lock when loading library, because JNI_OnLoad may load the other libraries
+     */
+    pthread_mutex_lock(&g_jni_lock);
+    jobject load_method = by_jni_cache_init(env)? by_jni_System_load_or_loadLibrary_method(env, loadName) : by_null;
+    jclass    object_clazz = g_jni_cache.object_clazz;
+    jclass    system_clazz = g_jni_cache.system_clazz;
+    jmethodID invoke_id = g_jni_cache.invoke_id;
+    pthread_mutex_unlock(&g_jni_lock);
+
+    // exception? clear it
+    jboolean check = (*env)->ExceptionCheck(env);
+    if (check || !load_method)
+    {
+        if (check) by_jni_clearException(env, by_true);
+        return by_false;
+    }
+
     // push
-    if ((*env)->PushLocalFrame(env, 20) < 0) return by_false;
+    if ((*env)->PushLocalFrame(env, 10) < 0) return by_false;
 
     // do load
-    jboolean check = by_false;
     do
     {
-        // get getDeclaredMethod method
-        jobject getDeclaredMethod_method = by_jni_Class_getDeclaredMethod(env);
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && getDeclaredMethod_method);
-
-        // get class
-        jclass clazz = (*env)->FindClass(env, "java/lang/Class");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && clazz);
-
-        // get object class
-        jclass object_clazz = (*env)->FindClass(env, "java/lang/Object");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && object_clazz);
-
-        // get string class
-        jclass string_clazz = (*env)->FindClass(env, "java/lang/String");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && string_clazz);
-
-        // get system class
-        jclass system_clazz = (*env)->FindClass(env, "java/lang/System");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && system_clazz);
-
-        // get method class
-        jclass method_clazz = (*env)->FindClass(env, "java/lang/reflect/Method");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && method_clazz);
-
-        // get getDeclaredMethod_method.invoke id
-        jmethodID invoke_id = (*env)->GetMethodID(env, method_clazz, "invoke", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && invoke_id);
-
-        // get load name
-        jstring load_name = (*env)->NewStringUTF(env, loadName);
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && load_name);
-
-        // get invoke args
-        jobjectArray invoke_args = (*env)->NewObjectArray(env, 2, object_clazz, by_null);
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && invoke_args);
-
-        // get load args
-        jobjectArray load_args = (*env)->NewObjectArray(env, 1, clazz, string_clazz);
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && load_args);
-
-        (*env)->SetObjectArrayElement(env, invoke_args, 0, load_name);
-        (*env)->SetObjectArrayElement(env, invoke_args, 1, load_args);
-
-        // Method load = (Method)getDeclaredMethod.invoke(systemClass, "load", new Class[]{String.class});
-        jobject load_method = (jobject)(*env)->CallObjectMethod(env, getDeclaredMethod_method, invoke_id, system_clazz, invoke_args);
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && load_method);
-
         // load.invoke(systemClass, libraryPath)
         jstring libraryPath_jstr = (*env)->NewStringUTF(env, libraryPath);
         by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && libraryPath_jstr);
 
-        invoke_args = (*env)->NewObjectArray(env, 1, object_clazz, libraryPath_jstr);
+        jobjectArray invoke_args = (*env)->NewObjectArray(env, 1, object_clazz, libraryPath_jstr);
         by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && invoke_args);
 
         (*env)->CallObjectMethod(env, load_method, invoke_id, system_clazz, invoke_args);
@@ -802,21 +428,33 @@ static by_bool_t by_jni_System_load_or_loadLibrary_from_app(JNIEnv* env, by_char
     // check
     by_assert_and_check_return_val(env && loadName && libraryPath, by_false);
 
+    // get the cached system class and load/loadLibrary id
+    pthread_mutex_lock(&g_jni_lock);
+    jmethodID load_id = by_null;
+    jclass    system_clazz = by_null;
+    if (by_jni_cache_init(env))
+    {
+        jmethodID* pload_id = !strcmp(loadName, "load")? &g_jni_cache.load_id : &g_jni_cache.loadLibrary_id;
+        if (!*pload_id) *pload_id = (*env)->GetStaticMethodID(env, g_jni_cache.system_clazz, loadName, "(Ljava/lang/String;)V");
+        load_id      = *pload_id;
+        system_clazz = g_jni_cache.system_clazz;
+    }
+    pthread_mutex_unlock(&g_jni_lock);
+
+    // exception? clear it
+    jboolean check = (*env)->ExceptionCheck(env);
+    if (check || !load_id)
+    {
+        if (check) by_jni_clearException(env, by_true);
+        return by_false;
+    }
+
     // push
     if ((*env)->PushLocalFrame(env, 10) < 0) return by_false;
 
     // do load
-    jboolean check = by_false;
     do
     {
-        // get system class
-        jclass system_clazz = (*env)->FindClass(env, "java/lang/System");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && system_clazz);
-
-        // get load/loadLibrary id
-        jmethodID load_id = (*env)->GetStaticMethodID(env, system_clazz, loadName, "(Ljava/lang/String;)V");
-        by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && load_id);
-
         // get library path
         jstring libraryPath_jstr = (*env)->NewStringUTF(env, libraryPath);
         by_assert_and_check_break(!(check = (*env)->ExceptionCheck(env)) && libraryPath_jstr);
@@ -849,7 +487,20 @@ static by_bool_t by_jni_System_loadLibrary(JNIEnv* env, by_char_t const* library
            by_jni_System_load_or_loadLibrary_from_sys(env, "loadLibrary", libraryName);
 }
 
-/* get the current jni environment
+// detach the current thread when it exits, it's only called for the threads attached by us
+static by_void_t by_jni_detach(by_pointer_t priv)
+{
+    JavaVM* jvm = (JavaVM*)priv;
+    if (jvm) (*jvm)->DetachCurrentThread(jvm);
+    g_tls_jnienv = by_null;
+    g_tls_jnivm  = by_null;
+}
+static by_void_t by_jni_detach_key_init()
+{
+    pthread_key_create(&g_jni_detach_key, by_jni_detach);
+}
+
+/* resolve AndroidRuntime::getJNIEnv()
  *
  * @see frameworks/base/core/jni/include/android_runtime/AndroidRuntime.h
  *
@@ -857,34 +508,79 @@ static by_bool_t by_jni_System_loadLibrary(JNIEnv* env, by_char_t const* library
  * static JavaVM* getJavaVM() { return mJavaVM; }
  * static JNIEnv* getJNIEnv();
  */
-static JNIEnv* by_jni_getenv()
+static by_void_t by_jni_getJNIEnv_init()
 {
-    if (g_jvm)
+    by_linker_init();
+    by_pointer_t handle = by_elf_dlopen(by_null, 0, "libandroid_runtime.so", BY_RTLD_NOW);
+    if (handle)
     {
-        JNIEnv* env = by_null;
-        if (JNI_OK == (*g_jvm)->GetEnv(g_jvm, (by_pointer_t*)&env, g_jversion))
-            return env;
+        g_jni_getJNIEnv = by_dlsym(handle, "_ZN7android14AndroidRuntime9getJNIEnvEv");
+        if (!g_jni_getJNIEnv) g_jni_getJNIEnv = by_dlsym_demangled(handle, "android::AndroidRuntime::getJNIEnv");
+        by_dlclose(handle);
     }
-    if (!g_tls_jnienv)
+
+    // trace
+    by_trace("getJNIEnv: %p", g_jni_getJNIEnv);
+}
+
+/* get the current jni environment
+ *
+ * we attach the non-java thread if the java vm is known, and it will be detached when the thread exits.
+ * the jni environment is cached per thread, it will be refreshed if the java vm has been changed.
+ */
+static JNIEnv* by_jni_getenv()
+{
+    // get the cached jni environment
+    JavaVM* jvm = g_jvm;
+    if (g_tls_jnienv && g_tls_jnivm == jvm)
+        return g_tls_jnienv;
+
+    JNIEnv* env = by_null;
+    if (jvm)
     {
-        by_fake_dlctx_ref_t dlctx = by_fake_dlopen("libandroid_runtime.so", BY_RTLD_NOW);
-        if (dlctx)
+        // the current thread has been attached?
+        if (JNI_OK != (*jvm)->GetEnv(jvm, (by_pointer_t*)&env, g_jversion))
         {
-            typedef by_pointer_t (*getJNIEnv_t)();
-            getJNIEnv_t getJNIEnv = (getJNIEnv_t)by_fake_dlsym(dlctx, "_ZN7android14AndroidRuntime9getJNIEnvEv");
-            if (getJNIEnv)
-                g_tls_jnienv = getJNIEnv();
-            by_fake_dlclose(dlctx);
+            // attach the current thread and detach it when it exits
+            JavaVMAttachArgs args;
+            args.version = g_jversion;
+            args.name    = "byopen";
+            args.group   = by_null;
+            env = by_null;
+            if (JNI_OK == (*jvm)->AttachCurrentThread(jvm, &env, &args) && env)
+            {
+                pthread_once(&g_jni_detach_once, by_jni_detach_key_init);
+                pthread_setspecific(g_jni_detach_key, jvm);
+            }
+            else env = by_null;
         }
-
-        // trace
-        by_trace("get jnienv: %p", g_tls_jnienv);
     }
-    return g_tls_jnienv;
+    else
+    {
+        // get it from AndroidRuntime::getJNIEnv()
+        typedef JNIEnv* (*getJNIEnv_t)();
+        pthread_once(&g_jni_getJNIEnv_once, by_jni_getJNIEnv_init);
+        getJNIEnv_t getJNIEnv = (getJNIEnv_t)g_jni_getJNIEnv;
+        if (getJNIEnv) env = getJNIEnv();
+    }
+
+    // cache it
+    g_tls_jnienv = env;
+    g_tls_jnivm  = jvm;
+
+    // trace
+    by_trace("get jnienv: %p", env);
+    return env;
 }
 
 by_void_t by_jni_javavm_set(JavaVM* jvm, by_int_t jversion)
 {
+    // drop the cached references if the java vm has been changed, we cannot delete them because they belong to the old vm
+    pthread_mutex_lock(&g_jni_lock);
+    if (g_jni_cache.jvm && g_jni_cache.jvm != jvm)
+        memset(&g_jni_cache, 0, sizeof(g_jni_cache));
+    pthread_mutex_unlock(&g_jni_lock);
+
     g_jvm = jvm;
     g_jversion = jversion;
 }
@@ -892,17 +588,45 @@ by_void_t by_jni_javavm_set(JavaVM* jvm, by_int_t jversion)
 /* //////////////////////////////////////////////////////////////////////////////////////
  * implementation
  */
+by_void_t by_linker_init()
+{
+    static by_bool_t s_inited = by_false;
+    if (!s_inited)
+    {
+        // we need linker mutex only for android 5.0 and 5.1
+        by_size_t apilevel = by_rt_api_level();
+        if (apilevel == __ANDROID_API_L__ || apilevel == __ANDROID_API_L_MR1__)
+        {
+            by_pointer_t linker = by_elf_dlopen(by_null, 0, BY_LINKER_NAME, BY_RTLD_NOW);
+            by_trace("init linker: %p", linker);
+            if (linker)
+            {
+                g_by_linker_mutex = (pthread_mutex_t*)by_dlsym(linker, BY_LINKER_MUTEX);
+                by_trace("load g_dl_mutex: %p", g_by_linker_mutex);
+                by_dlclose(linker);
+            }
+        }
+        s_inited = by_true;
+    }
+}
 by_pointer_t by_dlopen(by_char_t const* filename, by_int_t flag)
+{
+    return by_dlopen_into(by_null, 0, filename, flag);
+}
+by_pointer_t by_dlopen_into(by_pointer_t storage, by_size_t size, by_char_t const* filename, by_int_t flag)
 {
     // check
     by_assert_and_check_return_val(filename, by_null);
 
+    // init linker
+    by_linker_init();
+
     // attempt to use original dlopen to load it fist
     // TODO we disable the original dlopen now, load /data/xxx.so may be returned an invalid address
     by_pointer_t handle = by_null;//dlopen(filename, flag == BY_RTLD_LAZY? RTLD_LAZY : RTLD_NOW);
 
     // uses the fake dlopen to load it from maps directly
-    if (!handle) handle = (by_pointer_t)by_fake_dlopen(filename, flag);
+    if (!handle) handle = by_elf_dlopen(storage, size, filename, flag);
 
     // uses the fake dlopen to load it from maps directly
     if (!handle)
@@ -910,26 +634,7 @@ by_pointer_t by_dlopen(by_char_t const* filename, by_int_t flag)
         // load it via system call
         JNIEnv* env = by_jni_getenv();
         if (env && (((strstr(filename, "/") || strstr(filename, ".so")) && by_jni_System_load(env, filename)) || by_jni_System_loadLibrary(env, filename)))
-            handle = (by_pointer_t)by_fake_dlopen(filename, flag);
+            handle = by_elf_dlopen(storage, size, filename, flag);
     }
     return handle;
 }
-by_pointer_t by_dlsym(by_pointer_t handle, by_char_t const* symbol)
-{
-    // check
-    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
-    by_assert_and_check_return_val(dlctx && symbol, by_null);
-
-    // do dlsym
-    return (dlctx->magic == BY_FAKE_DLCTX_MAGIC)? by_fake_dlsym(dlctx, symbol) : dlsym(handle, symbol);
-}
-by_int_t by_dlclose(by_pointer_t handle)
-{
-    // check
-    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
-    by_assert_and_check_return_val(dlctx, -1);
-
-    // do dlclose
-    return (dlctx->magic == BY_FAKE_DLCTX_MAGIC)? by_fake_dlclose(dlctx) : dlclose(handle);
-}
-
@@ -0,0 +1,406 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_dlnotify.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_elf.h"
+#include <fnmatch.h>
+#include <stddef.h>
+#include <time.h>
+#include <link.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the library loaded listener type
+typedef struct _by_fake_dlnotify_t
+{
+    // the next listener
+    struct _by_fake_dlnotify_t* next;
+
+    // the listener id
+    by_size_t           id;
+
+    // the callback and user data
+    by_dlnotify_func_t  func;
+    by_pointer_t        udata;
+
+    // the matched module names of the checking and the index of the matched name
+    by_char_t**         names;
+    by_size_t           matched;
+
+    // the notifying thread, is it being called? has it been canceled before being called?
+    pthread_t           thread;
+    by_bool_t           calling;
+    by_bool_t           canceled;
+
+    // the library name pattern
+    by_char_t           pattern[1];
+
+}by_fake_dlnotify_t, *by_fake_dlnotify_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the pending library loaded listeners, they will be removed after being notified
+static by_fake_dlnotify_ref_t g_dlnotify_list = by_null;
+static by_size_t        g_dlnotify_id = 0;
+static pthread_mutex_t  g_dlnotify_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the in-flight listeners, they have been matched and will be notified by the checking thread
+static by_fake_dlnotify_ref_t g_dlnotify_calls = by_null;
+static pthread_cond_t   g_dlnotify_called = PTHREAD_COND_INITIALIZER;
+
+// the load generation of the last check, it's dlpi_adds or the module count if dlpi_adds is not supported
+static by_uint64_t      g_dlnotify_adds = 0;
+
+// the background checking thread
+static pthread_t        g_dlnotify_thread;
+static pthread_cond_t   g_dlnotify_cond = PTHREAD_COND_INITIALIZER;
+static by_bool_t        g_dlnotify_running = by_false;
+static by_size_t        g_dlnotify_interval = 0;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * declaration
+ */
+extern __attribute((weak)) by_int_t dl_iterate_phdr(by_int_t (*)(struct dl_phdr_info*, size_t, by_pointer_t), by_pointer_t);
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+// the callback of dl_iterate_phdr() for getting the load generation
+static by_int_t by_fake_dlnotify_adds_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+{
+    // dlpi_adds is only supported since android 11 and glibc 2.4, we need only read it from the first module
+    by_uint64_t* args = (by_uint64_t*)udata;
+    if (!args[1] && size >= offsetof(struct dl_phdr_info, dlpi_adds) + sizeof(info->dlpi_adds))
+    {
+        args[0] = (by_uint64_t)info->dlpi_adds;
+        return 1;
+    }
+
+    // otherwise, we count all modules and accumulate their addresses
+    args[0] += 1 + ((by_uint64_t)info->dlpi_addr << 16);
+    args[1] = 1;
+    return 0;
+}
+
+// the callback of dl_iterate_phdr() for getting all module names
+static by_int_t by_fake_dlnotify_names_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+{
+    // skip the main program
+    by_check_return_val(info->dlpi_name && info->dlpi_name[0], 0);
+
+    // grow the names
+    by_pointer_t* args = (by_pointer_t*)udata;
+    by_char_t**   names = (by_char_t**)args[0];
+    by_size_t     count = (by_size_t)args[1];
+    by_size_t     maxn = (by_size_t)args[2];
+    if (count == maxn)
+    {
+        maxn = maxn? maxn << 1 : 64;
+        by_char_t** data = realloc(names, maxn * sizeof(by_char_t*));
+        by_check_return_val(data, 1);
+        names = data;
+        args[0] = (by_pointer_t)names;
+        args[2] = (by_pointer_t)maxn;
+    }
+
+    // add name
+    names[count] = strdup(info->dlpi_name);
+    by_check_return_val(names[count], 1);
+    args[1] = (by_pointer_t)(count + 1);
+    return 0;
+}
+
+// is the module name matched with the pattern? we match the basename if the pattern has not any path separator
+static by_bool_t by_fake_dlnotify_match(by_char_t const* pattern, by_char_t const* name)
+{
+    if (!strchr(pattern, '/'))
+    {
+        by_char_t const* basename = strrchr(name, '/');
+        if (basename) name = basename + 1;
+    }
+    return !fnmatch(pattern, name, 0);
+}
+
+// remove the listener from the in-flight list, it need be called in the lock
+static by_void_t by_fake_dlnotify_unlink(by_fake_dlnotify_ref_t listener)
+{
+    by_fake_dlnotify_ref_t* plistener = &g_dlnotify_calls;
+    while (*plistener && *plistener != listener) plistener = &(*plistener)->next;
+    if (*plistener) *plistener = listener->next;
+}
+
+/* check the loaded modules and notify the matched listeners
+ *
+ * we only iterate all modules if the load generation has been changed or it's forced,
+ * and the callbacks are called without lock, so they can register or cancel the other listeners.
+ */
+static by_size_t by_fake_dlnotify_check(by_bool_t force)
+{
+    // no pending listeners?
+    by_check_return_val(__atomic_load_n(&g_dlnotify_list, __ATOMIC_ACQUIRE) && dl_iterate_phdr, 0);
+
+    // has the load generation been changed?
+    by_linker_init();
+    by_uint64_t adds = by_elf_dlnotify_adds();
+    pthread_mutex_lock(&g_dlnotify_lock);
+    by_bool_t changed = adds != g_dlnotify_adds;
+    g_dlnotify_adds = adds;
+    pthread_mutex_unlock(&g_dlnotify_lock);
+    by_check_return_val(changed || force, 0);
+
+    // get all module names
+    by_pointer_t args[3];
+    args[0] = by_null;
+    args[1] = by_null;
+    args[2] = by_null;
+    if (g_by_linker_mutex) pthread_mutex_lock(g_by_linker_mutex);
+    dl_iterate_phdr(by_fake_dlnotify_names_cb, args);
+    if (g_by_linker_mutex) pthread_mutex_unlock(g_by_linker_mutex);
+    by_char_t** names = (by_char_t**)args[0];
+    by_size_t   count = (by_size_t)args[1];
+
+    // move the matched listeners to the in-flight list, so each listener will be notified only once
+    by_size_t i = 0;
+    pthread_mutex_lock(&g_dlnotify_lock);
+    by_fake_dlnotify_ref_t* plistener = &g_dlnotify_list;
+    while (*plistener)
+    {
+        by_fake_dlnotify_ref_t listener = *plistener;
+        for (i = 0; i < count && !by_fake_dlnotify_match(listener->pattern, names[i]); i++) ;
+        if (i < count)
+        {
+            *plistener        = listener->next;
+            listener->next    = g_dlnotify_calls;
+            listener->names   = names;
+            listener->matched = i;
+            g_dlnotify_calls  = listener;
+        }
+        else plistener = &listener->next;
+    }
+
+    // notify them, the callbacks are called without lock
+    by_size_t notified = 0;
+    while (1)
+    {
+        // get the next in-flight listener of this checking
+        by_fake_dlnotify_ref_t listener = g_dlnotify_calls;
+        while (listener && (listener->calling || listener->names != names)) listener = listener->next;
+        by_check_break(listener);
+
+        // it has been canceled before being called
+        if (listener->canceled)
+        {
+            by_fake_dlnotify_unlink(listener);
+            free(listener);
+            continue;
+        }
+        listener->thread  = pthread_self();
+        listener->calling = by_true;
+        pthread_mutex_unlock(&g_dlnotify_lock);
+
+        // open it and notify the listener
+        by_char_t const* name = names[listener->matched];
+        by_pointer_t     handle = by_elf_dlopen(by_null, 0, name, BY_RTLD_NOW);
+        by_trace("dlnotify: %s matched %s, handle: %p", listener->pattern, name, handle);
+        if (handle)
+        {
+            listener->func(handle, name, listener->udata);
+            notified++;
+        }
+
+        // remove it from the in-flight list and wake up the cancelers
+        pthread_mutex_lock(&g_dlnotify_lock);
+        by_fake_dlnotify_unlink(listener);
+        if (handle) free(listener);
+        // we will try it again at the next load if it cannot be opened now
+        else
+        {
+            listener->names   = by_null;
+            listener->calling = by_false;
+            listener->next    = g_dlnotify_list;
+            __atomic_store_n(&g_dlnotify_list, listener, __ATOMIC_RELEASE);
+        }
+        pthread_cond_broadcast(&g_dlnotify_called);
+    }
+    pthread_mutex_unlock(&g_dlnotify_lock);
+
+    // free names
+    for (i = 0; i < count; i++)
+        free(names[i]);
+    if (names) free(names);
+    return notified;
+}
+
+// the background thread of checking the loaded modules
+static by_pointer_t by_fake_dlnotify_loop(by_pointer_t priv)
+{
+    /* it will exit if it's stopped or replaced by the new thread,
+     * because it's detached instead of being joined if it's stopped in the callback
+     */
+    pthread_mutex_lock(&g_dlnotify_lock);
+    while (g_dlnotify_running && pthread_equal(g_dlnotify_thread, pthread_self()))
+    {
+        // wait the next interval or stopping
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec  += g_dlnotify_interval / 1000;
+        ts.tv_nsec += (g_dlnotify_interval % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&g_dlnotify_cond, &g_dlnotify_lock, &ts);
+        by_check_break(g_dlnotify_running && pthread_equal(g_dlnotify_thread, pthread_self()));
+
+        // check it without lock
+        pthread_mutex_unlock(&g_dlnotify_lock);
+        by_fake_dlnotify_check(by_false);
+        pthread_mutex_lock(&g_dlnotify_lock);
+    }
+    pthread_mutex_unlock(&g_dlnotify_lock);
+    return by_null;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_uint64_t by_elf_dlnotify_adds(by_void_t)
+{
+    by_uint64_t args[2] = {0, 0};
+    if (g_by_linker_mutex) pthread_mutex_lock(g_by_linker_mutex);
+    dl_iterate_phdr(by_fake_dlnotify_adds_cb, args);
+    if (g_by_linker_mutex) pthread_mutex_unlock(g_by_linker_mutex);
+    return args[0];
+}
+by_size_t by_on_library_loaded(by_char_t const* pattern, by_dlnotify_func_t func, by_pointer_t udata)
+{
+    // check
+    by_assert_and_check_return_val(pattern && func, 0);
+
+    // make listener
+    by_size_t              size = strlen(pattern);
+    by_fake_dlnotify_ref_t listener = calloc(1, sizeof(by_fake_dlnotify_t) + size);
+    by_check_return_val(listener, 0);
+    listener->func  = func;
+    listener->udata = udata;
+    memcpy(listener->pattern, pattern, size + 1);
+
+    // add it
+    pthread_mutex_lock(&g_dlnotify_lock);
+    listener->id   = ++g_dlnotify_id;
+    listener->next = g_dlnotify_list;
+    __atomic_store_n(&g_dlnotify_list, listener, __ATOMIC_RELEASE);
+    by_size_t id = listener->id;
+    pthread_mutex_unlock(&g_dlnotify_lock);
+
+    // notify it now if the library has been loaded
+    by_fake_dlnotify_check(by_true);
+    return id;
+}
+by_bool_t by_dlnotify_cancel(by_size_t id)
+{
+    by_bool_t ok = by_false;
+    pthread_mutex_lock(&g_dlnotify_lock);
+    while (1)
+    {
+        // remove the pending listener
+        by_fake_dlnotify_ref_t* plistener = &g_dlnotify_list;
+        while (*plistener && (*plistener)->id != id) plistener = &(*plistener)->next;
+        if (*plistener)
+        {
+            by_fake_dlnotify_ref_t listener = *plistener;
+            *plistener = listener->next;
+            free(listener);
+            ok = by_true;
+            break;
+        }
+
+        // find the in-flight listener
+        by_fake_dlnotify_ref_t listener = g_dlnotify_calls;
+        while (listener && listener->id != id) listener = listener->next;
+        by_check_break(listener);
+
+        // suppress it if it has not been called, the checking thread will free it
+        if (!listener->calling)
+        {
+            listener->canceled = by_true;
+            ok = by_true;
+            break;
+        }
+
+        // it's being called in the current thread, e.g. it's canceled in its callback, so we cannot wait it
+        by_check_break(!pthread_equal(listener->thread, pthread_self()));
+
+        // wait for the callback to return, it will be pending again if the library cannot be opened
+        pthread_cond_wait(&g_dlnotify_called, &g_dlnotify_lock);
+    }
+    pthread_mutex_unlock(&g_dlnotify_lock);
+    return ok;
+}
+by_size_t by_dlnotify_poll()
+{
+    return by_fake_dlnotify_check(by_false);
+}
+by_bool_t by_dlnotify_start(by_size_t interval)
+{
+    // check
+    by_assert_and_check_return_val(interval, by_false);
+
+    // start the background thread
+    by_bool_t ok = by_true;
+    pthread_mutex_lock(&g_dlnotify_lock);
+    g_dlnotify_interval = interval;
+    if (!g_dlnotify_running)
+    {
+        g_dlnotify_running = by_true;
+        if (pthread_create(&g_dlnotify_thread, by_null, by_fake_dlnotify_loop, by_null))
+        {
+            g_dlnotify_running = by_false;
+            ok = by_false;
+        }
+    }
+    pthread_mutex_unlock(&g_dlnotify_lock);
+    return ok;
+}
+by_void_t by_dlnotify_stop()
+{
+    // stop the background thread
+    pthread_mutex_lock(&g_dlnotify_lock);
+    by_bool_t running = g_dlnotify_running;
+    pthread_t thread = g_dlnotify_thread;
+    g_dlnotify_running = by_false;
+    pthread_cond_signal(&g_dlnotify_cond);
+    pthread_mutex_unlock(&g_dlnotify_lock);
+
+    // wait it, we cannot join itself if it's stopped in the callback, so we detach it and it will exit after the callback returns
+    if (running)
+    {
+        if (pthread_equal(thread, pthread_self())) pthread_detach(thread);
+        else pthread_join(thread, by_null);
+    }
+}
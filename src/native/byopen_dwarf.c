@@ -0,0 +1,1171 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_dwarf.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_dwarf.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the standard opcodes of the line program
+#define BY_DWARF_LNS_COPY                   (0x01)
+#define BY_DWARF_LNS_ADVANCE_PC             (0x02)
+#define BY_DWARF_LNS_ADVANCE_LINE           (0x03)
+#define BY_DWARF_LNS_SET_FILE               (0x04)
+#define BY_DWARF_LNS_CONST_ADD_PC           (0x08)
+#define BY_DWARF_LNS_FIXED_ADVANCE_PC       (0x09)
+
+// the extended opcodes of the line program
+#define BY_DWARF_LNE_END_SEQUENCE           (0x01)
+#define BY_DWARF_LNE_SET_ADDRESS            (0x02)
+#define BY_DWARF_LNE_DEFINE_FILE            (0x03)
+
+// the content types of the directory and file entries (dwarf 5)
+#define BY_DWARF_LNCT_PATH                  (0x1)
+#define BY_DWARF_LNCT_DIRECTORY_INDEX       (0x2)
+
+// the attribute forms of the directory and file entries (dwarf 5)
+#define BY_DWARF_FORM_DATA2                 (0x05)
+#define BY_DWARF_FORM_DATA4                 (0x06)
+#define BY_DWARF_FORM_DATA8                 (0x07)
+#define BY_DWARF_FORM_STRING                (0x08)
+#define BY_DWARF_FORM_BLOCK                 (0x09)
+#define BY_DWARF_FORM_DATA1                 (0x0b)
+#define BY_DWARF_FORM_SDATA                 (0x0d)
+#define BY_DWARF_FORM_STRP                  (0x0e)
+#define BY_DWARF_FORM_UDATA                 (0x0f)
+#define BY_DWARF_FORM_DATA16                (0x1e)
+#define BY_DWARF_FORM_LINE_STRP             (0x1f)
+
+// the max count of the entry formats (dwarf 5)
+#define BY_DWARF_FORMATS_MAXN               (16)
+
+// the invalid file index
+#define BY_DWARF_FILE_NONE                  ((by_uint32_t)-1)
+
+// the pointer encodings of .eh_frame
+#define BY_DWARF_EH_PE_OMIT                 (0xff)
+#define BY_DWARF_EH_PE_ABSPTR               (0x00)
+#define BY_DWARF_EH_PE_ULEB128              (0x01)
+#define BY_DWARF_EH_PE_UDATA2               (0x02)
+#define BY_DWARF_EH_PE_UDATA4               (0x03)
+#define BY_DWARF_EH_PE_UDATA8               (0x04)
+#define BY_DWARF_EH_PE_SLEB128              (0x09)
+#define BY_DWARF_EH_PE_SDATA2               (0x0a)
+#define BY_DWARF_EH_PE_SDATA4               (0x0b)
+#define BY_DWARF_EH_PE_SDATA8               (0x0c)
+#define BY_DWARF_EH_PE_PCREL                (0x10)
+#define BY_DWARF_EH_PE_DATAREL              (0x30)
+#define BY_DWARF_EH_PE_INDIRECT             (0x80)
+
+// the call frame instructions
+#define BY_DWARF_CFA_ADVANCE_LOC            (0x40)
+#define BY_DWARF_CFA_OFFSET                 (0x80)
+#define BY_DWARF_CFA_RESTORE                (0xc0)
+#define BY_DWARF_CFA_NOP                    (0x00)
+#define BY_DWARF_CFA_SET_LOC                (0x01)
+#define BY_DWARF_CFA_ADVANCE_LOC1           (0x02)
+#define BY_DWARF_CFA_ADVANCE_LOC2           (0x03)
+#define BY_DWARF_CFA_ADVANCE_LOC4           (0x04)
+#define BY_DWARF_CFA_OFFSET_EXTENDED        (0x05)
+#define BY_DWARF_CFA_RESTORE_EXTENDED       (0x06)
+#define BY_DWARF_CFA_UNDEFINED              (0x07)
+#define BY_DWARF_CFA_SAME_VALUE             (0x08)
+#define BY_DWARF_CFA_REGISTER               (0x09)
+#define BY_DWARF_CFA_REMEMBER_STATE         (0x0a)
+#define BY_DWARF_CFA_RESTORE_STATE          (0x0b)
+#define BY_DWARF_CFA_DEF_CFA                (0x0c)
+#define BY_DWARF_CFA_DEF_CFA_REGISTER       (0x0d)
+#define BY_DWARF_CFA_DEF_CFA_OFFSET         (0x0e)
+#define BY_DWARF_CFA_DEF_CFA_EXPRESSION     (0x0f)
+#define BY_DWARF_CFA_EXPRESSION             (0x10)
+#define BY_DWARF_CFA_OFFSET_EXTENDED_SF     (0x11)
+#define BY_DWARF_CFA_DEF_CFA_SF             (0x12)
+#define BY_DWARF_CFA_DEF_CFA_OFFSET_SF      (0x13)
+#define BY_DWARF_CFA_VAL_OFFSET             (0x14)
+#define BY_DWARF_CFA_VAL_OFFSET_SF          (0x15)
+#define BY_DWARF_CFA_VAL_EXPRESSION         (0x16)
+#define BY_DWARF_CFA_AARCH64_NEGATE_RA      (0x2d)
+#define BY_DWARF_CFA_GNU_ARGS_SIZE          (0x2e)
+#define BY_DWARF_CFA_GNU_NEGATIVE_OFFSET    (0x2f)
+
+// the max depth of DW_CFA_remember_state
+#define BY_DWARF_CFA_STACK_MAXN             (8)
+
+// the max size of cie or fde, avoid reading the broken .eh_frame too far
+#define BY_DWARF_CFI_MAXSIZE                (1 << 20)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the dwarf reader type, it will be marked as broken if it's out of range
+typedef struct _by_dwarf_reader_t
+{
+    by_byte_t const*        p;
+    by_byte_t const*        e;
+    by_bool_t               broken;
+
+}by_dwarf_reader_t;
+
+// the directory or file entry of the line program header
+typedef struct _by_dwarf_entry_t
+{
+    // the path
+    by_char_t const*        path;
+
+    // the directory index
+    by_size_t               dir;
+
+    // the file index of the line table, it's made when it's used by rows
+    by_uint32_t             file;
+
+}by_dwarf_entry_t;
+
+// the line program header
+typedef struct _by_dwarf_header_t
+{
+    // the version and the address size
+    by_uint16_t             version;
+    by_size_t               addrsize;
+
+    // is 64bits dwarf?
+    by_bool_t               dwarf64;
+
+    // the line program parameters
+    by_uint8_t              min_inst_length;
+    by_int8_t               line_base;
+    by_uint8_t              line_range;
+    by_uint8_t              opcode_base;
+    by_byte_t const*        opcode_lengths;
+
+    // the directories and files, the entries are reused for all units
+    by_dwarf_entry_t*       entries;
+    by_size_t               entries_maxn;
+    by_size_t               dirs_num;
+    by_size_t               files_num;
+
+}by_dwarf_header_t;
+
+// the common information entry of .eh_frame
+typedef struct _by_dwarf_cie_t
+{
+    // the alignment factors
+    by_size_t               code_align;
+    by_long_t               data_align;
+
+    // the return address register
+    by_size_t               rareg;
+
+    // the pointer encoding of fde
+    by_uint8_t              fde_encoding;
+
+    // has the augmentation data? ("z")
+    by_bool_t               has_augdata;
+
+    // is the signal frame? ("S")
+    by_bool_t               signal;
+
+    // the initial instructions
+    by_byte_t const*        insts;
+    by_byte_t const*        insts_end;
+
+}by_dwarf_cie_t;
+
+// the register rules of the call frame instructions
+typedef struct _by_dwarf_cfa_state_t
+{
+    // the CFA rule, it's not supported if it's defined by the dwarf expression
+    by_size_t               cfa_reg;
+    by_long_t               cfa_offset;
+    by_bool_t               cfa_expr;
+
+    // the rules of the frame pointer and the return address
+    by_uint8_t              rules[2];
+    by_long_t               values[2];
+
+}by_dwarf_cfa_state_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+
+// read the fixed-size value with the native byte order, the dwarf sections are in the loaded library
+static by_uint64_t by_dwarf_read(by_dwarf_reader_t* reader, by_size_t size)
+{
+    if (reader->broken || size > 8 || (by_size_t)(reader->e - reader->p) < size)
+    {
+        reader->broken = by_true;
+        return 0;
+    }
+
+    by_uint64_t value = 0;
+    switch (size)
+    {
+    case 1: value = *reader->p; break;
+    case 2: { by_uint16_t v; memcpy(&v, reader->p, 2); value = v; } break;
+    case 4: { by_uint32_t v; memcpy(&v, reader->p, 4); value = v; } break;
+    case 8: { by_uint64_t v; memcpy(&v, reader->p, 8); value = v; } break;
+    default: reader->broken = by_true; break;
+    }
+    reader->p += size;
+    return value;
+}
+
+// read the unsigned leb128 value
+static by_uint64_t by_dwarf_read_uleb(by_dwarf_reader_t* reader)
+{
+    by_uint64_t value = 0;
+    by_size_t   shift = 0;
+    while (reader->p < reader->e)
+    {
+        by_byte_t b = *reader->p++;
+        if (shift < 64) value |= (by_uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+        if (!(b & 0x80)) return value;
+    }
+    reader->broken = by_true;
+    return 0;
+}
+
+// read the signed leb128 value
+static by_int64_t by_dwarf_read_sleb(by_dwarf_reader_t* reader)
+{
+    by_uint64_t value = 0;
+    by_size_t   shift = 0;
+    while (reader->p < reader->e)
+    {
+        by_byte_t b = *reader->p++;
+        if (shift < 64) value |= (by_uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+        if (!(b & 0x80))
+        {
+            if (shift < 64 && (b & 0x40)) value |= ~(by_uint64_t)0 << shift;
+            return (by_int64_t)value;
+        }
+    }
+    reader->broken = by_true;
+    return 0;
+}
+
+// read the inline string
+static by_char_t const* by_dwarf_read_cstr(by_dwarf_reader_t* reader)
+{
+    by_byte_t const* p = reader->p;
+    by_byte_t const* e = reader->broken? p : memchr(p, '\0', reader->e - p);
+    if (!e)
+    {
+        reader->broken = by_true;
+        return by_null;
+    }
+    reader->p = e + 1;
+    return (by_char_t const*)p;
+}
+
+// get the string of the given section offset
+static by_char_t const* by_dwarf_section_str(by_byte_t const* data, by_size_t size, by_uint64_t offset)
+{
+    by_check_return_val(data && offset < size && memchr(data + offset, '\0', size - offset), by_null);
+    return (by_char_t const*)data + offset;
+}
+
+// read the attribute of the directory or file entry (dwarf 5), the string attribute will be returned
+static by_char_t const* by_dwarf_read_form(by_dwarf_reader_t* reader, by_dwarf_header_t const* header, by_dwarf_sections_t const* sections,
+    by_uint64_t form, by_uint64_t* pvalue)
+{
+    by_size_t offsize = header->dwarf64? 8 : 4;
+    *pvalue = 0;
+    switch (form)
+    {
+    case BY_DWARF_FORM_STRING:      return by_dwarf_read_cstr(reader);
+    case BY_DWARF_FORM_LINE_STRP:   return by_dwarf_section_str(sections->line_str, sections->line_str_size, by_dwarf_read(reader, offsize));
+    case BY_DWARF_FORM_STRP:        return by_dwarf_section_str(sections->str, sections->str_size, by_dwarf_read(reader, offsize));
+    case BY_DWARF_FORM_UDATA:       *pvalue = by_dwarf_read_uleb(reader); break;
+    case BY_DWARF_FORM_SDATA:       *pvalue = (by_uint64_t)by_dwarf_read_sleb(reader); break;
+    case BY_DWARF_FORM_DATA1:       *pvalue = by_dwarf_read(reader, 1); break;
+    case BY_DWARF_FORM_DATA2:       *pvalue = by_dwarf_read(reader, 2); break;
+    case BY_DWARF_FORM_DATA4:       *pvalue = by_dwarf_read(reader, 4); break;
+    case BY_DWARF_FORM_DATA8:       *pvalue = by_dwarf_read(reader, 8); break;
+    case BY_DWARF_FORM_DATA16:      by_dwarf_read(reader, 8); by_dwarf_read(reader, 8); break;
+    case BY_DWARF_FORM_BLOCK:
+        {
+            by_uint64_t size = by_dwarf_read_uleb(reader);
+            if (size > (by_uint64_t)(reader->e - reader->p)) reader->broken = by_true;
+            else reader->p += size;
+        }
+        break;
+    default:
+        // the indexed strings (DW_FORM_strx) need .debug_str_offsets of the compile unit, we do not support it
+        reader->broken = by_true;
+        break;
+    }
+    return by_null;
+}
+
+// add the directory or file entry of the line program header
+static by_dwarf_entry_t* by_dwarf_header_add(by_dwarf_header_t* header)
+{
+    by_size_t count = header->dirs_num + header->files_num;
+    if (count == header->entries_maxn)
+    {
+        by_size_t         maxn = header->entries_maxn? header->entries_maxn << 1 : 64;
+        by_dwarf_entry_t* entries = realloc(header->entries, maxn * sizeof(by_dwarf_entry_t));
+        by_check_return_val(entries, by_null);
+        header->entries      = entries;
+        header->entries_maxn = maxn;
+    }
+    by_dwarf_entry_t* entry = header->entries + count;
+    entry->path = by_null;
+    entry->dir  = 0;
+    entry->file = BY_DWARF_FILE_NONE;
+    return entry;
+}
+
+// read the directory or file entries of dwarf 5
+static by_bool_t by_dwarf_header_entries5(by_dwarf_reader_t* reader, by_dwarf_header_t* header, by_dwarf_sections_t const* sections, by_bool_t isfile)
+{
+    // read the entry formats
+    by_size_t   i = 0;
+    by_uint64_t formats[BY_DWARF_FORMATS_MAXN * 2];
+    by_size_t   formats_num = (by_size_t)by_dwarf_read(reader, 1);
+    by_check_return_val(formats_num <= BY_DWARF_FORMATS_MAXN, by_false);
+    for (i = 0; i < formats_num; i++)
+    {
+        formats[i * 2]     = by_dwarf_read_uleb(reader);
+        formats[i * 2 + 1] = by_dwarf_read_uleb(reader);
+    }
+
+    // read the entries
+    by_uint64_t count = by_dwarf_read_uleb(reader);
+    by_uint64_t n = 0;
+    for (n = 0; n < count && !reader->broken; n++)
+    {
+        by_dwarf_entry_t* entry = by_dwarf_header_add(header);
+        by_check_return_val(entry, by_false);
+
+        for (i = 0; i < formats_num; i++)
+        {
+            by_uint64_t      value = 0;
+            by_char_t const* str = by_dwarf_read_form(reader, header, sections, formats[i * 2 + 1], &value);
+            if (formats[i * 2] == BY_DWARF_LNCT_PATH) entry->path = str;
+            else if (formats[i * 2] == BY_DWARF_LNCT_DIRECTORY_INDEX) entry->dir = (by_size_t)value;
+        }
+        if (isfile) header->files_num++;
+        else header->dirs_num++;
+    }
+    return !reader->broken;
+}
+
+// read the directories and files of dwarf 2 - 4
+static by_bool_t by_dwarf_header_entries(by_dwarf_reader_t* reader, by_dwarf_header_t* header)
+{
+    // read the include directories, the directory 0 is the compilation directory and it's not listed
+    by_dwarf_entry_t* entry = by_dwarf_header_add(header);
+    by_check_return_val(entry, by_false);
+    header->dirs_num++;
+    while (!reader->broken)
+    {
+        by_char_t const* path = by_dwarf_read_cstr(reader);
+        by_check_break(path && *path);
+
+        entry = by_dwarf_header_add(header);
+        by_check_return_val(entry, by_false);
+        entry->path = path;
+        header->dirs_num++;
+    }
+
+    // read the files, the file index starts from 1
+    while (!reader->broken)
+    {
+        by_char_t const* path = by_dwarf_read_cstr(reader);
+        by_check_break(path && *path);
+
+        entry = by_dwarf_header_add(header);
+        by_check_return_val(entry, by_false);
+        entry->path = path;
+        entry->dir  = (by_size_t)by_dwarf_read_uleb(reader);
+        by_dwarf_read_uleb(reader);
+        by_dwarf_read_uleb(reader);
+        header->files_num++;
+    }
+    return !reader->broken;
+}
+
+// append the data to the names pool
+static by_bool_t by_dwarf_lines_names_add(by_dwarf_lines_ref_t lines, by_char_t const* data, by_size_t size)
+{
+    if (lines->names_size + size > lines->names_maxn)
+    {
+        by_size_t  maxn = lines->names_maxn? lines->names_maxn : 4096;
+        while (maxn < lines->names_size + size) maxn <<= 1;
+        by_char_t* names = realloc(lines->names, maxn);
+        by_check_return_val(names, by_false);
+        lines->names      = names;
+        lines->names_maxn = maxn;
+    }
+    memcpy(lines->names + lines->names_size, data, size);
+    lines->names_size += size;
+    return by_true;
+}
+
+// get the file index of the line table for the given file entry, the full path is added to the names pool at first use
+static by_uint32_t by_dwarf_lines_file(by_dwarf_lines_ref_t lines, by_dwarf_header_t* header, by_uint64_t fileidx)
+{
+    // get the file entry, the file index starts from 0 since dwarf 5
+    if (header->version < 5)
+    {
+        by_check_return_val(fileidx, BY_DWARF_FILE_NONE);
+        fileidx--;
+    }
+    by_check_return_val(fileidx < header->files_num, BY_DWARF_FILE_NONE);
+    by_dwarf_entry_t* entry = header->entries + header->dirs_num + fileidx;
+    by_check_return_val(entry->path, BY_DWARF_FILE_NONE);
+    if (entry->file != BY_DWARF_FILE_NONE) return entry->file;
+
+    // grow files
+    if (lines->files_num == lines->files_maxn)
+    {
+        by_size_t    maxn = lines->files_maxn? lines->files_maxn << 1 : 256;
+        by_uint32_t* files = realloc(lines->files, maxn * sizeof(by_uint32_t));
+        by_check_return_val(files, BY_DWARF_FILE_NONE);
+        lines->files      = files;
+        lines->files_maxn = maxn;
+    }
+
+    // add the full path, e.g. dir/file.c
+    by_size_t        offset = lines->names_size;
+    by_char_t const* dir = entry->path[0] != '/' && entry->dir < header->dirs_num? header->entries[entry->dir].path : by_null;
+    if (dir && *dir)
+    {
+        by_check_return_val(by_dwarf_lines_names_add(lines, dir, strlen(dir)), BY_DWARF_FILE_NONE);
+        by_check_return_val(by_dwarf_lines_names_add(lines, "/", 1), BY_DWARF_FILE_NONE);
+    }
+    by_check_return_val(by_dwarf_lines_names_add(lines, entry->path, strlen(entry->path) + 1), BY_DWARF_FILE_NONE);
+    lines->files[lines->files_num] = (by_uint32_t)offset;
+    entry->file = (by_uint32_t)lines->files_num++;
+    return entry->file;
+}
+
+// add the row to the line table
+static by_bool_t by_dwarf_lines_add(by_dwarf_lines_ref_t lines, by_size_t sequence, by_size_t addr, by_uint32_t file, by_uint32_t line)
+{
+    /* we only keep the last row of the same address in the sequence, it's the row of the first instruction (e.g. the inlined callee),
+     * and the end of sequence also replaces the previous empty row.
+     */
+    if (lines->rows_num > sequence && lines->rows[lines->rows_num - 1].addr == addr)
+        lines->rows_num--;
+
+    // grow rows
+    if (lines->rows_num == lines->rows_maxn)
+    {
+        by_size_t       maxn = lines->rows_maxn? lines->rows_maxn << 1 : 4096;
+        by_dwarf_row_t* rows = realloc(lines->rows, maxn * sizeof(by_dwarf_row_t));
+        by_check_return_val(rows, by_false);
+        lines->rows      = rows;
+        lines->rows_maxn = maxn;
+    }
+
+    // add row
+    by_dwarf_row_t* row = lines->rows + lines->rows_num++;
+    row->addr = addr;
+    row->file = file;
+    row->line = line;
+    return by_true;
+}
+
+// run the line program of the unit
+static by_bool_t by_dwarf_lines_program(by_dwarf_lines_ref_t lines, by_dwarf_header_t* header, by_dwarf_reader_t* reader)
+{
+    // init the state machine
+    by_size_t   addr = 0;
+    by_uint64_t file = 1;
+    by_int64_t  line = 1;
+    by_size_t   sequence = lines->rows_num;
+    by_size_t   min_inst_length = header->min_inst_length;
+    while (reader->p < reader->e && !reader->broken)
+    {
+        by_bool_t emit = by_false;
+        by_bool_t end = by_false;
+        by_uint8_t opcode = (by_uint8_t)by_dwarf_read(reader, 1);
+        if (opcode >= header->opcode_base)
+        {
+            // the special opcode advances address and line, and then appends a row
+            by_uint8_t adjusted = opcode - header->opcode_base;
+            addr += (adjusted / header->line_range) * min_inst_length;
+            line += header->line_base + (adjusted % header->line_range);
+            emit = by_true;
+        }
+        else if (!opcode)
+        {
+            // the extended opcode
+            by_uint64_t      size = by_dwarf_read_uleb(reader);
+            by_byte_t const* next = reader->p + size;
+            by_check_return_val(!reader->broken && size && size <= (by_uint64_t)(reader->e - reader->p), by_false);
+            switch (by_dwarf_read(reader, 1))
+            {
+            case BY_DWARF_LNE_END_SEQUENCE:
+                emit = by_true;
+                end = by_true;
+                break;
+            case BY_DWARF_LNE_SET_ADDRESS:
+                addr = (by_size_t)by_dwarf_read(reader, (by_size_t)size - 1);
+                break;
+            default:
+                // we ignore DW_LNE_define_file, it's never used by the modern compilers
+                break;
+            }
+            reader->p = next;
+        }
+        else
+        {
+            // the standard opcodes
+            switch (opcode)
+            {
+            case BY_DWARF_LNS_COPY:
+                emit = by_true;
+                break;
+            case BY_DWARF_LNS_ADVANCE_PC:
+                addr += (by_size_t)by_dwarf_read_uleb(reader) * min_inst_length;
+                break;
+            case BY_DWARF_LNS_ADVANCE_LINE:
+                line += by_dwarf_read_sleb(reader);
+                break;
+            case BY_DWARF_LNS_SET_FILE:
+                file = by_dwarf_read_uleb(reader);
+                break;
+            case BY_DWARF_LNS_CONST_ADD_PC:
+                addr += ((255 - header->opcode_base) / header->line_range) * min_inst_length;
+                break;
+            case BY_DWARF_LNS_FIXED_ADVANCE_PC:
+                addr += (by_size_t)by_dwarf_read(reader, 2);
+                break;
+            default:
+                {
+                    // skip the operands of the other standard opcodes, e.g. DW_LNS_set_column
+                    by_size_t n = header->opcode_lengths[opcode - 1];
+                    while (n--) by_dwarf_read_uleb(reader);
+                }
+                break;
+            }
+        }
+        by_check_continue(emit);
+
+        // append row, the row of the invalid file is regarded as the end of range
+        by_uint32_t fileid = end? BY_DWARF_FILE_NONE : by_dwarf_lines_file(lines, header, file);
+        by_uint32_t lineno = end || fileid == BY_DWARF_FILE_NONE || line <= 0? 0 : (by_uint32_t)line;
+        by_check_return_val(by_dwarf_lines_add(lines, sequence, addr, fileid, lineno), by_false);
+
+        // end of sequence?
+        if (end)
+        {
+            /* the sequence of the discarded function is relocated to 0 or -1 (tombstone),
+             * we drop it, because it overlaps the real code.
+             */
+            if (lines->rows_num > sequence && (!lines->rows[sequence].addr || lines->rows[sequence].addr == (by_size_t)-1))
+                lines->rows_num = sequence;
+            sequence = lines->rows_num;
+            addr = 0;
+            file = 1;
+            line = 1;
+        }
+    }
+    return !reader->broken;
+}
+
+// parse the line program unit
+static by_bool_t by_dwarf_lines_unit(by_dwarf_lines_ref_t lines, by_dwarf_header_t* header, by_dwarf_sections_t const* sections, by_dwarf_reader_t* reader)
+{
+    // read the version
+    header->version = (by_uint16_t)by_dwarf_read(reader, 2);
+    by_check_return_val(header->version >= 2 && header->version <= 5, by_false);
+
+    // read the address size
+    header->addrsize = sections->addrsize;
+    if (header->version >= 5)
+    {
+        header->addrsize = (by_size_t)by_dwarf_read(reader, 1);
+        by_check_return_val(!by_dwarf_read(reader, 1), by_false);
+    }
+
+    // get the line program range
+    by_uint64_t header_length = by_dwarf_read(reader, header->dwarf64? 8 : 4);
+    by_check_return_val(!reader->broken && header_length <= (by_uint64_t)(reader->e - reader->p), by_false);
+    by_dwarf_reader_t program;
+    program.p      = reader->p + header_length;
+    program.e      = reader->e;
+    program.broken = by_false;
+
+    // read the line program parameters
+    header->min_inst_length = (by_uint8_t)by_dwarf_read(reader, 1);
+    if (header->version >= 4) by_dwarf_read(reader, 1);
+    by_dwarf_read(reader, 1);
+    header->line_base       = (by_int8_t)by_dwarf_read(reader, 1);
+    header->line_range      = (by_uint8_t)by_dwarf_read(reader, 1);
+    header->opcode_base     = (by_uint8_t)by_dwarf_read(reader, 1);
+    header->opcode_lengths  = reader->p;
+    by_check_return_val(!reader->broken && header->line_range && header->opcode_base, by_false);
+    by_check_return_val((by_size_t)(reader->e - reader->p) >= (by_size_t)header->opcode_base - 1, by_false);
+    reader->p += header->opcode_base - 1;
+
+    // read the directories and files
+    header->dirs_num  = 0;
+    header->files_num = 0;
+    if (header->version >= 5)
+    {
+        by_check_return_val(by_dwarf_header_entries5(reader, header, sections, by_false), by_false);
+        by_check_return_val(by_dwarf_header_entries5(reader, header, sections, by_true), by_false);
+    }
+    else by_check_return_val(by_dwarf_header_entries(reader, header), by_false);
+
+    // run the line program
+    return by_dwarf_lines_program(lines, header, &program);
+}
+
+// the row comparator, the end of sequence is in front of the row with the same address
+static by_int_t by_dwarf_row_comp(by_cpointer_t a, by_cpointer_t b)
+{
+    by_dwarf_row_t const* ra = (by_dwarf_row_t const*)a;
+    by_dwarf_row_t const* rb = (by_dwarf_row_t const*)b;
+    if (ra->addr != rb->addr) return ra->addr < rb->addr? -1 : 1;
+    return (ra->line != 0) - (rb->line != 0);
+}
+
+// find the row index (upper bound) of the given address from the given position
+static by_size_t by_dwarf_lines_upper(by_dwarf_lines_ref_t lines, by_size_t from, by_size_t addr)
+{
+    // gallop from the given position, the sorted queries are usually close to each other
+    by_size_t l = from;
+    by_size_t r = from;
+    by_size_t step = 1;
+    while (r < lines->rows_num && lines->rows[r].addr <= addr)
+    {
+        l = r + 1;
+        r = from + step;
+        step <<= 1;
+    }
+    if (r > lines->rows_num) r = lines->rows_num;
+
+    // find it in [l, r)
+    while (l < r)
+    {
+        by_size_t m = l + ((r - l) >> 1);
+        if (lines->rows[m].addr <= addr) l = m + 1;
+        else r = m;
+    }
+    return l;
+}
+
+// read the encoded pointer of .eh_frame, the datarel pointer is relative to the given base address
+static by_size_t by_dwarf_read_encoded(by_dwarf_reader_t* reader, by_uint8_t encoding, by_size_t database)
+{
+    by_byte_t const* p = reader->p;
+    by_size_t        value = 0;
+    switch (encoding & 0x0f)
+    {
+    case BY_DWARF_EH_PE_ABSPTR:     value = (by_size_t)by_dwarf_read(reader, sizeof(by_size_t)); break;
+    case BY_DWARF_EH_PE_ULEB128:    value = (by_size_t)by_dwarf_read_uleb(reader); break;
+    case BY_DWARF_EH_PE_UDATA2:     value = (by_size_t)by_dwarf_read(reader, 2); break;
+    case BY_DWARF_EH_PE_UDATA4:     value = (by_size_t)by_dwarf_read(reader, 4); break;
+    case BY_DWARF_EH_PE_UDATA8:     value = (by_size_t)by_dwarf_read(reader, 8); break;
+    case BY_DWARF_EH_PE_SLEB128:    value = (by_size_t)by_dwarf_read_sleb(reader); break;
+    case BY_DWARF_EH_PE_SDATA2:     value = (by_size_t)(by_long_t)(by_int16_t)by_dwarf_read(reader, 2); break;
+    case BY_DWARF_EH_PE_SDATA4:     value = (by_size_t)(by_long_t)(by_int32_t)by_dwarf_read(reader, 4); break;
+    case BY_DWARF_EH_PE_SDATA8:     value = (by_size_t)by_dwarf_read(reader, 8); break;
+    default:                        reader->broken = by_true; break;
+    }
+    switch (encoding & 0x70)
+    {
+    case 0:                         break;
+    case BY_DWARF_EH_PE_PCREL:      value += (by_size_t)p; break;
+    case BY_DWARF_EH_PE_DATAREL:    value += database; break;
+    default:                        reader->broken = by_true; break;
+    }
+    return value;
+}
+
+// set the register rule, we only keep the rules of the frame pointer and the return address
+static __inline__ by_void_t by_dwarf_cfa_rule(by_dwarf_cfa_state_t* state, by_size_t fpreg, by_size_t rareg, by_uint64_t reg, by_uint8_t rule, by_long_t value)
+{
+    by_int_t i = reg == fpreg? 0 : (reg == rareg? 1 : -1);
+    if (i >= 0)
+    {
+        state->rules[i]  = rule;
+        state->values[i] = value;
+    }
+}
+
+// restore the register rule to the initial rule of cie
+static __inline__ by_void_t by_dwarf_cfa_restore(by_dwarf_cfa_state_t* state, by_dwarf_cfa_state_t const* initial, by_size_t fpreg, by_size_t rareg, by_uint64_t reg)
+{
+    by_int_t i = reg == fpreg? 0 : (reg == rareg? 1 : -1);
+    if (i >= 0)
+    {
+        state->rules[i]  = initial? initial->rules[i] : BY_DWARF_RULE_SAME;
+        state->values[i] = initial? initial->values[i] : 0;
+    }
+}
+
+/* run the call frame instructions until the location is greater than pc
+ *
+ * @see https://dwarfstd.org/doc/DWARF5.pdf (6.4.2 Call Frame Instructions)
+ */
+static by_bool_t by_dwarf_cfa_run(by_dwarf_cie_t const* cie, by_byte_t const* insts, by_byte_t const* insts_end, by_size_t loc, by_size_t pc,
+    by_size_t fpreg, by_size_t rareg, by_dwarf_cfa_state_t* state, by_dwarf_cfa_state_t const* initial)
+{
+    by_size_t            depth = 0;
+    by_dwarf_cfa_state_t stack[BY_DWARF_CFA_STACK_MAXN];
+    by_dwarf_reader_t    reader;
+    reader.p      = insts;
+    reader.e      = insts_end;
+    reader.broken = by_false;
+    while (reader.p < reader.e && !reader.broken)
+    {
+        by_uint8_t  opcode = (by_uint8_t)by_dwarf_read(&reader, 1);
+        by_uint64_t reg = 0;
+        switch (opcode & 0xc0)
+        {
+        case BY_DWARF_CFA_ADVANCE_LOC:
+            loc += (opcode & 0x3f) * cie->code_align;
+            by_check_return_val(loc <= pc, by_true);
+            continue;
+        case BY_DWARF_CFA_OFFSET:
+            reg = opcode & 0x3f;
+            by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_OFFSET, (by_long_t)by_dwarf_read_uleb(&reader) * cie->data_align);
+            continue;
+        case BY_DWARF_CFA_RESTORE:
+            by_dwarf_cfa_restore(state, initial, fpreg, rareg, opcode & 0x3f);
+            continue;
+        default:
+            break;
+        }
+
+        switch (opcode)
+        {
+        case BY_DWARF_CFA_NOP:
+        case BY_DWARF_CFA_AARCH64_NEGATE_RA:
+            // the return address signed by pointer authentication is stripped by the caller
+            break;
+        case BY_DWARF_CFA_SET_LOC:
+            loc = by_dwarf_read_encoded(&reader, cie->fde_encoding, 0);
+            by_check_return_val(loc <= pc, by_true);
+            break;
+        case BY_DWARF_CFA_ADVANCE_LOC1:
+        case BY_DWARF_CFA_ADVANCE_LOC2:
+        case BY_DWARF_CFA_ADVANCE_LOC4:
+            loc += (by_size_t)by_dwarf_read(&reader, opcode == BY_DWARF_CFA_ADVANCE_LOC1? 1 : (opcode == BY_DWARF_CFA_ADVANCE_LOC2? 2 : 4)) * cie->code_align;
+            by_check_return_val(loc <= pc, by_true);
+            break;
+        case BY_DWARF_CFA_OFFSET_EXTENDED:
+            reg = by_dwarf_read_uleb(&reader);
+            by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_OFFSET, (by_long_t)by_dwarf_read_uleb(&reader) * cie->data_align);
+            break;
+        case BY_DWARF_CFA_OFFSET_EXTENDED_SF:
+            reg = by_dwarf_read_uleb(&reader);
+            by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_OFFSET, (by_long_t)by_dwarf_read_sleb(&reader) * cie->data_align);
+            break;
+        case BY_DWARF_CFA_GNU_NEGATIVE_OFFSET:
+            reg = by_dwarf_read_uleb(&reader);
+            by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_OFFSET, -(by_long_t)by_dwarf_read_uleb(&reader) * cie->data_align);
+            break;
+        case BY_DWARF_CFA_VAL_OFFSET:
+            reg = by_dwarf_read_uleb(&reader);
+            by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_VAL_OFFSET, (by_long_t)by_dwarf_read_uleb(&reader) * cie->data_align);
+            break;
+        case BY_DWARF_CFA_VAL_OFFSET_SF:
+            reg = by_dwarf_read_uleb(&reader);
+            by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_VAL_OFFSET, (by_long_t)by_dwarf_read_sleb(&reader) * cie->data_align);
+            break;
+        case BY_DWARF_CFA_RESTORE_EXTENDED:
+            by_dwarf_cfa_restore(state, initial, fpreg, rareg, by_dwarf_read_uleb(&reader));
+            break;
+        case BY_DWARF_CFA_UNDEFINED:
+            by_dwarf_cfa_rule(state, fpreg, rareg, by_dwarf_read_uleb(&reader), BY_DWARF_RULE_UNDEFINED, 0);
+            break;
+        case BY_DWARF_CFA_SAME_VALUE:
+            by_dwarf_cfa_rule(state, fpreg, rareg, by_dwarf_read_uleb(&reader), BY_DWARF_RULE_SAME, 0);
+            break;
+        case BY_DWARF_CFA_REGISTER:
+            reg = by_dwarf_read_uleb(&reader);
+            by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_REGISTER, (by_long_t)by_dwarf_read_uleb(&reader));
+            break;
+        case BY_DWARF_CFA_REMEMBER_STATE:
+            by_check_return_val(depth < BY_DWARF_CFA_STACK_MAXN, by_false);
+            stack[depth++] = *state;
+            break;
+        case BY_DWARF_CFA_RESTORE_STATE:
+            by_check_return_val(depth, by_false);
+            *state = stack[--depth];
+            break;
+        case BY_DWARF_CFA_DEF_CFA:
+            state->cfa_reg    = (by_size_t)by_dwarf_read_uleb(&reader);
+            state->cfa_offset = (by_long_t)by_dwarf_read_uleb(&reader);
+            state->cfa_expr   = by_false;
+            break;
+        case BY_DWARF_CFA_DEF_CFA_SF:
+            state->cfa_reg    = (by_size_t)by_dwarf_read_uleb(&reader);
+            state->cfa_offset = (by_long_t)by_dwarf_read_sleb(&reader) * cie->data_align;
+            state->cfa_expr   = by_false;
+            break;
+        case BY_DWARF_CFA_DEF_CFA_REGISTER:
+            state->cfa_reg    = (by_size_t)by_dwarf_read_uleb(&reader);
+            state->cfa_expr   = by_false;
+            break;
+        case BY_DWARF_CFA_DEF_CFA_OFFSET:
+            state->cfa_offset = (by_long_t)by_dwarf_read_uleb(&reader);
+            break;
+        case BY_DWARF_CFA_DEF_CFA_OFFSET_SF:
+            state->cfa_offset = (by_long_t)by_dwarf_read_sleb(&reader) * cie->data_align;
+            break;
+        case BY_DWARF_CFA_DEF_CFA_EXPRESSION:
+            {
+                // we do not support the dwarf expression, e.g. the stack realignment and the signal trampoline
+                by_uint64_t size = by_dwarf_read_uleb(&reader);
+                by_check_return_val(size <= (by_uint64_t)(reader.e - reader.p), by_false);
+                reader.p += size;
+                state->cfa_expr = by_true;
+            }
+            break;
+        case BY_DWARF_CFA_EXPRESSION:
+        case BY_DWARF_CFA_VAL_EXPRESSION:
+            {
+                reg = by_dwarf_read_uleb(&reader);
+                by_uint64_t size = by_dwarf_read_uleb(&reader);
+                by_check_return_val(size <= (by_uint64_t)(reader.e - reader.p), by_false);
+                reader.p += size;
+                by_dwarf_cfa_rule(state, fpreg, rareg, reg, BY_DWARF_RULE_UNSUPPORTED, 0);
+            }
+            break;
+        case BY_DWARF_CFA_GNU_ARGS_SIZE:
+            by_dwarf_read_uleb(&reader);
+            break;
+        default:
+            return by_false;
+        }
+    }
+    return !reader.broken;
+}
+
+// get the cie or fde range, it returns the content after the length field
+static by_byte_t const* by_dwarf_cfi_entry(by_byte_t const* p, by_byte_t const** pend)
+{
+    by_uint32_t length = 0;
+    memcpy(&length, p, 4);
+    p += 4;
+    if (length == 0xffffffff)
+    {
+        by_uint64_t length64 = 0;
+        memcpy(&length64, p, 8);
+        p += 8;
+        by_check_return_val(length64 && length64 <= BY_DWARF_CFI_MAXSIZE, by_null);
+        *pend = p + length64;
+    }
+    else
+    {
+        by_check_return_val(length && length <= BY_DWARF_CFI_MAXSIZE, by_null);
+        *pend = p + length;
+    }
+    return p;
+}
+
+// parse the cie of .eh_frame
+static by_bool_t by_dwarf_cie_parse(by_byte_t const* data, by_dwarf_cie_t* cie)
+{
+    // get the cie range, the cie id is 0 in .eh_frame
+    by_byte_t const*  end = by_null;
+    by_byte_t const*  p = by_dwarf_cfi_entry(data, &end);
+    by_check_return_val(p, by_false);
+    by_dwarf_reader_t reader;
+    reader.p      = p;
+    reader.e      = end;
+    reader.broken = by_false;
+    by_check_return_val(by_dwarf_read(&reader, 4) == 0, by_false);
+
+    // get the version and augmentation
+    by_size_t        version = (by_size_t)by_dwarf_read(&reader, 1);
+    by_char_t const* augmentation = by_dwarf_read_cstr(&reader);
+    by_check_return_val(augmentation && (version == 1 || version == 3 || version == 4), by_false);
+    if (augmentation[0] == 'e' && augmentation[1] == 'h')
+    {
+        by_dwarf_read(&reader, sizeof(by_size_t));
+        augmentation += 2;
+    }
+    if (version == 4)
+    {
+        // skip address_size and segment_selector_size
+        by_dwarf_read(&reader, 2);
+    }
+    cie->code_align   = (by_size_t)by_dwarf_read_uleb(&reader);
+    cie->data_align   = (by_long_t)by_dwarf_read_sleb(&reader);
+    cie->rareg        = version == 1? (by_size_t)by_dwarf_read(&reader, 1) : (by_size_t)by_dwarf_read_uleb(&reader);
+    cie->fde_encoding = BY_DWARF_EH_PE_ABSPTR;
+    cie->has_augdata  = augmentation[0] == 'z';
+    cie->signal       = by_false;
+
+    // parse the augmentation data
+    if (cie->has_augdata)
+    {
+        by_uint64_t size = by_dwarf_read_uleb(&reader);
+        by_check_return_val(!reader.broken && size <= (by_uint64_t)(reader.e - reader.p), by_false);
+        by_byte_t const* augend = reader.p + size;
+        by_char_t const* a = augmentation + 1;
+        for (; *a && !reader.broken; a++)
+        {
+            if (*a == 'R') cie->fde_encoding = (by_uint8_t)by_dwarf_read(&reader, 1);
+            else if (*a == 'L') by_dwarf_read(&reader, 1);
+            else if (*a == 'P')
+            {
+                // skip the personality routine, we need not dereference it
+                by_uint8_t encoding = (by_uint8_t)by_dwarf_read(&reader, 1);
+                by_dwarf_read_encoded(&reader, encoding & ~BY_DWARF_EH_PE_INDIRECT, 0);
+            }
+            else if (*a == 'S') cie->signal = by_true;
+            else if (*a != 'B' && *a != 'G') break;
+        }
+        reader.p = augend;
+    }
+    else by_check_return_val(!augmentation[0], by_false);
+
+    // get the initial instructions
+    cie->insts     = reader.p;
+    cie->insts_end = end;
+    return !reader.broken;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_dwarf_lines_init(by_dwarf_lines_ref_t lines, by_dwarf_sections_t const* sections)
+{
+    // check
+    by_assert_and_check_return_val(lines && sections && sections->line, by_false);
+
+    // init lines
+    memset(lines, 0, sizeof(by_dwarf_lines_t));
+
+    // parse all units
+    by_bool_t         ok = by_true;
+    by_dwarf_header_t header;
+    by_dwarf_reader_t reader;
+    memset(&header, 0, sizeof(header));
+    reader.p      = sections->line;
+    reader.e      = sections->line + sections->line_size;
+    reader.broken = by_false;
+    while (reader.p < reader.e && !reader.broken)
+    {
+        // get the unit range
+        by_uint64_t length = by_dwarf_read(&reader, 4);
+        header.dwarf64 = length == 0xffffffff;
+        if (header.dwarf64) length = by_dwarf_read(&reader, 8);
+        by_check_break(!reader.broken && length <= (by_uint64_t)(reader.e - reader.p));
+
+        // parse unit, we skip the broken unit
+        by_dwarf_reader_t unit;
+        unit.p      = reader.p;
+        unit.e      = reader.p + length;
+        unit.broken = by_false;
+        by_size_t rows_num = lines->rows_num;
+        if (!by_dwarf_lines_unit(lines, &header, sections, &unit))
+        {
+            by_trace("dwarf: skip the broken line program at %lu", (by_ulong_t)(reader.p - sections->line));
+            lines->rows_num = rows_num;
+        }
+        reader.p = unit.e;
+    }
+    if (header.entries) free(header.entries);
+
+    // sort rows, they are usually sorted if the sequences are in the address order
+    by_size_t i = 1;
+    while (i < lines->rows_num && by_dwarf_row_comp(lines->rows + i - 1, lines->rows + i) <= 0) i++;
+    if (i < lines->rows_num) qsort(lines->rows, lines->rows_num, sizeof(by_dwarf_row_t), by_dwarf_row_comp);
+
+    // shrink rows
+    if (lines->rows_num < lines->rows_maxn)
+    {
+        by_dwarf_row_t* rows = realloc(lines->rows, (lines->rows_num? lines->rows_num : 1) * sizeof(by_dwarf_row_t));
+        if (rows)
+        {
+            lines->rows      = rows;
+            lines->rows_maxn = lines->rows_num;
+        }
+    }
+
+    // trace
+    by_trace("dwarf: %lu rows, %lu files, names: %lu bytes", (by_ulong_t)lines->rows_num, (by_ulong_t)lines->files_num, (by_ulong_t)lines->names_size);
+    return ok;
+}
+by_void_t by_dwarf_lines_exit(by_dwarf_lines_ref_t lines)
+{
+    // check
+    by_assert_and_check_return(lines);
+
+    if (lines->rows) free(lines->rows);
+    if (lines->files) free(lines->files);
+    if (lines->names) free(lines->names);
+    memset(lines, 0, sizeof(by_dwarf_lines_t));
+}
+by_bool_t by_dwarf_lines_find(by_dwarf_lines_ref_t lines, by_size_t addr, by_char_t const** pfile, by_size_t* pline)
+{
+    // check
+    by_assert_and_check_return_val(lines, by_false);
+
+    // find the last row in front of the given address, it's not found if it's the end of sequence
+    by_size_t i = by_dwarf_lines_upper(lines, 0, addr);
+    by_check_return_val(i && lines->rows[i - 1].line, by_false);
+
+    by_dwarf_row_t const* row = lines->rows + i - 1;
+    if (pfile) *pfile = lines->names + lines->files[row->file];
+    if (pline) *pline = row->line;
+    return by_true;
+}
+by_size_t by_dwarf_lines_find_sorted(by_dwarf_lines_ref_t lines, by_dwarf_query_t const* queries, by_size_t count, by_char_t const** files, by_size_t* plines)
+{
+    // check
+    by_assert_and_check_return_val(lines && queries, 0);
+
+    // find them in one merge pass
+    by_size_t i = 0;
+    by_size_t pos = 0;
+    by_size_t found = 0;
+    for (i = 0; i < count; i++)
+    {
+        by_dwarf_query_t const* query = queries + i;
+        pos = by_dwarf_lines_upper(lines, pos, query->addr);
+        by_dwarf_row_t const* row = pos? lines->rows + pos - 1 : by_null;
+        if (row && row->line)
+        {
+            if (files) files[query->index] = lines->names + lines->files[row->file];
+            if (plines) plines[query->index] = row->line;
+            found++;
+        }
+        else
+        {
+            if (files) files[query->index] = by_null;
+            if (plines) plines[query->index] = 0;
+        }
+    }
+    return found;
+}
+by_int_t by_dwarf_query_comp(by_cpointer_t a, by_cpointer_t b)
+{
+    by_size_t aa = ((by_dwarf_query_t const*)a)->addr;
+    by_size_t ba = ((by_dwarf_query_t const*)b)->addr;
+    return aa < ba? -1 : (aa > ba);
+}
+by_bool_t by_dwarf_ehhdr_init(by_dwarf_ehhdr_t* ehhdr, by_cpointer_t data)
+{
+    // check
+    by_assert_and_check_return_val(ehhdr && data, by_false);
+
+    // parse header, the header fields are at most 4 + 8 * 2 bytes
+    by_byte_t const*  hdr = (by_byte_t const*)data;
+    by_dwarf_reader_t reader;
+    reader.p      = hdr;
+    reader.e      = hdr + 4 + 16;
+    reader.broken = by_false;
+    by_uint8_t version          = (by_uint8_t)by_dwarf_read(&reader, 1);
+    by_uint8_t eh_frame_ptr_enc = (by_uint8_t)by_dwarf_read(&reader, 1);
+    by_uint8_t fde_count_enc    = (by_uint8_t)by_dwarf_read(&reader, 1);
+    by_uint8_t table_enc        = (by_uint8_t)by_dwarf_read(&reader, 1);
+    by_check_return_val(version == 1 && eh_frame_ptr_enc != BY_DWARF_EH_PE_OMIT && fde_count_enc != BY_DWARF_EH_PE_OMIT, by_false);
+    by_check_return_val(table_enc == (BY_DWARF_EH_PE_DATAREL | BY_DWARF_EH_PE_SDATA4), by_false);
+
+    // get the binary search table
+    by_dwarf_read_encoded(&reader, eh_frame_ptr_enc, (by_size_t)hdr);
+    by_size_t count = by_dwarf_read_encoded(&reader, fde_count_enc, (by_size_t)hdr);
+    by_check_return_val(!reader.broken && count, by_false);
+    ehhdr->hdr   = hdr;
+    ehhdr->table = reader.p;
+    ehhdr->count = count;
+    return by_true;
+}
+by_bool_t by_dwarf_ehhdr_frame(by_dwarf_ehhdr_t const* ehhdr, by_size_t pc, by_size_t fpreg, by_size_t rareg, by_dwarf_frame_t* frame)
+{
+    // check
+    by_assert_and_check_return_val(ehhdr && ehhdr->table && frame, by_false);
+
+    // find the last fde whose initial location <= pc, the entries are (initial_loc, fde) relative to .eh_frame_hdr
+    by_size_t   l = 0;
+    by_size_t   r = ehhdr->count;
+    by_int32_t  entry[2];
+    by_size_t   hdr = (by_size_t)ehhdr->hdr;
+    while (l < r)
+    {
+        by_size_t m = l + ((r - l) >> 1);
+        memcpy(entry, ehhdr->table + m * 8, 4);
+        if (hdr + (by_long_t)entry[0] <= pc) l = m + 1;
+        else r = m;
+    }
+    by_check_return_val(l, by_false);
+    memcpy(entry, ehhdr->table + (l - 1) * 8, 8);
+
+    // parse fde
+    by_byte_t const* fde = (by_byte_t const*)(hdr + (by_long_t)entry[1]);
+    by_byte_t const* fde_end = by_null;
+    by_byte_t const* p = by_dwarf_cfi_entry(fde, &fde_end);
+    by_check_return_val(p, by_false);
+
+    // get cie, the cie pointer is relative to itself
+    by_uint32_t ciepos = 0;
+    memcpy(&ciepos, p, 4);
+    by_check_return_val(ciepos, by_false);
+    by_dwarf_cie_t cie;
+    by_check_return_val(by_dwarf_cie_parse(p - ciepos, &cie), by_false);
+
+    // get the pc range
+    by_dwarf_reader_t reader;
+    reader.p      = p + 4;
+    reader.e      = fde_end;
+    reader.broken = by_false;
+    by_size_t pc_begin = by_dwarf_read_encoded(&reader, cie.fde_encoding, 0);
+    by_size_t pc_range = by_dwarf_read_encoded(&reader, cie.fde_encoding & 0x0f, 0);
+    by_check_return_val(!reader.broken && pc >= pc_begin && pc < pc_begin + pc_range, by_false);
+
+    // skip the augmentation data
+    if (cie.has_augdata)
+    {
+        by_uint64_t size = by_dwarf_read_uleb(&reader);
+        by_check_return_val(!reader.broken && size <= (by_uint64_t)(reader.e - reader.p), by_false);
+        reader.p += size;
+    }
+
+    // run the initial instructions of cie and the instructions of fde
+    by_dwarf_cfa_state_t state;
+    by_dwarf_cfa_state_t initial;
+    memset(&state, 0, sizeof(state));
+    state.cfa_reg = (by_size_t)-1;
+    by_check_return_val(by_dwarf_cfa_run(&cie, cie.insts, cie.insts_end, 0, (by_size_t)-1, fpreg, rareg, &state, by_null), by_false);
+    initial = state;
+    by_check_return_val(by_dwarf_cfa_run(&cie, reader.p, fde_end, pc_begin, pc, fpreg, rareg, &state, &initial), by_false);
+    by_check_return_val(!state.cfa_expr && state.cfa_reg != (by_size_t)-1 && cie.rareg == rareg, by_false);
+
+    // save frame
+    frame->cfa_reg    = (by_uint16_t)state.cfa_reg;
+    frame->cfa_offset = state.cfa_offset;
+    frame->fp_rule    = state.rules[0];
+    frame->fp_value   = state.values[0];
+    frame->ra_rule    = state.rules[1];
+    frame->ra_value   = state.values[1];
+    frame->signal     = cie.signal;
+    return by_true;
+}
@@ -0,0 +1,240 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_dwarf.h
+ *
+ */
+#ifndef BY_DWARF_H
+#define BY_DWARF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "prefix.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+/// the dwarf sections for the line table
+typedef struct __by_dwarf_sections_t
+{
+    /// the .debug_line section
+    by_byte_t const*        line;
+    by_size_t               line_size;
+
+    /// the .debug_line_str section, it's only used by dwarf 5
+    by_byte_t const*        line_str;
+    by_size_t               line_str_size;
+
+    /// the .debug_str section
+    by_byte_t const*        str;
+    by_size_t               str_size;
+
+    /// the default address size, it's used by dwarf 2 - 4
+    by_size_t               addrsize;
+
+}by_dwarf_sections_t;
+
+/// the line table row type, the row with line 0 marks the end of sequence
+typedef struct __by_dwarf_row_t
+{
+    /// the address, it's the link-time address (st_value)
+    by_size_t               addr;
+
+    /// the file index
+    by_uint32_t             file;
+
+    /// the line
+    by_uint32_t             line;
+
+}by_dwarf_row_t;
+
+/// the line table query type of the batch lookup
+typedef struct __by_dwarf_query_t
+{
+    /// the link-time address
+    by_size_t               addr;
+
+    /// the query index of the caller
+    by_size_t               index;
+
+}by_dwarf_query_t;
+
+/*! the line table type
+ *
+ * it only keeps the address-sorted rows and the referenced file paths of .debug_line,
+ * so the debug sections need not be mapped after making it.
+ */
+typedef struct __by_dwarf_lines_t
+{
+    /// the rows sorted by address
+    by_dwarf_row_t*         rows;
+    by_size_t               rows_num;
+    by_size_t               rows_maxn;
+
+    /// the file path offsets of the names pool
+    by_uint32_t*            files;
+    by_size_t               files_num;
+    by_size_t               files_maxn;
+
+    /// the names pool
+    by_char_t*              names;
+    by_size_t               names_size;
+    by_size_t               names_maxn;
+
+}by_dwarf_lines_t, *by_dwarf_lines_ref_t;
+
+/// the register rule type of the call frame
+typedef enum __by_dwarf_rule_e
+{
+    BY_DWARF_RULE_SAME          = 0     //!< the register is not changed
+,   BY_DWARF_RULE_UNDEFINED     = 1     //!< the register is undefined, e.g. the return address of the outermost frame
+,   BY_DWARF_RULE_OFFSET        = 2     //!< the register is saved at CFA + value
+,   BY_DWARF_RULE_VAL_OFFSET    = 3     //!< the register is CFA + value
+,   BY_DWARF_RULE_REGISTER      = 4     //!< the register is saved in the register (value)
+,   BY_DWARF_RULE_UNSUPPORTED   = 5     //!< the register is computed by the dwarf expression, we do not support it
+
+}by_dwarf_rule_e;
+
+/*! the call frame type, it's the row of .eh_frame for the given pc
+ *
+ * we only keep the rules of CFA, the frame pointer and the return address, it's enough to unwind the stack.
+ */
+typedef struct __by_dwarf_frame_t
+{
+    /// the CFA offset
+    by_long_t               cfa_offset;
+
+    /// the rule values of the frame pointer and the return address
+    by_long_t               fp_value;
+    by_long_t               ra_value;
+
+    /// the CFA register
+    by_uint16_t             cfa_reg;
+
+    /// the rules of the frame pointer and the return address
+    by_uint8_t              fp_rule;
+    by_uint8_t              ra_rule;
+
+    /// is the signal frame?
+    by_bool_t               signal;
+
+}by_dwarf_frame_t;
+
+/*! the .eh_frame_hdr type of the loaded module
+ *
+ * @see https://refspecs.linuxfoundation.org/LSB_5.0.0/LSB-Core-generic/LSB-Core-generic/ehframechpt.html
+ */
+typedef struct __by_dwarf_ehhdr_t
+{
+    /// the .eh_frame_hdr address
+    by_byte_t const*        hdr;
+
+    /// the binary search table of the fde addresses
+    by_byte_t const*        table;
+    by_size_t               count;
+
+}by_dwarf_ehhdr_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * interfaces
+ */
+
+/*! make the line table from the dwarf sections, dwarf 2 - 5 are supported
+ *
+ * the broken or unsupported line programs are skipped.
+ *
+ * @param lines     the line table
+ * @param sections  the dwarf sections
+ *
+ * @return          by_true on success, the line table may be empty
+ */
+by_bool_t           by_dwarf_lines_init(by_dwarf_lines_ref_t lines, by_dwarf_sections_t const* sections);
+
+/*! exit the line table
+ *
+ * @param lines     the line table
+ */
+by_void_t           by_dwarf_lines_exit(by_dwarf_lines_ref_t lines);
+
+/*! find the source file and line of the given address
+ *
+ * @param lines     the line table
+ * @param addr      the link-time address
+ * @param pfile     the file path, it's valid until the line table is exited
+ * @param pline     the line
+ *
+ * @return          by_true if it's found
+ */
+by_bool_t           by_dwarf_lines_find(by_dwarf_lines_ref_t lines, by_size_t addr, by_char_t const** pfile, by_size_t* pline);
+
+/*! find the source files and lines of the given queries in one merge pass
+ *
+ * @param lines     the line table
+ * @param queries   the queries sorted by address
+ * @param count     the query count
+ * @param files     the file paths indexed by the query index, it's null if it's not found
+ * @param plines    the lines indexed by the query index, it's 0 if it's not found
+ *
+ * @return          the found count
+ */
+by_size_t           by_dwarf_lines_find_sorted(by_dwarf_lines_ref_t lines, by_dwarf_query_t const* queries, by_size_t count, by_char_t const** files, by_size_t* plines);
+
+/*! the query comparator by address, it's used to sort the queries by qsort()
+ *
+ * @param a         the query
+ * @param b         the other query
+ *
+ * @return          -1, 0 or 1
+ */
+by_int_t            by_dwarf_query_comp(by_cpointer_t a, by_cpointer_t b);
+
+/*! init .eh_frame_hdr of the loaded module (PT_GNU_EH_FRAME)
+ *
+ * only the sorted binary search table (datarel | sdata4) is supported, it's always used by ld, gold and lld.
+ *
+ * @param ehhdr     the eh_frame_hdr
+ * @param data      the .eh_frame_hdr address
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_dwarf_ehhdr_init(by_dwarf_ehhdr_t* ehhdr, by_cpointer_t data);
+
+/*! find the call frame of the given pc from .eh_frame of the loaded module
+ *
+ * it finds fde by the binary search table, and then runs the call frame instructions of cie and fde until pc.
+ * it never allocates memory, so it can be called in the signal handler.
+ *
+ * @param ehhdr     the eh_frame_hdr
+ * @param pc        the pc, it should be the return address - 1 for the caller frames
+ * @param fpreg     the dwarf register number of the frame pointer
+ * @param rareg     the dwarf register number of the return address
+ * @param frame     the call frame
+ *
+ * @return          by_true if it's found
+ */
+by_bool_t           by_dwarf_ehhdr_frame(by_dwarf_ehhdr_t const* ehhdr, by_size_t pc, by_size_t fpreg, by_size_t rareg, by_dwarf_frame_t* frame);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,3878 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_elf.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_elf.h"
+#include "byopen_pool.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/auxv.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <elf.h>
+#include <link.h>
+#include <pthread.h>
+#if defined(BY_ARCH_x64) || defined(BY_ARCH_x86)
+#   include <immintrin.h>
+#elif defined(BY_ARCH_ARM64)
+#   include <arm_neon.h>
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+/* the zip signatures
+ *
+ * @see https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+ */
+#define BY_ZIP_EOCD_SIGN        (0x06054b50)
+#define BY_ZIP_CDIR_SIGN        (0x02014b50)
+#define BY_ZIP_LOCAL_SIGN       (0x04034b50)
+#define BY_ZIP_EOCD_SIZE        (22)
+#define BY_ZIP_CDIR_SIZE        (46)
+#define BY_ZIP_LOCAL_SIZE       (30)
+
+// the entry separator of the zip path, e.g. /data/app/xxx/base.apk!/lib/arm64-v8a/libfoo.so
+#define BY_ZIP_ENTRY_SEP        "!/"
+
+// the shared symbol index magic
+#define BY_FAKE_DLSHARE_MAGIC   (0xfadd5a5e)
+
+// the memfd flags and seals, they may be not defined in the old ndk headers
+#ifndef MFD_CLOEXEC
+#   define MFD_CLOEXEC          (0x0001U)
+#endif
+#ifndef MFD_ALLOW_SEALING
+#   define MFD_ALLOW_SEALING    (0x0002U)
+#endif
+#ifndef F_ADD_SEALS
+#   define F_ADD_SEALS          (1033)
+#endif
+#ifndef F_GET_SEALS
+#   define F_GET_SEALS          (1034)
+#endif
+#ifndef F_SEAL_SEAL
+#   define F_SEAL_SEAL          (0x0001)
+#   define F_SEAL_SHRINK        (0x0002)
+#   define F_SEAL_GROW          (0x0004)
+#   define F_SEAL_WRITE         (0x0008)
+#endif
+
+// the compressed section flag, it may be not defined in the old ndk headers
+#ifndef SHF_COMPRESSED
+#   define SHF_COMPRESSED       (1 << 11)
+#endif
+
+// the global debug directory of the separate debug files
+#define BY_FAKE_DEBUG_DIR       "/usr/lib/debug"
+
+// the eh_frame_hdr segment type, it may be not defined in the old ndk headers
+#ifndef PT_GNU_EH_FRAME
+#   define PT_GNU_EH_FRAME      (0x6474e550)
+#endif
+
+// the gnu build-id note type
+#ifndef NT_GNU_BUILD_ID
+#   define NT_GNU_BUILD_ID      (3)
+#endif
+
+/* the procmap query ioctl of /proc/self/maps, it's supported since linux 6.11
+ *
+ * @see https://github.com/torvalds/linux/blob/master/include/uapi/linux/fs.h
+ */
+#ifndef PROCMAP_QUERY
+#   define PROCMAP_QUERY        _IOWR('f', 17, by_procmap_query_t)
+#endif
+
+// the tls symbol type
+#ifndef STT_TLS
+#   define STT_TLS              (6)
+#endif
+
+// the indirect function symbol type, its value is the resolver of the implementation
+#ifndef STT_GNU_IFUNC
+#   define STT_GNU_IFUNC        (10)
+#endif
+
+/* the ifunc flag of the symbol value in the compact index and journal
+ *
+ * the symbol values are always less than the half of the address space, so we use the top bit to mark the ifunc symbols.
+ */
+#define BY_FAKE_SYMVAL_IFUNC    ((by_size_t)1 << (sizeof(by_size_t) * 8 - 1))
+
+// the ifunc resolver argument flag of aarch64, the second argument is __ifunc_arg_t
+#define BY_IFUNC_ARG_HWCAP      (1ULL << 62)
+
+// the max count of the cached tls symbols of each handle
+#define BY_FAKE_TLS_CACHE_MAXN  (16)
+
+// the offset of the dtv pointer, the tls offset need be subtracted it for __tls_get_addr()
+#if defined(__riscv)
+#   define BY_TLS_DTV_OFFSET    (0x800)
+#else
+#   define BY_TLS_DTV_OFFSET    (0)
+#endif
+
+// the journal file header
+#define BY_JOURNAL_HEADER       "# byopen journal v1"
+
+// the handle count of each slab of the handle pool
+#define BY_FAKE_DLCTX_SLAB_ITEMN (16)
+
+// the max thread count of building the symbol indexes
+#define BY_FAKE_INDEX_THREADS_MAXN  (16)
+
+// the min symbol count of building the compact index in parallel
+#define BY_FAKE_COMPACT_PARALLEL_MINN (65536)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the compact index entry type
+typedef struct _by_fake_dlidx_t
+{
+    // the symbol name hash
+    by_uint64_t     hash;
+
+    // the symbol value (st_value), it's relative to the load bias address, the ifunc symbol is marked by BY_FAKE_SYMVAL_IFUNC
+    by_size_t       value;
+
+}by_fake_dlidx_t, *by_fake_dlidx_ref_t;
+
+/* the library entry of the shared symbol index
+ *
+ * all offsets are relative to the start of the shared mapping,
+ * and the index values are relative to the load bias address,
+ * so it's still valid if the library is loaded at the other address in another process.
+ */
+typedef struct _by_fake_dlshare_lib_t
+{
+    // the library name passed to by_dlshare_init()
+    by_char_t       name[128];
+
+    // the library real path
+    by_char_t       realpath[512];
+
+    // the offset and count of the compact index
+    by_size_t       index_offset;
+    by_size_t       index_num;
+
+}by_fake_dlshare_lib_t;
+
+// the header of the shared symbol index
+typedef struct _by_fake_dlshare_head_t
+{
+    // the magic
+    by_uint32_t     magic;
+
+    // the library count
+    by_uint32_t     count;
+
+    // the total size
+    by_size_t       size;
+
+}by_fake_dlshare_head_t;
+
+// the shared symbol index type
+typedef struct _by_fake_dlshare_t
+{
+    // the memfd, it's -1 if we use the anonymous shared mapping
+    by_int_t        fd;
+
+    // the read-only shared mapping
+    by_byte_t const* data;
+    by_size_t       size;
+
+}by_fake_dlshare_t, *by_fake_dlshare_ref_t;
+
+// the loaded library type for exporting the perf map file
+typedef struct _by_fake_perfmap_lib_t
+{
+    // the load bias address
+    by_pointer_t    biasaddr;
+
+    // the library name, it maybe not full path, e.g. libart.so
+    by_char_t*      name;
+
+}by_fake_perfmap_lib_t, *by_fake_perfmap_lib_ref_t;
+
+// the tls index type of __tls_get_addr()
+typedef struct _by_tls_index_t
+{
+    by_ulong_t      module;
+    by_ulong_t      offset;
+
+}by_tls_index_t;
+
+// the c++ abi demangle function type
+typedef by_char_t* (*by_cxa_demangle_t)(by_char_t const* mangled, by_char_t* buffer, size_t* length, by_int_t* status);
+
+// the demangle task type, it makes the demangled name index of a part of symbol table
+typedef struct _by_fake_demangle_task_t
+{
+    // the symbol table
+    ElfW(Sym) const*            syms;
+    by_int_t                    num;
+    by_char_t const*            strtab;
+    by_pointer_t                end;
+
+    // the demangled name index
+    struct _by_fake_dlidx_t*    index;
+    by_size_t                   count;
+
+}by_fake_demangle_task_t;
+
+// the compact task type, it makes the sorted compact index of a part of symbol table
+typedef struct _by_fake_dlcompact_task_t
+{
+    // the fake dlopen context
+    struct _by_fake_dlctx_t*    dlctx;
+
+    // the symbol table
+    ElfW(Sym) const*            syms;
+    by_int_t                    num;
+    by_char_t const*            strtab;
+    ElfW(Half) const*           versym;
+
+    // the compact index slice and its temporary buffer of sorting
+    struct _by_fake_dlidx_t*    index;
+    struct _by_fake_dlidx_t*    temp;
+    by_size_t                   maxn;
+    by_size_t                   count;
+
+}by_fake_dlcompact_task_t;
+
+// the merge task type, it merges two sorted runs of the compact index
+typedef struct _by_fake_dlmerge_task_t
+{
+    // the sorted runs
+    struct _by_fake_dlidx_t const* runs[2];
+    by_size_t                   counts[2];
+
+    // the output
+    struct _by_fake_dlidx_t*    output;
+
+}by_fake_dlmerge_task_t;
+
+// the query argument of PROCMAP_QUERY
+typedef struct _by_procmap_query_t
+{
+    by_uint64_t     size;
+    by_uint64_t     query_flags;
+    by_uint64_t     query_addr;
+    by_uint64_t     vma_start;
+    by_uint64_t     vma_end;
+    by_uint64_t     vma_flags;
+    by_uint64_t     vma_page_size;
+    by_uint64_t     vma_offset;
+    by_uint64_t     inode;
+    by_uint32_t     dev_major;
+    by_uint32_t     dev_minor;
+    by_uint32_t     vma_name_size;
+    by_uint32_t     build_id_size;
+    by_uint64_t     vma_name_addr;
+    by_uint64_t     build_id_addr;
+
+}by_procmap_query_t;
+
+// the journal symbol type
+typedef struct _by_journal_sym_t
+{
+    // the symbol name hash
+    by_uint64_t     hash;
+
+    // the symbol value, it's relative to the load bias address, the ifunc symbol is marked by BY_FAKE_SYMVAL_IFUNC
+    by_size_t       value;
+
+    // the symbol name
+    by_char_t*      name;
+
+}by_journal_sym_t;
+
+/* the immutable journal symbol table sorted by name hash
+ *
+ * it's published with the release store and read without lock,
+ * so the replaced tables are only retired and will not be freed.
+ */
+typedef struct _by_journal_syms_t
+{
+    // the next retired table
+    struct _by_journal_syms_t* next;
+
+    // the symbols
+    by_size_t       num;
+    by_journal_sym_t syms[1];
+
+}by_journal_syms_t;
+
+/* the journal library type
+ *
+ * the library is identified by its real path, file size and build-id,
+ * all symbols will be discarded if one of them has been changed.
+ */
+typedef struct _by_journal_lib_t
+{
+    // the next library
+    struct _by_journal_lib_t* next;
+
+    // the library name passed to by_dlopen() and its real path
+    by_char_t       name[128];
+    by_char_t       realpath[512];
+
+    // the library file size and build-id
+    by_uint64_t     filesize;
+    by_byte_t       buildid[32];
+    by_size_t       buildid_size;
+
+    // the validated load bias address in the current process, it's null if not validated
+    by_pointer_t    biasaddr;
+
+    // the replayed symbols, it's read without lock
+    by_journal_syms_t* replayed;
+
+    // the newly recorded symbols sorted by name hash, they are protected by the journal lock
+    by_journal_sym_t* syms;
+    by_size_t       syms_num;
+    by_size_t       syms_maxn;
+
+}by_journal_lib_t, *by_journal_lib_ref_t;
+
+// the symbol scan key type
+typedef struct _by_symscan_key_t
+{
+    // the symbol name and size
+    by_char_t const*        name;
+    by_size_t               size;
+
+    // the symbol name prefix with the null terminator, the rest bytes are zero
+    by_byte_t               prefix[32];
+
+    // the ignored bytes mask of the prefix (0xff), it's used to skip the bytes after the null terminator
+    by_byte_t               ignore[32];
+
+    // the needed bits of the prefix comparison mask (16 and 32 bytes)
+    by_uint32_t             need16;
+    by_uint32_t             need32;
+
+}by_symscan_key_t;
+
+// the symbol scan kernel type, return the symbol index or -1
+typedef by_int_t (*by_symscan_func_t)(ElfW(Sym) const* syms, by_int_t num, by_char_t const* strtab, by_pointer_t end, by_symscan_key_t const* key);
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the linker mutex
+pthread_mutex_t*        g_by_linker_mutex = by_null;
+
+// the handle pool, the first slab is static, so the common open/close cycle need not allocate heap memory
+static by_fake_dlctx_t  g_dlctx_slab[BY_FAKE_DLCTX_SLAB_ITEMN];
+static by_pool_t        g_dlctx_pool = BY_POOL_INIT(g_dlctx_slab, BY_FAKE_DLCTX_SLAB_ITEMN);
+
+// the handle count opened in the caller-provided storage
+static by_size_t        g_dlctx_storages = 0;
+
+// the handle must fit in the caller-provided storage
+typedef by_char_t       by_fake_dlctx_storage_check_t[sizeof(by_fake_dlctx_t) <= BY_DLOPEN_STORAGE_SIZE? 1 : -1];
+
+// the symbol scan kernel
+static by_symscan_func_t g_symscan = by_null;
+
+// the journal libraries, they will not be freed because the handles may refer to them
+static by_journal_lib_ref_t g_journal_libs = by_null;
+static by_bool_t        g_journal_enabled = by_false;
+static pthread_mutex_t  g_journal_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the retired journal symbol tables, the lock-free readers may still refer to them
+static by_journal_syms_t* g_journal_retired = by_null;
+
+// the loaded module range table sorted by address
+static by_fake_module_ref_t g_modules = by_null;
+static by_size_t        g_modules_num = 0;
+pthread_mutex_t         g_by_modules_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the module table generation, it's increased after rebuilding the module table
+by_size_t               g_by_modules_gen = 0;
+
+// is PROCMAP_QUERY not supported?
+static by_bool_t        g_procmap_query_disabled = by_false;
+
+// the c++ abi demangle function, it's resolved from the c++ runtime if we are not linked with it
+static by_cxa_demangle_t g_cxa_demangle = by_null;
+static pthread_once_t   g_cxa_demangle_once = PTHREAD_ONCE_INIT;
+
+// the lock of building the demangled name index
+static pthread_mutex_t  g_demangle_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the thread count of building the symbol indexes, it's selected by the cpu count if it's 0
+static by_size_t        g_index_threads = 0;
+
+// the lock of building the line table
+static pthread_mutex_t  g_lines_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the lock of appending the tls symbol cache
+static pthread_mutex_t  g_tls_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * declaration
+ */
+extern __attribute((weak)) by_int_t dl_iterate_phdr(by_int_t (*)(struct dl_phdr_info*, size_t, by_pointer_t), by_pointer_t);
+extern __attribute((weak)) by_pointer_t dlvsym(by_pointer_t handle, by_char_t const* symbol, by_char_t const* version);
+extern __attribute((weak)) by_pointer_t __tls_get_addr(by_tls_index_t* ti);
+extern __attribute((weak)) by_char_t* __cxa_demangle(by_char_t const* mangled, by_char_t* buffer, size_t* length, by_int_t* status);
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+by_size_t by_elf_strlcpy(by_char_t* dst, by_char_t const* src, by_size_t size)
+{
+    by_size_t n = strlen(src);
+    if (size)
+    {
+        by_size_t m = n < size - 1? n : size - 1;
+        memcpy(dst, src, m);
+        dst[m] = '\0';
+    }
+    return n;
+}
+#endif
+
+// find the load bias address from the base address
+static by_pointer_t by_fake_find_biasaddr_from_baseaddr(by_pointer_t baseaddr)
+{
+    // check
+    by_assert_and_check_return_val(baseaddr, by_null);
+
+    // find load bias from program header
+    ElfW(Ehdr)*       ehdr = (ElfW(Ehdr)*)baseaddr;
+    ElfW(Phdr) const* dlpi_phdr = (ElfW(Phdr) const*)(baseaddr + ehdr->e_phoff);
+    by_int_t          dlpi_phnum = ehdr->e_phnum;
+    uintptr_t         min_vaddr = UINTPTR_MAX;
+    for (by_int_t i = 0; i < dlpi_phnum; i++)
+    {
+        ElfW(Phdr) const* phdr = &(dlpi_phdr[i]);
+        if (PT_LOAD == phdr->p_type)
+        {
+            if (min_vaddr > phdr->p_vaddr)
+                min_vaddr = phdr->p_vaddr;
+        }
+    }
+    return min_vaddr != UINTPTR_MAX? baseaddr - min_vaddr : by_null;
+}
+
+// read the little-endian integers of zip
+static by_uint16_t by_zip_u16(by_byte_t const* p)
+{
+    return (by_uint16_t)(p[0] | (p[1] << 8));
+}
+static by_uint32_t by_zip_u32(by_byte_t const* p)
+{
+    return (by_uint32_t)p[0] | ((by_uint32_t)p[1] << 8) | ((by_uint32_t)p[2] << 16) | ((by_uint32_t)p[3] << 24);
+}
+
+/* split the zip entry path, e.g. /data/app/xxx/base.apk!/lib/arm64-v8a/libfoo.so
+ *
+ * the libraries can be loaded from apk directly if extractNativeLibs=false
+ *
+ * @return the entry name, e.g. lib/arm64-v8a/libfoo.so, or null if it's not a zip entry path
+ */
+static by_char_t const* by_zip_entry_split(by_char_t const* filepath, by_char_t* archivepath, by_size_t archivemaxn)
+{
+    by_char_t const* sep = strstr(filepath, BY_ZIP_ENTRY_SEP);
+    by_check_return_val(sep && sep > filepath && (by_size_t)(sep - filepath) < archivemaxn, by_null);
+
+    memcpy(archivepath, filepath, sep - filepath);
+    archivepath[sep - filepath] = '\0';
+    return sep + 2;
+}
+
+// find the data offset and size of the stored (uncompressed) entry in the zip file
+static by_bool_t by_zip_entry_find(by_int_t fd, by_size_t archivesize, by_char_t const* entryname, by_size_t* poffset, by_size_t* psize)
+{
+    // check
+    by_assert_and_check_return_val(fd >= 0 && entryname && poffset && psize, by_false);
+    by_check_return_val(archivesize >= BY_ZIP_EOCD_SIZE, by_false);
+
+    // map the archive, only the central directory and local header will be touched
+    by_byte_t const* data = (by_byte_t const*)mmap(by_null, archivesize, PROT_READ, MAP_PRIVATE, fd, 0);
+    by_check_return_val(data && data != MAP_FAILED, by_false);
+
+    by_bool_t ok = by_false;
+    do
+    {
+        // find the end of central directory record, it's followed by the comment (<= 64K)
+        by_byte_t const* end  = data + archivesize;
+        by_byte_t const* eocd = end - BY_ZIP_EOCD_SIZE;
+        by_byte_t const* stop = archivesize > BY_ZIP_EOCD_SIZE + 0xffff? end - BY_ZIP_EOCD_SIZE - 0xffff : data;
+        while (eocd >= stop && by_zip_u32(eocd) != BY_ZIP_EOCD_SIGN) eocd--;
+        by_check_break(eocd >= stop);
+
+        // get central directory
+        by_size_t        count = by_zip_u16(eocd + 10);
+        by_size_t        cdir_size = by_zip_u32(eocd + 12);
+        by_size_t        cdir_offset = by_zip_u32(eocd + 16);
+        by_check_break(cdir_offset <= archivesize && cdir_size <= archivesize - cdir_offset);
+
+        // find the entry
+        by_size_t        entrysize = strlen(entryname);
+        by_byte_t const* p = data + cdir_offset;
+        by_byte_t const* e = p + cdir_size;
+        for (; count && p + BY_ZIP_CDIR_SIZE <= e && by_zip_u32(p) == BY_ZIP_CDIR_SIGN; count--)
+        {
+            by_size_t namesize = by_zip_u16(p + 28);
+            by_size_t headsize = BY_ZIP_CDIR_SIZE + namesize + by_zip_u16(p + 30) + by_zip_u16(p + 32);
+            by_check_break(p + headsize <= e);
+            if (namesize == entrysize && !memcmp(p + BY_ZIP_CDIR_SIZE, entryname, entrysize))
+            {
+                // we can map it directly only if it's stored
+                by_size_t method = by_zip_u16(p + 10);
+                by_size_t size   = by_zip_u32(p + 24);
+                by_size_t local  = by_zip_u32(p + 42);
+                by_check_break(!method && by_zip_u32(p + 20) == size);
+                by_check_break(local < archivesize && BY_ZIP_LOCAL_SIZE <= archivesize - local && by_zip_u32(data + local) == BY_ZIP_LOCAL_SIGN);
+
+                // the extra field size of local header may be different with central directory, e.g. zipalign padding
+                by_size_t offset = local + BY_ZIP_LOCAL_SIZE + by_zip_u16(data + local + 26) + by_zip_u16(data + local + 28);
+                by_check_break(offset <= archivesize && size <= archivesize - offset);
+
+                // ok
+                *poffset = offset;
+                *psize   = size;
+                ok = by_true;
+                break;
+            }
+            p += headsize;
+        }
+
+    } while (0);
+
+    // trace
+    by_trace("zip entry(%s): %s", entryname, ok? "found" : "not found");
+
+    // unmap it
+    munmap((by_pointer_t)data, archivesize);
+    return ok;
+}
+
+// find the data offset of the zip entry path, e.g. /data/app/xxx/base.apk!/lib/arm64-v8a/libfoo.so
+static by_bool_t by_zip_entry_offset(by_char_t const* archivepath, by_char_t const* entryname, by_size_t* poffset)
+{
+    by_bool_t ok = by_false;
+    by_int_t  fd = open(archivepath, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        struct stat st;
+        by_size_t   size = 0;
+        if (0 == fstat(fd, &st))
+            ok = by_zip_entry_find(fd, (by_size_t)st.st_size, entryname, poffset, &size);
+        close(fd);
+    }
+    return ok;
+}
+
+/* find the load bias address, real path and base address from the maps of the given process
+ *
+ * the pid is 0 for the current process, and the headers of the remote process will be read by process_vm_readv()
+ */
+by_pointer_t by_elf_find_biasaddr_from_pidmaps(by_int_t pid, by_char_t const* filename, by_char_t* realpath, by_size_t realmaxn, by_pointer_t* pbaseaddr)
+{
+    // check
+    by_assert_and_check_return_val(filename && realpath && realmaxn, by_null);
+
+    // trace
+    by_trace("find biasaddr of %s from maps of %d", filename, pid);
+
+    /* is zip entry path? e.g. /data/app/xxx/base.apk!/lib/arm64-v8a/libfoo.so
+     *
+     * the maps only shows the archive path, so we need match it and the file offset of the entry data
+     */
+    by_char_t        archivepath[512];
+    by_char_t const* matchname = filename;
+    by_size_t        matchoffset = 0;
+    by_char_t const* entryname = by_zip_entry_split(filename, archivepath, sizeof(archivepath));
+    if (entryname)
+    {
+        by_check_return_val(by_zip_entry_offset(archivepath, entryname, &matchoffset), by_null);
+        matchname = archivepath;
+    }
+
+    /* find the first segment of the library
+     *
+     * the library file may be also mapped by the other handles (e.g. by_fake_open_file()) at the start of file,
+     * so we prefer the segment which is followed by the next segment of the same file, the first matched segment is only the fallback.
+     */
+    by_char_t    line[512];
+    by_char_t    found[512];
+    by_char_t    pending[512];
+    by_char_t    page_attr[10];
+    by_int_t     found_pos = 0;
+    by_int_t     pending_pos = 0;
+    uintptr_t    found_start = 0;
+    uintptr_t    pending_start = 0;
+    uintptr_t    pending_end = 0;
+    by_bool_t    has_found = by_false;
+    by_bool_t    has_pending = by_false;
+    by_char_t    mapspath[64];
+    if (pid) snprintf(mapspath, sizeof(mapspath), "/proc/%d/maps", pid);
+    else strlcpy(mapspath, "/proc/self/maps", sizeof(mapspath));
+    FILE* fp = fopen(mapspath, "r");
+    if (fp)
+    {
+        while (fgets(line, sizeof(line), fp))
+        {
+            // parse it, e.g. 7372a68000-7372bc1000 --xp 000fe000 fd:06 39690571                       /system/lib64/libandroid_runtime.so
+            int       pos = 0;
+            uintptr_t start = 0;
+            uintptr_t end = 0;
+            uintptr_t offset = 0;
+            by_bool_t matched = strstr(line, matchname) && 4 == sscanf(line, "%"SCNxPTR"-%"SCNxPTR" %4s %"SCNxPTR" %*x:%*x %*d%n", &start, &end, page_attr, &offset, &pos);
+
+            // the pending segment is followed by the next segment of the same file? we found it
+            by_bool_t next = matched && start == pending_end && offset > matchoffset;
+            if (has_pending && (next || !has_found))
+            {
+                strlcpy(found, pending, sizeof(found));
+                found_pos   = pending_pos;
+                found_start = pending_start;
+                has_found   = by_true;
+                if (next) break;
+            }
+            has_pending = by_false;
+
+            // check permission and offset, the first segment of the library is mapped at the start of file or zip entry
+            if (matched && page_attr[0] == 'r' && page_attr[3] == 'p' && matchoffset == offset)
+            {
+                strlcpy(pending, line, sizeof(pending));
+                pending_pos   = pos;
+                pending_start = start;
+                pending_end   = end;
+                has_pending   = by_true;
+            }
+        }
+        if (has_pending && !has_found)
+        {
+            strlcpy(found, pending, sizeof(found));
+            found_pos   = pending_pos;
+            found_start = pending_start;
+            has_found   = by_true;
+        }
+        fclose(fp);
+    }
+    by_check_return_val(has_found, by_null);
+
+    // get load bias address
+    by_pointer_t biasaddr = pid? by_elf_remote_find_biasaddr(pid, (by_pointer_t)found_start) : by_fake_find_biasaddr_from_baseaddr((by_pointer_t)found_start);
+    if (pbaseaddr) *pbaseaddr = (by_pointer_t)found_start;
+
+    // get real path
+    if (filename[0] == '/')
+        strlcpy(realpath, filename, realmaxn);
+    else if (found_pos < sizeof(found))
+    {
+        by_char_t* p = found + found_pos;
+        by_char_t* e = p + strlen(p);
+        while (p < e && isspace((by_int_t)*p)) p++;
+        while (p < e && isspace((by_int_t)(*(e - 1)))) e--;
+        *e = '\0';
+        if (p < e && entryname) snprintf(realpath, realmaxn, "%s" BY_ZIP_ENTRY_SEP "%s", p, entryname);
+        else if (p < e) strlcpy(realpath, p, realmaxn);
+        else realpath[0] = '\0';
+    }
+    else realpath[0] = '\0';
+
+    // trace
+    by_trace("realpath: %s, biasaddr: %p found!", realpath, biasaddr);
+    return biasaddr;
+}
+
+// find the load bias address and real path from the maps of the current process
+static by_pointer_t by_fake_find_biasaddr_from_maps(by_char_t const* filename, by_char_t* realpath, by_size_t realmaxn)
+{
+    return by_elf_find_biasaddr_from_pidmaps(0, filename, realpath, realmaxn, by_null);
+}
+
+// the callback of dl_iterate_phdr()
+static by_int_t by_fake_find_biasaddr_from_linker_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+{
+    // check
+    by_cpointer_t* args = (by_cpointer_t*)udata;
+    by_check_return_val(args, 1);
+    by_check_return_val(info && info->dlpi_addr && info->dlpi_name && info->dlpi_name[0] != '\0', 0);
+
+    // get filename
+    by_char_t const* filename = by_null;
+    by_char_t const* filepath = (by_char_t const*)args[0];
+    by_assert_and_check_return_val(filepath, 1);
+    if (filepath[0] == '/')
+    {
+        by_char_t const* p = filepath + strlen(filepath);
+        while (p >= filepath && *p != '/')
+            p--;
+        if (p >= filepath && *p == '/') filename = p + 1;
+    }
+
+    // find library, we can also get full path of dlpi_name from maps
+    by_pointer_t*    pbiasaddr = (by_pointer_t*)&args[3];
+    by_char_t*       realpath  = (by_char_t*)args[1];
+    by_size_t        realmaxn  = (by_size_t)args[2];
+    if ((filepath && strstr(info->dlpi_name, filepath)) ||
+        (filename && !strcmp(info->dlpi_name, filename))) // dlpi_name ma ybe not full path, e.g. libart.so
+    {
+        // save load bias address
+        *pbiasaddr = (by_pointer_t)info->dlpi_addr;
+
+        // get real path
+        if (filepath[0] == '/')
+            strlcpy(realpath, filepath, realmaxn);
+        else if (info->dlpi_name[0] == '/')
+            strlcpy(realpath, info->dlpi_name, realmaxn);
+        else
+        {
+            // we only find real path
+            if (!by_fake_find_biasaddr_from_maps(filepath, realpath, realmaxn))
+                realpath[0] = '\0';
+        }
+
+        // trace
+        by_trace("realpath: %s, biasaddr: %p found!", realpath, (by_pointer_t)info->dlpi_addr);
+
+        // found, stop it
+        return 1;
+    }
+    return 0;
+}
+
+// find the load bias address and real path from the maps
+static by_pointer_t by_fake_find_biasaddr_from_linker(by_char_t const* filepath, by_char_t* realpath, by_size_t realmaxn)
+{
+    // check
+    by_assert_and_check_return_val(dl_iterate_phdr && filepath && realpath && realmaxn, by_null);
+
+    // trace
+    by_trace("find biasaddr of %s from linker", filepath);
+
+    // find biasaddr
+    by_cpointer_t args[4];
+    args[0] = (by_cpointer_t)filepath;
+    args[1] = (by_cpointer_t)realpath;
+    args[2] = (by_cpointer_t)realmaxn;
+    args[3] = by_null;
+    if (g_by_linker_mutex) pthread_mutex_lock(g_by_linker_mutex);
+    dl_iterate_phdr(by_fake_find_biasaddr_from_linker_cb, args);
+    if (g_by_linker_mutex) pthread_mutex_unlock(g_by_linker_mutex);
+    return (by_pointer_t)args[3];
+}
+
+// find the load bias address and real path
+static by_pointer_t by_fake_find_biasaddr(by_char_t const* filename, by_char_t* realpath, by_size_t realmaxn)
+{
+    by_assert_and_check_return_val(filename && realpath, by_null);
+    by_pointer_t biasaddr = by_null;
+    if (dl_iterate_phdr && 0 != strcmp(filename, BY_LINKER_NAME))
+        biasaddr = by_fake_find_biasaddr_from_linker(filename, realpath, realmaxn);
+    if (!biasaddr)
+        biasaddr = by_fake_find_biasaddr_from_maps(filename, realpath, realmaxn);
+    return biasaddr;
+}
+
+// open map file
+static by_pointer_t by_fake_open_file(by_char_t const* filepath, by_size_t* pfilesize)
+{
+    // check
+    by_assert_and_check_return_val(filepath && pfilesize, by_null);
+
+    // is zip entry path? e.g. /data/app/xxx/base.apk!/lib/arm64-v8a/libfoo.so
+    by_char_t        archivepath[512];
+    by_char_t const* entryname = by_zip_entry_split(filepath, archivepath, sizeof(archivepath));
+    if (entryname) filepath = archivepath;
+
+    // open it
+    by_int_t     fd = -1;
+    by_pointer_t filedata = by_null;
+    do
+    {
+        // open file
+        fd = open(filepath, O_RDONLY | O_CLOEXEC);
+        if (fd < 0 && errno == EINTR)
+            fd = open(filepath, O_RDONLY | O_CLOEXEC);
+        by_check_break(fd > 0);
+
+        // get file size
+        struct stat st;
+        if (0 != fstat(fd, &st) || 0 == st.st_size) break;
+
+        // get the range of the library data, we only map the entry data if it's stored in zip
+        by_size_t offset = 0;
+        by_size_t size = (by_size_t)st.st_size;
+        if (entryname && !by_zip_entry_find(fd, size, entryname, &offset, &size)) break;
+
+        // mmap the file data, the map offset must be aligned to page
+        by_size_t    delta = offset & (by_size_t)(getpagesize() - 1);
+        by_pointer_t mapdata = mmap(by_null, size + delta, PROT_READ, MAP_PRIVATE, fd, offset - delta);
+        by_assert_and_check_break(mapdata && mapdata != MAP_FAILED);
+        filedata = mapdata + delta;
+
+        // save the file size
+        if (pfilesize) *pfilesize = size;
+
+    } while (0);
+
+    // close the fd first
+    if (fd > 0) close(fd);
+    fd = -1;
+
+    // ok?
+    return filedata;
+}
+
+// unmap file
+static by_void_t by_fake_close_file(by_pointer_t filedata, by_size_t filesize)
+{
+    // the zip entry data may be not aligned to page
+    by_size_t delta = (by_size_t)filedata & (by_size_t)(getpagesize() - 1);
+    munmap(filedata - delta, filesize + delta);
+}
+
+// init the symbol scan key
+static by_void_t by_symscan_key_init(by_symscan_key_t* key, by_char_t const* symbol)
+{
+    by_size_t size = strlen(symbol);
+    by_size_t n = size + 1 < sizeof(key->prefix)? size + 1 : sizeof(key->prefix);
+    memset(key, 0, sizeof(by_symscan_key_t));
+    memcpy(key->prefix, symbol, n);
+    memset(key->ignore + n, 0xff, sizeof(key->ignore) - n);
+    key->name   = symbol;
+    key->size   = size;
+    key->need16 = n >= 16? 0xffff : ((1u << n) - 1);
+    key->need32 = n >= 32? 0xffffffff : ((1u << n) - 1);
+}
+
+// the scalar symbol scan kernel
+static by_int_t by_symscan_scalar(ElfW(Sym) const* syms, by_int_t num, by_char_t const* strtab, by_pointer_t end, by_symscan_key_t const* key)
+{
+    by_char_t first = key->name[0];
+    for (by_int_t i = 0; i < num; i++)
+    {
+        by_char_t const* name = strtab + syms[i].st_name;
+        if ((by_pointer_t)name < end && *name == first && !strcmp(name, key->name))
+            return i;
+    }
+    return -1;
+}
+
+#if defined(BY_ARCH_x64) || defined(BY_ARCH_x86)
+/* the sse2 symbol scan kernel
+ *
+ * we compare the first byte and the first 16 bytes (with null terminator) of each candidate name before calling strcmp,
+ * so the short names can be matched without strcmp
+ */
+static __attribute__((target("sse2"))) by_int_t by_symscan_sse2(ElfW(Sym) const* syms, by_int_t num, by_char_t const* strtab, by_pointer_t end, by_symscan_key_t const* key)
+{
+    __m128i     prefix = _mm_loadu_si128((__m128i const*)key->prefix);
+    by_uint32_t need = key->need16;
+    by_char_t   first = key->name[0];
+    for (by_int_t i = 0; i < num; i++)
+    {
+        by_char_t const* name = strtab + syms[i].st_name;
+        if ((by_pointer_t)name >= end || *name != first) continue;
+        if ((by_pointer_t)(name + 16) <= end)
+        {
+            by_uint32_t eq = (by_uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)name), prefix));
+            if ((eq & need) == need && (key->size < 16 || !strcmp(name + 16, key->name + 16)))
+                return i;
+        }
+        else if (!strcmp(name, key->name))
+            return i;
+    }
+    return -1;
+}
+
+// the avx2 symbol scan kernel, compare the first 32 bytes
+static __attribute__((target("avx2"))) by_int_t by_symscan_avx2(ElfW(Sym) const* syms, by_int_t num, by_char_t const* strtab, by_pointer_t end, by_symscan_key_t const* key)
+{
+    __m256i     prefix = _mm256_loadu_si256((__m256i const*)key->prefix);
+    by_uint32_t need = key->need32;
+    by_char_t   first = key->name[0];
+    for (by_int_t i = 0; i < num; i++)
+    {
+        by_char_t const* name = strtab + syms[i].st_name;
+        if ((by_pointer_t)name >= end || *name != first) continue;
+        if ((by_pointer_t)(name + 32) <= end)
+        {
+            by_uint32_t eq = (by_uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*)name), prefix));
+            if ((eq & need) == need && (key->size < 32 || !strcmp(name + 32, key->name + 32)))
+                return i;
+        }
+        else if (!strcmp(name, key->name))
+            return i;
+    }
+    return -1;
+}
+#elif defined(BY_ARCH_ARM64)
+// the neon symbol scan kernel, compare the first 16 bytes
+static by_int_t by_symscan_neon(ElfW(Sym) const* syms, by_int_t num, by_char_t const* strtab, by_pointer_t end, by_symscan_key_t const* key)
+{
+    uint8x16_t prefix = vld1q_u8(key->prefix);
+    uint8x16_t ignore = vld1q_u8(key->ignore);
+    by_char_t  first = key->name[0];
+    for (by_int_t i = 0; i < num; i++)
+    {
+        by_char_t const* name = strtab + syms[i].st_name;
+        if ((by_pointer_t)name >= end || *name != first) continue;
+        if ((by_pointer_t)(name + 16) <= end)
+        {
+            uint8x16_t eq = vorrq_u8(vceqq_u8(vld1q_u8((by_byte_t const*)name), prefix), ignore);
+            if (vminvq_u8(eq) == 0xff && (key->size < 16 || !strcmp(name + 16, key->name + 16)))
+                return i;
+        }
+        else if (!strcmp(name, key->name))
+            return i;
+    }
+    return -1;
+}
+#endif
+
+// get the symbol scan kernel by name
+static by_symscan_func_t by_symscan_find(by_char_t const* name)
+{
+    by_bool_t autoselect = !strcmp(name, "auto");
+#if defined(BY_ARCH_x64) || defined(BY_ARCH_x86)
+    __builtin_cpu_init();
+    if ((autoselect || !strcmp(name, "avx2")) && __builtin_cpu_supports("avx2"))
+        return by_symscan_avx2;
+    if ((autoselect || !strcmp(name, "sse2")) && __builtin_cpu_supports("sse2"))
+        return by_symscan_sse2;
+#elif defined(BY_ARCH_ARM64)
+    if (autoselect || !strcmp(name, "neon"))
+        return by_symscan_neon;
+#endif
+    return (autoselect || !strcmp(name, "scalar"))? by_symscan_scalar : by_null;
+}
+
+// get the symbol scan kernel, it's selected at runtime based on the cpu features
+static by_symscan_func_t by_symscan_func()
+{
+    by_symscan_func_t func = g_symscan;
+    if (!func)
+    {
+        func = by_symscan_find("auto");
+        g_symscan = func;
+    }
+    return func;
+}
+
+// update the 64-bit fnv-1a hash with the given string
+static by_uint64_t by_fake_hash_update(by_uint64_t h, by_char_t const* name)
+{
+    while (*name)
+    {
+        h ^= (by_uint8_t)*name++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// the 64-bit fnv-1a hash of the symbol name
+static by_uint64_t by_fake_hash(by_char_t const* name)
+{
+    return by_fake_hash_update(0xcbf29ce484222325ULL, name);
+}
+
+// the 64-bit fnv-1a hash of the versioned symbol name, e.g. memcpy@GLIBC_2.14
+static by_uint64_t by_fake_vhash(by_char_t const* name, by_char_t const* version)
+{
+    by_uint64_t h = by_fake_hash(name);
+    return version? by_fake_hash_update(by_fake_hash_update(h, "@"), version) : h;
+}
+
+// is the versioned symbol name (name@version)?
+static by_bool_t by_fake_vname_equal(by_char_t const* vname, by_char_t const* name, by_char_t const* version)
+{
+    by_check_return_val(version, !strcmp(vname, name));
+    by_size_t n = strlen(name);
+    return !strncmp(vname, name, n) && vname[n] == '@' && !strcmp(vname + n + 1, version);
+}
+
+// find the symbol value from the compact index
+static by_bool_t by_fake_dlidx_find(by_fake_dlidx_t const* index, by_size_t index_num, by_uint64_t hash, by_size_t* pvalue)
+{
+    by_size_t l = 0;
+    by_size_t r = index_num;
+    while (l < r)
+    {
+        by_size_t m = l + ((r - l) >> 1);
+        if (index[m].hash < hash) l = m + 1;
+        else r = m;
+    }
+    if (l < index_num && index[l].hash == hash)
+    {
+        *pvalue = index[l].value;
+        return by_true;
+    }
+    return by_false;
+}
+
+/* call the ifunc resolver to get the implementation, e.g. memcpy of glibc
+ *
+ * it's same as the resolver arguments of glibc and bionic, and the x86 resolvers get the cpu features by themselves.
+ */
+static by_pointer_t by_fake_ifunc_resolve(by_pointer_t resolver)
+{
+#if defined(BY_ARCH_ARM64)
+    by_uint64_t args[3];
+    args[0] = sizeof(args);
+    args[1] = (by_uint64_t)getauxval(AT_HWCAP);
+#   ifdef AT_HWCAP2
+    args[2] = (by_uint64_t)getauxval(AT_HWCAP2);
+#   else
+    args[2] = 0;
+#   endif
+    return ((by_pointer_t (*)(by_uint64_t, by_uint64_t const*))resolver)(args[1] | BY_IFUNC_ARG_HWCAP, args);
+#else
+    return ((by_pointer_t (*)(by_ulong_t))resolver)((by_ulong_t)getauxval(AT_HWCAP));
+#endif
+}
+
+// get the symbol value of the compact index and journal, the ifunc symbol is marked by BY_FAKE_SYMVAL_IFUNC
+static __inline__ by_size_t by_fake_symval(ElfW(Sym) const* sym)
+{
+    return (by_size_t)sym->st_value | (BY_ELF_ST_TYPE(sym->st_info) == STT_GNU_IFUNC? BY_FAKE_SYMVAL_IFUNC : 0);
+}
+
+/* get the symbol address from the symbol value
+ *
+ * the ifunc resolver is only called for the current process, so we get the resolver address of the remote process.
+ */
+static by_pointer_t by_fake_symaddr(by_fake_dlctx_ref_t dlctx, by_size_t value)
+{
+    by_pointer_t symboladdr = (by_pointer_t)(dlctx->biasaddr + (value & ~BY_FAKE_SYMVAL_IFUNC));
+    return (value & BY_FAKE_SYMVAL_IFUNC) && !dlctx->pid? by_fake_ifunc_resolve(symboladdr) : symboladdr;
+}
+
+// the callback of dl_iterate_phdr() for getting the build-id
+static by_int_t by_journal_buildid_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+{
+    // is this library?
+    by_pointer_t* args = (by_pointer_t*)udata;
+    by_check_return_val(info && (by_pointer_t)info->dlpi_addr == args[0], 0);
+
+    // find the gnu build-id note in the loaded segments
+    by_int_t   i = 0;
+    by_byte_t* buildid = (by_byte_t*)args[1];
+    by_size_t  maxn = (by_size_t)args[2];
+    for (i = 0; i < info->dlpi_phnum; i++)
+    {
+        ElfW(Phdr) const* phdr = info->dlpi_phdr + i;
+        by_check_continue(phdr->p_type == PT_NOTE);
+
+        by_byte_t const* p = (by_byte_t const*)(info->dlpi_addr + phdr->p_vaddr);
+        by_byte_t const* e = p + phdr->p_memsz;
+        while (p + sizeof(ElfW(Nhdr)) <= e)
+        {
+            ElfW(Nhdr) const* note = (ElfW(Nhdr) const*)p;
+            by_byte_t const*  name = p + sizeof(ElfW(Nhdr));
+            by_byte_t const*  desc = name + ((note->n_namesz + 3) & ~3);
+            by_check_break(desc + note->n_descsz <= e);
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && !memcmp(name, "GNU", 4) && note->n_descsz <= maxn)
+            {
+                memcpy(buildid, desc, note->n_descsz);
+                args[3] = (by_pointer_t)(by_size_t)note->n_descsz;
+                return 1;
+            }
+            p = desc + ((note->n_descsz + 3) & ~3);
+        }
+    }
+    return 1;
+}
+
+// get the build-id of the loaded library, return the build-id size
+static by_size_t by_journal_buildid(by_pointer_t biasaddr, by_byte_t* buildid, by_size_t maxn)
+{
+    // check
+    by_check_return_val(dl_iterate_phdr, 0);
+
+    // get build-id
+    by_pointer_t args[4];
+    args[0] = biasaddr;
+    args[1] = (by_pointer_t)buildid;
+    args[2] = (by_pointer_t)maxn;
+    args[3] = by_null;
+    if (g_by_linker_mutex) pthread_mutex_lock(g_by_linker_mutex);
+    dl_iterate_phdr(by_journal_buildid_cb, args);
+    if (g_by_linker_mutex) pthread_mutex_unlock(g_by_linker_mutex);
+    return (by_size_t)args[3];
+}
+
+// get the library file size, we use the archive size if it's loaded from the zip file
+static by_uint64_t by_journal_filesize(by_char_t const* realpath)
+{
+    by_char_t        archivepath[512];
+    by_char_t const* entryname = by_zip_entry_split(realpath, archivepath, sizeof(archivepath));
+
+    struct stat st;
+    return stat(entryname? archivepath : realpath, &st) == 0? (by_uint64_t)st.st_size : 0;
+}
+
+// retire the replayed symbol table of the journal library, it need be called in lock
+static by_void_t by_journal_lib_retire(by_journal_lib_ref_t jlib, by_journal_syms_t* replayed)
+{
+    by_journal_syms_t* old = jlib->replayed;
+    __atomic_store_n(&jlib->replayed, replayed, __ATOMIC_RELEASE);
+    if (old)
+    {
+        old->next = g_journal_retired;
+        g_journal_retired = old;
+    }
+}
+
+// clear all symbols of the journal library, it need be called in lock
+static by_void_t by_journal_lib_clear(by_journal_lib_ref_t jlib)
+{
+    by_size_t i = 0;
+    for (i = 0; i < jlib->syms_num; i++)
+        free(jlib->syms[i].name);
+    jlib->syms_num = 0;
+    by_journal_lib_retire(jlib, by_null);
+}
+
+// get the total symbol count of the journal library, it need be called in lock
+static by_size_t by_journal_lib_count(by_journal_lib_ref_t jlib)
+{
+    return jlib->syms_num + (jlib->replayed? jlib->replayed->num : 0);
+}
+
+// find the symbol index (lower bound) of the sorted journal symbols
+static by_size_t by_journal_syms_lower(by_journal_sym_t const* syms, by_size_t num, by_uint64_t hash)
+{
+    by_size_t l = 0;
+    by_size_t r = num;
+    while (l < r)
+    {
+        by_size_t m = l + ((r - l) >> 1);
+        if (syms[m].hash < hash) l = m + 1;
+        else r = m;
+    }
+    return l;
+}
+
+// find the symbol value from the sorted journal symbols
+static by_bool_t by_journal_syms_find(by_journal_sym_t const* syms, by_size_t num, by_uint64_t hash, by_char_t const* symbol, by_size_t* pvalue)
+{
+    by_size_t i = by_journal_syms_lower(syms, num, hash);
+    for (; i < num && syms[i].hash == hash; i++)
+    {
+        if (!strcmp(syms[i].name, symbol))
+        {
+            if (pvalue) *pvalue = syms[i].value;
+            return by_true;
+        }
+    }
+    return by_false;
+}
+
+/* merge the recorded symbols into a new replayed table, it need be called in lock
+ *
+ * the names are moved to the new table, so the retired table and the new table may share them.
+ */
+static by_void_t by_journal_lib_freeze(by_journal_lib_ref_t jlib)
+{
+    // check
+    by_check_return(jlib->syms_num);
+
+    // make the new table
+    by_journal_syms_t const* old = jlib->replayed;
+    by_size_t                oldn = old? old->num : 0;
+    by_size_t                num = oldn + jlib->syms_num;
+    by_journal_syms_t*       table = malloc(sizeof(by_journal_syms_t) + num * sizeof(by_journal_sym_t));
+    by_check_return(table);
+
+    // merge the sorted symbols
+    by_size_t i = 0;
+    by_size_t j = 0;
+    by_size_t k = 0;
+    while (i < oldn || j < jlib->syms_num)
+    {
+        if (j >= jlib->syms_num || (i < oldn && old->syms[i].hash <= jlib->syms[j].hash))
+            table->syms[k++] = old->syms[i++];
+        else table->syms[k++] = jlib->syms[j++];
+    }
+    table->num  = num;
+    table->next = by_null;
+
+    // publish it
+    by_journal_lib_retire(jlib, table);
+    jlib->syms_num = 0;
+}
+
+// add symbol to the journal library, it need be called in lock
+static by_void_t by_journal_lib_add(by_journal_lib_ref_t jlib, by_char_t const* symbol, by_size_t value)
+{
+    // has been added?
+    by_uint64_t hash = by_fake_hash(symbol);
+    by_check_return(!jlib->replayed || !by_journal_syms_find(jlib->replayed->syms, jlib->replayed->num, hash, symbol, by_null));
+    by_size_t   i = by_journal_syms_lower(jlib->syms, jlib->syms_num, hash);
+    for (; i < jlib->syms_num && jlib->syms[i].hash == hash; i++)
+    {
+        by_check_return(strcmp(jlib->syms[i].name, symbol));
+    }
+
+    // grow symbols
+    if (jlib->syms_num == jlib->syms_maxn)
+    {
+        by_size_t         maxn = jlib->syms_maxn? jlib->syms_maxn << 1 : 64;
+        by_journal_sym_t* syms = realloc(jlib->syms, maxn * sizeof(by_journal_sym_t));
+        by_check_return(syms);
+        jlib->syms      = syms;
+        jlib->syms_maxn = maxn;
+    }
+
+    // insert it
+    by_char_t* name = strdup(symbol);
+    by_check_return(name);
+    if (i < jlib->syms_num) memmove(jlib->syms + i + 1, jlib->syms + i, (jlib->syms_num - i) * sizeof(by_journal_sym_t));
+    jlib->syms[i].hash  = hash;
+    jlib->syms[i].value = value;
+    jlib->syms[i].name  = name;
+    jlib->syms_num++;
+}
+
+// find the journal library by name, it need be called in lock
+static by_journal_lib_ref_t by_journal_lib_find(by_char_t const* filename)
+{
+    by_journal_lib_ref_t jlib = g_journal_libs;
+    for (; jlib && strcmp(jlib->name, filename); jlib = jlib->next) ;
+    return jlib;
+}
+
+/* validate the journal library with the loaded library, it need be called in lock
+ *
+ * we discard all journaled symbols if the library has been changed.
+ */
+static by_void_t by_journal_lib_validate(by_journal_lib_ref_t jlib, by_char_t const* realpath, by_pointer_t biasaddr)
+{
+    // get the identity of the loaded library
+    by_byte_t   buildid[32];
+    by_size_t   buildid_size = by_journal_buildid(biasaddr, buildid, sizeof(buildid));
+    by_uint64_t filesize = by_journal_filesize(realpath);
+
+    // has been changed?
+    if (strcmp(jlib->realpath, realpath) || jlib->filesize != filesize ||
+        jlib->buildid_size != buildid_size || memcmp(jlib->buildid, buildid, buildid_size))
+    {
+        // trace
+        by_trace("journal: %s has been changed, discard %lu symbols", jlib->name, (by_ulong_t)by_journal_lib_count(jlib));
+
+        by_journal_lib_clear(jlib);
+        strlcpy(jlib->realpath, realpath, sizeof(jlib->realpath));
+        jlib->filesize     = filesize;
+        jlib->buildid_size = buildid_size;
+        memcpy(jlib->buildid, buildid, buildid_size);
+    }
+    jlib->biasaddr = biasaddr;
+}
+
+// get the validated journal library of the loaded library, it will be added if it does not exist
+static by_journal_lib_ref_t by_journal_lib_get(by_char_t const* filename, by_char_t const* realpath, by_pointer_t biasaddr)
+{
+    // check
+    by_check_return_val(g_journal_enabled && strlen(filename) < sizeof(((by_journal_lib_t*)0)->name), by_null);
+
+    // get the journal library
+    pthread_mutex_lock(&g_journal_lock);
+    by_journal_lib_ref_t jlib = by_journal_lib_find(filename);
+    if (!jlib && (jlib = calloc(1, sizeof(by_journal_lib_t))))
+    {
+        strlcpy(jlib->name, filename, sizeof(jlib->name));
+        jlib->next = g_journal_libs;
+        g_journal_libs = jlib;
+    }
+
+    // validate it if it has been reloaded
+    if (jlib && jlib->biasaddr != biasaddr)
+        by_journal_lib_validate(jlib, realpath, biasaddr);
+    pthread_mutex_unlock(&g_journal_lock);
+    return jlib;
+}
+
+// find the symbol value from the journal library
+static by_bool_t by_journal_find(by_journal_lib_ref_t jlib, by_char_t const* symbol, by_size_t* pvalue)
+{
+    // find it from the replayed symbols without lock
+    by_uint64_t              hash = by_fake_hash(symbol);
+    by_journal_syms_t const* replayed = __atomic_load_n(&jlib->replayed, __ATOMIC_ACQUIRE);
+    if (replayed && by_journal_syms_find(replayed->syms, replayed->num, hash, symbol, pvalue))
+        return by_true;
+
+    // find it from the recorded symbols of this run
+    pthread_mutex_lock(&g_journal_lock);
+    by_bool_t ok = by_journal_syms_find(jlib->syms, jlib->syms_num, hash, symbol, pvalue);
+    pthread_mutex_unlock(&g_journal_lock);
+    return ok;
+}
+
+/* record the resolved symbol to the journal library
+ *
+ * the recorded symbols are merged into the replayed table once they are more than 1/4 of it,
+ * so the later lookups of them need not take the lock.
+ */
+static by_void_t by_journal_record(by_journal_lib_ref_t jlib, by_char_t const* symbol, by_size_t value)
+{
+    by_check_return(jlib);
+    pthread_mutex_lock(&g_journal_lock);
+    by_journal_lib_add(jlib, symbol, value);
+    if (jlib->syms_num >= 16 && jlib->syms_num * 4 >= (jlib->replayed? jlib->replayed->num : 0))
+        by_journal_lib_freeze(jlib);
+    pthread_mutex_unlock(&g_journal_lock);
+}
+
+// load the library file of the journal handle if it has not been loaded
+by_bool_t by_elf_dlctx_ensure(by_fake_dlctx_ref_t dlctx)
+{
+    if (__atomic_load_n(&dlctx->lazy, __ATOMIC_ACQUIRE))
+    {
+        pthread_mutex_lock(&g_journal_lock);
+        if (dlctx->lazy && by_elf_dlctx_load(dlctx, dlctx->journal->realpath))
+            __atomic_store_n(&dlctx->lazy, 0, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&g_journal_lock);
+    }
+    return !__atomic_load_n(&dlctx->lazy, __ATOMIC_ACQUIRE);
+}
+
+// get the version name of the given version index from .gnu.version_d
+static by_char_t const* by_fake_version_name(by_fake_dlctx_ref_t dlctx, by_uint16_t ndx)
+{
+    // check
+    by_check_return_val(dlctx->verdef && dlctx->dynstr, by_null);
+
+    // find the version definition
+    by_int_t         i = 0;
+    by_pointer_t     end = dlctx->filedata + dlctx->filesize;
+    by_byte_t const* p = (by_byte_t const*)dlctx->verdef;
+    for (i = 0; i < dlctx->verdef_num && (by_pointer_t)(p + sizeof(ElfW(Verdef))) <= end; i++)
+    {
+        ElfW(Verdef) const* vd = (ElfW(Verdef) const*)p;
+        if (vd->vd_ndx == ndx && vd->vd_cnt)
+        {
+            ElfW(Verdaux) const* aux = (ElfW(Verdaux) const*)(p + vd->vd_aux);
+            by_check_return_val((by_pointer_t)(aux + 1) <= end, by_null);
+
+            by_char_t const* name = (by_char_t const*)dlctx->dynstr + aux->vda_name;
+            return (by_pointer_t)name < end? name : by_null;
+        }
+        by_check_break(vd->vd_next);
+        p += vd->vd_next;
+    }
+    return by_null;
+}
+
+/* is the given .dynsym entry matched with the version?
+ *
+ * we only accept the default version (not hidden) if no version is given, it's same as dlsym() of the linker,
+ * and all symbols are accepted if the library has no version information.
+ */
+static by_bool_t by_fake_version_match(by_fake_dlctx_ref_t dlctx, by_int_t index, by_char_t const* version)
+{
+    // no version information?
+    ElfW(Half) const* versym = (ElfW(Half) const*)dlctx->versym;
+    by_check_return_val(versym, by_true);
+
+    // is default version?
+    ElfW(Half) ndx = versym[index];
+    by_check_return_val(version, !(ndx & 0x8000));
+
+    // is the given version?
+    by_char_t const* name = by_fake_version_name(dlctx, ndx & 0x7fff);
+    return name && !strcmp(name, version);
+}
+
+// get symbol address with the given version from the fake dlopen context, we use the default version if version is null
+static by_pointer_t by_fake_dlvsym(by_fake_dlctx_ref_t dlctx, by_char_t const* symbol, by_char_t const* version)
+{
+    // check
+    by_assert_and_check_return_val(dlctx && symbol, by_null);
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_DLSYM_BEGIN, by_trace_tag(symbol), dlctx, 0);
+
+    // get the journal name, e.g. memcpy@GLIBC_2.14
+    by_char_t        vname[256];
+    by_char_t const* jname = symbol;
+    if (version) jname = snprintf(vname, sizeof(vname), "%s@%s", symbol, version) < (by_int_t)sizeof(vname)? vname : by_null;
+    by_journal_lib_ref_t journal = jname? dlctx->journal : by_null;
+
+    // find the symbol address from the journal first, it has been resolved in the last run
+    by_size_t value = 0;
+    if (journal && by_journal_find(journal, jname, &value))
+    {
+        by_pointer_t symboladdr = by_fake_symaddr(dlctx, value);
+        by_trace_event(BY_TRACE_EVENT_DLSYM_HIT, SHT_NULL, symboladdr, 0);
+        return symboladdr;
+    }
+
+    // find the symbol address from the compact index, the versioned symbols are indexed by the hash of name@version
+    if (dlctx->index)
+    {
+        if (by_fake_dlidx_find(dlctx->index, dlctx->index_num, by_fake_vhash(symbol, version), &value))
+        {
+            by_pointer_t symboladdr = by_fake_symaddr(dlctx, value);
+            by_trace_event(BY_TRACE_EVENT_DLSYM_HIT, SHT_HASH, symboladdr, 1);
+            if (journal) by_journal_record(journal, jname, value);
+            return symboladdr;
+        }
+        by_trace_event(BY_TRACE_EVENT_DLSYM_MISS, by_trace_tag(symbol), 1, 0);
+        return by_null;
+    }
+
+    // load the library file if it's the journal handle
+    by_check_return_val(by_elf_dlctx_ensure(dlctx), by_null);
+    by_assert_and_check_return_val(dlctx->filedata && dlctx->filesize, by_null);
+
+    // init the symbol scan key and kernel
+    by_symscan_key_t  key;
+    by_symscan_func_t scan = by_symscan_func();
+    by_symscan_key_init(&key, symbol);
+
+    // find the symbol address from the .dynsym first, we continue to scan it if the version is not matched
+    by_int_t         i = 0;
+    by_int_t         start = 0;
+    by_pointer_t     end = dlctx->filedata + dlctx->filesize;
+    by_char_t const* dynstr = (by_char_t const*)dlctx->dynstr;
+    ElfW(Sym)*       dynsym = (ElfW(Sym)*)dlctx->dynsym;
+    by_int_t         dynsym_num = dlctx->dynsym_num;
+    while (dynsym && dynstr && start < dynsym_num && (i = scan(dynsym + start, dynsym_num - start, dynstr, end, &key)) >= 0)
+    {
+        i += start;
+        start = i + 1;
+        by_check_continue(dynsym[i].st_shndx != SHN_UNDEF && by_fake_version_match(dlctx, i, version));
+
+        /* NB: sym->st_value is an offset into the section for relocatables,
+         * but a VMA for shared libs or exe files, so we have to subtract the bias
+         */
+        value = by_fake_symval(dynsym + i);
+        by_pointer_t symboladdr = by_fake_symaddr(dlctx, value);
+        by_trace_event(BY_TRACE_EVENT_DLSYM_HIT, SHT_DYNSYM, symboladdr, i + 1);
+        if (journal) by_journal_record(journal, jname, value);
+        return symboladdr;
+    }
+
+    // find the symbol address from the .symtab, it has no version information
+    by_char_t const* strtab = (by_char_t const*)dlctx->strtab;
+    ElfW(Sym)*       symtab = (ElfW(Sym)*)dlctx->symtab;
+    by_int_t         symtab_num = dlctx->symtab_num;
+    if (!version && symtab && strtab && (i = scan(symtab, symtab_num, strtab, end, &key)) >= 0)
+    {
+        value = by_fake_symval(symtab + i);
+        by_pointer_t symboladdr = by_fake_symaddr(dlctx, value);
+        by_trace_event(BY_TRACE_EVENT_DLSYM_HIT, SHT_SYMTAB, symboladdr, dynsym_num + i + 1);
+        if (journal) by_journal_record(journal, jname, value);
+        return symboladdr;
+    }
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_DLSYM_MISS, by_trace_tag(symbol), dynsym_num + symtab_num, 0);
+    return by_null;
+}
+
+// get symbol address from the fake dlopen context
+by_pointer_t by_elf_dlsym(by_fake_dlctx_ref_t dlctx, by_char_t const* symbol)
+{
+    return by_fake_dlvsym(dlctx, symbol, by_null);
+}
+
+// allocate the fake dlopen context from the handle pool or the caller-provided storage
+by_fake_dlctx_ref_t by_elf_dlctx_alloc(by_pointer_t storage)
+{
+    by_fake_dlctx_ref_t dlctx = by_null;
+    if (storage)
+    {
+        dlctx = (by_fake_dlctx_ref_t)storage;
+        memset(dlctx, 0, sizeof(by_fake_dlctx_t));
+        dlctx->storage = by_true;
+        __atomic_add_fetch(&g_dlctx_storages, 1, __ATOMIC_RELAXED);
+    }
+    else dlctx = (by_fake_dlctx_ref_t)by_pool_alloc(&g_dlctx_pool);
+    return dlctx;
+}
+
+// free the fake dlopen context, the caller-provided storage is only cleared
+static by_void_t by_fake_dlctx_free(by_fake_dlctx_ref_t dlctx)
+{
+    dlctx->magic = 0;
+    if (dlctx->storage) __atomic_sub_fetch(&g_dlctx_storages, 1, __ATOMIC_RELAXED);
+    else by_pool_free(&g_dlctx_pool, dlctx);
+}
+
+// close the fake dlopen context
+by_int_t by_elf_dlclose(by_fake_dlctx_ref_t dlctx)
+{
+    // check
+    by_assert_and_check_return_val(dlctx, -1);
+
+    // clear data
+    dlctx->biasaddr   = by_null;
+    dlctx->dynsym     = by_null;
+    dlctx->dynstr     = by_null;
+    dlctx->dynsym_num = 0;
+    dlctx->strtab     = by_null;
+    dlctx->symtab     = by_null;
+    dlctx->symtab_num = 0;
+    dlctx->versym     = by_null;
+    dlctx->verdef     = by_null;
+    dlctx->verdef_num = 0;
+
+    // unmap file data
+    if (dlctx->filedata) by_fake_close_file(dlctx->filedata, dlctx->filesize);
+    dlctx->filedata = by_null;
+    dlctx->filesize = 0;
+
+    // free the compact index, the shared index will be unmapped by by_dlshare_exit()
+    if (dlctx->index && !dlctx->index_shared) free(dlctx->index);
+    dlctx->index     = by_null;
+    dlctx->index_num = 0;
+
+    // free the demangled name index
+    if (dlctx->demangled) free(dlctx->demangled);
+    dlctx->demangled     = by_null;
+    dlctx->demangled_num = 0;
+
+    // free the tls symbol cache
+    if (dlctx->tls_cache) free(dlctx->tls_cache);
+    dlctx->tls_cache     = by_null;
+    dlctx->tls_cache_num = 0;
+
+    // free the line table
+    if (dlctx->lines)
+    {
+        by_dwarf_lines_exit(dlctx->lines);
+        free(dlctx->lines);
+    }
+    dlctx->lines = by_null;
+
+    // free context
+    by_fake_dlctx_free(dlctx);
+    return 0;
+}
+
+// load the library file and its symbol tables to the fake dlopen context
+by_bool_t by_elf_dlctx_load(by_fake_dlctx_ref_t dlctx, by_char_t const* realpath)
+{
+    // check
+    by_assert_and_check_return_val(dlctx && dlctx->biasaddr && realpath && !dlctx->filedata, by_false);
+
+    // do load
+    by_bool_t ok = by_false;
+    do
+    {
+        // open file
+        dlctx->filedata = by_fake_open_file(realpath, &dlctx->filesize);
+        by_assert_and_check_break(dlctx->filedata && dlctx->filesize);
+
+        // trace
+        by_trace("fake_dlopen: biasaddr: %p, realpath: %s, filesize: %d", dlctx->biasaddr, realpath, (by_int_t)dlctx->filesize);
+        by_trace_event(BY_TRACE_EVENT_OPEN_FILE, dlctx->filedata, dlctx->filesize, 0);
+
+        // get elf
+        ElfW(Ehdr)*  elf = (ElfW(Ehdr)*)dlctx->filedata;
+        by_pointer_t end = dlctx->filedata + dlctx->filesize;
+        by_assert_and_check_break((by_pointer_t)(elf + 1) < end);
+
+        // get .shstrtab section
+        by_pointer_t shoff = dlctx->filedata + elf->e_shoff;
+        ElfW(Shdr)*  shstrtab = (ElfW(Shdr)*)(shoff + elf->e_shstrndx * elf->e_shentsize);
+        by_assert_and_check_break((by_pointer_t)(shstrtab + 1) <= end);
+
+        by_pointer_t shstr = dlctx->filedata + shstrtab->sh_offset;
+        by_assert_and_check_break(shstr < end);
+
+        // parse elf sections
+        by_int_t  i = 0;
+        by_int_t  versym_num = 0;
+        by_bool_t broken = by_false;
+        for (i = 0; !broken && i < elf->e_shnum && shoff; i++, shoff += elf->e_shentsize)
+        {
+            // get section
+            ElfW(Shdr)* sh = (ElfW(Shdr)*)shoff;
+            by_assert_and_check_break((by_pointer_t)(sh + 1) <= end && shstr + sh->sh_name < end);
+            by_assert_and_check_break(dlctx->filedata + sh->sh_offset < end);
+
+            // trace
+            by_trace_event(BY_TRACE_EVENT_OPEN_SECTION, i, sh->sh_type, sh->sh_offset);
+
+            // get .dynsym and .symtab sections
+            switch(sh->sh_type)
+            {
+            case SHT_DYNSYM:
+                // get .dynsym
+                if (dlctx->dynsym)
+                {
+                    by_trace("%s: duplicate .dynsym sections", realpath);
+                    broken = by_true;
+                    break;
+                }
+                dlctx->dynsym     = dlctx->filedata + sh->sh_offset;
+                dlctx->dynsym_num = (sh->sh_size / sizeof(ElfW(Sym)));
+                by_trace_event(BY_TRACE_EVENT_OPEN_SYMTAB, SHT_DYNSYM, dlctx->dynsym, dlctx->dynsym_num);
+                break;
+            case SHT_SYMTAB:
+                // get .symtab
+                if (dlctx->symtab)
+                {
+                    by_trace("%s: duplicate .symtab sections", realpath);
+                    broken = by_true;
+                    break;
+                }
+                dlctx->symtab     = dlctx->filedata + sh->sh_offset;
+                dlctx->symtab_num = (sh->sh_size / sizeof(ElfW(Sym)));
+                by_trace_event(BY_TRACE_EVENT_OPEN_SYMTAB, SHT_SYMTAB, dlctx->symtab, dlctx->symtab_num);
+                break;
+            case SHT_GNU_versym:
+                // get .gnu.version, it's parallel to .dynsym
+                dlctx->versym = dlctx->filedata + sh->sh_offset;
+                versym_num    = (by_int_t)(sh->sh_size / sizeof(ElfW(Half)));
+                break;
+            case SHT_GNU_verdef:
+                // get .gnu.version_d
+                dlctx->verdef     = dlctx->filedata + sh->sh_offset;
+                dlctx->verdef_num = sh->sh_info;
+                break;
+            case SHT_STRTAB:
+                // get .dynstr
+                if (!strcmp(shstr + sh->sh_name, ".dynstr"))
+                {
+                    // .dynstr is guaranteed to be the first STRTAB
+                    if (dlctx->dynstr) break;
+                    dlctx->dynstr = dlctx->filedata + sh->sh_offset;
+                    by_trace_event(BY_TRACE_EVENT_OPEN_SYMTAB, SHT_STRTAB, dlctx->dynstr, 0);
+                }
+                // get .strtab
+                else if (!strcmp(shstr + sh->sh_name, ".strtab"))
+                {
+                    if (dlctx->strtab) break;
+                    dlctx->strtab = dlctx->filedata + sh->sh_offset;
+                    by_trace_event(BY_TRACE_EVENT_OPEN_SYMTAB, SHT_STRTAB, dlctx->strtab, 0);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        by_check_break(!broken && dlctx->dynstr && dlctx->dynsym);
+
+        // we cannot use the broken .gnu.version
+        if (dlctx->versym && versym_num < dlctx->dynsym_num)
+        {
+            dlctx->versym     = by_null;
+            dlctx->verdef     = by_null;
+            dlctx->verdef_num = 0;
+        }
+
+        // ok
+        ok = by_true;
+
+    } while (0);
+
+    // failed? clear the loaded tables
+    if (!ok)
+    {
+        dlctx->dynsym     = by_null;
+        dlctx->dynstr     = by_null;
+        dlctx->dynsym_num = 0;
+        dlctx->strtab     = by_null;
+        dlctx->symtab     = by_null;
+        dlctx->symtab_num = 0;
+        dlctx->versym     = by_null;
+        dlctx->verdef     = by_null;
+        dlctx->verdef_num = 0;
+        if (dlctx->filedata) by_fake_close_file(dlctx->filedata, dlctx->filesize);
+        dlctx->filedata   = by_null;
+        dlctx->filesize   = 0;
+    }
+    return ok;
+}
+
+// open the fake dlopen context from the given load bias address and real path
+by_fake_dlctx_ref_t by_elf_dlopen_file(by_pointer_t storage, by_pointer_t biasaddr, by_char_t const* realpath)
+{
+    // check
+    by_assert_and_check_return_val(biasaddr && realpath, by_null);
+
+    // init context
+    by_fake_dlctx_ref_t dlctx = by_elf_dlctx_alloc(storage);
+    by_assert_and_check_return_val(dlctx, by_null);
+
+    dlctx->magic    = BY_FAKE_DLCTX_MAGIC;
+    dlctx->biasaddr = biasaddr;
+
+    // load file
+    if (!by_elf_dlctx_load(dlctx, realpath))
+    {
+        by_elf_dlclose(dlctx);
+        dlctx = by_null;
+    }
+    return dlctx;
+}
+
+/* @see https://www.sunmoonblog.com/2019/06/04/fake-dlopen/
+ * https://github.com/avs333/Nougat_dlfunctions
+ */
+static by_fake_dlctx_ref_t by_fake_dlopen_impl(by_pointer_t storage, by_char_t const* filename, by_int_t flag)
+{
+    // check
+    by_assert_and_check_return_val(filename, by_null);
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_OPEN_BEGIN, by_trace_tag(filename), flag, 0);
+
+    // attempt to find the load bias address and real path
+    by_char_t    realpath[512];
+    by_pointer_t biasaddr = by_fake_find_biasaddr(filename, realpath, sizeof(realpath));
+    by_trace_event(BY_TRACE_EVENT_OPEN_BIASADDR, by_trace_tag(filename), biasaddr, 0);
+
+    // get the journal library, we need not load the library file now if some symbols have been journaled
+    by_fake_dlctx_ref_t  dlctx = by_null;
+    by_journal_lib_ref_t jlib = biasaddr? by_journal_lib_get(filename, realpath, biasaddr) : by_null;
+    if (jlib && __atomic_load_n(&jlib->replayed, __ATOMIC_ACQUIRE) && (dlctx = by_elf_dlctx_alloc(storage)))
+    {
+        dlctx->magic    = BY_FAKE_DLCTX_MAGIC;
+        dlctx->biasaddr = biasaddr;
+        dlctx->journal  = jlib;
+        dlctx->lazy     = 1;
+    }
+
+    // open it
+    if (!dlctx && biasaddr && (dlctx = by_elf_dlopen_file(storage, biasaddr, realpath)))
+        dlctx->journal = jlib;
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_OPEN_END, by_trace_tag(filename), dlctx, 0);
+    return dlctx;
+}
+static by_fake_dlctx_ref_t by_fake_dlopen(by_char_t const* filename, by_int_t flag)
+{
+    by_linker_init();
+    return by_fake_dlopen_impl(by_null, filename, flag);
+}
+
+// the callback of dl_iterate_phdr() for making the module range table
+static by_int_t by_fake_modules_make_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+{
+    // get the address range of all loaded segments and the .eh_frame_hdr segment
+    by_int_t  i = 0;
+    by_size_t start = (by_size_t)-1;
+    by_size_t end = 0;
+    by_size_t ehhdr = 0;
+    for (i = 0; i < info->dlpi_phnum; i++)
+    {
+        ElfW(Phdr) const* phdr = info->dlpi_phdr + i;
+        if (phdr->p_type == PT_GNU_EH_FRAME && phdr->p_memsz) ehhdr = (by_size_t)(info->dlpi_addr + phdr->p_vaddr);
+        by_check_continue(phdr->p_type == PT_LOAD && phdr->p_memsz);
+        by_size_t addr = (by_size_t)(info->dlpi_addr + phdr->p_vaddr);
+        if (addr < start) start = addr;
+        if (addr + phdr->p_memsz > end) end = addr + phdr->p_memsz;
+    }
+    by_check_return_val(start < end, 0);
+
+    // grow the module table
+    by_pointer_t* args = (by_pointer_t*)udata;
+    by_fake_module_ref_t modules = (by_fake_module_ref_t)args[0];
+    by_size_t            count = (by_size_t)args[1];
+    by_size_t            maxn = (by_size_t)args[2];
+    if (count == maxn)
+    {
+        maxn = maxn? maxn << 1 : 64;
+        by_fake_module_ref_t data = realloc(modules, maxn * sizeof(by_fake_module_t));
+        by_check_return_val(data, 1);
+        modules = data;
+        args[0] = (by_pointer_t)modules;
+        args[2] = (by_pointer_t)maxn;
+    }
+
+    // add module
+    by_fake_module_ref_t module = modules + count;
+    module->start    = start;
+    module->end      = end;
+    module->biasaddr = (by_pointer_t)info->dlpi_addr;
+    module->name     = strdup(info->dlpi_name? info->dlpi_name : "");
+    by_check_return_val(module->name, 1);
+    if (!ehhdr || !by_dwarf_ehhdr_init(&module->ehhdr, (by_cpointer_t)ehhdr))
+        memset(&module->ehhdr, 0, sizeof(by_dwarf_ehhdr_t));
+    args[1] = (by_pointer_t)(count + 1);
+    return 0;
+}
+
+// the module comparator
+static by_int_t by_fake_modules_comp(by_cpointer_t a, by_cpointer_t b)
+{
+    by_fake_module_t const* x = (by_fake_module_t const*)a;
+    by_fake_module_t const* y = (by_fake_module_t const*)b;
+    return x->start < y->start? -1 : (x->start > y->start);
+}
+
+// make the module range table of all loaded libraries, it need be called in lock
+by_void_t by_elf_modules_make()
+{
+    // clear the old modules
+    by_size_t i = 0;
+    for (i = 0; i < g_modules_num; i++)
+        free(g_modules[i].name);
+    if (g_modules) free(g_modules);
+    g_modules     = by_null;
+    g_modules_num = 0;
+    g_by_modules_gen++;
+    by_check_return(dl_iterate_phdr);
+
+    // make modules
+    by_pointer_t args[3];
+    args[0] = by_null;
+    args[1] = by_null;
+    args[2] = by_null;
+    if (g_by_linker_mutex) pthread_mutex_lock(g_by_linker_mutex);
+    dl_iterate_phdr(by_fake_modules_make_cb, args);
+    if (g_by_linker_mutex) pthread_mutex_unlock(g_by_linker_mutex);
+
+    // sort them by address
+    g_modules     = (by_fake_module_ref_t)args[0];
+    g_modules_num = (by_size_t)args[1];
+    if (g_modules_num) qsort(g_modules, g_modules_num, sizeof(by_fake_module_t), by_fake_modules_comp);
+
+    // trace
+    by_trace("modules: %lu loaded", (by_ulong_t)g_modules_num);
+}
+
+// find the module containing the given address, it need be called in lock
+by_fake_module_ref_t by_elf_modules_find(by_size_t addr)
+{
+    // find the last module whose start address <= addr
+    by_size_t l = 0;
+    by_size_t r = g_modules_num;
+    while (l < r)
+    {
+        by_size_t m = l + ((r - l) >> 1);
+        if (g_modules[m].start <= addr) l = m + 1;
+        else r = m;
+    }
+    return (l && addr < g_modules[l - 1].end)? g_modules + l - 1 : by_null;
+}
+
+/* find the module containing the given address, and get its load bias address and name
+ *
+ * we rebuild the module range table only if the address is not found, the library may be loaded after making it.
+ */
+static by_pointer_t by_fake_find_module(by_size_t addr, by_char_t* name, by_size_t maxn, by_bool_t rebuild)
+{
+    by_pointer_t biasaddr = by_null;
+    pthread_mutex_lock(&g_by_modules_lock);
+    by_fake_module_ref_t module = rebuild? by_null : by_elf_modules_find(addr);
+    if (!module)
+    {
+        by_elf_modules_make();
+        module = by_elf_modules_find(addr);
+    }
+    if (module)
+    {
+        biasaddr = module->biasaddr;
+        strlcpy(name, module->name, maxn);
+    }
+    pthread_mutex_unlock(&g_by_modules_lock);
+    return biasaddr;
+}
+
+// find the file path of the mapping containing the given address by PROCMAP_QUERY, we need not parse maps
+static by_int_t by_fake_find_path_from_procmap(by_size_t addr, by_char_t* path, by_size_t maxn)
+{
+    // check
+    by_check_return_val(!g_procmap_query_disabled, -1);
+
+    // we cannot cache the maps fd, because it will refer to the parent process after fork()
+    by_int_t fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    by_check_return_val(fd >= 0, -1);
+
+    // query the covering mapping
+    by_procmap_query_t query;
+    memset(&query, 0, sizeof(query));
+    query.size          = sizeof(query);
+    query.query_addr    = (by_uint64_t)addr;
+    query.vma_name_addr = (by_uint64_t)(by_size_t)path;
+    query.vma_name_size = (by_uint32_t)maxn;
+    by_int_t ok = ioctl(fd, PROCMAP_QUERY, &query);
+    by_int_t err = errno;
+    close(fd);
+
+    // not supported? we need not try it again
+    if (ok < 0 && (err == ENOTTY || err == EINVAL || err == EOPNOTSUPP))
+    {
+        g_procmap_query_disabled = by_true;
+        return -1;
+    }
+    return (!ok && query.vma_name_size && path[0] == '/')? 1 : 0;
+}
+
+// find the file path of the mapping containing the given address from maps
+static by_bool_t by_fake_find_path_from_maps(by_size_t addr, by_char_t* path, by_size_t maxn)
+{
+    FILE* fp = fopen("/proc/self/maps", "r");
+    by_check_return_val(fp, by_false);
+
+    by_bool_t ok = by_false;
+    by_char_t line[512];
+    while (!ok && fgets(line, sizeof(line), fp))
+    {
+        // parse line, e.g. 7f1b4f4000-7f1b4f5000 r-xp 00000000 fd:00 1234 /system/lib64/libc.so
+        by_size_t start = 0;
+        by_size_t end = 0;
+        by_int_t  pos = 0;
+        by_check_continue(sscanf(line, "%zx-%zx %*s %*s %*s %*s%n", &start, &end, &pos) == 2);
+        by_check_continue(addr >= start && addr < end);
+
+        by_char_t* p = line + pos;
+        by_char_t* e = p + strlen(p);
+        while (p < e && isspace((by_int_t)*p)) p++;
+        while (p < e && isspace((by_int_t)(*(e - 1)))) e--;
+        *e = '\0';
+        if (*p == '/')
+        {
+            strlcpy(path, p, maxn);
+            ok = by_true;
+        }
+        break;
+    }
+    fclose(fp);
+    return ok;
+}
+
+// get the real path of the module containing the given address if the module name is not full path
+by_bool_t by_elf_find_realpath(by_size_t addr, by_char_t* realpath, by_size_t maxn)
+{
+    by_check_return_val(realpath[0] != '/', by_true);
+    by_int_t found = by_fake_find_path_from_procmap(addr, realpath, maxn);
+    if (found < 0 && !by_fake_find_path_from_maps(addr, realpath, maxn)) found = 0;
+    return found > 0;
+}
+
+// open the module containing the given address
+static by_fake_dlctx_ref_t by_fake_dlopen_by_addr(by_size_t addr, by_int_t flag)
+{
+    // find the module from the module range table
+    by_char_t    name[512];
+    by_char_t    realpath[512];
+    by_bool_t    retry = by_false;
+    by_pointer_t biasaddr = by_null;
+    by_fake_dlctx_ref_t dlctx = by_null;
+    do
+    {
+        name[0] = '\0';
+        biasaddr = by_fake_find_module(addr, name, sizeof(name), retry);
+
+        /* get the real path
+         *
+         * dlpi_name may be not full path (e.g. the main program or the libraries loaded by soname),
+         * we use the path of the mapping instead of it.
+         */
+        if (name[0] == '/') strlcpy(realpath, name, sizeof(realpath));
+        else
+        {
+            by_int_t found = by_fake_find_path_from_procmap(addr, realpath, sizeof(realpath));
+            if (found < 0 && !by_fake_find_path_from_maps(addr, realpath, sizeof(realpath))) found = 0;
+            by_check_break(found);
+        }
+
+        // trace
+        by_trace("dlopen_by_addr: %p, biasaddr: %p, realpath: %s", (by_pointer_t)addr, biasaddr, realpath);
+
+        // open it with the normal fake dlopen
+        dlctx = by_fake_dlopen(realpath, flag);
+
+        /* the found module may be stale or the same file may be loaded twice,
+         * so we open it with the load bias address of the module if the load bias address does not match
+         */
+        if (biasaddr && (!dlctx || dlctx->biasaddr != biasaddr))
+        {
+            if (dlctx) by_elf_dlclose(dlctx);
+            dlctx = by_null;
+
+            // the module range table may be stale, we rebuild it and try it again
+            if (!retry) retry = by_true;
+            else
+            {
+                dlctx = by_elf_dlopen_file(by_null, biasaddr, realpath);
+                break;
+            }
+        }
+        else break;
+
+    } while (1);
+    return dlctx;
+}
+
+// advise the kernel for the given mapped range
+static by_void_t by_fake_madvise(by_cpointer_t data, by_size_t size, by_int_t advice)
+{
+    by_size_t delta = (by_size_t)data & (by_size_t)(getpagesize() - 1);
+    madvise((by_pointer_t)((by_size_t)data - delta), size + delta, advice);
+}
+
+// get the resident size of the given mapped range
+static by_size_t by_fake_resident(by_pointer_t data, by_size_t size)
+{
+    // check
+    by_check_return_val(data && size, 0);
+
+    // get the page count
+    by_size_t pagesize = (by_size_t)getpagesize();
+    by_size_t delta = (by_size_t)data & (pagesize - 1);
+    by_size_t pages = (size + delta + pagesize - 1) / pagesize;
+
+    // get the resident pages
+    by_size_t      resident = 0;
+    unsigned char* vec = malloc(pages);
+    if (vec)
+    {
+        if (0 == mincore(data - delta, size + delta, vec))
+        {
+            for (by_size_t i = 0; i < pages; i++)
+                if (vec[i] & 1) resident++;
+        }
+        free(vec);
+    }
+    return resident * pagesize;
+}
+
+// the compact index comparator
+static by_int_t by_fake_dlidx_comp(by_cpointer_t a, by_cpointer_t b)
+{
+    by_uint64_t x = ((by_fake_dlidx_t const*)a)->hash;
+    by_uint64_t y = ((by_fake_dlidx_t const*)b)->hash;
+    return x < y? -1 : (x > y);
+}
+
+// merge two sorted runs of the compact index, the entries of the first run go first if they have the same hash
+static by_void_t by_fake_dlidx_merge(by_fake_dlidx_t const* a, by_size_t an, by_fake_dlidx_t const* b, by_size_t bn, by_fake_dlidx_ref_t output)
+{
+    by_fake_dlidx_t const* ae = a + an;
+    by_fake_dlidx_t const* be = b + bn;
+    while (a < ae && b < be)
+        *output++ = b->hash < a->hash? *b++ : *a++;
+    if (a < ae) memcpy(output, a, (ae - a) * sizeof(by_fake_dlidx_t));
+    if (b < be) memcpy(output, b, (be - b) * sizeof(by_fake_dlidx_t));
+}
+
+/* sort the compact index by name hash stably
+ *
+ * the symbols are added in the table order (.dynsym first, then .symtab), so the symbols with the same name keep this order,
+ * and by_fake_dlidx_find() will find the same symbol as the full symbol table lookup, e.g. the global symbol instead of the local one.
+ *
+ * the temporary buffer need be the same size as the index, it's not used for the small index.
+ */
+static by_bool_t by_fake_dlidx_sort(by_fake_dlidx_ref_t index, by_size_t count, by_fake_dlidx_ref_t temp)
+{
+    // sort the small blocks by insertion sort
+    by_size_t i = 0;
+    by_size_t j = 0;
+    for (i = 1; i < count; i++)
+    {
+        by_fake_dlidx_t entry = index[i];
+        if ((i & 15) && entry.hash < index[i - 1].hash)
+        {
+            for (j = i; (j & 15) && entry.hash < index[j - 1].hash; j--)
+                index[j] = index[j - 1];
+            index[j] = entry;
+        }
+    }
+    by_check_return_val(count > 16, by_true);
+    by_check_return_val(temp, by_false);
+
+    // merge the sorted blocks bottom-up
+    by_size_t           width = 0;
+    by_fake_dlidx_ref_t input = index;
+    by_fake_dlidx_ref_t output = temp;
+    for (width = 16; width < count; width <<= 1)
+    {
+        for (i = 0; i < count; i += width << 1)
+        {
+            by_size_t an = count - i < width? count - i : width;
+            by_size_t bn = count - i - an < width? count - i - an : width;
+            by_fake_dlidx_merge(input + i, an, input + i + an, bn, output + i);
+        }
+        by_fake_dlidx_ref_t swap = input;
+        input  = output;
+        output = swap;
+    }
+    if (input != index) memcpy(index, input, count * sizeof(by_fake_dlidx_t));
+    return by_true;
+}
+
+// add the symbol to the compact index if it's wanted
+static by_size_t by_fake_dlcompact_add(by_fake_dlidx_ref_t index, by_size_t count, by_size_t maxn, by_char_t const* name, by_char_t const* version,
+    by_size_t value, by_fake_dlidx_t const* wanted, by_char_t const** wanted_names, by_size_t wanted_num)
+{
+    // check
+    by_check_return_val(count < maxn, count);
+
+    // is wanted symbol?
+    by_uint64_t hash = by_fake_vhash(name, version);
+    if (wanted)
+    {
+        by_size_t wanted_index = 0;
+        by_check_return_val(by_fake_dlidx_find(wanted, wanted_num, hash, &wanted_index), count);
+        by_check_return_val(by_fake_vname_equal(wanted_names[wanted_index], name, version), count);
+    }
+
+    // add it
+    index[count].hash  = hash;
+    index[count].value = value;
+    return count + 1;
+}
+
+/* add the symbols of the given table to the compact index
+ *
+ * we only add the wanted symbols if the wanted list (sorted by hash) is given,
+ * and their names will be also compared to avoid hash collisions.
+ *
+ * the versioned symbols in .dynsym are also indexed by the hash of name@version,
+ * and only the default versions are indexed by the plain name, so we need not filter versions when finding it.
+ */
+static by_size_t by_fake_dlcompact_table(by_fake_dlctx_ref_t dlctx, ElfW(Sym) const* syms, by_int_t num, by_char_t const* strtab, ElfW(Half) const* versym,
+    by_fake_dlidx_t const* wanted, by_char_t const** wanted_names, by_size_t wanted_num, by_fake_dlidx_ref_t index, by_size_t maxn)
+{
+    // tell kernel that we will read the table sequentially
+    by_size_t tablesize = num * sizeof(ElfW(Sym));
+    by_fake_madvise(syms, tablesize, MADV_SEQUENTIAL);
+    by_fake_madvise(syms, tablesize, MADV_WILLNEED);
+
+    // add symbols
+    by_int_t     i = 0;
+    by_size_t    count = 0;
+    by_pointer_t end = dlctx->filedata + dlctx->filesize;
+    for (i = 0; i < num && count < maxn; i++)
+    {
+        // only add the defined symbols
+        ElfW(Sym) const* sym = syms + i;
+        by_check_continue(sym->st_shndx != SHN_UNDEF && sym->st_value);
+
+        by_char_t const* name = strtab + sym->st_name;
+        by_check_continue((by_pointer_t)name < end && *name);
+
+        // get version
+        ElfW(Half)       ndx = versym? versym[i] : 0;
+        by_char_t const* version = (ndx & 0x7fff) > 1? by_fake_version_name(dlctx, ndx & 0x7fff) : by_null;
+
+        // add it with the plain name if it's default version
+        if (!(ndx & 0x8000))
+            count = by_fake_dlcompact_add(index, count, maxn, name, by_null, by_fake_symval(sym), wanted, wanted_names, wanted_num);
+
+        // add it with the versioned name
+        if (version)
+            count = by_fake_dlcompact_add(index, count, maxn, name, version, by_fake_symval(sym), wanted, wanted_names, wanted_num);
+    }
+
+    // we need not the table pages now
+    by_fake_madvise(syms, tablesize, MADV_DONTNEED);
+    return count;
+}
+
+// get the thread count of building the symbol index with the given symbol count
+static by_size_t by_fake_index_threads(by_size_t total, by_size_t minn)
+{
+    by_check_return_val(total >= minn, 1);
+    by_size_t nthreads = __atomic_load_n(&g_index_threads, __ATOMIC_RELAXED);
+    if (!nthreads)
+    {
+        by_long_t nproc = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = nproc > 1? (by_size_t)(nproc < 8? nproc : 8) : 1;
+    }
+    return nthreads < BY_FAKE_INDEX_THREADS_MAXN? nthreads : BY_FAKE_INDEX_THREADS_MAXN;
+}
+
+// run the given tasks in parallel, the last task is run in the current thread
+static by_void_t by_fake_index_run(by_pointer_t (*func)(by_pointer_t), by_byte_t* tasks, by_size_t tasksize, by_size_t ntasks)
+{
+    by_size_t i = 0;
+    pthread_t threads[BY_FAKE_INDEX_THREADS_MAXN];
+    by_bool_t started[BY_FAKE_INDEX_THREADS_MAXN];
+    memset(started, 0, sizeof(started));
+    for (i = 0; i + 1 < ntasks; i++)
+        started[i] = !pthread_create(&threads[i], by_null, func, tasks + i * tasksize);
+    for (i = 0; i < ntasks; i++)
+    {
+        if (started[i]) pthread_join(threads[i], by_null);
+        else func(tasks + i * tasksize);
+    }
+}
+
+// make the sorted compact index slice of the symbols in the given task
+static by_pointer_t by_fake_dlcompact_task(by_pointer_t priv)
+{
+    by_fake_dlcompact_task_t* task = (by_fake_dlcompact_task_t*)priv;
+    task->count = by_fake_dlcompact_table(task->dlctx, task->syms, task->num, task->strtab, task->versym, by_null, by_null, 0, task->index, task->maxn);
+    by_fake_dlidx_sort(task->index, task->count, task->temp);
+    return by_null;
+}
+
+// merge two sorted runs of the compact index
+static by_pointer_t by_fake_dlmerge_task(by_pointer_t priv)
+{
+    by_fake_dlmerge_task_t* task = (by_fake_dlmerge_task_t*)priv;
+    by_fake_dlidx_merge(task->runs[0], task->counts[0], task->runs[1], task->counts[1], task->output);
+    return by_null;
+}
+
+/* make the full compact index of all symbols in parallel
+ *
+ * the symbol tables are split to the chunks, and each chunk is hashed and sorted to its own slice of the index by one thread.
+ * then these sorted runs are merged pairwise in parallel, so we need only one extra buffer of the index size.
+ *
+ * the tasks and runs are kept in the table order and all sorts and merges are stable,
+ * so the index has the same order as the serial one for the symbols with the same name.
+ */
+static by_size_t by_fake_dlcompact_parallel(by_fake_dlctx_ref_t dlctx, by_fake_dlidx_ref_t* pindex, by_fake_dlidx_ref_t* ptemp, by_size_t maxn, by_size_t nthreads)
+{
+    // split the symbol tables to tasks, each .dynsym entry may be indexed by two names
+    by_size_t                i = 0;
+    by_size_t                ntasks = 0;
+    by_size_t                offset = 0;
+    by_fake_dlidx_ref_t      index = *pindex;
+    by_fake_dlidx_ref_t      output = *ptemp;
+    by_fake_dlcompact_task_t tasks[BY_FAKE_INDEX_THREADS_MAXN];
+    ElfW(Sym) const*         tables[2] = {(ElfW(Sym) const*)dlctx->dynsym, (ElfW(Sym) const*)dlctx->symtab};
+    by_char_t const*         strtabs[2] = {(by_char_t const*)dlctx->dynstr, (by_char_t const*)dlctx->strtab};
+    ElfW(Half) const*        versyms[2] = {(ElfW(Half) const*)dlctx->versym, by_null};
+    by_int_t                 nums[2] = {dlctx->dynsym_num, dlctx->symtab_num};
+    by_size_t                counts[2] = {0};
+    memset(tasks, 0, sizeof(tasks));
+    for (i = 0; i < 2; i++)
+    {
+        if (!tables[i] || !strtabs[i] || nums[i] <= 0) nums[i] = 0;
+    }
+    by_check_return_val(nums[0] + nums[1] > 0, 0);
+
+    // the tasks count of each table is proportional to its size, and each non-empty table has one task at least
+    counts[0] = nums[0]? (by_size_t)(((by_uint64_t)nums[0] * nthreads) / (nums[0] + nums[1])) : 0;
+    if (nums[0] && !counts[0]) counts[0] = 1;
+    if (nums[1] && counts[0] == nthreads) counts[0] = nthreads - 1;
+    counts[1] = nums[1]? nthreads - counts[0] : 0;
+    for (i = 0; i < 2; i++)
+    {
+        by_check_continue(counts[i]);
+        by_int_t step = (by_int_t)((nums[i] + counts[i] - 1) / counts[i]);
+        by_int_t start = 0;
+        for (start = 0; start < nums[i]; start += step)
+        {
+            by_fake_dlcompact_task_t* task = tasks + ntasks++;
+            task->dlctx  = dlctx;
+            task->syms   = tables[i] + start;
+            task->num    = nums[i] - start < step? nums[i] - start : step;
+            task->strtab = strtabs[i];
+            task->versym = versyms[i]? versyms[i] + start : by_null;
+            task->index  = index + offset;
+            task->temp   = output + offset;
+            task->maxn   = (by_size_t)task->num * (i? 1 : 2);
+            offset += task->maxn;
+        }
+    }
+    by_assert_and_check_return_val(offset <= maxn, 0);
+
+    // make the sorted slices
+    by_fake_index_run(by_fake_dlcompact_task, (by_byte_t*)tasks, sizeof(by_fake_dlcompact_task_t), ntasks);
+
+    // move the slices to the head of index
+    by_size_t                runs_num = 0;
+    by_size_t                runs_count[BY_FAKE_INDEX_THREADS_MAXN];
+    by_size_t                count = 0;
+    for (i = 0; i < ntasks; i++)
+    {
+        if (tasks[i].index != index + count && tasks[i].count)
+            memmove(index + count, tasks[i].index, tasks[i].count * sizeof(by_fake_dlidx_t));
+        runs_count[runs_num++] = tasks[i].count;
+        count += tasks[i].count;
+    }
+
+    // merge the sorted runs pairwise
+    while (runs_num > 1)
+    {
+        by_fake_dlmerge_task_t merges[BY_FAKE_INDEX_THREADS_MAXN];
+        by_size_t              merges_num = 0;
+        by_size_t              offset = 0;
+        for (i = 0; i < runs_num; i += 2)
+        {
+            by_fake_dlmerge_task_t* merge = merges + merges_num++;
+            merge->runs[0]   = index + offset;
+            merge->counts[0] = runs_count[i];
+            merge->runs[1]   = index + offset + runs_count[i];
+            merge->counts[1] = i + 1 < runs_num? runs_count[i + 1] : 0;
+            merge->output    = output + offset;
+            offset += merge->counts[0] + merge->counts[1];
+        }
+        by_fake_index_run(by_fake_dlmerge_task, (by_byte_t*)merges, sizeof(by_fake_dlmerge_task_t), merges_num);
+
+        // swap buffers
+        for (i = 0; i < merges_num; i++)
+            runs_count[i] = merges[i].counts[0] + merges[i].counts[1];
+        runs_num = merges_num;
+        by_fake_dlidx_ref_t temp = index;
+        index = output;
+        output = temp;
+    }
+
+    // save the merged index, the buffers may have been swapped
+    *pindex = index;
+    *ptemp  = output;
+
+    // trace
+    by_trace("compact: %lu symbols, %lu threads", (by_ulong_t)(nums[0] + nums[1]), (by_ulong_t)ntasks);
+    return count;
+}
+
+/* build the compact index and unmap the file data
+ *
+ * we only keep the name hashes and values of all symbols or the given wanted symbols,
+ * so the long-lived handle need not keep the whole library file mapped.
+ */
+by_bool_t by_elf_dlcompact(by_fake_dlctx_ref_t dlctx, by_char_t const** symbols, by_size_t count)
+{
+    // check
+    by_assert_and_check_return_val(dlctx && !dlctx->index && by_elf_dlctx_ensure(dlctx), by_false);
+    by_assert_and_check_return_val(dlctx->filedata, by_false);
+
+    // trace
+    by_trace("compact: mapped: %lu, resident: %lu", (by_ulong_t)dlctx->filesize, (by_ulong_t)by_fake_resident(dlctx->filedata, dlctx->filesize));
+
+    // make the wanted list sorted by name hash
+    by_size_t           i = 0;
+    by_bool_t           ok = by_false;
+    by_fake_dlidx_ref_t wanted = by_null;
+    by_fake_dlidx_ref_t index = by_null;
+    by_fake_dlidx_ref_t temp = by_null;
+    by_size_t           index_num = 0;
+    do
+    {
+        if (symbols && count)
+        {
+            wanted = malloc(count * sizeof(by_fake_dlidx_t));
+            by_check_break(wanted);
+
+            // we use the name index as value to find the wanted name
+            for (i = 0; i < count; i++)
+            {
+                wanted[i].hash  = by_fake_hash(symbols[i]);
+                wanted[i].value = i;
+            }
+            qsort(wanted, count, sizeof(by_fake_dlidx_t), by_fake_dlidx_comp);
+        }
+
+        // make index, the wanted symbols may be found in both .dynsym and .symtab, and each .dynsym entry may be indexed by two names
+        by_size_t maxn = wanted? count * 2 : (by_size_t)dlctx->dynsym_num * 2 + (by_size_t)dlctx->symtab_num;
+        index = malloc((maxn? maxn : 1) * sizeof(by_fake_dlidx_t));
+        by_check_break(index);
+
+        // make the full index in parallel for the large symbol tables
+        by_size_t total = (by_size_t)dlctx->dynsym_num + (by_size_t)dlctx->symtab_num;
+        by_size_t nthreads = wanted? 1 : by_fake_index_threads(total, BY_FAKE_COMPACT_PARALLEL_MINN);
+        if (nthreads > 1 && (temp = malloc(maxn * sizeof(by_fake_dlidx_t))))
+            index_num = by_fake_dlcompact_parallel(dlctx, &index, &temp, maxn, nthreads);
+        else
+        {
+            // add symbols
+            if (dlctx->dynsym && dlctx->dynstr)
+                index_num += by_fake_dlcompact_table(dlctx, (ElfW(Sym) const*)dlctx->dynsym, dlctx->dynsym_num, (by_char_t const*)dlctx->dynstr, (ElfW(Half) const*)dlctx->versym,
+                    wanted, symbols, count, index, maxn);
+            if (dlctx->symtab && dlctx->strtab)
+                index_num += by_fake_dlcompact_table(dlctx, (ElfW(Sym) const*)dlctx->symtab, dlctx->symtab_num, (by_char_t const*)dlctx->strtab, by_null,
+                    wanted, symbols, count, index + index_num, maxn - index_num);
+
+            // sort index
+            if (index_num > 16) temp = malloc(index_num * sizeof(by_fake_dlidx_t));
+            by_check_break(by_fake_dlidx_sort(index, index_num, temp));
+        }
+
+        // shrink index
+        if (index_num < maxn)
+        {
+            by_fake_dlidx_ref_t data = realloc(index, (index_num? index_num : 1) * sizeof(by_fake_dlidx_t));
+            if (data) index = data;
+        }
+
+        // ok
+        ok = by_true;
+
+    } while (0);
+
+    // save the compact index and unmap the file data
+    if (ok)
+    {
+        dlctx->index      = index;
+        dlctx->index_num  = index_num;
+        dlctx->dynsym     = by_null;
+        dlctx->dynstr     = by_null;
+        dlctx->dynsym_num = 0;
+        dlctx->strtab     = by_null;
+        dlctx->symtab     = by_null;
+        dlctx->symtab_num = 0;
+        dlctx->versym     = by_null;
+        dlctx->verdef     = by_null;
+        dlctx->verdef_num = 0;
+        by_fake_close_file(dlctx->filedata, dlctx->filesize);
+        dlctx->filedata   = by_null;
+        dlctx->filesize   = 0;
+        index = by_null;
+
+        // trace
+        by_trace("compact: %lu symbols, index: %lu bytes", (by_ulong_t)index_num, (by_ulong_t)(index_num * sizeof(by_fake_dlidx_t)));
+    }
+
+    // exit
+    if (index) free(index);
+    if (temp) free(temp);
+    if (wanted) free(wanted);
+    return ok;
+}
+
+// init the c++ abi demangle function
+static by_void_t by_fake_demangle_init()
+{
+    // we use it directly if we are linked with the c++ runtime
+    if (__cxa_demangle)
+    {
+        g_cxa_demangle = __cxa_demangle;
+        return ;
+    }
+
+    // find it from the loaded c++ runtime
+    static by_char_t const* s_cxxlibs[] = {"libc++.so", "libc++_shared.so", "libstdc++.so"};
+    by_size_t i = 0;
+    for (i = 0; i < sizeof(s_cxxlibs) / sizeof(s_cxxlibs[0]) && !g_cxa_demangle; i++)
+    {
+        by_fake_dlctx_ref_t dlctx = by_fake_dlopen(s_cxxlibs[i], BY_RTLD_NOW);
+        if (dlctx)
+        {
+            g_cxa_demangle = (by_cxa_demangle_t)by_elf_dlsym(dlctx, "__cxa_demangle");
+            by_elf_dlclose(dlctx);
+        }
+    }
+
+    // trace
+    by_trace("cxa_demangle: %p", g_cxa_demangle);
+}
+
+/* get the size of the qualified name without parameters
+ *
+ * e.g.
+ * android::AndroidRuntime::getJNIEnv() => android::AndroidRuntime::getJNIEnv
+ * (anonymous namespace)::Foo::operator()(int) const => (anonymous namespace)::Foo::operator()
+ */
+static by_size_t by_fake_demangle_basesize(by_char_t const* name)
+{
+    by_int_t         depth = 0;
+    by_char_t const* p = name;
+    while (*p)
+    {
+        // skip the operator name, e.g. operator(), operator<<
+        if (!strncmp(p, "operator", 8))
+        {
+            p += 8;
+            while (*p && strchr("+-*/%^&|~!=<>,[]", *p)) p++;
+            if (p[0] == '(' && p[1] == ')') p += 2;
+            continue;
+        }
+
+        // skip the anonymous namespace
+        if (!strncmp(p, "(anonymous namespace)", 21))
+        {
+            p += 21;
+            continue;
+        }
+
+        // find the parameters
+        if (*p == '<') depth++;
+        else if (*p == '>') depth--;
+        else if (*p == '(' && !depth) break;
+        p++;
+    }
+    return p - name;
+}
+
+// make the demangled name index of the symbols in the given task
+static by_pointer_t by_fake_demangle_task(by_pointer_t priv)
+{
+    // check
+    by_fake_demangle_task_t* task = (by_fake_demangle_task_t*)priv;
+    by_assert_and_check_return_val(task && task->index, by_null);
+
+    // demangle the c++ symbols, the buffer will be reused and grown by __cxa_demangle()
+    by_int_t   i = 0;
+    by_char_t* buffer = by_null;
+    size_t     length = 0;
+    for (i = 0; i < task->num; i++)
+    {
+        ElfW(Sym) const* sym = task->syms + i;
+        by_check_continue(sym->st_shndx != SHN_UNDEF && sym->st_value);
+
+        by_char_t const* name = task->strtab + sym->st_name;
+        by_check_continue((by_pointer_t)name < task->end && name[0] == '_' && name[1] == 'Z');
+
+        by_int_t   status = -1;
+        by_char_t* demangled = g_cxa_demangle(name, buffer, &length, &status);
+        by_check_continue(demangled && !status);
+        buffer = demangled;
+
+        // add the full name
+        task->index[task->count].hash  = by_fake_hash(demangled);
+        task->index[task->count].value = by_fake_symval(sym);
+        task->count++;
+
+        // add the qualified name without parameters
+        by_size_t basesize = by_fake_demangle_basesize(demangled);
+        if (demangled[basesize])
+        {
+            demangled[basesize] = '\0';
+            task->index[task->count].hash  = by_fake_hash(demangled);
+            task->index[task->count].value = by_fake_symval(sym);
+            task->count++;
+        }
+    }
+    if (buffer) free(buffer);
+    return by_null;
+}
+
+/* make the demangled name index of the .dynsym and .symtab
+ *
+ * each c++ symbol is indexed by its full demangled name and the qualified name without parameters,
+ * and we demangle them in parallel for the large symbol tables.
+ */
+static by_bool_t by_fake_demangle_make(by_fake_dlctx_ref_t dlctx)
+{
+    // check
+    by_check_return_val(g_cxa_demangle && dlctx->filedata, by_false);
+
+    // get the thread count
+    by_size_t total = (by_size_t)dlctx->dynsym_num + (by_size_t)dlctx->symtab_num;
+    by_size_t nthreads = by_fake_index_threads(total, 8192);
+
+    // split the symbol tables to tasks
+    by_size_t               i = 0;
+    by_size_t               ntasks = 0;
+    by_fake_demangle_task_t tasks[BY_FAKE_INDEX_THREADS_MAXN];
+    by_pointer_t            end = dlctx->filedata + dlctx->filesize;
+    ElfW(Sym) const*        tables[2] = {(ElfW(Sym) const*)dlctx->dynsym, (ElfW(Sym) const*)dlctx->symtab};
+    by_char_t const*        strtabs[2] = {(by_char_t const*)dlctx->dynstr, (by_char_t const*)dlctx->strtab};
+    by_int_t                nums[2] = {dlctx->dynsym_num, dlctx->symtab_num};
+    by_size_t               counts[2] = {0};
+    memset(tasks, 0, sizeof(tasks));
+    for (i = 0; i < 2; i++)
+    {
+        if (!tables[i] || !strtabs[i] || nums[i] <= 0) nums[i] = 0;
+    }
+    by_check_return_val(nums[0] + nums[1] > 0, by_false);
+
+    /* the tasks count of each table is proportional to its size, and each non-empty table has one task at least,
+     * so there are two tasks at most if we have only one thread
+     */
+    counts[0] = nums[0]? (by_size_t)(((by_uint64_t)nums[0] * nthreads) / (nums[0] + nums[1])) : 0;
+    if (nums[0] && !counts[0]) counts[0] = 1;
+    if (nums[1] && counts[0] == nthreads && nthreads > 1) counts[0] = nthreads - 1;
+    counts[1] = nums[1]? (nthreads > counts[0]? nthreads - counts[0] : 1) : 0;
+    for (i = 0; i < 2; i++)
+    {
+        by_check_continue(counts[i]);
+        by_int_t step = (by_int_t)((nums[i] + counts[i] - 1) / counts[i]);
+        by_int_t start = 0;
+        for (start = 0; start < nums[i]; start += step)
+        {
+            by_fake_demangle_task_t* task = tasks + ntasks++;
+            task->syms   = tables[i] + start;
+            task->num    = nums[i] - start < step? nums[i] - start : step;
+            task->strtab = strtabs[i];
+            task->end    = end;
+            task->index  = malloc((task->num * 2 + 1) * sizeof(by_fake_dlidx_t));
+        }
+    }
+
+    // run tasks
+    by_fake_index_run(by_fake_demangle_task, (by_byte_t*)tasks, sizeof(by_fake_demangle_task_t), ntasks);
+
+    // merge tasks
+    by_bool_t           ok = by_true;
+    by_size_t           count = 0;
+    by_fake_dlidx_ref_t index = by_null;
+    for (i = 0; i < ntasks; i++)
+    {
+        if (!tasks[i].index) ok = by_false;
+        count += tasks[i].count;
+    }
+    by_fake_dlidx_ref_t temp = by_null;
+    if (ok) index = malloc((count? count : 1) * sizeof(by_fake_dlidx_t));
+    if (index && count > 16 && !(temp = malloc(count * sizeof(by_fake_dlidx_t))))
+    {
+        free(index);
+        index = by_null;
+    }
+    if (index)
+    {
+        count = 0;
+        for (i = 0; i < ntasks; i++)
+        {
+            memcpy(index + count, tasks[i].index, tasks[i].count * sizeof(by_fake_dlidx_t));
+            count += tasks[i].count;
+        }
+
+        // sort it and remove the duplicate symbols in .dynsym and .symtab, the first one of the same name is kept
+        by_size_t j = 0;
+        by_size_t n = 0;
+        by_size_t run = 0;
+        by_fake_dlidx_sort(index, count, temp);
+        for (i = 0; i < count; i++)
+        {
+            if (!n || index[n - 1].hash != index[i].hash) run = n;
+            for (j = run; j < n && index[j].value != index[i].value; j++) ;
+            if (j == n) index[n++] = index[i];
+        }
+        dlctx->demangled_num = n;
+        __atomic_store_n(&dlctx->demangled, index, __ATOMIC_RELEASE);
+
+        // trace
+        by_trace("demangle: %lu symbols, %lu names, %lu threads", (by_ulong_t)total, (by_ulong_t)n, (by_ulong_t)nthreads);
+    }
+
+    // exit tasks
+    for (i = 0; i < ntasks; i++)
+        if (tasks[i].index) free(tasks[i].index);
+    if (temp) free(temp);
+    return index != by_null;
+}
+
+// get symbol address by the demangled name from the fake dlopen context
+static by_pointer_t by_fake_dlsym_demangled(by_fake_dlctx_ref_t dlctx, by_char_t const* name)
+{
+    // check
+    by_assert_and_check_return_val(dlctx && name, by_null);
+
+    // make the demangled name index at the first lookup
+    if (!__atomic_load_n(&dlctx->demangled, __ATOMIC_ACQUIRE))
+    {
+        pthread_once(&g_cxa_demangle_once, by_fake_demangle_init);
+        by_check_return_val(by_elf_dlctx_ensure(dlctx), by_null);
+
+        pthread_mutex_lock(&g_demangle_lock);
+        if (!dlctx->demangled) by_fake_demangle_make(dlctx);
+        pthread_mutex_unlock(&g_demangle_lock);
+        by_check_return_val(dlctx->demangled, by_null);
+    }
+
+    // find it
+    by_size_t value = 0;
+    return by_fake_dlidx_find(dlctx->demangled, dlctx->demangled_num, by_fake_hash(name), &value)? by_fake_symaddr(dlctx, value) : by_null;
+}
+
+// the callback of dl_iterate_phdr() for getting the tls module id and the tls block of the calling thread
+static by_int_t by_fake_tls_find_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+{
+    // is this library?
+    by_pointer_t* args = (by_pointer_t*)udata;
+    by_check_return_val(info && (by_pointer_t)info->dlpi_addr == args[0], 0);
+
+    // dlpi_tls_modid and dlpi_tls_data are only supported since android 10 and glibc 2.4
+    if (size >= offsetof(struct dl_phdr_info, dlpi_tls_data) + sizeof(info->dlpi_tls_data))
+    {
+        args[1] = (by_pointer_t)info->dlpi_tls_modid;
+        args[2] = info->dlpi_tls_data;
+    }
+    return 1;
+}
+
+// find the tls module id and the tls block of the calling thread
+static by_size_t by_fake_tls_find(by_pointer_t biasaddr, by_pointer_t* pdata)
+{
+    // check
+    by_check_return_val(dl_iterate_phdr, 0);
+
+    // find it
+    by_pointer_t args[3];
+    args[0] = biasaddr;
+    args[1] = by_null;
+    args[2] = by_null;
+    if (g_by_linker_mutex) pthread_mutex_lock(g_by_linker_mutex);
+    dl_iterate_phdr(by_fake_tls_find_cb, args);
+    if (g_by_linker_mutex) pthread_mutex_unlock(g_by_linker_mutex);
+    if (pdata) *pdata = args[2];
+    return (by_size_t)args[1];
+}
+
+// find the tls symbol offset (st_value) from .dynsym and .symtab
+static by_bool_t by_fake_tls_symbol(by_fake_dlctx_ref_t dlctx, by_char_t const* symbol, by_size_t* poffset)
+{
+    // we need the symbol type, so we cannot use the compact index
+    by_check_return_val(!dlctx->index && by_elf_dlctx_ensure(dlctx) && dlctx->filedata, by_false);
+
+    // init the symbol scan key and kernel
+    by_symscan_key_t  key;
+    by_symscan_func_t scan = by_symscan_func();
+    by_symscan_key_init(&key, symbol);
+
+    // find the defined tls symbol, the first tls symbol may be at offset 0
+    by_size_t        i = 0;
+    by_pointer_t     end = dlctx->filedata + dlctx->filesize;
+    ElfW(Sym) const* tables[2] = {(ElfW(Sym) const*)dlctx->dynsym, (ElfW(Sym) const*)dlctx->symtab};
+    by_char_t const* strtabs[2] = {(by_char_t const*)dlctx->dynstr, (by_char_t const*)dlctx->strtab};
+    by_int_t         nums[2] = {dlctx->dynsym_num, dlctx->symtab_num};
+    for (i = 0; i < 2; i++)
+    {
+        by_int_t index = 0;
+        by_int_t start = 0;
+        while (tables[i] && strtabs[i] && start < nums[i] && (index = scan(tables[i] + start, nums[i] - start, strtabs[i], end, &key)) >= 0)
+        {
+            ElfW(Sym) const* sym = tables[i] + start + index;
+            start += index + 1;
+            if (sym->st_shndx != SHN_UNDEF && BY_ELF_ST_TYPE(sym->st_info) == STT_TLS)
+            {
+                *poffset = (by_size_t)sym->st_value;
+                return by_true;
+            }
+        }
+    }
+    return by_false;
+}
+
+/* get the address of the calling thread's instance of the tls symbol
+ *
+ * the module id and symbol offsets are cached in the handle,
+ * so we only need find the cached offset and call __tls_get_addr() for the next calls.
+ */
+static by_pointer_t by_fake_dlsym_tls(by_fake_dlctx_ref_t dlctx, by_char_t const* symbol)
+{
+    // check
+    by_assert_and_check_return_val(dlctx && symbol, by_null);
+
+    // get the tls module id
+    by_size_t modid = __atomic_load_n(&dlctx->tls_modid, __ATOMIC_ACQUIRE);
+    if (!modid)
+    {
+        modid = by_fake_tls_find(dlctx->biasaddr, by_null);
+        by_check_return_val(modid, by_null);
+        __atomic_store_n(&dlctx->tls_modid, modid, __ATOMIC_RELEASE);
+    }
+
+    // find the symbol offset from the cache
+    by_size_t   i = 0;
+    by_bool_t   found = by_false;
+    by_size_t   offset = 0;
+    by_uint64_t hash = by_fake_hash(symbol);
+    by_size_t   count = __atomic_load_n(&dlctx->tls_cache_num, __ATOMIC_ACQUIRE);
+    for (i = 0; i < count && !found; i++)
+    {
+        if (dlctx->tls_cache[i].hash == hash)
+        {
+            offset = dlctx->tls_cache[i].value;
+            found = by_true;
+        }
+    }
+
+    // find it from the symbol tables and cache it
+    if (!found)
+    {
+        by_check_return_val(by_fake_tls_symbol(dlctx, symbol, &offset), by_null);
+
+        pthread_mutex_lock(&g_tls_cache_lock);
+        if (!dlctx->tls_cache) dlctx->tls_cache = malloc(BY_FAKE_TLS_CACHE_MAXN * sizeof(by_fake_dlidx_t));
+        if (dlctx->tls_cache && dlctx->tls_cache_num < BY_FAKE_TLS_CACHE_MAXN)
+        {
+            dlctx->tls_cache[dlctx->tls_cache_num].hash  = hash;
+            dlctx->tls_cache[dlctx->tls_cache_num].value = offset;
+            __atomic_store_n(&dlctx->tls_cache_num, dlctx->tls_cache_num + 1, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&g_tls_cache_lock);
+    }
+
+    // get the address of the calling thread's instance, the tls block will be allocated if it has not been allocated
+    if (__tls_get_addr)
+    {
+        by_tls_index_t ti;
+        ti.module = (by_ulong_t)modid;
+        ti.offset = (by_ulong_t)(offset - BY_TLS_DTV_OFFSET);
+        return __tls_get_addr(&ti);
+    }
+
+    // we can only use the allocated tls block if __tls_get_addr() is not exported, e.g. x86 and arm64 on android
+    by_pointer_t data = by_null;
+    by_fake_tls_find(dlctx->biasaddr, &data);
+    return data? (by_pointer_t)((by_byte_t*)data + offset) : by_null;
+}
+
+// create the sealable memfd, it's only supported on linux 3.17+
+static by_int_t by_fake_memfd_create(by_char_t const* name)
+{
+#ifdef __NR_memfd_create
+    return (by_int_t)syscall(__NR_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    return -1;
+#endif
+}
+
+// check the shared symbol index data
+static by_bool_t by_fake_dlshare_check(by_byte_t const* data, by_size_t size)
+{
+    // check header
+    by_fake_dlshare_head_t const* head = (by_fake_dlshare_head_t const*)data;
+    by_check_return_val(size >= sizeof(by_fake_dlshare_head_t), by_false);
+    by_check_return_val(head->magic == BY_FAKE_DLSHARE_MAGIC && head->size == size, by_false);
+    by_check_return_val(head->count <= (size - sizeof(by_fake_dlshare_head_t)) / sizeof(by_fake_dlshare_lib_t), by_false);
+
+    // check libraries
+    by_uint32_t i = 0;
+    by_fake_dlshare_lib_t const* libs = (by_fake_dlshare_lib_t const*)(head + 1);
+    for (i = 0; i < head->count; i++)
+    {
+        by_fake_dlshare_lib_t const* lib = libs + i;
+        by_check_return_val(memchr(lib->name, '\0', sizeof(lib->name)) && memchr(lib->realpath, '\0', sizeof(lib->realpath)), by_false);
+        by_check_return_val(lib->index_offset <= size && lib->index_num <= (size - lib->index_offset) / sizeof(by_fake_dlidx_t), by_false);
+        by_check_return_val(!(lib->index_offset & (__alignof__(by_fake_dlidx_t) - 1)), by_false);
+    }
+    return by_true;
+}
+
+// write header, libraries and indexes to the shared mapping
+static by_void_t by_fake_dlshare_write(by_byte_t* data, by_size_t size, by_fake_dlshare_lib_t const* libs, by_fake_dlctx_ref_t const* dlctxs, by_size_t count)
+{
+    by_size_t               i = 0;
+    by_fake_dlshare_head_t* head = (by_fake_dlshare_head_t*)data;
+    head->magic = BY_FAKE_DLSHARE_MAGIC;
+    head->count = (by_uint32_t)count;
+    head->size  = size;
+    memcpy(head + 1, libs, count * sizeof(by_fake_dlshare_lib_t));
+    for (i = 0; i < count; i++)
+    {
+        if (libs[i].index_num)
+            memcpy(data + libs[i].index_offset, dlctxs[i]->index, libs[i].index_num * sizeof(by_fake_dlidx_t));
+    }
+}
+
+/* make the shared symbol index of the given libraries
+ *
+ * we write the compact indexes to a sealed memfd (or the anonymous shared mapping if memfd is not supported or cannot be sealed),
+ * the child processes inherit the read-only mapping after fork(), and the other processes can map the memfd,
+ * so they can find symbols without parsing the library files and need not the private copies of indexes.
+ */
+static by_fake_dlshare_ref_t by_fake_dlshare_make(by_char_t const** filenames, by_size_t count)
+{
+    // check
+    by_assert_and_check_return_val(filenames && count, by_null);
+
+    // do make
+    by_size_t              i = 0;
+    by_bool_t              ok = by_false;
+    by_fake_dlshare_ref_t  share = by_null;
+    by_fake_dlctx_ref_t*   dlctxs = by_null;
+    by_fake_dlshare_lib_t* libs = by_null;
+    by_byte_t*             data = by_null;
+    by_size_t              size = 0;
+    by_int_t               fd = -1;
+    do
+    {
+        // init libraries
+        dlctxs = calloc(count, sizeof(by_fake_dlctx_ref_t));
+        libs   = calloc(count, sizeof(by_fake_dlshare_lib_t));
+        by_assert_and_check_break(dlctxs && libs);
+
+        // open libraries and build their compact indexes
+        by_linker_init();
+        size = sizeof(by_fake_dlshare_head_t) + count * sizeof(by_fake_dlshare_lib_t);
+        for (i = 0; i < count; i++)
+        {
+            by_fake_dlshare_lib_t* lib = libs + i;
+            by_assert_and_check_break(filenames[i] && strlen(filenames[i]) < sizeof(lib->name));
+            strlcpy(lib->name, filenames[i], sizeof(lib->name));
+
+            by_pointer_t biasaddr = by_fake_find_biasaddr(filenames[i], lib->realpath, sizeof(lib->realpath));
+            by_check_break(biasaddr);
+
+            dlctxs[i] = by_elf_dlopen_file(by_null, biasaddr, lib->realpath);
+            by_check_break(dlctxs[i] && by_elf_dlcompact(dlctxs[i], by_null, 0));
+
+            lib->index_offset = size;
+            lib->index_num    = dlctxs[i]->index_num;
+            size += lib->index_num * sizeof(by_fake_dlidx_t);
+        }
+        by_check_break(i == count);
+
+        /* create the sealed memfd
+         *
+         * we need unmap the writable mapping before sealing memfd,
+         * otherwise F_SEAL_WRITE will be failed.
+         */
+        fd = by_fake_memfd_create("byopen-dlshare");
+        if (fd >= 0)
+        {
+            if (ftruncate(fd, size) == 0)
+            {
+                data = mmap(by_null, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (data == MAP_FAILED) data = by_null;
+            }
+            if (data)
+            {
+                by_fake_dlshare_write(data, size, libs, dlctxs, count);
+                munmap(data, size);
+                data = by_null;
+
+                // we never publish the unsealed memfd, because the other processes will reject it and it can be rewritten
+                if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0)
+                {
+                    data = mmap(by_null, size, PROT_READ, MAP_SHARED, fd, 0);
+                    if (data == MAP_FAILED) data = by_null;
+                }
+                else by_trace("dlshare: seal memfd failed, errno: %d", errno);
+            }
+            if (!data)
+            {
+                close(fd);
+                fd = -1;
+            }
+        }
+
+        // use the read-only anonymous shared mapping if memfd is not supported or not sealed
+        if (!data)
+        {
+            data = mmap(by_null, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (data == MAP_FAILED) data = by_null;
+            by_assert_and_check_break(data);
+
+            by_fake_dlshare_write(data, size, libs, dlctxs, count);
+            if (mprotect(data, size, PROT_READ) != 0)
+            {
+                munmap(data, size);
+                data = by_null;
+            }
+        }
+        by_assert_and_check_break(data);
+
+        // init share
+        share = calloc(1, sizeof(by_fake_dlshare_t));
+        by_assert_and_check_break(share);
+
+        share->fd   = fd;
+        share->data = data;
+        share->size = size;
+        data = by_null;
+
+        // trace
+        by_trace("dlshare: %lu libraries, fd: %d, size: %lu", (by_ulong_t)count, fd, (by_ulong_t)size);
+
+        // ok
+        ok = by_true;
+
+    } while (0);
+
+    // failed?
+    if (!ok && data)
+    {
+        munmap(data, size);
+        if (fd >= 0) close(fd);
+    }
+
+    // exit
+    if (dlctxs)
+    {
+        for (i = 0; i < count; i++)
+            if (dlctxs[i]) by_elf_dlclose(dlctxs[i]);
+        free(dlctxs);
+    }
+    if (libs) free(libs);
+    return share;
+}
+
+// split the journal line by tab, return the field count
+static by_size_t by_journal_split(by_char_t* line, by_char_t** fields, by_size_t maxn)
+{
+    by_size_t  n = 0;
+    by_char_t* p = line;
+    while (p && n < maxn)
+    {
+        fields[n++] = p;
+        p = strchr(p, '\t');
+        if (p) *p++ = '\0';
+    }
+    return n;
+}
+
+/* load the journal file, it need be called in lock
+ *
+ * L\t<name>\t<realpath>\t<filesize>\t<build-id>
+ * S\t<value>\t<symbol>
+ */
+static by_void_t by_journal_load(by_char_t const* filepath)
+{
+    // open the journal file
+    FILE* fp = fopen(filepath, "r");
+    by_check_return(fp);
+
+    // load libraries and symbols
+    by_char_t            line[1024];
+    by_char_t*           fields[5];
+    by_journal_lib_ref_t jlib = by_null;
+    by_bool_t            valid = by_false;
+    while (fgets(line, sizeof(line), fp))
+    {
+        // strip the line ending
+        by_size_t size = strlen(line);
+        while (size && (line[size - 1] == '\n' || line[size - 1] == '\r')) line[--size] = '\0';
+
+        // check header
+        if (!valid)
+        {
+            valid = !strcmp(line, BY_JOURNAL_HEADER);
+            by_check_break(valid);
+            continue;
+        }
+
+        // load library
+        by_size_t n = by_journal_split(line, fields, 5);
+        if (n == 5 && !strcmp(fields[0], "L"))
+        {
+            jlib = by_null;
+            by_check_continue(strlen(fields[1]) < sizeof(jlib->name) && strlen(fields[2]) < sizeof(jlib->realpath));
+
+            // we need not load it if it has been validated in this run
+            jlib = by_journal_lib_find(fields[1]);
+            if (jlib && jlib->biasaddr)
+            {
+                jlib = by_null;
+                continue;
+            }
+            if (!jlib && (jlib = calloc(1, sizeof(by_journal_lib_t))))
+            {
+                strlcpy(jlib->name, fields[1], sizeof(jlib->name));
+                jlib->next = g_journal_libs;
+                g_journal_libs = jlib;
+            }
+            by_check_continue(jlib);
+
+            // load the library identity
+            by_journal_lib_clear(jlib);
+            strlcpy(jlib->realpath, fields[2], sizeof(jlib->realpath));
+            jlib->filesize     = strtoull(fields[3], by_null, 10);
+            jlib->buildid_size = 0;
+            by_char_t const* p = fields[4];
+            while (p[0] && p[1] && jlib->buildid_size < sizeof(jlib->buildid))
+            {
+                by_char_t hex[3] = {p[0], p[1], '\0'};
+                jlib->buildid[jlib->buildid_size++] = (by_byte_t)strtoul(hex, by_null, 16);
+                p += 2;
+            }
+        }
+        // load symbol
+        else if (n == 3 && !strcmp(fields[0], "S") && jlib && fields[2][0])
+            by_journal_lib_add(jlib, fields[2], (by_size_t)strtoull(fields[1], by_null, 16));
+    }
+    fclose(fp);
+
+    // publish the loaded symbols
+    for (jlib = g_journal_libs; jlib; jlib = jlib->next)
+        by_journal_lib_freeze(jlib);
+}
+
+// save the journal file
+static by_bool_t by_journal_save_file(FILE* fp)
+{
+    // save header
+    fprintf(fp, "%s\n", BY_JOURNAL_HEADER);
+
+    // save libraries and their symbols
+    by_journal_lib_ref_t jlib = g_journal_libs;
+    for (; jlib; jlib = jlib->next)
+    {
+        by_check_continue(by_journal_lib_count(jlib));
+
+        by_size_t i = 0;
+        fprintf(fp, "L\t%s\t%s\t%llu\t", jlib->name, jlib->realpath, (unsigned long long)jlib->filesize);
+        for (i = 0; i < jlib->buildid_size; i++)
+            fprintf(fp, "%02x", jlib->buildid[i]);
+        fprintf(fp, "\n");
+
+        for (i = 0; jlib->replayed && i < jlib->replayed->num; i++)
+            fprintf(fp, "S\t%lx\t%s\n", (by_ulong_t)jlib->replayed->syms[i].value, jlib->replayed->syms[i].name);
+        for (i = 0; i < jlib->syms_num; i++)
+            fprintf(fp, "S\t%lx\t%s\n", (by_ulong_t)jlib->syms[i].value, jlib->syms[i].name);
+    }
+    return !ferror(fp);
+}
+
+// export the given symbol table to the perf map file
+static by_int_t by_fake_perfmap_export_symtab(FILE* fp, by_fake_dlctx_ref_t dlctx, ElfW(Sym) const* symtab, by_int_t symtab_num, by_char_t const* strtab, by_size_t minsize)
+{
+    // we write symbols one by one to the buffered file, so we need not copy the whole table
+    by_int_t         i = 0;
+    by_int_t         count = 0;
+    by_pointer_t     end = dlctx->filedata + dlctx->filesize;
+    for (i = 0; i < symtab_num; i++, symtab++)
+    {
+        // only export the defined symbols with size
+        by_check_continue(symtab->st_shndx != SHN_UNDEF && symtab->st_value && symtab->st_size);
+
+        // only export the large functions?
+        if (minsize && (BY_ELF_ST_TYPE(symtab->st_info) != STT_FUNC || symtab->st_size < minsize))
+            continue;
+
+        // get symbol name
+        by_char_t const* name = strtab + symtab->st_name;
+        by_check_continue((by_pointer_t)name < end && *name);
+
+        // get symbol address, we need clear the thumb bit for perf
+        by_size_t symboladdr = (by_size_t)dlctx->biasaddr + (by_size_t)symtab->st_value;
+#if defined(BY_ARCH_ARM) && !defined(BY_ARCH_ARM64)
+        if (BY_ELF_ST_TYPE(symtab->st_info) == STT_FUNC) symboladdr &= ~1;
+#endif
+
+        // write "START SIZE symbolname"
+        fprintf(fp, "%lx %lx %s\n", (by_ulong_t)symboladdr, (by_ulong_t)symtab->st_size, name);
+        count++;
+    }
+    return count;
+}
+
+// export the symbols of the fake dlopen context to the perf map file
+static by_int_t by_fake_perfmap_export(FILE* fp, by_fake_dlctx_ref_t dlctx, by_size_t minsize)
+{
+    // check
+    by_assert_and_check_return_val(fp && dlctx, -1);
+    by_check_return_val(by_elf_dlctx_ensure(dlctx), -1);
+
+    // .symtab is usually the superset of .dynsym, so we use .dynsym only if it has been stripped
+    if (dlctx->symtab && dlctx->strtab)
+        return by_fake_perfmap_export_symtab(fp, dlctx, (ElfW(Sym) const*)dlctx->symtab, dlctx->symtab_num, (by_char_t const*)dlctx->strtab, minsize);
+    else if (dlctx->dynsym && dlctx->dynstr)
+        return by_fake_perfmap_export_symtab(fp, dlctx, (ElfW(Sym) const*)dlctx->dynsym, dlctx->dynsym_num, (by_char_t const*)dlctx->dynstr, minsize);
+    return 0;
+}
+
+/* the callback of dl_iterate_phdr() for collecting all libraries to export the perf map file
+ *
+ * it's called with the loader lock, so we only copy the load bias address and name here,
+ * and open and export these libraries after iterating them.
+ */
+static by_int_t by_fake_perfmap_collect_cb(struct dl_phdr_info* info, size_t size, by_pointer_t udata)
+{
+    // check
+    by_pointer_t* args = (by_pointer_t*)udata;
+    by_check_return_val(args, 1);
+    by_check_return_val(info && info->dlpi_addr && info->dlpi_name && info->dlpi_name[0] != '\0', 0);
+
+    // grow the library table
+    by_fake_perfmap_lib_ref_t libs = (by_fake_perfmap_lib_ref_t)args[0];
+    by_size_t                 count = (by_size_t)args[1];
+    by_size_t                 maxn = (by_size_t)args[2];
+    if (count == maxn)
+    {
+        maxn = maxn? maxn << 1 : 64;
+        by_fake_perfmap_lib_ref_t data = realloc(libs, maxn * sizeof(by_fake_perfmap_lib_t));
+        by_check_return_val(data, 1);
+        libs = data;
+        args[0] = (by_pointer_t)libs;
+        args[2] = (by_pointer_t)maxn;
+    }
+
+    // add library
+    by_fake_perfmap_lib_ref_t lib = libs + count;
+    lib->biasaddr = (by_pointer_t)info->dlpi_addr;
+    lib->name     = strdup(info->dlpi_name);
+    by_check_return_val(lib->name, 1);
+    args[1] = (by_pointer_t)(count + 1);
+    return 0;
+}
+
+// export all loaded libraries to the perf map file
+static by_int_t by_fake_perfmap_export_all(FILE* fp, by_size_t minsize)
+{
+    // collect all libraries
+    by_pointer_t args[3];
+    args[0] = by_null;
+    args[1] = by_null;
+    args[2] = by_null;
+    if (g_by_linker_mutex) pthread_mutex_lock(g_by_linker_mutex);
+    dl_iterate_phdr(by_fake_perfmap_collect_cb, args);
+    if (g_by_linker_mutex) pthread_mutex_unlock(g_by_linker_mutex);
+
+    // export them
+    by_size_t                 i = 0;
+    by_int_t                  count = 0;
+    by_fake_perfmap_lib_ref_t libs = (by_fake_perfmap_lib_ref_t)args[0];
+    by_size_t                 libs_num = (by_size_t)args[1];
+    for (i = 0; i < libs_num; i++)
+    {
+        // get real path, dlpi_name maybe not full path, e.g. libart.so
+        by_char_t        realpath[512];
+        by_char_t const* filepath = libs[i].name;
+        if (filepath[0] != '/')
+        {
+            if (!by_fake_find_biasaddr_from_maps(filepath, realpath, sizeof(realpath)) || !realpath[0]) filepath = by_null;
+            else filepath = realpath;
+        }
+
+        // export it
+        by_fake_dlctx_ref_t dlctx = filepath? by_elf_dlopen_file(by_null, libs[i].biasaddr, filepath) : by_null;
+        if (dlctx)
+        {
+            by_int_t n = by_fake_perfmap_export(fp, dlctx, minsize);
+            if (n > 0) count += n;
+            by_elf_dlclose(dlctx);
+        }
+        free(libs[i].name);
+    }
+    if (libs) free(libs);
+    return count;
+}
+
+// get the section header of the given name from the elf file data
+static ElfW(Shdr) const* by_fake_elf_section_header(by_pointer_t filedata, by_size_t filesize, by_char_t const* name)
+{
+    // check
+    ElfW(Ehdr) const* elf = (ElfW(Ehdr) const*)filedata;
+    by_check_return_val(filedata && filesize > sizeof(ElfW(Ehdr)) && !memcmp(elf->e_ident, ELFMAG, SELFMAG), by_null);
+    by_check_return_val(elf->e_shoff && elf->e_shentsize >= sizeof(ElfW(Shdr)) && elf->e_shstrndx < elf->e_shnum, by_null);
+    by_check_return_val(elf->e_shoff + (by_size_t)elf->e_shnum * elf->e_shentsize <= filesize, by_null);
+
+    // get .shstrtab section
+    by_byte_t const*  shoff = (by_byte_t const*)filedata + elf->e_shoff;
+    ElfW(Shdr) const* shstrtab = (ElfW(Shdr) const*)(shoff + elf->e_shstrndx * elf->e_shentsize);
+    by_check_return_val(shstrtab->sh_offset < filesize && shstrtab->sh_size <= filesize - shstrtab->sh_offset, by_null);
+    by_char_t const*  shstr = (by_char_t const*)filedata + shstrtab->sh_offset;
+
+    // find section
+    by_int_t i = 0;
+    for (i = 0; i < elf->e_shnum; i++, shoff += elf->e_shentsize)
+    {
+        ElfW(Shdr) const* sh = (ElfW(Shdr) const*)shoff;
+        by_check_continue(sh->sh_name < shstrtab->sh_size && !strncmp(shstr + sh->sh_name, name, shstrtab->sh_size - sh->sh_name));
+        return sh;
+    }
+    return by_null;
+}
+
+// get the file data of the given section header, the compressed section is not supported
+static by_byte_t const* by_fake_elf_section_data(by_pointer_t filedata, by_size_t filesize, ElfW(Shdr) const* sh, by_size_t* psize)
+{
+    by_check_return_val(sh && sh->sh_type != SHT_NOBITS && !(sh->sh_flags & SHF_COMPRESSED), by_null);
+    by_check_return_val(sh->sh_offset < filesize && sh->sh_size <= filesize - sh->sh_offset, by_null);
+    if (psize) *psize = sh->sh_size;
+    return (by_byte_t const*)filedata + sh->sh_offset;
+}
+
+// get the section data of the given name from the elf file data
+static by_byte_t const* by_fake_elf_section(by_pointer_t filedata, by_size_t filesize, by_char_t const* name, by_size_t* psize)
+{
+    return by_fake_elf_section_data(filedata, filesize, by_fake_elf_section_header(filedata, filesize, name), psize);
+}
+
+// get the program headers from the elf file data
+static ElfW(Phdr) const* by_fake_elf_segments(by_pointer_t filedata, by_size_t filesize, by_size_t* pcount)
+{
+    ElfW(Ehdr) const* elf = (ElfW(Ehdr) const*)filedata;
+    by_check_return_val(filedata && filesize > sizeof(ElfW(Ehdr)) && !memcmp(elf->e_ident, ELFMAG, SELFMAG), by_null);
+    by_check_return_val(elf->e_phoff && elf->e_phentsize == sizeof(ElfW(Phdr)), by_null);
+    by_check_return_val(elf->e_phoff + (by_size_t)elf->e_phnum * sizeof(ElfW(Phdr)) <= filesize, by_null);
+    *pcount = elf->e_phnum;
+    return (ElfW(Phdr) const*)((by_byte_t const*)filedata + elf->e_phoff);
+}
+
+// is the given virtual address range in a readable PT_LOAD segment?
+static by_bool_t by_fake_elf_loaded(ElfW(Phdr) const* phdrs, by_size_t count, by_size_t vaddr, by_size_t size)
+{
+    by_size_t i = 0;
+    for (i = 0; i < count; i++)
+    {
+        ElfW(Phdr) const* phdr = phdrs + i;
+        if (phdr->p_type == PT_LOAD && (phdr->p_flags & PF_R) && vaddr >= phdr->p_vaddr && vaddr - phdr->p_vaddr <= phdr->p_memsz && size <= phdr->p_memsz - (vaddr - phdr->p_vaddr))
+            return by_true;
+    }
+    return by_false;
+}
+
+// open the debug file if it has .debug_line
+static by_pointer_t by_fake_open_debugfile_at(by_char_t const* filepath, by_size_t* pfilesize)
+{
+    // trace
+    by_trace("addr2line: try debug file: %s", filepath);
+
+    by_pointer_t filedata = access(filepath, R_OK) == 0? by_fake_open_file(filepath, pfilesize) : by_null;
+    if (filedata && !by_fake_elf_section(filedata, *pfilesize, ".debug_line", by_null))
+    {
+        by_fake_close_file(filedata, *pfilesize);
+        filedata = by_null;
+    }
+    return filedata;
+}
+
+/* open the separate debug file of the library
+ *
+ * we find it by the build-id first, e.g. /usr/lib/debug/.build-id/ab/cdef.debug,
+ * and then by .gnu_debuglink in the library directory, its .debug directory and the global debug directory.
+ *
+ * @see https://sourceware.org/gdb/current/onlinedocs/gdb.html/Separate-Debug-Files.html
+ */
+static by_pointer_t by_fake_open_debugfile(by_pointer_t biasaddr, by_char_t const* realpath, by_pointer_t filedata, by_size_t filesize, by_size_t* pdebugsize)
+{
+    // find it by the build-id
+    by_char_t    filepath[1024];
+    by_pointer_t debugdata = by_null;
+    by_byte_t    buildid[64];
+    by_size_t    buildid_size = by_journal_buildid(biasaddr, buildid, sizeof(buildid));
+    if (buildid_size > 1)
+    {
+        by_size_t i = 0;
+        by_int_t  n = snprintf(filepath, sizeof(filepath), "%s/.build-id/%02x/", BY_FAKE_DEBUG_DIR, buildid[0]);
+        for (i = 1; i < buildid_size && n > 0 && n + 3 < (by_int_t)sizeof(filepath); i++)
+            n += snprintf(filepath + n, sizeof(filepath) - n, "%02x", buildid[i]);
+        if (n > 0 && n + 7 < (by_int_t)sizeof(filepath))
+        {
+            strlcpy(filepath + n, ".debug", sizeof(filepath) - n);
+            debugdata = by_fake_open_debugfile_at(filepath, pdebugsize);
+        }
+    }
+
+    // find it by .gnu_debuglink, it's the file name and crc32
+    by_size_t        linksize = 0;
+    by_char_t const* linkname = (by_char_t const*)by_fake_elf_section(filedata, filesize, ".gnu_debuglink", &linksize);
+    by_char_t const* basename = strrchr(realpath, '/');
+    if (!debugdata && linkname && linksize && memchr(linkname, '\0', linksize) && *linkname && !strchr(linkname, '/') && basename)
+    {
+        by_int_t         i = 0;
+        by_int_t         dirsize = (by_int_t)(basename - realpath);
+        by_char_t const* formats[] = {"%.*s/%s", "%.*s/.debug/%s", BY_FAKE_DEBUG_DIR "%.*s/%s"};
+        for (i = 0; i < (by_int_t)(sizeof(formats) / sizeof(formats[0])) && !debugdata; i++)
+        {
+            by_int_t n = snprintf(filepath, sizeof(filepath), formats[i], dirsize, realpath, linkname);
+            by_check_continue(n > 0 && n < (by_int_t)sizeof(filepath) && strcmp(filepath, realpath));
+            debugdata = by_fake_open_debugfile_at(filepath, pdebugsize);
+        }
+    }
+    return debugdata;
+}
+
+/* make the line table of the library containing the given address
+ *
+ * the line table is empty if there is no debug information, so we need not load it again.
+ */
+static by_dwarf_lines_ref_t by_fake_lines_make(by_fake_dlctx_ref_t dlctx, by_size_t addr)
+{
+    // find the module of the given address, it must be this library
+    by_char_t    realpath[512];
+    by_pointer_t biasaddr = by_fake_find_module(addr, realpath, sizeof(realpath), by_false);
+    if (biasaddr != dlctx->biasaddr) biasaddr = by_fake_find_module(addr, realpath, sizeof(realpath), by_true);
+    by_check_return_val(biasaddr && biasaddr == dlctx->biasaddr, by_null);
+
+    /* get the real path from the mapping instead of dlpi_name
+     *
+     * dlpi_name may be not full path, and the cached module name may be stale
+     * if the other library has been loaded at the same address after it was unloaded.
+     */
+    realpath[0] = '\0';
+    by_check_return_val(by_elf_find_realpath(addr, realpath, sizeof(realpath)), by_null);
+
+    // init lines
+    by_dwarf_lines_ref_t lines = calloc(1, sizeof(by_dwarf_lines_t));
+    by_check_return_val(lines, by_null);
+
+    // open the library file, we need not the symbol tables of the handle
+    by_size_t    filesize = 0;
+    by_size_t    debugsize = 0;
+    by_pointer_t filedata = by_fake_open_file(realpath, &filesize);
+    by_pointer_t debugdata = by_null;
+    do
+    {
+        by_check_break(filedata);
+
+        // get the dwarf sections from the library or its separate debug file
+        by_dwarf_sections_t sections;
+        memset(&sections, 0, sizeof(sections));
+        sections.addrsize = sizeof(by_pointer_t);
+        sections.line = by_fake_elf_section(filedata, filesize, ".debug_line", &sections.line_size);
+        if (!sections.line)
+        {
+            debugdata = by_fake_open_debugfile(biasaddr, realpath, filedata, filesize, &debugsize);
+            by_check_break(debugdata);
+            sections.line = by_fake_elf_section(debugdata, debugsize, ".debug_line", &sections.line_size);
+        }
+        by_pointer_t data = debugdata? debugdata : filedata;
+        by_size_t    size = debugdata? debugsize : filesize;
+        sections.line_str = by_fake_elf_section(data, size, ".debug_line_str", &sections.line_str_size);
+        sections.str      = by_fake_elf_section(data, size, ".debug_str", &sections.str_size);
+
+        // make the line table
+        by_dwarf_lines_init(lines, &sections);
+
+    } while (0);
+
+    // trace
+    by_trace("addr2line: %s, %lu rows", realpath, (by_ulong_t)lines->rows_num);
+
+    // exit files
+    if (debugdata) by_fake_close_file(debugdata, debugsize);
+    if (filedata) by_fake_close_file(filedata, filesize);
+    return lines;
+}
+
+// get the line table of the fake dlopen context, it's built at the first lookup
+static by_dwarf_lines_ref_t by_fake_lines_get(by_fake_dlctx_ref_t dlctx, by_size_t addr)
+{
+    by_dwarf_lines_ref_t lines = __atomic_load_n(&dlctx->lines, __ATOMIC_ACQUIRE);
+    if (!lines)
+    {
+        pthread_mutex_lock(&g_lines_lock);
+        lines = dlctx->lines;
+        if (!lines && (lines = by_fake_lines_make(dlctx, addr)))
+            __atomic_store_n(&dlctx->lines, lines, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&g_lines_lock);
+    }
+    return lines;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_pointer_t by_dlopen_compact(by_char_t const* filename, by_int_t flag, by_char_t const** symbols, by_size_t count)
+{
+    // open it
+    by_pointer_t handle = by_dlopen(filename, flag & ~BY_RTLD_COMPACT);
+
+    // build the compact index and unmap the file, we still keep the full handle if it's failed
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    if (dlctx && dlctx->magic == BY_FAKE_DLCTX_MAGIC)
+        by_elf_dlcompact(dlctx, symbols, count);
+    return handle;
+}
+by_pointer_t by_elf_dlopen(by_pointer_t storage, by_size_t size, by_char_t const* filename, by_int_t flag)
+{
+    // check
+    by_assert_and_check_return_val(filename, by_null);
+    by_assert_and_check_return_val(!storage || (size >= BY_DLOPEN_STORAGE_SIZE && !((by_size_t)storage & (sizeof(by_pointer_t) - 1))), by_null);
+
+    // uses the fake dlopen to load it from maps directly
+    by_fake_dlctx_ref_t dlctx = by_fake_dlopen_impl(storage, filename, flag);
+
+    // build the compact index for all symbols?
+    if (dlctx && (flag & BY_RTLD_COMPACT))
+        by_elf_dlcompact(dlctx, by_null, 0);
+    return (by_pointer_t)dlctx;
+}
+by_pointer_t by_dlopen_by_addr(by_cpointer_t addr, by_int_t flag)
+{
+    // check
+    by_assert_and_check_return_val(addr, by_null);
+
+    // open the module containing the given address
+    by_linker_init();
+    by_fake_dlctx_ref_t dlctx = by_fake_dlopen_by_addr((by_size_t)addr, flag);
+
+    // build the compact index for all symbols?
+    if (dlctx && (flag & BY_RTLD_COMPACT))
+        by_elf_dlcompact(dlctx, by_null, 0);
+    return (by_pointer_t)dlctx;
+}
+by_pointer_t by_dlsym(by_pointer_t handle, by_char_t const* symbol)
+{
+    // check
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && symbol, by_null);
+
+    // do dlsym
+    return (dlctx->magic == BY_FAKE_DLCTX_MAGIC)? by_elf_dlsym(dlctx, symbol) : dlsym(handle, symbol);
+}
+by_pointer_t by_dlvsym(by_pointer_t handle, by_char_t const* symbol, by_char_t const* version)
+{
+    // check
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && symbol && version, by_null);
+
+    // do dlvsym, it's only supported since android 7.0
+    if (dlctx->magic == BY_FAKE_DLCTX_MAGIC) return by_fake_dlvsym(dlctx, symbol, version);
+    return dlvsym? dlvsym(handle, symbol, version) : by_null;
+}
+by_pointer_t by_dlsym_demangled(by_pointer_t handle, by_char_t const* name)
+{
+    // check
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && name, by_null);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC, by_null);
+
+    // do dlsym
+    return by_fake_dlsym_demangled(dlctx, name);
+}
+by_pointer_t by_dlsym_tls(by_pointer_t handle, by_char_t const* symbol)
+{
+    // check
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && symbol, by_null);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC && !dlctx->pid, by_null);
+
+    // do dlsym
+    return by_fake_dlsym_tls(dlctx, symbol);
+}
+by_bool_t by_dlpool_stat(by_dlpool_stat_t* stat)
+{
+    // check
+    by_assert_and_check_return_val(stat, by_false);
+
+    // get the statistics of the handle pool
+    by_pool_stat(&g_dlctx_pool, stat);
+    stat->storages = __atomic_load_n(&g_dlctx_storages, __ATOMIC_RELAXED);
+    return by_true;
+}
+by_bool_t by_dlstat(by_pointer_t handle, by_dlstat_t* stat)
+{
+    // check
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && stat, by_false);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC, by_false);
+
+    // get the memory usage of handle
+    stat->mapped   = dlctx->filesize;
+    stat->resident = by_fake_resident(dlctx->filedata, dlctx->filesize);
+    stat->heap     = (dlctx->storage? 0 : sizeof(by_fake_dlctx_t)) + (dlctx->index_shared? 0 : dlctx->index_num * sizeof(by_fake_dlidx_t));
+    return by_true;
+}
+by_pointer_t by_dlshare_init(by_char_t const** filenames, by_size_t count)
+{
+    return (by_pointer_t)by_fake_dlshare_make(filenames, count);
+}
+by_pointer_t by_dlshare_attach(by_int_t fd)
+{
+    // check
+    by_assert_and_check_return_val(fd >= 0, by_null);
+
+    /* the memfd must be sealed, we check it only once and then trust the mapping,
+     * so the sender cannot rewrite or shrink it after checking
+     */
+    by_int_t seals = fcntl(fd, F_GET_SEALS);
+    by_check_return_val(seals >= 0 && (seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) == (F_SEAL_WRITE | F_SEAL_SHRINK), by_null);
+
+    // get the mapping size
+    struct stat st;
+    by_check_return_val(fstat(fd, &st) == 0 && st.st_size > 0, by_null);
+
+    // map it
+    by_size_t  size = (by_size_t)st.st_size;
+    by_byte_t* data = mmap(by_null, size, PROT_READ, MAP_SHARED, fd, 0);
+    by_check_return_val(data != MAP_FAILED, by_null);
+
+    // check it and init share
+    by_fake_dlshare_ref_t share = by_null;
+    if (by_fake_dlshare_check(data, size) && (share = calloc(1, sizeof(by_fake_dlshare_t))))
+    {
+        share->fd   = dup(fd);
+        share->data = data;
+        share->size = size;
+    }
+    else munmap(data, size);
+    return (by_pointer_t)share;
+}
+by_int_t by_dlshare_fd(by_pointer_t handle)
+{
+    by_fake_dlshare_ref_t share = (by_fake_dlshare_ref_t)handle;
+    by_assert_and_check_return_val(share, -1);
+    return share->fd;
+}
+by_pointer_t by_dlopen_shared(by_pointer_t handle, by_char_t const* filename, by_int_t flag)
+{
+    // check
+    by_fake_dlshare_ref_t share = (by_fake_dlshare_ref_t)handle;
+    by_assert_and_check_return_val(share && share->data && filename, by_null);
+
+    // find the library by the given name or real path
+    by_uint32_t                   i = 0;
+    by_fake_dlshare_head_t const* head = (by_fake_dlshare_head_t const*)share->data;
+    by_fake_dlshare_lib_t const*  libs = (by_fake_dlshare_lib_t const*)(head + 1);
+    by_fake_dlshare_lib_t const*  lib = by_null;
+    for (i = 0; i < head->count && !lib; i++)
+    {
+        if (!strcmp(libs[i].name, filename) || !strcmp(libs[i].realpath, filename))
+            lib = libs + i;
+    }
+    by_check_return_val(lib, by_null);
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_OPEN_BEGIN, by_trace_tag(filename), flag, 0);
+
+    /* find the load bias address of the current process
+     *
+     * it's same as the parent process after fork(), but we still find it again,
+     * because the memfd may be passed to the other processes.
+     */
+    by_linker_init();
+    by_char_t    realpath[512];
+    by_pointer_t biasaddr = by_fake_find_biasaddr(lib->realpath, realpath, sizeof(realpath));
+    by_trace_event(BY_TRACE_EVENT_OPEN_BIASADDR, by_trace_tag(filename), biasaddr, 0);
+
+    // init context, we use the shared compact index directly
+    by_fake_dlctx_ref_t dlctx = biasaddr? by_elf_dlctx_alloc(by_null) : by_null;
+    if (dlctx)
+    {
+        dlctx->magic        = BY_FAKE_DLCTX_MAGIC;
+        dlctx->biasaddr     = biasaddr;
+        dlctx->index        = (by_fake_dlidx_ref_t)(share->data + lib->index_offset);
+        dlctx->index_num    = lib->index_num;
+        dlctx->index_shared = by_true;
+    }
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_OPEN_END, by_trace_tag(filename), dlctx, 0);
+    return (by_pointer_t)dlctx;
+}
+by_void_t by_dlshare_exit(by_pointer_t handle)
+{
+    by_fake_dlshare_ref_t share = (by_fake_dlshare_ref_t)handle;
+    by_assert_and_check_return(share);
+
+    if (share->data) munmap((by_pointer_t)share->data, share->size);
+    if (share->fd >= 0) close(share->fd);
+    free(share);
+}
+by_int_t by_journal_replay(by_char_t const* filepath)
+{
+    // check
+    by_assert_and_check_return_val(filepath, -1);
+
+    // init linker
+    by_linker_init();
+
+    // enable journal and load the journal file
+    pthread_mutex_lock(&g_journal_lock);
+    g_journal_enabled = by_true;
+    by_journal_load(filepath);
+
+    // revalidate the loaded libraries, the other libraries will be validated when they are opened
+    by_int_t             count = 0;
+    by_journal_lib_ref_t jlib = g_journal_libs;
+    for (; jlib; jlib = jlib->next)
+    {
+        if (!jlib->biasaddr)
+        {
+            by_char_t    realpath[512];
+            by_pointer_t biasaddr = by_fake_find_biasaddr(jlib->name, realpath, sizeof(realpath));
+            if (biasaddr) by_journal_lib_validate(jlib, realpath, biasaddr);
+        }
+        count += (by_int_t)by_journal_lib_count(jlib);
+    }
+    pthread_mutex_unlock(&g_journal_lock);
+
+    // trace
+    by_trace("journal: %s, %d symbols replayed", filepath, count);
+    return count;
+}
+by_bool_t by_journal_save(by_char_t const* filepath)
+{
+    // check
+    by_assert_and_check_return_val(filepath, by_false);
+
+    // we write it to the temporary file first, and rename it to avoid the broken journal file
+    by_char_t temppath[512];
+    by_check_return_val(snprintf(temppath, sizeof(temppath), "%s.tmp", filepath) < (by_int_t)sizeof(temppath), by_false);
+
+    // save journal
+    FILE* fp = fopen(temppath, "w");
+    by_check_return_val(fp, by_false);
+
+    pthread_mutex_lock(&g_journal_lock);
+    by_bool_t ok = by_journal_save_file(fp);
+    pthread_mutex_unlock(&g_journal_lock);
+
+    if (fclose(fp) != 0) ok = by_false;
+    if (ok) ok = !rename(temppath, filepath);
+    if (!ok) unlink(temppath);
+    return ok;
+}
+by_void_t by_index_threads_set(by_size_t count)
+{
+    __atomic_store_n(&g_index_threads, count < BY_FAKE_INDEX_THREADS_MAXN? count : BY_FAKE_INDEX_THREADS_MAXN, __ATOMIC_RELAXED);
+}
+by_bool_t by_symscan_set(by_char_t const* name)
+{
+    // check
+    by_assert_and_check_return_val(name, by_false);
+
+    // set the symbol scan kernel
+    by_symscan_func_t func = by_symscan_find(name);
+    if (func) g_symscan = func;
+    return func != by_null;
+}
+by_int_t by_perfmap_export(by_pointer_t handle, by_size_t minsize)
+{
+    // only for fake dlopen
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_check_return_val(!dlctx || (dlctx->magic == BY_FAKE_DLCTX_MAGIC && !dlctx->pid), -1);
+
+    // open the perf map file, we need append it because it may be also written by jit
+    by_char_t mapfile[64];
+    snprintf(mapfile, sizeof(mapfile), "/tmp/perf-%d.map", (by_int_t)getpid());
+    FILE* fp = fopen(mapfile, "a");
+    by_check_return_val(fp, -1);
+
+    // uses a large buffer to reduce the write calls
+    setvbuf(fp, by_null, _IOFBF, 64 * 1024);
+
+    // export symbols
+    by_int_t count = 0;
+    if (dlctx) count = by_fake_perfmap_export(fp, dlctx, minsize);
+    else if (dl_iterate_phdr)
+    {
+        by_linker_init();
+        count = by_fake_perfmap_export_all(fp, minsize);
+    }
+    else count = -1;
+    fclose(fp);
+
+    // trace
+    by_trace("perfmap: %s, %d symbols exported", mapfile, count);
+    return count;
+}
+by_bool_t by_addr2line(by_pointer_t handle, by_cpointer_t addr, by_char_t const** pfile, by_size_t* pline)
+{
+    // check, only for fake dlopen in the current process
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && addr, by_false);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC && !dlctx->pid, by_false);
+
+    // find it from the line table
+    by_dwarf_lines_ref_t lines = by_fake_lines_get(dlctx, (by_size_t)addr);
+    return lines? by_dwarf_lines_find(lines, (by_size_t)addr - (by_size_t)dlctx->biasaddr, pfile, pline) : by_false;
+}
+by_size_t by_addr2line_batch(by_pointer_t handle, by_cpointer_t const* addrs, by_char_t const** files, by_size_t* plines, by_size_t count)
+{
+    // check, only for fake dlopen in the current process
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && addrs, 0);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC && !dlctx->pid, 0);
+
+    // get the line table, the frames of stack may be in the other libraries
+    by_size_t            i = 0;
+    by_dwarf_lines_ref_t lines = __atomic_load_n(&dlctx->lines, __ATOMIC_ACQUIRE);
+    for (i = 0; i < count && !lines; i++)
+    {
+        if (addrs[i]) lines = by_fake_lines_get(dlctx, (by_size_t)addrs[i]);
+    }
+
+    // make the queries sorted by address, we need not allocate it for the common stack depth
+    by_dwarf_query_t  buffer[64];
+    by_dwarf_query_t* queries = count <= sizeof(buffer) / sizeof(buffer[0])? buffer : malloc(count * sizeof(by_dwarf_query_t));
+    if (!lines || !queries)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (files) files[i] = by_null;
+            if (plines) plines[i] = 0;
+        }
+        if (queries && queries != buffer) free(queries);
+        return 0;
+    }
+    for (i = 0; i < count; i++)
+    {
+        queries[i].addr  = (by_size_t)addrs[i] - (by_size_t)dlctx->biasaddr;
+        queries[i].index = i;
+    }
+    qsort(queries, count, sizeof(by_dwarf_query_t), by_dwarf_query_comp);
+
+    // find them in one merge pass
+    by_size_t found = by_dwarf_lines_find_sorted(lines, queries, count, files, plines);
+    if (queries != buffer) free(queries);
+    return found;
+}
+by_bool_t by_dlsection(by_pointer_t handle, by_char_t const* name, by_pointer_t* paddr, by_size_t* psize)
+{
+    // check, only for fake dlopen in the current process, the compact handle has not the section headers
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && name && paddr, by_false);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC && !dlctx->pid, by_false);
+    by_check_return_val(by_elf_dlctx_ensure(dlctx) && dlctx->filedata, by_false);
+
+    // find section
+    ElfW(Shdr) const* sh = by_fake_elf_section_header(dlctx->filedata, dlctx->filesize, name);
+    by_check_return_val(sh, by_false);
+
+    // .tbss has not any data, its address is overlapped with the next section
+    by_check_return_val(sh->sh_type != SHT_NOBITS || !(sh->sh_flags & SHF_TLS), by_false);
+
+    // it's in the loaded segment? we use the runtime address, the data may have been relocated
+    by_size_t         phnum = 0;
+    ElfW(Phdr) const* phdrs = by_fake_elf_segments(dlctx->filedata, dlctx->filesize, &phnum);
+    if (phdrs && (sh->sh_flags & SHF_ALLOC) && sh->sh_addr && by_fake_elf_loaded(phdrs, phnum, (by_size_t)sh->sh_addr, (by_size_t)sh->sh_size))
+    {
+        *paddr = (by_pointer_t)((by_size_t)dlctx->biasaddr + (by_size_t)sh->sh_addr);
+        if (psize) *psize = (by_size_t)sh->sh_size;
+        return by_true;
+    }
+
+    // use the file-mapped data
+    by_byte_t const* data = by_fake_elf_section_data(dlctx->filedata, dlctx->filesize, sh, psize);
+    by_check_return_val(data, by_false);
+    *paddr = (by_pointer_t)data;
+    return by_true;
+}
+by_bool_t by_dlsegment(by_pointer_t handle, by_size_t type, by_size_t index, by_pointer_t* paddr, by_size_t* psize)
+{
+    // check, only for fake dlopen in the current process
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && paddr, by_false);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC && !dlctx->pid, by_false);
+    by_check_return_val(by_elf_dlctx_ensure(dlctx) && dlctx->filedata, by_false);
+
+    // find the nth segment of the given type
+    by_size_t         i = 0;
+    by_size_t         phnum = 0;
+    ElfW(Phdr) const* phdrs = by_fake_elf_segments(dlctx->filedata, dlctx->filesize, &phnum);
+    ElfW(Phdr) const* phdr = by_null;
+    for (i = 0; i < phnum && !phdr; i++)
+    {
+        if (phdrs[i].p_type == type && !index--) phdr = phdrs + i;
+    }
+    by_check_return_val(phdr && phdr->p_memsz, by_false);
+
+    // it's in the loaded segment? e.g. PT_LOAD, PT_DYNAMIC and PT_NOTE
+    if (by_fake_elf_loaded(phdrs, phnum, (by_size_t)phdr->p_vaddr, (by_size_t)phdr->p_memsz))
+    {
+        *paddr = (by_pointer_t)((by_size_t)dlctx->biasaddr + (by_size_t)phdr->p_vaddr);
+        if (psize) *psize = (by_size_t)phdr->p_memsz;
+        return by_true;
+    }
+
+    // use the file-mapped data
+    by_check_return_val(phdr->p_filesz && phdr->p_offset < dlctx->filesize && phdr->p_filesz <= dlctx->filesize - phdr->p_offset, by_false);
+    *paddr = (by_pointer_t)(dlctx->filedata + phdr->p_offset);
+    if (psize) *psize = (by_size_t)phdr->p_filesz;
+    return by_true;
+}
+by_int_t by_dlclose(by_pointer_t handle)
+{
+    // check
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx, -1);
+
+    // do dlclose
+    return (dlctx->magic == BY_FAKE_DLCTX_MAGIC)? by_elf_dlclose(dlctx) : dlclose(handle);
+}
+
@@ -0,0 +1,310 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_elf.h
+ *
+ */
+#ifndef BY_ELF_H
+#define BY_ELF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen.h"
+#include "byopen_dwarf.h"
+#include <pthread.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the linker name, it's not listed by dl_iterate_phdr() on android
+#ifndef __LP64__
+#   define BY_LINKER_NAME       "linker"
+#else
+#   define BY_LINKER_NAME       "linker64"
+#endif
+
+// the fake dlopen magic
+#define BY_FAKE_DLCTX_MAGIC      (0xfaddfadd)
+
+// get the symbol type from st_info
+#define BY_ELF_ST_TYPE(info)    ((info) & 0xf)
+
+// strlcpy() is only provided since glibc 2.38
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+#   define strlcpy(dst, src, size)  by_elf_strlcpy(dst, src, size)
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the dynamic library context type for fake dlopen
+typedef struct _by_fake_dlctx_t
+{
+    // magic, mark handle for fake dlopen
+    by_uint32_t     magic;
+
+    // is the context in the caller-provided storage? we need not free it to the handle pool
+    by_bool_t       storage;
+
+    // the remote process id, the load bias address is in the remote process, it's 0 for the current process
+    by_int_t        pid;
+
+    // the load bias address of the dynamic library
+    by_pointer_t    biasaddr;
+
+    // the .dynsym and .dynstr sections
+    by_pointer_t    dynstr;
+    by_pointer_t    dynsym;
+    by_int_t        dynsym_num;
+
+    // the .symtab and .strtab sections
+    by_pointer_t    strtab;
+    by_pointer_t    symtab;
+    by_int_t        symtab_num;
+
+    // the .gnu.version and .gnu.version_d sections, the version names are in .dynstr
+    by_pointer_t    versym;
+    by_pointer_t    verdef;
+    by_int_t        verdef_num;
+
+    // the file data and size
+    by_pointer_t    filedata;
+    by_size_t       filesize;
+
+    // the compact index sorted by name hash, the file data has been unmapped if it exists
+    struct _by_fake_dlidx_t* index;
+    by_size_t       index_num;
+
+    // is the compact index in the shared mapping? we need not free it
+    by_bool_t       index_shared;
+
+    // the journal library, it's null if the journal is not enabled
+    struct _by_journal_lib_t* journal;
+
+    // the library file has not been loaded? it will be loaded at the first journal miss
+    by_uint32_t     lazy;
+
+    // the demangled name index sorted by name hash, it's built at the first demangled lookup
+    struct _by_fake_dlidx_t* demangled;
+    by_size_t       demangled_num;
+
+    // the tls module id, it's 0 if it has not been found
+    by_size_t       tls_modid;
+
+    // the cached tls symbol offsets (hash and st_value), we only append it and publish its count atomically
+    struct _by_fake_dlidx_t* tls_cache;
+    by_size_t       tls_cache_num;
+
+    // the line table of .debug_line, it's built at the first line lookup
+    struct __by_dwarf_lines_t* lines;
+
+}by_fake_dlctx_t, *by_fake_dlctx_ref_t;
+
+// the loaded module range type
+typedef struct _by_fake_module_t
+{
+    // the address range of all loaded segments
+    by_size_t       start;
+    by_size_t       end;
+
+    // the load bias address
+    by_pointer_t    biasaddr;
+
+    // the module name (dlpi_name), it may be not full path
+    by_char_t*      name;
+
+    // the .eh_frame_hdr of PT_GNU_EH_FRAME, the table is null if it's not found
+    by_dwarf_ehhdr_t ehhdr;
+
+}by_fake_module_t, *by_fake_module_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+/* the linker mutex, it will be locked when iterating the loaded libraries by dl_iterate_phdr()
+ *
+ * it's only found by the android backend for android 5.x, dl_iterate_phdr() locks it itself on the other systems.
+ */
+extern pthread_mutex_t*     g_by_linker_mutex;
+
+// the module table lock, it protects the module range table and the call frame cache of the unwinder
+extern pthread_mutex_t      g_by_modules_lock;
+
+// the module table generation, it's increased after rebuilding the module table
+extern by_size_t            g_by_modules_gen;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * interfaces
+ */
+
+/*! init the linker of the platform backend, e.g. find g_by_linker_mutex
+ *
+ * @note it's implemented by the platform backend (byopen_android.c, byopen_linux.c),
+ * and it's called by the elf engine before iterating the loaded libraries.
+ */
+by_void_t                   by_linker_init(by_void_t);
+
+/*! open the loaded library by the elf engine, it will not load the library if it has not been loaded
+ *
+ * @note the platform backend should call by_linker_init() first
+ *
+ * @param storage           the caller-provided handle storage, the handle is allocated from the handle pool if it's null
+ * @param size              the storage size
+ * @param filename          the library name or path
+ * @param flag              the dlopen flag
+ *
+ * @return                  the dynamic library handle
+ */
+by_pointer_t                by_elf_dlopen(by_pointer_t storage, by_size_t size, by_char_t const* filename, by_int_t flag);
+
+/*! alloc the fake dlopen context from the handle pool or the caller-provided storage
+ *
+ * @param storage           the caller-provided handle storage, it may be null
+ *
+ * @return                  the zeroed context
+ */
+by_fake_dlctx_ref_t         by_elf_dlctx_alloc(by_pointer_t storage);
+
+/*! load the library file to the fake dlopen context
+ *
+ * @param dlctx             the fake dlopen context, the load bias address has been set
+ * @param realpath          the library file path
+ *
+ * @return                  by_true on success
+ */
+by_bool_t                   by_elf_dlctx_load(by_fake_dlctx_ref_t dlctx, by_char_t const* realpath);
+
+/*! ensure the library file of the lazy journal handle has been loaded
+ *
+ * @param dlctx             the fake dlopen context
+ *
+ * @return                  by_true if the symbol tables are available
+ */
+by_bool_t                   by_elf_dlctx_ensure(by_fake_dlctx_ref_t dlctx);
+
+/*! open the fake dlopen context of the given library file and load bias address
+ *
+ * @param storage           the caller-provided handle storage, it may be null
+ * @param biasaddr          the load bias address
+ * @param realpath          the library file path
+ *
+ * @return                  the fake dlopen context
+ */
+by_fake_dlctx_ref_t         by_elf_dlopen_file(by_pointer_t storage, by_pointer_t biasaddr, by_char_t const* realpath);
+
+/*! close the fake dlopen context
+ *
+ * @param dlctx             the fake dlopen context
+ *
+ * @return                  0 on success
+ */
+by_int_t                    by_elf_dlclose(by_fake_dlctx_ref_t dlctx);
+
+/*! find the symbol address of the fake dlopen context
+ *
+ * @param dlctx             the fake dlopen context
+ * @param symbol            the symbol name
+ *
+ * @return                  the symbol address, it's in the remote process for the remote handle
+ */
+by_pointer_t                by_elf_dlsym(by_fake_dlctx_ref_t dlctx, by_char_t const* symbol);
+
+/*! build the compact index and unmap the file data, all symbols are indexed if symbols is null
+ *
+ * @param dlctx             the fake dlopen context
+ * @param symbols           the symbol names
+ * @param count             the symbol count
+ *
+ * @return                  by_true on success
+ */
+by_bool_t                   by_elf_dlcompact(by_fake_dlctx_ref_t dlctx, by_char_t const** symbols, by_size_t count);
+
+/*! find the load bias address, real path and base address from the maps of the given process
+ *
+ * @param pid               the process id, it's 0 for the current process
+ * @param filename          the library name or path
+ * @param realpath          the real path
+ * @param realmaxn          the real path size
+ * @param pbaseaddr         the base address, it may be null
+ *
+ * @return                  the load bias address
+ */
+by_pointer_t                by_elf_find_biasaddr_from_pidmaps(by_int_t pid, by_char_t const* filename, by_char_t* realpath, by_size_t realmaxn, by_pointer_t* pbaseaddr);
+
+/*! find the real path of the library containing the given address
+ *
+ * @param addr              the address
+ * @param realpath          the real path
+ * @param maxn              the real path size
+ *
+ * @return                  by_true if it's found
+ */
+by_bool_t                   by_elf_find_realpath(by_size_t addr, by_char_t* realpath, by_size_t maxn);
+
+/*! make the module range table of all loaded libraries, it need be called in g_by_modules_lock
+ */
+by_void_t                   by_elf_modules_make(by_void_t);
+
+/*! find the module containing the given address, it need be called in g_by_modules_lock
+ *
+ * @param addr              the address
+ *
+ * @return                  the module, it's null if it's not found
+ */
+by_fake_module_ref_t        by_elf_modules_find(by_size_t addr);
+
+/*! find the load bias address from the base address of the remote process
+ *
+ * @note it's implemented in byopen_remote.c
+ *
+ * @param pid               the remote process id
+ * @param baseaddr          the base address in the remote process
+ *
+ * @return                  the load bias address
+ */
+by_pointer_t                by_elf_remote_find_biasaddr(by_int_t pid, by_pointer_t baseaddr);
+
+/*! get the load generation, it's dlpi_adds or the module count if dlpi_adds is not supported
+ *
+ * it's cheap because only the first module is visited if dlpi_adds is supported.
+ *
+ * @note it's implemented in byopen_dlnotify.c
+ *
+ * @return                  the load generation
+ */
+by_uint64_t                 by_elf_dlnotify_adds(by_void_t);
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+/*! copy the string with the size limit like strlcpy() of bsd
+ *
+ * @return                  the source length
+ */
+by_size_t                   by_elf_strlcpy(by_char_t* dst, by_char_t const* src, by_size_t size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,57 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_linux.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_elf.h"
+#include <dlfcn.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_void_t by_linker_init()
+{
+    // nothing to do, dl_iterate_phdr() of glibc holds the loader lock itself
+}
+by_pointer_t by_dlopen(by_char_t const* filename, by_int_t flag)
+{
+    return by_dlopen_into(by_null, 0, filename, flag);
+}
+by_pointer_t by_dlopen_into(by_pointer_t storage, by_size_t size, by_char_t const* filename, by_int_t flag)
+{
+    // check
+    by_assert_and_check_return_val(filename, by_null);
+
+    // init linker
+    by_linker_init();
+
+    // uses the fake dlopen to load it from maps directly
+    by_pointer_t handle = by_elf_dlopen(storage, size, filename, flag);
+
+    /* load it via the system dlopen if it has not been loaded yet, there is no namespace restriction on linux.
+     *
+     * we never close the system handle, so the mapped library is kept alive for the fake handle.
+     */
+    if (!handle && dlopen(filename, (flag & BY_RTLD_LAZY)? RTLD_LAZY : RTLD_NOW))
+        handle = by_elf_dlopen(storage, size, filename, flag);
+    return handle;
+}
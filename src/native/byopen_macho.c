@@ -23,20 +23,21 @@
  * includes
  */
 #include "byopen.h"
+#include "byopen_macho_image.h"
+#include "byopen_macho_images.h"
+#include "byopen_pool.h"
+#include <dlfcn.h>
 #include <mach/mach.h>
 #include <mach/machine.h>
 #include <mach-o/dyld.h>
-#include <mach-o/nlist.h>
 #include <objc/runtime.h>
 
 /* //////////////////////////////////////////////////////////////////////////////////////
  * macros
  */
-#if defined(__LP64__)
-#   define NLIST                struct nlist_64
-#else
-#   define NLIST                struct nlist
-#endif
+
+// the handle count of each slab of the handle pool
+#define BY_FAKE_DLCTX_SLAB_ITEMN    (16)
 
 /* //////////////////////////////////////////////////////////////////////////////////////
  * types
@@ -44,68 +45,93 @@
 // the dynamic library context type for fake dlopen
 typedef struct _by_fake_dlctx_t 
 {    
-    // the image index
-    by_size_t                   image_index;
-
     // the image image_header
     struct mach_header const*   image_header;
 
+    // the parsed image, __LINKEDIT, symtab and the export trie are located once at dlopen
+    by_macho_image_t            image;
+
+    // is the context in the caller-provided storage? we need not free it to the handle pool
+    by_bool_t                   storage;
+
 }by_fake_dlctx_t, *by_fake_dlctx_ref_t;
 
 /* //////////////////////////////////////////////////////////////////////////////////////
  * private implementation
  */
-
-// get first cmd after image_header
-static by_pointer_t by_get_first_cmd_after_header(struct mach_header const* image_header)
+static by_void_t by_dyld_register_add(by_macho_images_func_t func)
 {
-    switch (image_header->magic)
-    {
-        case MH_MAGIC:
-        case MH_CIGAM:
-            return (by_pointer_t)(image_header + 1);
-        case MH_MAGIC_64:
-        case MH_CIGAM_64:
-            return (by_pointer_t)(((struct mach_header_64*)image_header) + 1);
-        default:
-            // image_header is corrupt
-            return 0;
-    }
+    _dyld_register_func_for_add_image((by_void_t (*)(struct mach_header const*, intptr_t))func);
+}
+static by_void_t by_dyld_register_remove(by_macho_images_func_t func)
+{
+    _dyld_register_func_for_remove_image((by_void_t (*)(struct mach_header const*, intptr_t))func);
+}
+static by_char_t const* by_dyld_image_path(struct mach_header const* header)
+{
+    Dl_info info;
+    return dladdr(header, &info)? info.dli_fname : by_null;
 }
 
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the dyld image provider
+static by_macho_images_provider_t g_dyld_images_provider =
+{
+    by_dyld_register_add
+,   by_dyld_register_remove
+,   by_dyld_image_path
+};
+
+// the handle pool, the first slab is static, so the common open/close cycle need not allocate heap memory
+static by_fake_dlctx_t  g_dlctx_slab[BY_FAKE_DLCTX_SLAB_ITEMN];
+static by_pool_t        g_dlctx_pool = BY_POOL_INIT(g_dlctx_slab, BY_FAKE_DLCTX_SLAB_ITEMN);
+
+// the handle count opened in the caller-provided storage
+static by_size_t        g_dlctx_storages = 0;
+
+// the handle must fit in the caller-provided storage
+typedef by_char_t       by_fake_dlctx_storage_check_t[sizeof(by_fake_dlctx_t) <= BY_DLOPEN_STORAGE_SIZE? 1 : -1];
+
 /* //////////////////////////////////////////////////////////////////////////////////////
  * implementation
  */
 by_pointer_t by_dlopen(by_char_t const* filename, by_int_t flag)
+{
+    return by_dlopen_into(by_null, 0, filename, flag);
+}
+by_pointer_t by_dlopen_into(by_pointer_t storage, by_size_t size, by_char_t const* filename, by_int_t flag)
 {
     // check
     by_assert_and_check_return_val(filename, by_null);
+    by_assert_and_check_return_val(!storage || (size >= BY_DLOPEN_STORAGE_SIZE && !((by_size_t)storage & (sizeof(by_pointer_t) - 1))), by_null);
+
+    // init the image table, it's kept current by the dyld callbacks
+    by_check_return_val(by_macho_images_init(&g_dyld_images_provider), by_null);
 
-    /* skip the first image (master app), becasue it's symtab will be stripped after be archived.
-     * so we need to keep our behavior consistent for debug/release and archived packages.
-     */
+    // find image by the full path, basename or framework name
     struct mach_header const* image_header = by_null;
-    by_size_t const           image_count = _dyld_image_count();
-    for (by_size_t image_index = 1; image_index < image_count; image_index++)
+    by_long_t                 image_vmaddr_slide = 0;
+    by_check_return_val(by_macho_images_find(filename, &image_header, &image_vmaddr_slide), by_null);
+
+    // init context from the caller-provided storage or the handle pool
+    by_fake_dlctx_ref_t dlctx = storage? (by_fake_dlctx_ref_t)storage : (by_fake_dlctx_ref_t)by_pool_alloc(&g_dlctx_pool);
+    by_check_return_val(dlctx, by_null);
+    if (storage) memset(dlctx, 0, sizeof(by_fake_dlctx_t));
+    dlctx->image_header = image_header;
+    dlctx->storage      = storage? by_true : by_false;
+
+    // parse image
+    if (!by_macho_image_init(&dlctx->image, image_header, 0, image_vmaddr_slide))
     {
-        image_header = _dyld_get_image_header((uint32_t)image_index);
-        if (image_header)
-        {
-            by_char_t const* image_name = _dyld_get_image_name(image_index);
-            if (image_name && 0 == strcmp(image_name, filename))
-            {
-                by_fake_dlctx_ref_t dlctx = calloc(1, sizeof(by_fake_dlctx_t));
-                if (dlctx)
-                {
-                    dlctx->image_index  = image_index;
-                    dlctx->image_header = image_header;
-                }
-                by_trace("%s: found at %p/%d", image_name, image_header, (by_int_t)image_index);
-                return (by_pointer_t)dlctx;
-            }
-        }
+        if (!storage) by_pool_free(&g_dlctx_pool, dlctx);
+        return by_null;
     }
-    return by_null;
+    if (storage) __atomic_add_fetch(&g_dlctx_storages, 1, __ATOMIC_RELAXED);
+    by_trace("%s: found at %p", filename, image_header);
+    return (by_pointer_t)dlctx;
 }
 by_pointer_t by_dlsym(by_pointer_t handle, by_char_t const* symbol)
 {
@@ -113,75 +139,11 @@ by_pointer_t by_dlsym(by_pointer_t handle, by_char_t const* symbol)
     by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
     by_assert_and_check_return_val(dlctx && dlctx->image_header && symbol, by_null);
 
-    // skip '_'
-    if (*symbol == '_') symbol++;
+    // trace
+    by_trace_event(BY_TRACE_EVENT_DLSYM_BEGIN, by_trace_tag(symbol), dlctx, 0);
 
-    // get command pointer
-    struct mach_header const* image_header  = dlctx->image_header;
-    uintptr_t cmd_ptr                       = by_get_first_cmd_after_header(image_header);
-    uintptr_t image_vmaddr_slide            = (uintptr_t)_dyld_get_image_vmaddr_slide(dlctx->image_index);
-    if (cmd_ptr)
-    {
-        uintptr_t segment_base = 0;
-        for (by_size_t cmd_index = 0; cmd_index < image_header->ncmds; cmd_index++)
-        {
-            // get segment base address
-            struct load_command const* load_cmd = (struct load_command*)cmd_ptr;
-            if (load_cmd->cmd == LC_SEGMENT)
-            {
-                struct segment_command const* segment_cmd = (struct segment_command*)cmd_ptr;
-                if (strcmp(segment_cmd->segname, SEG_LINKEDIT) == 0)
-                    segment_base = (uintptr_t)(segment_cmd->vmaddr - segment_cmd->fileoff) + image_vmaddr_slide;
-            }
-            else if (load_cmd->cmd == LC_SEGMENT_64)
-            {
-                struct segment_command_64 const* segment_cmd = (struct segment_command_64*)cmd_ptr;
-                if (strcmp(segment_cmd->segname, SEG_LINKEDIT) == 0)
-                    segment_base = (uintptr_t)(segment_cmd->vmaddr - segment_cmd->fileoff) + image_vmaddr_slide;
-            }
-            else if (load_cmd->cmd == LC_SYMTAB && segment_base > 0)
-            {
-                struct symtab_command const* symbol_table_cmd = (struct symtab_command*)cmd_ptr;
-                NLIST const*                 symbol_table = (NLIST*)(segment_base + symbol_table_cmd->symoff);
-                uintptr_t                    string_table = segment_base + symbol_table_cmd->stroff;
-                for (uint32_t symbol_index = 0; symbol_index < symbol_table_cmd->nsyms; symbol_index++)
-                {
-                    // if n_value is 0, the symbol refers to an external object.
-                    if (symbol_table[symbol_index].n_value != 0)
-                    {
-                        // get symbol name
-                        NLIST const* item          = symbol_table + symbol_index;
-                        by_pointer_t dli_saddr     = (by_pointer_t)(item->n_value + image_vmaddr_slide);
-                        by_char_t const* dli_sname = (by_char_t*)((intptr_t)string_table + (intptr_t)item->n_un.n_strx);
-                        if (*dli_sname == '_') dli_sname++;
-
-                        // found and skip symbols with '0x...'?
-                        if (*dli_sname != '0' && !strcmp(symbol, dli_sname))
-                        {
-                            // thumb function? fix address
-#if defined(BY_ARCH_ARM) && !defined(BY_ARCH_ARM64)
-#   ifdef BY_ARCH_ARM_THUMB
-                            if (item->n_desc & N_ARM_THUMB_DEF) 
-                                dli_saddr = (by_pointer_t)((by_ulong_t)dli_saddr | 1);
-#   else
-                            if (item->n_desc & N_ARM_THUMB_DEF) 
-                                dli_saddr = (by_pointer_t)((by_ulong_t)dli_saddr & ~1);
-#   endif
-#endif
-                            // trace
-                            by_trace("dlsym(%s): %p", dli_sname, dli_saddr);
-                            return dli_saddr;
-                        }
-                    }
-                }
-
-                // reset the segment base address
-                segment_base = 0;
-            }
-            cmd_ptr += load_cmd->cmdsize;
-        }
-    }
-    return by_null;
+    // find it from the export trie and the nlist hash table
+    return by_macho_image_dlsym(&dlctx->image, symbol);
 }
 by_int_t by_dlclose(by_pointer_t handle)
 {
@@ -189,7 +151,22 @@ by_int_t by_dlclose(by_pointer_t handle)
     by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
     by_assert_and_check_return_val(dlctx, -1);
 
-    // free it
-    free(dlctx);
+    // exit image
+    by_macho_image_exit(&dlctx->image);
+
+    // free it to the handle pool, the caller-provided storage is only cleared
+    dlctx->image_header = by_null;
+    if (dlctx->storage) __atomic_sub_fetch(&g_dlctx_storages, 1, __ATOMIC_RELAXED);
+    else by_pool_free(&g_dlctx_pool, dlctx);
     return 0;
 }
+by_bool_t by_dlpool_stat(by_dlpool_stat_t* stat)
+{
+    // check
+    by_assert_and_check_return_val(stat, by_false);
+
+    // get the statistics of the handle pool
+    by_pool_stat(&g_dlctx_pool, stat);
+    stat->storages = __atomic_load_n(&g_dlctx_storages, __ATOMIC_RELAXED);
+    return by_true;
+}
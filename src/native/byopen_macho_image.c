@@ -0,0 +1,592 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_macho_image.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_macho_image.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the mach-o magic
+#define BY_MACHO_MAGIC                      (0xfeedface)
+#define BY_MACHO_MAGIC_64                   (0xfeedfacf)
+
+// the load commands
+#define BY_MACHO_LC_REQ_DYLD                (0x80000000)
+#define BY_MACHO_LC_SEGMENT                 (0x1)
+#define BY_MACHO_LC_SYMTAB                  (0x2)
+#define BY_MACHO_LC_SEGMENT_64              (0x19)
+#define BY_MACHO_LC_DYLD_INFO               (0x22)
+#define BY_MACHO_LC_DYLD_INFO_ONLY          (0x22 | BY_MACHO_LC_REQ_DYLD)
+#define BY_MACHO_LC_DYLD_EXPORTS_TRIE       (0x33 | BY_MACHO_LC_REQ_DYLD)
+
+// the nlist type
+#define BY_MACHO_N_STAB                     (0xe0)
+#define BY_MACHO_N_ARM_THUMB_DEF            (0x0008)
+
+// the export symbol flags
+#define BY_MACHO_EXPORT_KIND_MASK           (0x03)
+#define BY_MACHO_EXPORT_KIND_REGULAR        (0x00)
+#define BY_MACHO_EXPORT_KIND_ABSOLUTE       (0x02)
+#define BY_MACHO_EXPORT_REEXPORT            (0x08)
+#define BY_MACHO_EXPORT_STUB_AND_RESOLVER   (0x10)
+
+// the maximum depth of the export trie, avoid the loop of the corrupt trie
+#define BY_MACHO_TRIE_MAXDEPTH              (128)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the mach header type
+typedef struct _by_macho_header_t
+{
+    by_uint32_t             magic;
+    by_int32_t              cputype;
+    by_int32_t              cpusubtype;
+    by_uint32_t             filetype;
+    by_uint32_t             ncmds;
+    by_uint32_t             sizeofcmds;
+    by_uint32_t             flags;
+
+}by_macho_header_t;
+
+// the load command type
+typedef struct _by_macho_load_command_t
+{
+    by_uint32_t             cmd;
+    by_uint32_t             cmdsize;
+
+}by_macho_load_command_t;
+
+// the segment command type
+typedef struct _by_macho_segment_command_t
+{
+    by_uint32_t             cmd;
+    by_uint32_t             cmdsize;
+    by_char_t               segname[16];
+    by_uint32_t             vmaddr;
+    by_uint32_t             vmsize;
+    by_uint32_t             fileoff;
+    by_uint32_t             filesize;
+
+}by_macho_segment_command_t;
+
+// the 64bits segment command type
+typedef struct _by_macho_segment_command_64_t
+{
+    by_uint32_t             cmd;
+    by_uint32_t             cmdsize;
+    by_char_t               segname[16];
+    by_uint64_t             vmaddr;
+    by_uint64_t             vmsize;
+    by_uint64_t             fileoff;
+    by_uint64_t             filesize;
+
+}by_macho_segment_command_64_t;
+
+// the symtab command type
+typedef struct _by_macho_symtab_command_t
+{
+    by_uint32_t             cmd;
+    by_uint32_t             cmdsize;
+    by_uint32_t             symoff;
+    by_uint32_t             nsyms;
+    by_uint32_t             stroff;
+    by_uint32_t             strsize;
+
+}by_macho_symtab_command_t;
+
+// the dyld info command type
+typedef struct _by_macho_dyld_info_command_t
+{
+    by_uint32_t             cmd;
+    by_uint32_t             cmdsize;
+    by_uint32_t             rebase_off;
+    by_uint32_t             rebase_size;
+    by_uint32_t             bind_off;
+    by_uint32_t             bind_size;
+    by_uint32_t             weak_bind_off;
+    by_uint32_t             weak_bind_size;
+    by_uint32_t             lazy_bind_off;
+    by_uint32_t             lazy_bind_size;
+    by_uint32_t             export_off;
+    by_uint32_t             export_size;
+
+}by_macho_dyld_info_command_t;
+
+// the linkedit data command type
+typedef struct _by_macho_linkedit_data_command_t
+{
+    by_uint32_t             cmd;
+    by_uint32_t             cmdsize;
+    by_uint32_t             dataoff;
+    by_uint32_t             datasize;
+
+}by_macho_linkedit_data_command_t;
+
+// the nlist type
+typedef struct _by_macho_nlist_t
+{
+    by_uint32_t             n_strx;
+    by_uint8_t              n_type;
+    by_uint8_t              n_sect;
+    by_int16_t              n_desc;
+    by_uint32_t             n_value;
+
+}by_macho_nlist_t;
+
+// the 64bits nlist type
+typedef struct _by_macho_nlist_64_t
+{
+    by_uint32_t             n_strx;
+    by_uint8_t              n_type;
+    by_uint8_t              n_sect;
+    by_uint16_t             n_desc;
+    by_uint64_t             n_value;
+
+}by_macho_nlist_64_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+
+// is the given file range in the image? it's always true for the image loaded by dyld
+static __inline__ by_bool_t by_macho_image_range(by_macho_image_ref_t image, by_uint64_t offset, by_uint64_t size)
+{
+    return !image->size || (offset <= image->size && size <= image->size - offset);
+}
+static by_bool_t by_macho_uleb128(by_byte_t const** pp, by_byte_t const* e, by_ulong_t* pv)
+{
+    by_ulong_t       v = 0;
+    by_size_t        bit = 0;
+    by_byte_t const* p = *pp;
+    while (p < e)
+    {
+        by_byte_t b = *p++;
+        if (bit < sizeof(by_ulong_t) * 8)
+            v |= (by_ulong_t)(b & 0x7f) << bit;
+        bit += 7;
+        if (!(b & 0x80))
+        {
+            *pp = p;
+            *pv = v;
+            return by_true;
+        }
+    }
+    return by_false;
+}
+
+// the symbol hash, the leading '_' has been skipped
+static __inline__ by_uint32_t by_macho_hash(by_char_t const* name)
+{
+    by_uint32_t h = 5381;
+    while (*name) h = (h << 5) + h + (by_uint8_t)*name++;
+    return h;
+}
+
+// get the nlist entry
+static __inline__ by_void_t by_macho_nlist(by_macho_image_ref_t image, by_uint32_t index, by_uint32_t* strx, by_uint8_t* type, by_uint16_t* desc, by_ulong_t* value)
+{
+    if (image->is64)
+    {
+        by_macho_nlist_64_t const* item = (by_macho_nlist_64_t const*)image->symbols + index;
+        *strx  = item->n_strx;
+        *type  = item->n_type;
+        *desc  = item->n_desc;
+        *value = (by_ulong_t)item->n_value;
+    }
+    else
+    {
+        by_macho_nlist_t const* item = (by_macho_nlist_t const*)image->symbols + index;
+        *strx  = item->n_strx;
+        *type  = item->n_type;
+        *desc  = (by_uint16_t)item->n_desc;
+        *value = (by_ulong_t)item->n_value;
+    }
+}
+
+/* get the searchable name of the nlist entry, the leading '_' will be skipped
+ *
+ * if n_value is 0, the symbol refers to an external object,
+ * and we also skip the stab entries and the symbols with '0x...'
+ */
+static by_char_t const* by_macho_nlist_name(by_macho_image_ref_t image, by_uint32_t index, by_uint16_t* desc, by_ulong_t* value)
+{
+    by_uint32_t strx;
+    by_uint8_t  type;
+    by_macho_nlist(image, index, &strx, &type, desc, value);
+    by_check_return_val(*value && !(type & BY_MACHO_N_STAB) && strx < image->strings_size, by_null);
+
+    by_char_t const* name = image->strings + strx;
+    if (*name == '_') name++;
+    return *name != '0'? name : by_null;
+}
+
+// build the nlist hash table, it's a chained hash table with the index + 1 of nlist
+static by_uint32_t* by_macho_hash_make(by_macho_image_ref_t image)
+{
+    // get the bucket count, the power of 2
+    by_uint32_t count = 1;
+    while (count < image->symbols_num && count < 0x40000000) count <<= 1;
+
+    // make the hash table: [count][buckets][chains]
+    by_uint32_t* hash = calloc(1 + count + image->symbols_num, sizeof(by_uint32_t));
+    by_check_return_val(hash, by_null);
+    hash[0] = count;
+
+    // insert symbols in the reverse order, so the first matched symbol is found first like the linear scan
+    by_uint32_t* buckets = hash + 1;
+    by_uint32_t* chains = buckets + count;
+    for (by_uint32_t i = image->symbols_num; i > 0; i--)
+    {
+        by_uint16_t      desc;
+        by_ulong_t       value;
+        by_char_t const* name = by_macho_nlist_name(image, i - 1, &desc, &value);
+        if (name)
+        {
+            by_uint32_t bucket = by_macho_hash(name) & (count - 1);
+            chains[i - 1] = buckets[bucket];
+            buckets[bucket] = i;
+        }
+    }
+    return hash;
+}
+
+// get the lazy nlist hash table
+static by_uint32_t* by_macho_hash_get(by_macho_image_ref_t image)
+{
+    // get it if it has been built
+    by_uint32_t* hash = __atomic_load_n(&image->hash, __ATOMIC_ACQUIRE);
+    by_check_return_val(!hash, hash);
+
+    // build it and publish it, we use the other one if it has been built by the other thread
+    hash = by_macho_hash_make(image);
+    by_check_return_val(hash, by_null);
+
+    by_uint32_t* expected = by_null;
+    if (!__atomic_compare_exchange_n(&image->hash, &expected, hash, by_false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        free(hash);
+        hash = expected;
+    }
+    return hash;
+}
+
+// get the character of the export trie key ("_" + symbol)
+static __inline__ by_char_t by_macho_trie_key(by_char_t const* symbol, by_size_t pos)
+{
+    return pos? symbol[pos - 1] : '_';
+}
+
+// walk the export trie and get the terminal info of the given symbol
+static by_byte_t const* by_macho_trie_walk(by_macho_image_ref_t image, by_char_t const* symbol)
+{
+    by_byte_t const* start = image->trie;
+    by_byte_t const* end = start + image->trie_size;
+    by_byte_t const* p = start;
+    by_size_t        pos = 0;
+    for (by_size_t depth = 0; p < end && depth < BY_MACHO_TRIE_MAXDEPTH; depth++)
+    {
+        // get the terminal size, the key has been matched if it's the terminal node
+        by_ulong_t terminal_size = 0;
+        by_check_break(by_macho_uleb128(&p, end, &terminal_size));
+        if (terminal_size && !by_macho_trie_key(symbol, pos))
+            return p;
+
+        // get the children
+        by_check_break(terminal_size < (by_size_t)(end - p));
+        p += terminal_size;
+        by_uint8_t child_count = *p++;
+
+        // find the child edge with the prefix of the remaining key
+        by_ulong_t node_offset = 0;
+        for (by_uint8_t i = 0; i < child_count && !node_offset && p < end; i++)
+        {
+            by_size_t n = 0;
+            by_bool_t matched = by_true;
+            for (; p < end && *p; p++, n++)
+            {
+                if (matched && *p != (by_byte_t)by_macho_trie_key(symbol, pos + n))
+                    matched = by_false;
+            }
+            p++;
+
+            by_ulong_t offset = 0;
+            by_check_break(by_macho_uleb128(&p, end, &offset));
+            if (matched)
+            {
+                node_offset = offset;
+                pos += n;
+            }
+        }
+
+        // goto the child node
+        by_check_break(node_offset && node_offset < image->trie_size);
+        p = start + node_offset;
+    }
+    return by_null;
+}
+
+// get the exported symbol address from the export trie, the leading '_' has been skipped
+static by_pointer_t by_macho_trie_dlsym(by_macho_image_ref_t image, by_char_t const* symbol)
+{
+    // check
+    by_check_return_val(image->trie, by_null);
+
+    // walk the export trie
+    by_byte_t const* p = by_macho_trie_walk(image, symbol);
+    by_check_return_val(p, by_null);
+
+    // get the export flags, we cannot resolve the re-exported symbol from the other image here
+    by_byte_t const* e = image->trie + image->trie_size;
+    by_ulong_t flags = 0;
+    by_ulong_t offset = 0;
+    by_check_return_val(by_macho_uleb128(&p, e, &flags) && !(flags & BY_MACHO_EXPORT_REEXPORT), by_null);
+
+    // get the symbol offset, it's the stub address if it has the resolver
+    by_check_return_val(by_macho_uleb128(&p, e, &offset), by_null);
+    switch (flags & BY_MACHO_EXPORT_KIND_MASK)
+    {
+    case BY_MACHO_EXPORT_KIND_REGULAR:
+        return (by_pointer_t)(image->text_vmaddr + image->slide + offset);
+    case BY_MACHO_EXPORT_KIND_ABSOLUTE:
+        return (by_pointer_t)offset;
+    default:
+        // the thread local symbol
+        break;
+    }
+    return by_null;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_macho_image_init(by_macho_image_ref_t image, by_cpointer_t header, by_size_t size, by_long_t slide)
+{
+    // check
+    by_assert_and_check_return_val(image && header, by_false);
+
+    // init image
+    memset(image, 0, sizeof(by_macho_image_t));
+    image->header = (by_byte_t const*)header;
+    image->size   = size;
+    image->slide  = slide;
+
+    // check header, we only support the thin image with the native byte order
+    by_macho_header_t const* mh = (by_macho_header_t const*)header;
+    by_check_return_val(by_macho_image_range(image, 0, sizeof(by_macho_header_t)), by_false);
+    by_check_return_val(mh->magic == BY_MACHO_MAGIC || mh->magic == BY_MACHO_MAGIC_64, by_false);
+    image->is64 = mh->magic == BY_MACHO_MAGIC_64;
+
+    // get the load commands, the 64bits header has an extra reserved field
+    by_size_t cmds_offset = sizeof(by_macho_header_t) + (image->is64? sizeof(by_uint32_t) : 0);
+    by_check_return_val(by_macho_image_range(image, cmds_offset, mh->sizeofcmds), by_false);
+
+    // locate __LINKEDIT, symtab and the export trie
+    by_bool_t                                 has_linkedit = by_false;
+    by_uint64_t                               linkedit_vmaddr = 0;
+    by_uint64_t                               linkedit_fileoff = 0;
+    by_macho_symtab_command_t const*          symtab_cmd = by_null;
+    by_macho_linkedit_data_command_t const*   trie_cmd = by_null;
+    by_macho_dyld_info_command_t const*       info_cmd = by_null;
+    by_byte_t const*                          cmd_ptr = image->header + cmds_offset;
+    by_byte_t const*                          cmd_end = cmd_ptr + mh->sizeofcmds;
+    for (by_uint32_t cmd_index = 0; cmd_index < mh->ncmds; cmd_index++)
+    {
+        // check the command size
+        by_macho_load_command_t const* load_cmd = (by_macho_load_command_t const*)cmd_ptr;
+        by_check_break((by_size_t)(cmd_end - cmd_ptr) >= sizeof(by_macho_load_command_t));
+        by_check_break(load_cmd->cmdsize >= sizeof(by_macho_load_command_t) && load_cmd->cmdsize <= (by_size_t)(cmd_end - cmd_ptr) && !(load_cmd->cmdsize & 3));
+
+        // get segment
+        by_char_t const* segname = by_null;
+        by_uint64_t      vmaddr = 0;
+        by_uint64_t      fileoff = 0;
+        by_uint64_t      filesize = 0;
+        if (load_cmd->cmd == BY_MACHO_LC_SEGMENT && load_cmd->cmdsize >= sizeof(by_macho_segment_command_t))
+        {
+            by_macho_segment_command_t const* segment_cmd = (by_macho_segment_command_t const*)cmd_ptr;
+            segname  = segment_cmd->segname;
+            vmaddr   = segment_cmd->vmaddr;
+            fileoff  = segment_cmd->fileoff;
+            filesize = segment_cmd->filesize;
+        }
+        else if (load_cmd->cmd == BY_MACHO_LC_SEGMENT_64 && load_cmd->cmdsize >= sizeof(by_macho_segment_command_64_t))
+        {
+            by_macho_segment_command_64_t const* segment_cmd = (by_macho_segment_command_64_t const*)cmd_ptr;
+            segname  = segment_cmd->segname;
+            vmaddr   = segment_cmd->vmaddr;
+            fileoff  = segment_cmd->fileoff;
+            filesize = segment_cmd->filesize;
+        }
+        else if (load_cmd->cmd == BY_MACHO_LC_SYMTAB && load_cmd->cmdsize >= sizeof(by_macho_symtab_command_t))
+            symtab_cmd = (by_macho_symtab_command_t const*)cmd_ptr;
+        else if (load_cmd->cmd == BY_MACHO_LC_DYLD_EXPORTS_TRIE && load_cmd->cmdsize >= sizeof(by_macho_linkedit_data_command_t))
+            trie_cmd = (by_macho_linkedit_data_command_t const*)cmd_ptr;
+        else if ((load_cmd->cmd == BY_MACHO_LC_DYLD_INFO || load_cmd->cmd == BY_MACHO_LC_DYLD_INFO_ONLY) && load_cmd->cmdsize >= sizeof(by_macho_dyld_info_command_t))
+            info_cmd = (by_macho_dyld_info_command_t const*)cmd_ptr;
+
+        // the mach header is mapped at the segment with file offset 0 (__TEXT)
+        if (segname)
+        {
+            if (!fileoff && filesize)
+                image->text_vmaddr = (by_ulong_t)vmaddr;
+            if (!strncmp(segname, "__LINKEDIT", 16))
+            {
+                has_linkedit     = by_true;
+                linkedit_vmaddr  = vmaddr;
+                linkedit_fileoff = fileoff;
+            }
+        }
+        cmd_ptr += load_cmd->cmdsize;
+    }
+
+    // get the address of the file offset 0 in __LINKEDIT, it's the file buffer itself if it's not loaded by dyld
+    if (image->size) image->linkedit = image->header;
+    else if (has_linkedit) image->linkedit = (by_byte_t const*)(by_size_t)(linkedit_vmaddr - linkedit_fileoff + slide);
+
+    // get symtab, the string table must be terminated for the file buffer and nlist must be aligned
+    if (image->linkedit && symtab_cmd)
+    {
+        by_size_t symsize = image->is64? sizeof(by_macho_nlist_64_t) : sizeof(by_macho_nlist_t);
+        if (    !(symtab_cmd->symoff & (image->is64? 7 : 3))
+            &&  by_macho_image_range(image, symtab_cmd->symoff, (by_uint64_t)symtab_cmd->nsyms * symsize)
+            &&  by_macho_image_range(image, symtab_cmd->stroff, symtab_cmd->strsize)
+            &&  symtab_cmd->strsize
+            &&  (!image->size || !image->linkedit[symtab_cmd->stroff + symtab_cmd->strsize - 1]))
+        {
+            image->symbols      = image->linkedit + symtab_cmd->symoff;
+            image->symbols_num  = symtab_cmd->nsyms;
+            image->strings      = (by_char_t const*)image->linkedit + symtab_cmd->stroff;
+            image->strings_size = symtab_cmd->strsize;
+        }
+    }
+
+    // get the export trie, LC_DYLD_EXPORTS_TRIE is used on the chained fixups images, otherwise LC_DYLD_INFO(_ONLY)
+    by_uint32_t trie_off = trie_cmd? trie_cmd->dataoff : (info_cmd? info_cmd->export_off : 0);
+    by_uint32_t trie_size = trie_cmd? trie_cmd->datasize : (info_cmd? info_cmd->export_size : 0);
+    if (image->linkedit && trie_off && trie_size && by_macho_image_range(image, trie_off, trie_size))
+    {
+        image->trie      = image->linkedit + trie_off;
+        image->trie_size = trie_size;
+    }
+
+    // trace
+    by_trace("macho: %p, linkedit: %p, symbols: %u, trie: %u bytes", image->header, image->linkedit, image->symbols_num, image->trie_size);
+    return by_true;
+}
+by_void_t by_macho_image_exit(by_macho_image_ref_t image)
+{
+    // check
+    by_assert_and_check_return(image);
+
+    // free the hash table
+    if (image->hash) free(image->hash);
+    image->hash = by_null;
+}
+by_pointer_t by_macho_image_dlsym_export(by_macho_image_ref_t image, by_char_t const* symbol)
+{
+    // check
+    by_assert_and_check_return_val(image && symbol, by_null);
+
+    // skip '_'
+    if (*symbol == '_') symbol++;
+
+    // walk the export trie
+    return by_macho_trie_dlsym(image, symbol);
+}
+by_pointer_t by_macho_image_dlsym(by_macho_image_ref_t image, by_char_t const* symbol)
+{
+    // check
+    by_assert_and_check_return_val(image && symbol, by_null);
+
+    // skip '_'
+    if (*symbol == '_') symbol++;
+
+    // find the exported symbol from the export trie first
+    by_pointer_t dli_saddr = by_macho_trie_dlsym(image, symbol);
+    if (dli_saddr)
+    {
+        by_trace_event(BY_TRACE_EVENT_DLSYM_HIT, BY_MACHO_LC_DYLD_EXPORTS_TRIE, dli_saddr, 0);
+        return dli_saddr;
+    }
+
+    // find the local symbol from the nlist hash table
+    by_uint32_t* hash = image->symbols_num? by_macho_hash_get(image) : by_null;
+    if (hash)
+    {
+        by_uint32_t  count = hash[0];
+        by_uint32_t* buckets = hash + 1;
+        by_uint32_t* chains = buckets + count;
+        by_uint32_t  probes = 0;
+        for (by_uint32_t i = buckets[by_macho_hash(symbol) & (count - 1)]; i; i = chains[i - 1])
+        {
+            by_uint16_t      desc;
+            by_ulong_t       value;
+            by_char_t const* name = by_macho_nlist_name(image, i - 1, &desc, &value);
+            probes++;
+            if (name && !strcmp(symbol, name))
+            {
+                dli_saddr = (by_pointer_t)(value + image->slide);
+
+                // thumb function? fix address
+#if defined(BY_ARCH_ARM) && !defined(BY_ARCH_ARM64)
+#   ifdef BY_ARCH_ARM_THUMB
+                if (desc & BY_MACHO_N_ARM_THUMB_DEF)
+                    dli_saddr = (by_pointer_t)((by_ulong_t)dli_saddr | 1);
+#   else
+                if (desc & BY_MACHO_N_ARM_THUMB_DEF)
+                    dli_saddr = (by_pointer_t)((by_ulong_t)dli_saddr & ~1);
+#   endif
+#endif
+                // trace
+                by_trace_event(BY_TRACE_EVENT_DLSYM_HIT, BY_MACHO_LC_SYMTAB, dli_saddr, probes);
+                return dli_saddr;
+            }
+        }
+    }
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_DLSYM_MISS, by_trace_tag(symbol), 0, 0);
+    return by_null;
+}
+by_char_t const* by_macho_image_symbol(by_macho_image_ref_t image, by_uint32_t index, by_uint8_t* type, by_ulong_t* value)
+{
+    // check
+    by_assert_and_check_return_val(image && index < image->symbols_num, by_null);
+
+    // get symbol
+    by_uint32_t strx;
+    by_uint8_t  n_type;
+    by_uint16_t desc;
+    by_ulong_t  n_value;
+    by_macho_nlist(image, index, &strx, &n_type, &desc, &n_value);
+    by_check_return_val(strx < image->strings_size, by_null);
+
+    // save type and value
+    if (type) *type = n_type;
+    if (value) *value = n_value;
+    return image->strings + strx;
+}
@@ -0,0 +1,135 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_macho_image.h
+ *
+ */
+#ifndef BY_MACHO_IMAGE_H
+#define BY_MACHO_IMAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "prefix.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+/*! the mach-o image type
+ *
+ * it only depends on the mach-o file format (not the mach-o headers and dyld),
+ * so it can parse the image loaded by dyld or the mach-o file buffer on any platform.
+ */
+typedef struct __by_macho_image_t
+{
+    /// the mach header address
+    by_byte_t const*        header;
+
+    /// the image size, it's 0 for the image loaded by dyld
+    by_size_t               size;
+
+    /// the vmaddr slide
+    by_long_t               slide;
+
+    /// is 64bits?
+    by_bool_t               is64;
+
+    /// the vmaddr of the mach header (__TEXT)
+    by_ulong_t              text_vmaddr;
+
+    /// the address of the file offset 0 in __LINKEDIT
+    by_byte_t const*        linkedit;
+
+    /// the symbol table (nlist)
+    by_byte_t const*        symbols;
+    by_uint32_t             symbols_num;
+
+    /// the string table
+    by_char_t const*        strings;
+    by_uint32_t             strings_size;
+
+    /// the export trie
+    by_byte_t const*        trie;
+    by_uint32_t             trie_size;
+
+    /// the lazy symbol hash table of nlist, it's built at the first lookup
+    by_uint32_t*            hash;
+
+}by_macho_image_t, *by_macho_image_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * interfaces
+ */
+
+/*! init the mach-o image and locate __LINKEDIT, symtab and the export trie
+ *
+ * @param image     the image
+ * @param header    the mach header address
+ * @param size      the file buffer size, pass 0 for the image loaded by dyld
+ * @param slide     the vmaddr slide, it's always 0 for the file buffer
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_macho_image_init(by_macho_image_ref_t image, by_cpointer_t header, by_size_t size, by_long_t slide);
+
+/*! exit the mach-o image
+ *
+ * @param image     the image
+ */
+by_void_t           by_macho_image_exit(by_macho_image_ref_t image);
+
+/*! get the symbol address, the export trie will be walked first, and then the nlist hash table
+ *
+ * the leading '_' of the symbol name is optional, e.g. "_malloc" and "malloc".
+ * the address of the file buffer is the unslid vmaddr.
+ *
+ * @param image     the image
+ * @param symbol    the symbol name
+ *
+ * @return          the symbol address
+ */
+by_pointer_t        by_macho_image_dlsym(by_macho_image_ref_t image, by_char_t const* symbol);
+
+/*! get the symbol address from the export trie only
+ *
+ * @param image     the image
+ * @param symbol    the symbol name
+ *
+ * @return          the symbol address
+ */
+by_pointer_t        by_macho_image_dlsym_export(by_macho_image_ref_t image, by_char_t const* symbol);
+
+/*! get the nlist symbol with the given index
+ *
+ * @param image     the image
+ * @param index     the symbol index
+ * @param type      the symbol type (n_type), optional
+ * @param value     the symbol value (n_value), optional
+ *
+ * @return          the symbol name
+ */
+by_char_t const*    by_macho_image_symbol(by_macho_image_ref_t image, by_uint32_t index, by_uint8_t* type, by_ulong_t* value);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
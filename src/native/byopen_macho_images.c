@@ -0,0 +1,364 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_macho_images.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_macho_images.h"
+#include <pthread.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the executable file type of the mach header
+#define BY_MACHO_MH_EXECUTE             (0x2)
+
+// the initial bucket count of the image table, must be power of 2
+#define BY_MACHO_IMAGES_BUCKETS_INIT    (256)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the mach header type, we only need the file type
+typedef struct _by_macho_images_header_t
+{
+    by_uint32_t                         magic;
+    by_int32_t                          cputype;
+    by_int32_t                          cpusubtype;
+    by_uint32_t                         filetype;
+
+}by_macho_images_header_t;
+
+// the image key node type
+typedef struct _by_macho_images_node_t
+{
+    // the next node in the bucket
+    struct _by_macho_images_node_t*     next;
+
+    // the key, it's not terminated for the framework name
+    by_char_t const*                    key;
+    by_size_t                           keylen;
+    by_uint32_t                         hash;
+
+    // the image entry
+    struct _by_macho_images_entry_t*    entry;
+
+}by_macho_images_node_t;
+
+// the image entry type
+typedef struct _by_macho_images_entry_t
+{
+    // the next entry
+    struct _by_macho_images_entry_t*    next;
+
+    // the mach header and vmaddr slide
+    struct mach_header const*           header;
+    by_long_t                           slide;
+
+    // the key nodes: full path, basename and framework name
+    by_macho_images_node_t              nodes[3];
+    by_size_t                           nodes_num;
+
+    // the full path
+    by_char_t                           path[1];
+
+}by_macho_images_entry_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the image table lock
+static pthread_mutex_t                  g_images_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// is the image table initialized?
+static by_bool_t                        g_images_inited = by_false;
+
+// the once flag of initializing the image table
+static pthread_once_t                   g_images_once = PTHREAD_ONCE_INIT;
+
+// the image provider of the first init call
+static by_macho_images_provider_t       g_images_provider;
+
+// the image entries
+static by_macho_images_entry_t*         g_images_entries = by_null;
+static by_size_t                        g_images_count = 0;
+
+// the key buckets
+static by_macho_images_node_t**         g_images_buckets = by_null;
+static by_size_t                        g_images_buckets_num = 0;
+static by_size_t                        g_images_nodes_num = 0;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static __inline__ by_uint32_t by_macho_images_hash(by_char_t const* key, by_size_t keylen)
+{
+    by_uint32_t h = 5381;
+    while (keylen--) h = (h << 5) + h + (by_uint8_t)*key++;
+    return h;
+}
+
+// resize the key buckets, the node order of each bucket is kept
+static by_bool_t by_macho_images_resize(by_size_t buckets_num)
+{
+    by_macho_images_node_t** buckets = calloc(buckets_num, sizeof(by_macho_images_node_t*));
+    by_check_return_val(buckets, by_false);
+
+    // move all nodes to the tail of the new buckets
+    for (by_size_t i = 0; i < g_images_buckets_num; i++)
+    {
+        by_macho_images_node_t* node = g_images_buckets[i];
+        while (node)
+        {
+            by_macho_images_node_t*  next = node->next;
+            by_macho_images_node_t** pnode = &buckets[node->hash & (buckets_num - 1)];
+            while (*pnode) pnode = &(*pnode)->next;
+            node->next = by_null;
+            *pnode = node;
+            node = next;
+        }
+    }
+
+    // update buckets
+    if (g_images_buckets) free(g_images_buckets);
+    g_images_buckets = buckets;
+    g_images_buckets_num = buckets_num;
+    return by_true;
+}
+
+// add a key node to the tail of the bucket, so the first loaded image will be found first
+static by_void_t by_macho_images_add_node(by_macho_images_entry_t* entry, by_char_t const* key, by_size_t keylen)
+{
+    by_macho_images_node_t* node = &entry->nodes[entry->nodes_num++];
+    node->key    = key;
+    node->keylen = keylen;
+    node->hash   = by_macho_images_hash(key, keylen);
+    node->entry  = entry;
+
+    by_macho_images_node_t** pnode = &g_images_buckets[node->hash & (g_images_buckets_num - 1)];
+    while (*pnode) pnode = &(*pnode)->next;
+    *pnode = node;
+    g_images_nodes_num++;
+}
+
+// add image, it's called by the image provider
+static by_void_t by_macho_images_add(struct mach_header const* header, by_long_t slide)
+{
+    /* skip the main executable, becasue it's symtab will be stripped after be archived.
+     * so we need to keep our behavior consistent for debug/release and archived packages.
+     */
+    by_check_return(header && ((by_macho_images_header_t const*)header)->filetype != BY_MACHO_MH_EXECUTE);
+
+    // get the image path, we do not lock it because it may take the loader lock, e.g. dladdr()
+    by_char_t const* path = g_images_provider.path? g_images_provider.path(header) : by_null;
+    by_check_return(path && *path);
+
+    // add it
+    pthread_mutex_lock(&g_images_lock);
+    do
+    {
+        // check
+        by_check_break(g_images_inited);
+
+        // grow buckets
+        if (g_images_nodes_num + 3 > g_images_buckets_num)
+        {
+            by_check_break(by_macho_images_resize(g_images_buckets_num << 1));
+        }
+
+        // make entry
+        by_size_t                pathlen = strlen(path);
+        by_macho_images_entry_t* entry = calloc(1, sizeof(by_macho_images_entry_t) + pathlen);
+        by_check_break(entry);
+        entry->header = header;
+        entry->slide  = slide;
+        memcpy(entry->path, path, pathlen + 1);
+
+        // index the full path
+        by_macho_images_add_node(entry, entry->path, pathlen);
+
+        // index the basename
+        by_char_t const* basename = strrchr(entry->path, '/');
+        if (basename && basename[1])
+        {
+            basename++;
+            by_macho_images_add_node(entry, basename, entry->path + pathlen - basename);
+        }
+
+        // index the framework name, e.g. .../UIKit.framework/UIKit or .../Foo.framework/Versions/A/Foo
+        by_char_t const* framework = by_null;
+        for (by_char_t const* p = strstr(entry->path, ".framework/"); p; p = strstr(p + 1, ".framework/"))
+            framework = p;
+        if (framework)
+        {
+            by_char_t const* name = framework;
+            while (name > entry->path && name[-1] != '/') name--;
+            by_size_t namelen = framework - name;
+            if (namelen && (!basename || strlen(basename) != namelen || strncmp(basename, name, namelen)))
+                by_macho_images_add_node(entry, name, namelen);
+        }
+
+        // append entry
+        entry->next = g_images_entries;
+        g_images_entries = entry;
+        g_images_count++;
+
+        // trace
+        by_trace("images: add %s at %p", entry->path, header);
+
+    } while (0);
+    pthread_mutex_unlock(&g_images_lock);
+}
+
+// remove image, it's called by the image provider
+static by_void_t by_macho_images_remove(struct mach_header const* header, by_long_t slide)
+{
+    pthread_mutex_lock(&g_images_lock);
+    by_macho_images_entry_t** pentry = &g_images_entries;
+    for (; *pentry; pentry = &(*pentry)->next)
+    {
+        by_macho_images_entry_t* entry = *pentry;
+        if (entry->header == header)
+        {
+            // remove all key nodes from buckets
+            for (by_size_t i = 0; i < entry->nodes_num; i++)
+            {
+                by_macho_images_node_t*  node = &entry->nodes[i];
+                by_macho_images_node_t** pnode = &g_images_buckets[node->hash & (g_images_buckets_num - 1)];
+                while (*pnode && *pnode != node) pnode = &(*pnode)->next;
+                if (*pnode) *pnode = node->next;
+                g_images_nodes_num--;
+            }
+
+            // trace
+            by_trace("images: remove %s at %p", entry->path, header);
+
+            // free entry
+            *pentry = entry->next;
+            g_images_count--;
+            free(entry);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_images_lock);
+}
+
+/* init the image table and register callbacks, it's called only once
+ *
+ * the other init calls wait for it in pthread_once(), so all existing images have been added after they return.
+ */
+static by_void_t by_macho_images_init_once()
+{
+    // init the table
+    pthread_mutex_lock(&g_images_lock);
+    by_bool_t                  ok = by_macho_images_resize(BY_MACHO_IMAGES_BUCKETS_INIT);
+    by_macho_images_provider_t provider = g_images_provider;
+    if (ok) g_images_inited = by_true;
+    pthread_mutex_unlock(&g_images_lock);
+
+    // register callbacks, the add callback will be called for all existing images at once, so we cannot lock it
+    if (ok)
+    {
+        provider.register_add(by_macho_images_add);
+        if (provider.register_remove) provider.register_remove(by_macho_images_remove);
+    }
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_macho_images_init(by_macho_images_provider_t const* provider)
+{
+    // check
+    by_assert_and_check_return_val(provider && provider->register_add && provider->path, by_false);
+
+    // save the provider of the first call
+    pthread_mutex_lock(&g_images_lock);
+    if (!g_images_provider.register_add) g_images_provider = *provider;
+    pthread_mutex_unlock(&g_images_lock);
+
+    // init the table only once
+    pthread_once(&g_images_once, by_macho_images_init_once);
+
+    // ok?
+    pthread_mutex_lock(&g_images_lock);
+    by_bool_t ok = g_images_inited;
+    pthread_mutex_unlock(&g_images_lock);
+    return ok;
+}
+by_void_t by_macho_images_exit()
+{
+    pthread_mutex_lock(&g_images_lock);
+    while (g_images_entries)
+    {
+        by_macho_images_entry_t* entry = g_images_entries;
+        g_images_entries = entry->next;
+        free(entry);
+    }
+    if (g_images_buckets) free(g_images_buckets);
+    g_images_buckets = by_null;
+    g_images_buckets_num = 0;
+    g_images_nodes_num = 0;
+    g_images_count = 0;
+    g_images_inited = by_false;
+    memset(&g_images_provider, 0, sizeof(g_images_provider));
+
+    // we can init it again with the other stub provider
+    g_images_once = (pthread_once_t)PTHREAD_ONCE_INIT;
+    pthread_mutex_unlock(&g_images_lock);
+}
+by_bool_t by_macho_images_find(by_char_t const* name, struct mach_header const** pheader, by_long_t* pslide)
+{
+    // check
+    by_assert_and_check_return_val(name && pheader, by_false);
+
+    // find image
+    by_bool_t   ok = by_false;
+    by_size_t   namelen = strlen(name);
+    by_uint32_t hash = by_macho_images_hash(name, namelen);
+    pthread_mutex_lock(&g_images_lock);
+    if (g_images_buckets_num)
+    {
+        by_macho_images_node_t* node = g_images_buckets[hash & (g_images_buckets_num - 1)];
+        for (; node; node = node->next)
+        {
+            if (node->hash == hash && node->keylen == namelen && !memcmp(node->key, name, namelen))
+            {
+                *pheader = node->entry->header;
+                if (pslide) *pslide = node->entry->slide;
+                ok = by_true;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_images_lock);
+    return ok;
+}
+by_size_t by_macho_images_count()
+{
+    pthread_mutex_lock(&g_images_lock);
+    by_size_t count = g_images_count;
+    pthread_mutex_unlock(&g_images_lock);
+    return count;
+}
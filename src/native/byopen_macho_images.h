@@ -0,0 +1,103 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_macho_images.h
+ *
+ */
+#ifndef BY_MACHO_IMAGES_H
+#define BY_MACHO_IMAGES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "prefix.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the mach header type, it's only defined in the system headers
+struct mach_header;
+
+/// the image callback type, it's compatible with the dyld add/remove image callbacks
+typedef by_void_t               (*by_macho_images_func_t)(struct mach_header const* header, by_long_t slide);
+
+/*! the image provider type
+ *
+ * it's dyld on apple platforms, and it can be replaced by a stub provider for testing on the other platforms.
+ */
+typedef struct __by_macho_images_provider_t
+{
+    /// register the add image callback, it will be called for all existing images at once
+    by_void_t                   (*register_add)(by_macho_images_func_t func);
+
+    /// register the remove image callback
+    by_void_t                   (*register_remove)(by_macho_images_func_t func);
+
+    /// get the image path
+    by_char_t const*            (*path)(struct mach_header const* header);
+
+}by_macho_images_provider_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * interfaces
+ */
+
+/*! init the global image table and register the image callbacks of the given provider
+ *
+ * the callbacks of dyld cannot be unregistered and have no user data, so the table is global
+ * and it's initialized only once, the provider of the later calls will be ignored.
+ *
+ * @param provider  the image provider
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_macho_images_init(by_macho_images_provider_t const* provider);
+
+/*! exit the global image table, only for the stub provider, because the dyld callbacks cannot be unregistered
+ *
+ * it must not be called concurrently with by_macho_images_init(), the table can be initialized again after exiting.
+ */
+by_void_t           by_macho_images_exit(by_void_t);
+
+/*! find the image by the full path, basename or framework name
+ *
+ * e.g. "/System/Library/Frameworks/UIKit.framework/UIKit", "UIKit" and "libz.1.dylib",
+ * the main executable is not indexed, and the first loaded image is found if the names are same.
+ *
+ * @param name      the image name
+ * @param pheader   the mach header pointer
+ * @param pslide    the vmaddr slide pointer
+ *
+ * @return          by_true if it's found
+ */
+by_bool_t           by_macho_images_find(by_char_t const* name, struct mach_header const** pheader, by_long_t* pslide);
+
+/*! get the indexed image count
+ *
+ * @return          the image count
+ */
+by_size_t           by_macho_images_count(by_void_t);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
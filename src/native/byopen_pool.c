@@ -0,0 +1,115 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_pool.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_pool.h"
+#include <sys/mman.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+
+// map a new slab, the caller has held the lock
+static by_bool_t by_pool_grow(by_pool_ref_t pool)
+{
+    // the item size has been aligned by BY_POOL_INIT()
+    by_size_t slabsize = pool->itemsize * pool->itemn;
+
+    // map it, we do not use malloc() to avoid re-entering the allocator
+    by_pointer_t slab = mmap(by_null, slabsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    by_check_return_val(slab != MAP_FAILED, by_false);
+
+    // update the current slab, the unused items of the last slab have been exhausted
+    pool->tail      = (by_byte_t*)slab;
+    pool->tail_left = pool->itemn;
+    pool->slabs++;
+    pool->total += pool->itemn;
+
+    // trace
+    by_trace("pool: grow slab %p, %lu items", slab, (by_ulong_t)pool->itemn);
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_pointer_t by_pool_alloc(by_pool_ref_t pool)
+{
+    // check
+    by_assert_and_check_return_val(pool && pool->itemsize >= sizeof(by_pointer_t), by_null);
+
+    by_pointer_t item = by_null;
+    pthread_mutex_lock(&pool->lock);
+    do
+    {
+        // reuse the free item first
+        if (pool->free)
+        {
+            item = pool->free;
+            pool->free = *((by_pointer_t*)item);
+        }
+        else
+        {
+            // get the unused item of the current slab
+            if (!pool->tail_left) by_check_break(by_pool_grow(pool));
+            item = pool->tail;
+            pool->tail += pool->itemsize;
+            pool->tail_left--;
+        }
+
+        // update statistics
+        pool->allocs++;
+        if (++pool->used > pool->peak) pool->peak = pool->used;
+
+    } while (0);
+    pthread_mutex_unlock(&pool->lock);
+
+    // clear it
+    if (item) memset(item, 0, pool->itemsize);
+    return item;
+}
+by_void_t by_pool_free(by_pool_ref_t pool, by_pointer_t item)
+{
+    // check
+    by_assert_and_check_return(pool && item);
+
+    // push it to the free list
+    pthread_mutex_lock(&pool->lock);
+    *((by_pointer_t*)item) = pool->free;
+    pool->free = item;
+    pool->used--;
+    pthread_mutex_unlock(&pool->lock);
+}
+by_void_t by_pool_stat(by_pool_ref_t pool, by_dlpool_stat_t* stat)
+{
+    // check
+    by_assert_and_check_return(pool && stat);
+
+    pthread_mutex_lock(&pool->lock);
+    stat->slabs  = pool->slabs;
+    stat->total  = pool->total;
+    stat->used   = pool->used;
+    stat->peak   = pool->peak;
+    stat->allocs = pool->allocs;
+    pthread_mutex_unlock(&pool->lock);
+}
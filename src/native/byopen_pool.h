@@ -0,0 +1,119 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_pool.h
+ *
+ */
+#ifndef BY_POOL_H
+#define BY_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen.h"
+#include <pthread.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+/// the item size of the pool, it's aligned by the pointer size, so we can link the free items
+#define BY_POOL_ITEMSIZE(size)  (((size) + sizeof(by_pointer_t) - 1) & ~(sizeof(by_pointer_t) - 1))
+
+/*! init the fixed-size slab pool statically
+ *
+ * the first slab is the given static array, so the pool need not allocate memory before it's exhausted.
+ *
+ * @param slab      the static array of the items
+ * @param itemn     the item count of each slab
+ */
+#define BY_POOL_INIT(slab, itemn) \
+    { PTHREAD_MUTEX_INITIALIZER, BY_POOL_ITEMSIZE(sizeof((slab)[0])), (itemn), by_null, (by_byte_t*)(slab) \
+    , sizeof(slab) / BY_POOL_ITEMSIZE(sizeof((slab)[0])), 1, sizeof(slab) / BY_POOL_ITEMSIZE(sizeof((slab)[0])), 0, 0, 0 }
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+/*! the fixed-size slab pool type
+ *
+ * the freed items are reused from the free list first, and the new slab is mapped by mmap() only if all slabs are exhausted,
+ * so it never re-enters malloc() and it can be used in the allocator hooks. the slabs will never be released.
+ */
+typedef struct __by_pool_t
+{
+    // the lock
+    pthread_mutex_t             lock;
+
+    // the aligned item size and the item count of each new slab, they are read-only after initialization
+    by_size_t const             itemsize;
+    by_size_t const             itemn;
+
+    // the free items list
+    by_pointer_t                free;
+
+    // the unused items of the current slab
+    by_byte_t*                  tail;
+    by_size_t                   tail_left;
+
+    // the slab count and the total item count
+    by_size_t                   slabs;
+    by_size_t                   total;
+
+    // the used and peak item count
+    by_size_t                   used;
+    by_size_t                   peak;
+
+    // the allocated item count
+    by_size_t                   allocs;
+
+}by_pool_t, *by_pool_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * interfaces
+ */
+
+/*! allocate a zeroed item from the pool
+ *
+ * @param pool      the pool
+ *
+ * @return          the item, by_null if no memory
+ */
+by_pointer_t        by_pool_alloc(by_pool_ref_t pool);
+
+/*! free the item to the pool
+ *
+ * @param pool      the pool
+ * @param item      the item
+ */
+by_void_t           by_pool_free(by_pool_ref_t pool, by_pointer_t item);
+
+/*! get the pool statistics
+ *
+ * @param pool      the pool
+ * @param stat      the pool statistics
+ */
+by_void_t           by_pool_stat(by_pool_ref_t pool, by_dlpool_stat_t* stat);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
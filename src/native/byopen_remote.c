@@ -0,0 +1,360 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_remote.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_elf.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <elf.h>
+#include <link.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the max size of the elf and program headers which are read from the remote process at once
+#define BY_REMOTE_HEADER_MAXN   (4096)
+
+// the max count of the dynamic entries which are read from the remote process
+#define BY_REMOTE_DYNAMIC_MAXN  (256)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+/* read the memory of the remote process, all segments are read by one system call
+ *
+ * we read it from /proc/<pid>/mem if process_vm_readv() is not supported, e.g. linux < 3.2
+ */
+static by_bool_t by_fake_remote_read(by_int_t pid, struct iovec const* local, struct iovec const* remote, by_size_t count)
+{
+    // get the total size
+    by_size_t i = 0;
+    by_size_t size = 0;
+    for (i = 0; i < count; i++)
+        size += local[i].iov_len;
+
+    // read it
+    ssize_t real = syscall(__NR_process_vm_readv, (pid_t)pid, local, (unsigned long)count, remote, (unsigned long)count, 0UL);
+    if (real < 0 && errno == ENOSYS)
+    {
+        by_char_t path[64];
+        snprintf(path, sizeof(path), "/proc/%d/mem", pid);
+        by_int_t fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            for (i = 0, real = 0; i < count && real >= 0; i++)
+            {
+                ssize_t n = pread(fd, local[i].iov_base, local[i].iov_len, (off_t)(by_size_t)remote[i].iov_base);
+                real = n == (ssize_t)local[i].iov_len? real + n : -1;
+            }
+            close(fd);
+        }
+    }
+    return real == (ssize_t)size;
+}
+
+// read the elf and program headers from the base address of the remote process
+static ElfW(Ehdr) const* by_fake_remote_read_header(by_int_t pid, by_pointer_t baseaddr, by_byte_t* data, by_size_t size)
+{
+    // read the first page, the program headers are usually followed by the elf header
+    struct iovec local;
+    struct iovec remote;
+    local.iov_base  = data;
+    local.iov_len   = size;
+    remote.iov_base = baseaddr;
+    remote.iov_len  = size;
+    by_check_return_val(by_fake_remote_read(pid, &local, &remote, 1), by_null);
+
+    // check the elf and program headers
+    ElfW(Ehdr) const* ehdr = (ElfW(Ehdr) const*)data;
+    by_check_return_val(!memcmp(ehdr->e_ident, ELFMAG, SELFMAG) && ehdr->e_phentsize == sizeof(ElfW(Phdr)), by_null);
+    by_check_return_val(ehdr->e_phoff + ehdr->e_phnum * sizeof(ElfW(Phdr)) <= size, by_null);
+    return ehdr;
+}
+
+// get the address of the dynamic entry in the remote process, the entries may be not relocated, e.g. bionic linker
+static __inline__ by_size_t by_fake_remote_dynaddr(by_fake_dlctx_ref_t dlctx, by_size_t value)
+{
+    return value >= (by_size_t)dlctx->biasaddr? value : (by_size_t)dlctx->biasaddr + value;
+}
+
+// get the dynamic symbol count from the DT_GNU_HASH table of the remote process
+static by_size_t by_fake_remote_gnuhash_count(by_int_t pid, by_size_t gnuhash)
+{
+    // read the header: nbuckets, symoffset, bloom_size and bloom_shift
+    by_uint32_t  head[4];
+    struct iovec local;
+    struct iovec remote;
+    local.iov_base  = head;
+    local.iov_len   = sizeof(head);
+    remote.iov_base = (by_pointer_t)gnuhash;
+    remote.iov_len  = sizeof(head);
+    by_check_return_val(by_fake_remote_read(pid, &local, &remote, 1), 0);
+    by_check_return_val(head[0] && head[0] < (1 << 24), 0);
+
+    // read the buckets and find the max symbol index
+    by_size_t    count = 0;
+    by_size_t    buckets_addr = gnuhash + sizeof(head) + head[2] * sizeof(ElfW(Addr));
+    by_uint32_t* buckets = malloc(head[0] * sizeof(by_uint32_t));
+    do
+    {
+        by_check_break(buckets);
+        local.iov_base  = buckets;
+        local.iov_len   = head[0] * sizeof(by_uint32_t);
+        remote.iov_base = (by_pointer_t)buckets_addr;
+        remote.iov_len  = local.iov_len;
+        by_check_break(by_fake_remote_read(pid, &local, &remote, 1));
+
+        by_uint32_t maxidx = 0;
+        for (by_uint32_t i = 0; i < head[0]; i++)
+            if (maxidx < buckets[i]) maxidx = buckets[i];
+        if (maxidx < head[1])
+        {
+            count = head[1];
+            break;
+        }
+
+        // walk the chain of the max symbol index until the end bit
+        by_uint32_t chain[64];
+        by_size_t   chain_addr = buckets_addr + head[0] * sizeof(by_uint32_t) + (maxidx - head[1]) * sizeof(by_uint32_t);
+        while (!count && maxidx < (1 << 24))
+        {
+            local.iov_base  = chain;
+            local.iov_len   = sizeof(chain);
+            remote.iov_base = (by_pointer_t)chain_addr;
+            remote.iov_len  = sizeof(chain);
+            by_check_break(by_fake_remote_read(pid, &local, &remote, 1));
+            for (by_size_t i = 0; i < sizeof(chain) / sizeof(chain[0]) && !count; i++, maxidx++)
+                if (chain[i] & 1) count = maxidx + 1;
+            chain_addr += sizeof(chain);
+        }
+
+    } while (0);
+    if (buckets) free(buckets);
+    return count;
+}
+
+/* load the dynamic symbols from the PT_DYNAMIC of the remote process
+ *
+ * it's used if the library file cannot be opened, e.g. [vdso] or the deleted library,
+ * .dynsym and .dynstr are read to the private mapping by one system call.
+ */
+static by_bool_t by_fake_dlctx_load_remote(by_fake_dlctx_ref_t dlctx, by_pointer_t baseaddr)
+{
+    // check
+    by_assert_and_check_return_val(dlctx && dlctx->pid && dlctx->biasaddr && baseaddr && !dlctx->filedata, by_false);
+
+    by_bool_t  ok = by_false;
+    by_byte_t* data = MAP_FAILED;
+    by_size_t  size = 0;
+    do
+    {
+        // read headers
+        by_byte_t         header[BY_REMOTE_HEADER_MAXN];
+        ElfW(Ehdr) const* ehdr = by_fake_remote_read_header(dlctx->pid, baseaddr, header, sizeof(header));
+        by_check_break(ehdr);
+
+        // find PT_DYNAMIC
+        by_int_t          i = 0;
+        ElfW(Phdr) const* phdr = (ElfW(Phdr) const*)(header + ehdr->e_phoff);
+        ElfW(Phdr) const* dynamic_phdr = by_null;
+        for (i = 0; i < ehdr->e_phnum && !dynamic_phdr; i++)
+            if (phdr[i].p_type == PT_DYNAMIC) dynamic_phdr = &phdr[i];
+        by_check_break(dynamic_phdr && dynamic_phdr->p_memsz >= sizeof(ElfW(Dyn)));
+
+        // read the dynamic entries
+        ElfW(Dyn)    dynamic[BY_REMOTE_DYNAMIC_MAXN];
+        by_size_t    dynamic_num = dynamic_phdr->p_memsz / sizeof(ElfW(Dyn));
+        struct iovec local[2];
+        struct iovec remote[2];
+        if (dynamic_num > BY_REMOTE_DYNAMIC_MAXN) dynamic_num = BY_REMOTE_DYNAMIC_MAXN;
+        local[0].iov_base  = dynamic;
+        local[0].iov_len   = dynamic_num * sizeof(ElfW(Dyn));
+        remote[0].iov_base = (by_pointer_t)(dlctx->biasaddr + dynamic_phdr->p_vaddr);
+        remote[0].iov_len  = local[0].iov_len;
+        by_check_break(by_fake_remote_read(dlctx->pid, local, remote, 1));
+
+        // get the dynamic symbol tables
+        by_size_t symtab = 0;
+        by_size_t strtab = 0;
+        by_size_t strsz = 0;
+        by_size_t hash = 0;
+        by_size_t gnuhash = 0;
+        for (i = 0; i < (by_int_t)dynamic_num && dynamic[i].d_tag != DT_NULL; i++)
+        {
+            switch (dynamic[i].d_tag)
+            {
+            case DT_SYMTAB:     symtab = by_fake_remote_dynaddr(dlctx, dynamic[i].d_un.d_ptr); break;
+            case DT_STRTAB:     strtab = by_fake_remote_dynaddr(dlctx, dynamic[i].d_un.d_ptr); break;
+            case DT_STRSZ:      strsz = dynamic[i].d_un.d_val; break;
+            case DT_HASH:       hash = by_fake_remote_dynaddr(dlctx, dynamic[i].d_un.d_ptr); break;
+            case DT_GNU_HASH:   gnuhash = by_fake_remote_dynaddr(dlctx, dynamic[i].d_un.d_ptr); break;
+            default: break;
+            }
+        }
+        by_check_break(symtab && strtab && strsz && strsz < (64 << 20) && (hash || gnuhash));
+
+        // get the dynamic symbol count, nchain of DT_HASH is equal to it
+        by_size_t symnum = 0;
+        if (hash)
+        {
+            by_uint32_t nbucket_nchain[2];
+            local[0].iov_base  = nbucket_nchain;
+            local[0].iov_len   = sizeof(nbucket_nchain);
+            remote[0].iov_base = (by_pointer_t)hash;
+            remote[0].iov_len  = sizeof(nbucket_nchain);
+            if (by_fake_remote_read(dlctx->pid, local, remote, 1)) symnum = nbucket_nchain[1];
+        }
+        if (!symnum && gnuhash) symnum = by_fake_remote_gnuhash_count(dlctx->pid, gnuhash);
+        by_check_break(symnum && symnum < (1 << 24));
+
+        // map the private buffer, so it can be unmapped by by_fake_close_file()
+        size = symnum * sizeof(ElfW(Sym)) + strsz;
+        data = mmap(by_null, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        by_check_break(data != MAP_FAILED);
+
+        // read .dynsym and .dynstr by one call
+        local[0].iov_base  = data;
+        local[0].iov_len   = symnum * sizeof(ElfW(Sym));
+        local[1].iov_base  = data + local[0].iov_len;
+        local[1].iov_len   = strsz;
+        remote[0].iov_base = (by_pointer_t)symtab;
+        remote[0].iov_len  = local[0].iov_len;
+        remote[1].iov_base = (by_pointer_t)strtab;
+        remote[1].iov_len  = strsz;
+        by_check_break(by_fake_remote_read(dlctx->pid, local, remote, 2));
+
+        // trace
+        by_trace("fake_dlopen_remote: biasaddr: %p, %lu dynamic symbols from memory", dlctx->biasaddr, (by_ulong_t)symnum);
+
+        // save tables
+        dlctx->filedata   = data;
+        dlctx->filesize   = size;
+        dlctx->dynsym     = data;
+        dlctx->dynsym_num = (by_int_t)symnum;
+        dlctx->dynstr     = data + symnum * sizeof(ElfW(Sym));
+        ok = by_true;
+
+    } while (0);
+
+    // failed?
+    if (!ok && data != MAP_FAILED) munmap(data, size);
+    return ok;
+}
+
+// open the fake dlopen context of the library loaded in the remote process
+static by_fake_dlctx_ref_t by_fake_dlopen_remote(by_int_t pid, by_char_t const* filename, by_int_t flag)
+{
+    // trace
+    by_trace_event(BY_TRACE_EVENT_OPEN_BEGIN, by_trace_tag(filename), flag, 0);
+
+    // find the load bias address, real path and base address from the maps of the remote process
+    by_char_t    realpath[512];
+    by_pointer_t baseaddr = by_null;
+    by_pointer_t biasaddr = by_elf_find_biasaddr_from_pidmaps(pid, filename, realpath, sizeof(realpath), &baseaddr);
+    by_trace_event(BY_TRACE_EVENT_OPEN_BIASADDR, by_trace_tag(filename), biasaddr, 0);
+
+    // init context
+    by_fake_dlctx_ref_t dlctx = biasaddr? by_elf_dlctx_alloc(by_null) : by_null;
+    if (dlctx)
+    {
+        dlctx->magic    = BY_FAKE_DLCTX_MAGIC;
+        dlctx->biasaddr = biasaddr;
+        dlctx->pid      = pid;
+
+        // load the library file from the root directory of the remote process first, it may be in another mount namespace
+        by_bool_t ok = by_false;
+        by_char_t rootpath[600];
+        if (realpath[0] == '/' && snprintf(rootpath, sizeof(rootpath), "/proc/%d/root%s", pid, realpath) < (by_int_t)sizeof(rootpath))
+            ok = by_elf_dlctx_load(dlctx, rootpath);
+        if (!ok && realpath[0] == '/')
+            ok = by_elf_dlctx_load(dlctx, realpath);
+
+        // load the dynamic symbols from the remote memory if the library file cannot be opened
+        if (!ok) ok = by_fake_dlctx_load_remote(dlctx, baseaddr);
+        if (!ok)
+        {
+            by_elf_dlclose(dlctx);
+            dlctx = by_null;
+        }
+    }
+
+    // trace
+    by_trace_event(BY_TRACE_EVENT_OPEN_END, by_trace_tag(filename), dlctx, 0);
+    return dlctx;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_pointer_t by_elf_remote_find_biasaddr(by_int_t pid, by_pointer_t baseaddr)
+{
+    // read headers
+    by_byte_t         data[BY_REMOTE_HEADER_MAXN];
+    ElfW(Ehdr) const* ehdr = by_fake_remote_read_header(pid, baseaddr, data, sizeof(data));
+    by_check_return_val(ehdr, by_null);
+
+    // find load bias from program header
+    ElfW(Phdr) const* phdr = (ElfW(Phdr) const*)(data + ehdr->e_phoff);
+    uintptr_t         min_vaddr = UINTPTR_MAX;
+    for (by_int_t i = 0; i < ehdr->e_phnum; i++)
+    {
+        if (PT_LOAD == phdr[i].p_type && min_vaddr > phdr[i].p_vaddr)
+            min_vaddr = phdr[i].p_vaddr;
+    }
+    return min_vaddr != UINTPTR_MAX? baseaddr - min_vaddr : by_null;
+}
+by_pointer_t by_dlopen_remote(by_int_t pid, by_char_t const* filename, by_int_t flag)
+{
+    // check
+    by_assert_and_check_return_val(pid > 0 && filename, by_null);
+
+    // open the library of the remote process
+    by_fake_dlctx_ref_t dlctx = by_fake_dlopen_remote(pid, filename, flag);
+
+    // build the compact index for all symbols?
+    if (dlctx && (flag & BY_RTLD_COMPACT))
+        by_elf_dlcompact(dlctx, by_null, 0);
+    return (by_pointer_t)dlctx;
+}
+by_size_t by_dlsym_remote(by_pointer_t handle, by_char_t const** symbols, by_pointer_t* addrs, by_size_t count)
+{
+    // check
+    by_fake_dlctx_ref_t dlctx = (by_fake_dlctx_ref_t)handle;
+    by_assert_and_check_return_val(dlctx && symbols && addrs, 0);
+    by_check_return_val(dlctx->magic == BY_FAKE_DLCTX_MAGIC, 0);
+
+    // find all symbols, all tables have been read from the library file or the remote process
+    by_size_t i = 0;
+    by_size_t found = 0;
+    for (i = 0; i < count; i++)
+    {
+        addrs[i] = symbols[i]? by_elf_dlsym(dlctx, symbols[i]) : by_null;
+        if (addrs[i]) found++;
+    }
+    return found;
+}
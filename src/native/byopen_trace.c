@@ -0,0 +1,282 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_trace.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "prefix.h"
+#include <time.h>
+#include <pthread.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the ring mask
+#define BY_TRACE_RING_MASK      (BY_TRACE_RING_SIZE - 1)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the trace ring type of each thread
+typedef struct _by_trace_ring_t
+{
+    // the next ring in the global list
+    struct _by_trace_ring_t*    next;
+
+    // the ring index
+    by_uint32_t                 index;
+
+    // is owned by a living thread? only modified by atomic operations
+    by_uint32_t                 owned;
+
+    // the count of the written events, only modified by the owner thread
+    by_size_t                   head;
+
+    // the events
+    by_trace_event_t            events[BY_TRACE_RING_SIZE];
+
+}by_trace_ring_t, *by_trace_ring_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// is tracing enabled?
+#ifdef BY_DEBUG
+by_bool_t volatile              g_by_trace_enabled = by_true;
+#else
+by_bool_t volatile              g_by_trace_enabled = by_false;
+#endif
+
+// the trace ring of the current thread
+static __thread by_trace_ring_ref_t g_tls_trace_ring = by_null;
+
+// the trace rings of all threads
+static by_trace_ring_ref_t      g_trace_rings = by_null;
+
+// the trace ring count
+static by_uint32_t              g_trace_rings_count = 0;
+
+// the thread key to release the ring when thread exits
+static pthread_key_t            g_trace_key;
+static pthread_once_t           g_trace_key_once = PTHREAD_ONCE_INIT;
+
+// the event names
+static by_char_t const*         g_trace_event_names[BY_TRACE_EVENT_MAXN] =
+{
+    "none"
+,   "open_begin"
+,   "open_biasaddr"
+,   "open_file"
+,   "open_section"
+,   "open_symtab"
+,   "open_end"
+,   "dlsym_begin"
+,   "dlsym_hit"
+,   "dlsym_miss"
+};
+
+/* the event argument kinds
+ *
+ * t: name tag
+ * p: pointer
+ * i: integer
+ */
+static by_char_t const*         g_trace_event_args[BY_TRACE_EVENT_MAXN] =
+{
+    ""
+,   "ti"
+,   "tp"
+,   "pi"
+,   "iip"
+,   "ipi"
+,   "tp"
+,   "tp"
+,   "ipi"
+,   "ti"
+};
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_uint64_t by_trace_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (by_uint64_t)ts.tv_sec * 1000000000ULL + (by_uint64_t)ts.tv_nsec;
+}
+static by_void_t by_trace_ring_exit(by_pointer_t priv)
+{
+    // release this ring, it can be reused by the other new threads
+    by_trace_ring_ref_t ring = (by_trace_ring_ref_t)priv;
+    if (ring) __atomic_store_n(&ring->owned, 0, __ATOMIC_RELEASE);
+    g_tls_trace_ring = by_null;
+}
+static by_void_t by_trace_key_init()
+{
+    pthread_key_create(&g_trace_key, by_trace_ring_exit);
+}
+static by_trace_ring_ref_t by_trace_ring_attach()
+{
+    // init thread key
+    pthread_once(&g_trace_key_once, by_trace_key_init);
+
+    // attempt to reuse a released ring first
+    by_trace_ring_ref_t ring = __atomic_load_n(&g_trace_rings, __ATOMIC_ACQUIRE);
+    for (; ring; ring = ring->next)
+    {
+        by_uint32_t owned = 0;
+        if (__atomic_compare_exchange_n(&ring->owned, &owned, 1, by_false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            break;
+    }
+
+    // make a new ring and push it to the global list
+    if (!ring)
+    {
+        ring = calloc(1, sizeof(by_trace_ring_t));
+        by_check_return_val(ring, by_null);
+
+        ring->owned = 1;
+        ring->index = __atomic_fetch_add(&g_trace_rings_count, 1, __ATOMIC_RELAXED);
+        ring->next  = __atomic_load_n(&g_trace_rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&g_trace_rings, &ring->next, ring, by_false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) ;
+    }
+
+    // bind it to the current thread
+    pthread_setspecific(g_trace_key, ring);
+    g_tls_trace_ring = ring;
+    return ring;
+}
+static by_void_t by_trace_event_print(by_trace_ring_ref_t ring, by_trace_event_t const* event, by_uint64_t base)
+{
+    // get event name and argument kinds
+    by_uint32_t      id = event->id < BY_TRACE_EVENT_MAXN? event->id : BY_TRACE_EVENT_NONE;
+    by_char_t const* kinds = g_trace_event_args[id];
+
+    // decode arguments
+    by_char_t  info[256];
+    by_char_t* p = info;
+    by_char_t* e = info + sizeof(info);
+    for (by_size_t i = 0; i < 3 && kinds[i] && p < e; i++)
+    {
+        by_uint64_t arg = event->args[i];
+        switch (kinds[i])
+        {
+        case 't':
+            {
+                by_char_t tag[9];
+                memcpy(tag, &arg, 8);
+                tag[8] = '\0';
+                p += snprintf(p, e - p, " %s", tag);
+            }
+            break;
+        case 'p':
+            p += snprintf(p, e - p, " %p", (by_pointer_t)(by_size_t)arg);
+            break;
+        default:
+            p += snprintf(p, e - p, " %llu", arg);
+            break;
+        }
+    }
+    if (p >= e) p = e - 1;
+    *p = '\0';
+
+    // trace
+    by_print("trace[%u]: #%u +%lluns %s:%s", ring->index, event->seq, event->time - base, g_trace_event_names[id], info);
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_void_t by_trace_enable(by_bool_t enabled)
+{
+    g_by_trace_enabled = enabled;
+}
+by_void_t by_trace_event_write(by_uint32_t id, by_uint64_t a0, by_uint64_t a1, by_uint64_t a2)
+{
+    // get the ring of the current thread
+    by_trace_ring_ref_t ring = g_tls_trace_ring;
+    if (!ring) ring = by_trace_ring_attach();
+    by_check_return(ring);
+
+    // write event, only the owner thread writes it, so we need not lock it
+    by_size_t         head  = ring->head;
+    by_trace_event_t* event = &ring->events[head & BY_TRACE_RING_MASK];
+    event->time    = by_trace_now();
+    event->id      = id;
+    event->seq     = (by_uint32_t)head;
+    event->args[0] = a0;
+    event->args[1] = a1;
+    event->args[2] = a2;
+
+    // publish it
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+by_uint64_t by_trace_tag(by_char_t const* name)
+{
+    // check
+    by_check_return_val(name, 0);
+
+    // skip the directory of the library path
+    by_char_t const* p = strrchr(name, '/');
+    if (p) name = p + 1;
+
+    // pack the first 8 bytes
+    by_uint64_t tag = 0;
+    by_char_t*  t = (by_char_t*)&tag;
+    for (by_size_t i = 0; i < 8 && name[i]; i++)
+        t[i] = name[i];
+    return tag;
+}
+by_void_t by_trace_dump()
+{
+    by_trace_ring_ref_t ring = __atomic_load_n(&g_trace_rings, __ATOMIC_ACQUIRE);
+    for (; ring; ring = ring->next)
+    {
+        // get the readable range
+        by_size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        by_size_t tail = head > BY_TRACE_RING_SIZE? head - BY_TRACE_RING_SIZE : 0;
+        by_check_continue(head != tail);
+
+        // dump events
+        by_uint64_t base = 0;
+        for (by_size_t i = tail; i < head; i++)
+        {
+            // copy event first
+            by_trace_event_t event = ring->events[i & BY_TRACE_RING_MASK];
+
+            /* skip it if it's being overwritten by the owner thread
+             *
+             * the owner writes the event at the slot of the current head before publishing it,
+             * so the slot i is stable only if the current head is less than i + ring size
+             */
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            by_size_t now = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+            by_check_continue(now < i + BY_TRACE_RING_SIZE && event.seq == (by_uint32_t)i);
+
+            // dump it
+            if (!base) base = event.time;
+            by_trace_event_print(ring, &event, base);
+        }
+    }
+}
@@ -0,0 +1,463 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        byopen_unwind.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen_elf.h"
+#include <ucontext.h>
+#include <elf.h>
+#include <link.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+/* the dwarf register numbers of the unwinder
+ *
+ * @see https://gitlab.com/x86-psABIs/x86-64-ABI
+ * @see https://github.com/ARM-software/abi-aa/blob/main/aadwarf64/aadwarf64.rst
+ */
+#if defined(BY_ARCH_x64)
+#   define BY_FAKE_UNWIND_FP    (6)
+#   define BY_FAKE_UNWIND_SP    (7)
+#   define BY_FAKE_UNWIND_RA    (16)
+#elif defined(BY_ARCH_ARM64)
+#   define BY_FAKE_UNWIND_FP    (29)
+#   define BY_FAKE_UNWIND_SP    (31)
+#   define BY_FAKE_UNWIND_RA    (30)
+#endif
+
+// the general register indexes of ucontext_t, they may be not defined without _GNU_SOURCE
+#if defined(BY_ARCH_x64) && !defined(REG_RIP)
+#   define REG_RBP              (10)
+#   define REG_RSP              (15)
+#   define REG_RIP              (16)
+#endif
+
+// the max stack size of the unwinder, we stop it if CFA is too far from the initial sp
+#define BY_FAKE_UNWIND_STACK_MAXN   (64 << 20)
+
+// the entry count of the call frame cache, it must be power of 2
+#define BY_FAKE_UNWIND_CACHE_MAXN   (1024)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the call frame cache entry of the unwinder
+typedef struct _by_fake_unwind_cache_t
+{
+    // the pc and the module table generation, the entry is empty if the generation is 0
+    by_size_t       pc;
+    by_size_t       gen;
+
+    // the call frame
+    by_dwarf_frame_t frame;
+
+}by_fake_unwind_cache_t;
+
+// the function symbol of the backtrace symbolizer
+typedef struct _by_fake_funcsym_t
+{
+    // the symbol value and size, it's relative to the load bias address
+    by_size_t           value;
+    by_size_t           size;
+
+    // the symbol name
+    by_char_t const*    name;
+
+}by_fake_funcsym_t;
+
+/* the backtrace symbolizer of the loaded module
+ *
+ * it keeps the library opened and its function symbols sorted by address,
+ * the returned names refer to its string table, so it will not be freed.
+ */
+typedef struct _by_fake_symbolizer_t
+{
+    // the next symbolizer
+    struct _by_fake_symbolizer_t* next;
+
+    // the module range and load bias address
+    by_size_t           start;
+    by_size_t           end;
+    by_pointer_t        biasaddr;
+
+    // the fake dlopen context, it's null if the library cannot be opened
+    by_fake_dlctx_ref_t dlctx;
+
+    // the function symbols sorted by value
+    by_fake_funcsym_t*  syms;
+    by_size_t           syms_num;
+
+}by_fake_symbolizer_t, *by_fake_symbolizer_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the call frame cache of the unwinder, it's protected by the module table lock
+static by_fake_unwind_cache_t g_unwind_cache[BY_FAKE_UNWIND_CACHE_MAXN];
+
+// the load generation of the last rebuilding by the unwinder
+static by_uint64_t      g_unwind_adds = 0;
+
+// the backtrace symbolizers, they will not be freed because the returned names refer to them
+static by_fake_symbolizer_ref_t g_symbolizers = by_null;
+static pthread_mutex_t  g_symbolizers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+#ifdef BY_FAKE_UNWIND_RA
+// get the call frame of the given pc, it need be called in the module table lock
+static by_bool_t by_fake_unwind_frame(by_fake_module_ref_t module, by_size_t pc, by_dwarf_frame_t* frame)
+{
+    // find it from the cache first, we need not parse cie and fde again for the same call site
+    by_fake_unwind_cache_t* entry = g_unwind_cache + (((pc >> 2) ^ (pc >> 12)) & (BY_FAKE_UNWIND_CACHE_MAXN - 1));
+    if (entry->pc == pc && entry->gen == g_by_modules_gen)
+    {
+        *frame = entry->frame;
+        return by_true;
+    }
+
+    // parse it from .eh_frame
+    by_check_return_val(by_dwarf_ehhdr_frame(&module->ehhdr, pc, BY_FAKE_UNWIND_FP, BY_FAKE_UNWIND_RA, frame), by_false);
+
+    // cache it
+    entry->pc    = pc;
+    entry->gen   = g_by_modules_gen;
+    entry->frame = *frame;
+    return by_true;
+}
+
+/* unwind the stack by .eh_frame of the loaded modules, it need be called in the module table lock
+ *
+ * it only reads the stack memory and never allocates memory, the module table may be rebuilt only if it's allowed.
+ */
+static by_size_t by_fake_unwind(by_size_t pc, by_size_t sp, by_size_t fp, by_size_t lr, by_bool_t exact, by_size_t skip, by_pointer_t* pcs, by_bool_t* exacts, by_size_t maxn, by_bool_t rebuild)
+{
+    by_size_t count = 0;
+    by_size_t stack = sp;
+    while (count < maxn && pc)
+    {
+        // save pc
+        if (skip) skip--;
+        else
+        {
+            if (exacts) exacts[count] = exact;
+            pcs[count++] = (by_pointer_t)pc;
+        }
+
+        /* find the module and call frame
+         *
+         * the return address may be the next function if the call is the last instruction (e.g. abort()),
+         * so we use pc - 1 for the caller frames.
+         */
+        by_size_t            lookup = exact? pc : pc - 1;
+        by_fake_module_ref_t module = by_elf_modules_find(lookup);
+        if (!module && rebuild)
+        {
+            // we rebuild the module table only if some libraries have been loaded, the pc may be in the jit code
+            by_uint64_t adds = by_elf_dlnotify_adds();
+            if (adds != g_unwind_adds)
+            {
+                g_unwind_adds = adds;
+                by_elf_modules_make();
+                module = by_elf_modules_find(lookup);
+            }
+        }
+        by_check_break(module && module->ehhdr.table);
+        by_dwarf_frame_t frame;
+        by_check_break(by_fake_unwind_frame(module, lookup, &frame));
+
+        // compute CFA, it must be in the current stack
+        by_size_t cfa = 0;
+        if (frame.cfa_reg == BY_FAKE_UNWIND_SP) cfa = sp + frame.cfa_offset;
+        else if (frame.cfa_reg == BY_FAKE_UNWIND_FP && fp) cfa = fp + frame.cfa_offset;
+        else break;
+        by_check_break(cfa >= sp && cfa - stack < BY_FAKE_UNWIND_STACK_MAXN && !(cfa & (sizeof(by_size_t) - 1)));
+
+        // get the return address
+        by_size_t ra = 0;
+        if (frame.ra_rule == BY_DWARF_RULE_OFFSET) ra = *((by_size_t const*)(cfa + frame.ra_value));
+        else if (frame.ra_rule == BY_DWARF_RULE_SAME && lr) ra = lr;
+        else break;
+#ifdef BY_ARCH_ARM64
+        // strip the pointer authentication code
+        ra &= 0x0000ffffffffffffULL;
+#endif
+
+        // restore the frame pointer, it's unknown if the caller frame is defined by the other registers
+        if (frame.fp_rule == BY_DWARF_RULE_OFFSET) fp = *((by_size_t const*)(cfa + frame.fp_value));
+        else if (frame.fp_rule == BY_DWARF_RULE_VAL_OFFSET) fp = cfa + frame.fp_value;
+        else if (frame.fp_rule != BY_DWARF_RULE_SAME) fp = 0;
+
+        // goto the caller frame, the link register of the caller frame is unknown
+        exact = frame.signal;
+        pc    = ra;
+        sp    = cfa;
+        lr    = 0;
+    }
+    return count;
+}
+#endif
+
+// the function symbol comparator
+static by_int_t by_fake_funcsym_comp(by_cpointer_t a, by_cpointer_t b)
+{
+    by_size_t av = ((by_fake_funcsym_t const*)a)->value;
+    by_size_t bv = ((by_fake_funcsym_t const*)b)->value;
+    return av < bv? -1 : (av > bv);
+}
+
+// make the function symbols of the symbolizer, .symtab is usually the superset of .dynsym
+static by_void_t by_fake_symbolizer_load(by_fake_symbolizer_ref_t symbolizer)
+{
+    // get the symbol table
+    by_fake_dlctx_ref_t dlctx = symbolizer->dlctx;
+    by_check_return(by_elf_dlctx_ensure(dlctx));
+    ElfW(Sym) const* symtab = (ElfW(Sym) const*)dlctx->symtab;
+    by_char_t const* strtab = (by_char_t const*)dlctx->strtab;
+    by_int_t         symtab_num = dlctx->symtab_num;
+    if (!symtab || !strtab)
+    {
+        symtab     = (ElfW(Sym) const*)dlctx->dynsym;
+        strtab     = (by_char_t const*)dlctx->dynstr;
+        symtab_num = dlctx->dynsym_num;
+    }
+    by_check_return(symtab && strtab && symtab_num > 0);
+
+    // get all defined functions
+    by_fake_funcsym_t* syms = malloc(symtab_num * sizeof(by_fake_funcsym_t));
+    by_check_return(syms);
+    by_int_t     i = 0;
+    by_size_t    count = 0;
+    by_pointer_t end = dlctx->filedata + dlctx->filesize;
+    for (i = 0; i < symtab_num; i++, symtab++)
+    {
+        by_check_continue(BY_ELF_ST_TYPE(symtab->st_info) == STT_FUNC && symtab->st_shndx != SHN_UNDEF && symtab->st_value);
+        by_char_t const* name = strtab + symtab->st_name;
+        by_check_continue((by_pointer_t)name < end && *name);
+
+        // we need clear the thumb bit
+        syms[count].value = (by_size_t)symtab->st_value;
+#if defined(BY_ARCH_ARM) && !defined(BY_ARCH_ARM64)
+        syms[count].value &= ~1;
+#endif
+        syms[count].size  = (by_size_t)symtab->st_size;
+        syms[count].name  = name;
+        count++;
+    }
+    if (count) qsort(syms, count, sizeof(by_fake_funcsym_t), by_fake_funcsym_comp);
+    symbolizer->syms     = syms;
+    symbolizer->syms_num = count;
+}
+
+/* get the backtrace symbolizer of the module containing the given address
+ *
+ * it's created at the first lookup, and the empty symbolizer is also cached if the library cannot be opened.
+ */
+static by_fake_symbolizer_ref_t by_fake_symbolizer_get(by_size_t addr)
+{
+    // find the module
+    by_size_t    start = 0;
+    by_size_t    end = 0;
+    by_pointer_t biasaddr = by_null;
+    by_char_t    realpath[512];
+    pthread_mutex_lock(&g_by_modules_lock);
+    by_fake_module_ref_t module = by_elf_modules_find(addr);
+    if (!module)
+    {
+        by_elf_modules_make();
+        module = by_elf_modules_find(addr);
+    }
+    if (module)
+    {
+        start    = module->start;
+        end      = module->end;
+        biasaddr = module->biasaddr;
+        strlcpy(realpath, module->name, sizeof(realpath));
+    }
+    pthread_mutex_unlock(&g_by_modules_lock);
+    by_check_return_val(start < end, by_null);
+
+    // find the cached symbolizer
+    pthread_mutex_lock(&g_symbolizers_lock);
+    by_fake_symbolizer_ref_t symbolizer = g_symbolizers;
+    while (symbolizer && (symbolizer->start != start || symbolizer->end != end || symbolizer->biasaddr != biasaddr))
+        symbolizer = symbolizer->next;
+
+    // make a new symbolizer
+    if (!symbolizer && (symbolizer = calloc(1, sizeof(by_fake_symbolizer_t))))
+    {
+        symbolizer->start    = start;
+        symbolizer->end      = end;
+        symbolizer->biasaddr = biasaddr;
+        if (by_elf_find_realpath(addr, realpath, sizeof(realpath)))
+            symbolizer->dlctx = by_elf_dlopen_file(by_null, biasaddr, realpath);
+        if (symbolizer->dlctx) by_fake_symbolizer_load(symbolizer);
+        symbolizer->next = g_symbolizers;
+        g_symbolizers    = symbolizer;
+
+        // trace
+        by_trace("backtrace: %s, %lu functions", realpath, (by_ulong_t)symbolizer->syms_num);
+    }
+    pthread_mutex_unlock(&g_symbolizers_lock);
+    return symbolizer;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+__attribute__((noinline)) by_size_t by_backtrace(by_pointer_t* pcs, by_bool_t* exacts, by_size_t maxn)
+{
+    // check
+    by_assert_and_check_return_val(pcs && maxn, 0);
+
+#ifdef BY_FAKE_UNWIND_RA
+    // get the registers of the current frame
+    by_size_t pc = 0;
+    by_size_t sp = 0;
+    by_size_t fp = 0;
+    by_size_t lr = 0;
+#   if defined(BY_ARCH_x64)
+    __asm__ __volatile__("leaq 0(%%rip), %0\n\tmovq %%rsp, %1\n\tmovq %%rbp, %2" : "=r"(pc), "=r"(sp), "=r"(fp));
+#   else
+    __asm__ __volatile__("adr %0, .\n\tmov %1, sp\n\tmov %2, x29\n\tmov %3, x30" : "=r"(pc), "=r"(sp), "=r"(fp), "=r"(lr));
+#   endif
+
+    // unwind it and skip the current frame
+    by_linker_init();
+    pthread_mutex_lock(&g_by_modules_lock);
+    by_size_t count = by_fake_unwind(pc, sp, fp, lr, by_true, 1, pcs, exacts, maxn, by_true);
+    pthread_mutex_unlock(&g_by_modules_lock);
+    return count;
+#else
+    return 0;
+#endif
+}
+by_size_t by_backtrace_context(by_cpointer_t context, by_pointer_t* pcs, by_bool_t* exacts, by_size_t maxn)
+{
+    // check
+    by_assert_and_check_return_val(context && pcs && maxn, 0);
+
+#ifdef BY_FAKE_UNWIND_RA
+    // get the registers of the interrupted frame
+    ucontext_t const* uc = (ucontext_t const*)context;
+#   if defined(BY_ARCH_x64)
+    by_size_t pc = (by_size_t)uc->uc_mcontext.gregs[REG_RIP];
+    by_size_t sp = (by_size_t)uc->uc_mcontext.gregs[REG_RSP];
+    by_size_t fp = (by_size_t)uc->uc_mcontext.gregs[REG_RBP];
+    by_size_t lr = 0;
+#   else
+    by_size_t pc = (by_size_t)uc->uc_mcontext.pc;
+    by_size_t sp = (by_size_t)uc->uc_mcontext.sp;
+    by_size_t fp = (by_size_t)uc->uc_mcontext.regs[29];
+    by_size_t lr = (by_size_t)uc->uc_mcontext.regs[30];
+#   endif
+
+    /* unwind it without rebuilding the module table, it may be called in the signal handler
+     *
+     * we cannot wait the lock if the interrupted thread is rebuilding the module table.
+     */
+    by_check_return_val(!pthread_mutex_trylock(&g_by_modules_lock), 0);
+    by_size_t count = by_fake_unwind(pc, sp, fp, lr, by_true, 0, pcs, exacts, maxn, by_false);
+    pthread_mutex_unlock(&g_by_modules_lock);
+    return count;
+#else
+    return 0;
+#endif
+}
+by_size_t by_backtrace_symbols(by_pointer_t const* pcs, by_bool_t const* exacts, by_char_t const** names, by_size_t* offsets, by_size_t count)
+{
+    // check
+    by_assert_and_check_return_val(pcs && names, 0);
+
+    // make the queries sorted by address, the return addresses are looked up by pc - 1, but the exact pcs are not
+    by_size_t         i = 0;
+    by_dwarf_query_t  buffer[64];
+    by_dwarf_query_t* queries = count <= sizeof(buffer) / sizeof(buffer[0])? buffer : malloc(count * sizeof(by_dwarf_query_t));
+    for (i = 0; i < count; i++)
+    {
+        names[i] = by_null;
+        if (offsets) offsets[i] = 0;
+        if (queries)
+        {
+            queries[i].addr  = pcs[i]? (by_size_t)pcs[i] - (exacts && exacts[i]? 0 : 1) : 0;
+            queries[i].index = i;
+        }
+    }
+    by_check_return_val(queries, 0);
+    qsort(queries, count, sizeof(by_dwarf_query_t), by_dwarf_query_comp);
+
+    // find them module by module, we need only one merge pass for each module
+    by_size_t found = 0;
+    for (i = 0; i < count; )
+    {
+        // get the symbolizer of the current module
+        by_size_t                addr = queries[i].addr;
+        by_fake_symbolizer_ref_t symbolizer = addr? by_fake_symbolizer_get(addr) : by_null;
+        if (!symbolizer)
+        {
+            i++;
+            continue;
+        }
+
+        // find the last symbol whose value <= addr, the queries are sorted, so we need only gallop forward
+        by_size_t                pos = 0;
+        by_fake_funcsym_t const* syms = symbolizer->syms;
+        by_size_t                syms_num = symbolizer->syms_num;
+        for (; i < count && queries[i].addr >= symbolizer->start && queries[i].addr < symbolizer->end; i++)
+        {
+            by_size_t value = queries[i].addr - (by_size_t)symbolizer->biasaddr;
+            by_size_t step = 1;
+            by_size_t hi = pos;
+            while (hi < syms_num && syms[hi].value <= value)
+            {
+                pos = hi + 1;
+                hi += step;
+                step <<= 1;
+            }
+            if (hi > syms_num) hi = syms_num;
+            while (pos < hi)
+            {
+                by_size_t m = pos + ((hi - pos) >> 1);
+                if (syms[m].value <= value) pos = m + 1;
+                else hi = m;
+            }
+
+            // the function without size (e.g. assembly) is considered to extend to the next symbol
+            by_check_continue(pos);
+            by_fake_funcsym_t const* sym = syms + pos - 1;
+            if (!sym->size || value < sym->value + sym->size)
+            {
+                by_size_t index = queries[i].index;
+                names[index] = sym->name;
+                if (offsets) offsets[index] = (by_size_t)pcs[index] - (by_size_t)symbolizer->biasaddr - sym->value;
+                found++;
+            }
+        }
+    }
+    if (queries != buffer) free(queries);
+    return found;
+}
@@ -226,6 +226,98 @@ typedef by_uint64_t                 by_hize_t;
 typedef float                       by_float_t;
 typedef double                      by_double_t;
 
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * trace events
+ *
+ * the binary event tracing for the hot paths, it's cheaper than by_trace() (printf/logcat),
+ * each event is written to a per-thread lock-free ring buffer and decoded only in by_trace_dump().
+ *
+ * it's compiled in all modes and switched at runtime by by_trace_enable(),
+ * it's enabled by default for BY_DEBUG mode.
+ */
+
+// the trace event ring size of each thread, must be power of 2
+#ifndef BY_TRACE_RING_SIZE
+#   define BY_TRACE_RING_SIZE                   (1024)
+#endif
+
+// write trace event if tracing is enabled, the arguments will not be evaluated if it's disabled
+#define by_trace_event(id, a0, a1, a2) \
+    do \
+    { \
+        if (g_by_trace_enabled) \
+            by_trace_event_write((id), (by_uint64_t)(by_size_t)(a0), (by_uint64_t)(by_size_t)(a1), (by_uint64_t)(by_size_t)(a2)); \
+    } while (0)
+
+/// the trace event id enum
+typedef enum __by_trace_event_id_e
+{
+    BY_TRACE_EVENT_NONE             = 0
+,   BY_TRACE_EVENT_OPEN_BEGIN       = 1     //!< args: name tag, flag
+,   BY_TRACE_EVENT_OPEN_BIASADDR    = 2     //!< args: name tag, biasaddr
+,   BY_TRACE_EVENT_OPEN_FILE        = 3     //!< args: filedata, filesize
+,   BY_TRACE_EVENT_OPEN_SECTION     = 4     //!< args: index, type, offset
+,   BY_TRACE_EVENT_OPEN_SYMTAB      = 5     //!< args: section type, address, count
+,   BY_TRACE_EVENT_OPEN_END         = 6     //!< args: name tag, handle
+,   BY_TRACE_EVENT_DLSYM_BEGIN      = 7     //!< args: symbol tag, handle
+,   BY_TRACE_EVENT_DLSYM_HIT        = 8     //!< args: section type, address, probes
+,   BY_TRACE_EVENT_DLSYM_MISS       = 9     //!< args: symbol tag, probes
+,   BY_TRACE_EVENT_MAXN             = 10
+
+}by_trace_event_id_e;
+
+/// the trace event type, fixed size
+typedef struct __by_trace_event_t
+{
+    /// the monotonic timestamp (ns)
+    by_uint64_t             time;
+
+    /// the event id
+    by_uint32_t             id;
+
+    /// the event sequence
+    by_uint32_t             seq;
+
+    /// the event arguments
+    by_uint64_t             args[3];
+
+}by_trace_event_t;
+
+/// is tracing enabled? only for by_trace_event()
+extern by_bool_t volatile   g_by_trace_enabled;
+
+/*! enable or disable the event tracing at runtime
+ *
+ * @param enabled   is enabled?
+ */
+by_void_t                   by_trace_enable(by_bool_t enabled);
+
+/*! write a trace event to the ring buffer of the current thread
+ *
+ * @note please uses by_trace_event() instead of it
+ *
+ * @param id        the event id
+ * @param a0        the first argument
+ * @param a1        the second argument
+ * @param a2        the third argument
+ */
+by_void_t                   by_trace_event_write(by_uint32_t id, by_uint64_t a0, by_uint64_t a1, by_uint64_t a2);
+
+/*! pack the first 8 bytes of the given name to an event argument
+ *
+ * @param name      the name, e.g. library or symbol name
+ *
+ * @return          the name tag
+ */
+by_uint64_t                 by_trace_tag(by_char_t const* name);
+
+/*! decode and dump the trace events of all threads
+ *
+ * the events are copied out first, so it is safe to be called when other threads are still tracing,
+ * and the overwritten events will be skipped.
+ */
+by_void_t                   by_trace_dump(by_void_t);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,9 +1,13 @@
 target("byopen")
     set_kind("static")
+    add_files("byopen_trace.c", "byopen_pool.c", "byopen_dwarf.c", "byopen_macho_image.c", "byopen_macho_images.c")
     if is_plat("iphoneos", "macosx") then
         add_files("byopen_macho.c")
     elseif is_plat("android") then
-        add_files("byopen_android.c")
+        add_files("byopen_elf.c", "byopen_unwind.c", "byopen_remote.c", "byopen_dlnotify.c", "byopen_android.c")
+    elseif is_plat("linux") then
+        add_files("byopen_elf.c", "byopen_unwind.c", "byopen_remote.c", "byopen_dlnotify.c", "byopen_linux.c")
+        add_defines("_GNU_SOURCE")
     end
     add_includedirs(".", {interface = true})
     add_headerfiles("*.h")
@@ -0,0 +1,40 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        dup1.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+/* the local symbol which has the same name as the global symbol in dup2.c,
+ * it's only in .symtab and it's usually placed before the global one.
+ */
+static int  by_test_dup_first __attribute__((used)) = 1;
+
+// the global symbol, the local one with the same name is in dup2.c
+int         by_test_dup_second = 2;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+int by_test_dup_first_local(void)
+{
+    return by_test_dup_first;
+}
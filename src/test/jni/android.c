@@ -0,0 +1,50 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        android.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <android/log.h>
+#include <sys/system_properties.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+int __android_log_print(int prio, char const* tag, char const* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    return n;
+}
+prop_info const* __system_property_find(char const* name)
+{
+    return NULL;
+}
+int __system_property_get(char const* name, char* value)
+{
+    value[0] = '\0';
+    return 0;
+}
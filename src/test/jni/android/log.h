@@ -0,0 +1,29 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        log.h
+ *
+ */
+#ifndef BY_TEST_ANDROID_LOG_H
+#define BY_TEST_ANDROID_LOG_H
+
+// the android log of the host-side jni test, it's printed to stderr
+#define ANDROID_LOG_INFO        (4)
+
+int __android_log_print(int prio, char const* tag, char const* fmt, ...);
+
+#endif
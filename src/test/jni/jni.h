@@ -0,0 +1,114 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        jni.h
+ *
+ */
+#ifndef BY_TEST_JNI_H
+#define BY_TEST_JNI_H
+
+/* the reduced jni.h of the host-side jni test
+ *
+ * it only declares the jni functions used by byopen_android.c, so the test can fill a fake function table.
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include <stdarg.h>
+#include <stdint.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+#define JNI_FALSE               (0)
+#define JNI_TRUE                (1)
+#define JNI_OK                  (0)
+#define JNI_ERR                 (-1)
+#define JNI_EDETACHED           (-2)
+#define JNI_VERSION_1_4         (0x00010004)
+#define JNI_VERSION_1_6         (0x00010006)
+#define JNIEXPORT               __attribute__((visibility("default")))
+#define JNICALL
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+typedef uint8_t                 jboolean;
+typedef int32_t                 jint;
+typedef int64_t                 jlong;
+typedef jint                    jsize;
+typedef void*                   jobject;
+typedef jobject                 jclass;
+typedef jobject                 jthrowable;
+typedef jobject                 jstring;
+typedef jobject                 jarray;
+typedef jarray                  jobjectArray;
+typedef jobject                 jweak;
+typedef struct _jmethodID*      jmethodID;
+typedef struct _jfieldID*       jfieldID;
+
+struct JNINativeInterface;
+struct JNIInvokeInterface;
+typedef struct JNINativeInterface const* JNIEnv;
+typedef struct JNIInvokeInterface const* JavaVM;
+
+typedef struct JavaVMAttachArgs
+{
+    jint                        version;
+    char const*                 name;
+    jobject                     group;
+
+}JavaVMAttachArgs;
+
+struct JNINativeInterface
+{
+    void*                       reserved0;
+    jclass                      (*FindClass)(JNIEnv*, char const*);
+    jthrowable                  (*ExceptionOccurred)(JNIEnv*);
+    void                        (*ExceptionClear)(JNIEnv*);
+    jboolean                    (*ExceptionCheck)(JNIEnv*);
+    jclass                      (*GetObjectClass)(JNIEnv*, jobject);
+    jmethodID                   (*GetMethodID)(JNIEnv*, jclass, char const*, char const*);
+    jmethodID                   (*GetStaticMethodID)(JNIEnv*, jclass, char const*, char const*);
+    void                        (*CallVoidMethod)(JNIEnv*, jobject, jmethodID, ...);
+    jobject                     (*CallObjectMethod)(JNIEnv*, jobject, jmethodID, ...);
+    void                        (*CallStaticVoidMethod)(JNIEnv*, jclass, jmethodID, ...);
+    jint                        (*PushLocalFrame)(JNIEnv*, jint);
+    jobject                     (*PopLocalFrame)(JNIEnv*, jobject);
+    jobject                     (*NewGlobalRef)(JNIEnv*, jobject);
+    void                        (*DeleteGlobalRef)(JNIEnv*, jobject);
+    void                        (*DeleteLocalRef)(JNIEnv*, jobject);
+    jstring                     (*NewStringUTF)(JNIEnv*, char const*);
+    char const*                 (*GetStringUTFChars)(JNIEnv*, jstring, jboolean*);
+    void                        (*ReleaseStringUTFChars)(JNIEnv*, jstring, char const*);
+    jobjectArray                (*NewObjectArray)(JNIEnv*, jsize, jclass, jobject);
+    void                        (*SetObjectArrayElement)(JNIEnv*, jobjectArray, jsize, jobject);
+    jint                        (*GetJavaVM)(JNIEnv*, JavaVM**);
+};
+
+struct JNIInvokeInterface
+{
+    void*                       reserved0;
+    jint                        (*DestroyJavaVM)(JavaVM*);
+    jint                        (*AttachCurrentThread)(JavaVM*, JNIEnv**, void*);
+    jint                        (*DetachCurrentThread)(JavaVM*);
+    jint                        (*GetEnv)(JavaVM*, void**, jint);
+    jint                        (*AttachCurrentThreadAsDaemon)(JavaVM*, JNIEnv**, void*);
+};
+
+#endif
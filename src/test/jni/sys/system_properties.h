@@ -0,0 +1,33 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        system_properties.h
+ *
+ */
+#ifndef BY_TEST_SYS_SYSTEM_PROPERTIES_H
+#define BY_TEST_SYS_SYSTEM_PROPERTIES_H
+
+// the system properties of the host-side jni test, no property will be found
+#define PROP_VALUE_MAX          (92)
+#define __ANDROID_API_L__       (21)
+#define __ANDROID_API_L_MR1__   (22)
+
+typedef struct prop_info        prop_info;
+
+prop_info const* __system_property_find(char const* name);
+
+#endif
@@ -0,0 +1,440 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_jni.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include <jni.h>
+#include <pthread.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the library path, it's not loaded, so by_dlopen() will fall back to System.load()
+#define BY_TEST_JNI_LIBPATH         "/data/app/byopen/lib/libbytest_jni.so"
+
+// the max count of the fake objects
+#define BY_TEST_JNI_OBJECTS_MAXN    (256)
+
+// the worker thread count
+#define BY_TEST_JNI_WORKERS         (4)
+
+// count the jni call
+#define by_test_jni_call(name)      g_calls[BY_TEST_JNI_##name]++
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the counted jni functions
+typedef enum _by_test_jni_func_e
+{
+    BY_TEST_JNI_FindClass
+,   BY_TEST_JNI_GetMethodID
+,   BY_TEST_JNI_GetStaticMethodID
+,   BY_TEST_JNI_CallObjectMethod
+,   BY_TEST_JNI_CallStaticVoidMethod
+,   BY_TEST_JNI_NewGlobalRef
+,   BY_TEST_JNI_DeleteGlobalRef
+,   BY_TEST_JNI_NewStringUTF
+,   BY_TEST_JNI_NewObjectArray
+,   BY_TEST_JNI_GetJavaVM
+,   BY_TEST_JNI_GetEnv
+,   BY_TEST_JNI_AttachCurrentThread
+,   BY_TEST_JNI_DetachCurrentThread
+,   BY_TEST_JNI_MAXN
+
+}by_test_jni_func_e;
+
+/* the fake java object type
+ *
+ * the classes, strings and reflected methods are named by their class name, string or method name.
+ */
+typedef struct _by_test_jni_object_t
+{
+    // the name
+    by_char_t const*        name;
+
+    // the array elements
+    jobject                 elements[2];
+
+}by_test_jni_object_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * declaration
+ */
+by_void_t by_jni_javavm_set(JavaVM* jvm, by_int_t jversion);
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the call counts of the jni functions
+static by_size_t                g_calls[BY_TEST_JNI_MAXN];
+
+// the fake objects
+static by_test_jni_object_t     g_objects[BY_TEST_JNI_OBJECTS_MAXN];
+static by_size_t                g_objects_num = 0;
+
+// the pending exception
+static by_bool_t                g_pending = by_false;
+
+// fail Class.getDeclaredMethod()?
+static by_bool_t                g_fail_getDeclaredMethod = by_false;
+
+// the library path loaded by the reflected System.load()
+static by_char_t                g_loaded[256];
+
+// the current java vm
+static JavaVM*                  g_vm = by_null;
+
+// the main thread, it has been attached to the java vm
+static pthread_t                g_main;
+
+// the current thread has been attached by AttachCurrentThread()?
+static __thread by_bool_t       g_attached = by_false;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static jobject by_test_jni_object(by_char_t const* name)
+{
+    by_test_jni_object_t* object = &g_objects[g_objects_num++ % BY_TEST_JNI_OBJECTS_MAXN];
+    object->name = name;
+    object->elements[0] = by_null;
+    object->elements[1] = by_null;
+    return (jobject)object;
+}
+static by_bool_t by_test_jni_object_is(jobject object, by_char_t const* name)
+{
+    return object && !strcmp(((by_test_jni_object_t*)object)->name, name);
+}
+static jclass by_test_jni_FindClass(JNIEnv* env, by_char_t const* name)
+{
+    by_test_jni_call(FindClass);
+    return by_test_jni_object(name);
+}
+static jthrowable by_test_jni_ExceptionOccurred(JNIEnv* env)
+{
+    return by_null;
+}
+static by_void_t by_test_jni_ExceptionClear(JNIEnv* env)
+{
+    g_pending = by_false;
+}
+static jboolean by_test_jni_ExceptionCheck(JNIEnv* env)
+{
+    return g_pending;
+}
+static jclass by_test_jni_GetObjectClass(JNIEnv* env, jobject object)
+{
+    return by_test_jni_object("java/lang/Object");
+}
+static jmethodID by_test_jni_GetMethodID(JNIEnv* env, jclass clazz, by_char_t const* name, by_char_t const* signature)
+{
+    by_test_jni_call(GetMethodID);
+    return (jmethodID)by_test_jni_object(name);
+}
+static jmethodID by_test_jni_GetStaticMethodID(JNIEnv* env, jclass clazz, by_char_t const* name, by_char_t const* signature)
+{
+    by_test_jni_call(GetStaticMethodID);
+    return (jmethodID)by_test_jni_object(name);
+}
+static by_void_t by_test_jni_CallVoidMethod(JNIEnv* env, jobject object, jmethodID method, ...)
+{
+}
+static jobject by_test_jni_CallObjectMethod(JNIEnv* env, jobject object, jmethodID method, ...)
+{
+    by_test_jni_call(CallObjectMethod);
+    jobject result = by_null;
+    va_list args;
+    va_start(args, method);
+    if (by_test_jni_object_is((jobject)method, "getDeclaredMethod"))
+    {
+        // Class.class.getDeclaredMethod("getDeclaredMethod", String.class, Class[].class)
+        if (g_fail_getDeclaredMethod) g_pending = by_true;
+        else result = by_test_jni_object("getDeclaredMethod");
+    }
+    else if (by_test_jni_object_is((jobject)method, "invoke"))
+    {
+        va_arg(args, jobject);
+        by_test_jni_object_t* invoke_args = va_arg(args, by_test_jni_object_t*);
+        by_test_jni_object_t* arg0 = (by_test_jni_object_t*)invoke_args->elements[0];
+        if (by_test_jni_object_is(object, "getDeclaredMethod"))
+        {
+            // getDeclaredMethod.invoke(systemClass, "load", new Class[]{String.class})
+            result = by_test_jni_object(arg0->name);
+        }
+        else if (by_test_jni_object_is(object, "load"))
+        {
+            // load.invoke(systemClass, libraryPath)
+            snprintf(g_loaded, sizeof(g_loaded), "%s", arg0->name);
+        }
+    }
+    va_end(args);
+    return result;
+}
+static by_void_t by_test_jni_CallStaticVoidMethod(JNIEnv* env, jclass clazz, jmethodID method, ...)
+{
+    // the System.load() of the app class loader is always rejected, so the reflected System.load() will be used
+    by_test_jni_call(CallStaticVoidMethod);
+    g_pending = by_true;
+}
+static jint by_test_jni_PushLocalFrame(JNIEnv* env, jint capacity)
+{
+    return 0;
+}
+static jobject by_test_jni_PopLocalFrame(JNIEnv* env, jobject result)
+{
+    return result;
+}
+static jobject by_test_jni_NewGlobalRef(JNIEnv* env, jobject object)
+{
+    by_test_jni_call(NewGlobalRef);
+    return object;
+}
+static by_void_t by_test_jni_DeleteGlobalRef(JNIEnv* env, jobject object)
+{
+    by_test_jni_call(DeleteGlobalRef);
+}
+static by_void_t by_test_jni_DeleteLocalRef(JNIEnv* env, jobject object)
+{
+}
+static jstring by_test_jni_NewStringUTF(JNIEnv* env, by_char_t const* cstr)
+{
+    by_test_jni_call(NewStringUTF);
+    return (jstring)by_test_jni_object(cstr);
+}
+static jobjectArray by_test_jni_NewObjectArray(JNIEnv* env, jsize size, jclass clazz, jobject init)
+{
+    by_test_jni_call(NewObjectArray);
+    by_test_jni_object_t* array = (by_test_jni_object_t*)by_test_jni_object("[Ljava/lang/Object;");
+    for (jsize i = 0; i < size && i < 2; i++)
+        array->elements[i] = init;
+    return (jobjectArray)array;
+}
+static by_void_t by_test_jni_SetObjectArrayElement(JNIEnv* env, jobjectArray array, jsize index, jobject object)
+{
+    if (index < 2) ((by_test_jni_object_t*)array)->elements[index] = object;
+}
+static jint by_test_jni_GetJavaVM(JNIEnv* env, JavaVM** pvm)
+{
+    by_test_jni_call(GetJavaVM);
+    *pvm = g_vm;
+    return JNI_OK;
+}
+
+// the fake jni environment
+static struct JNINativeInterface const g_env_funcs =
+{
+    .FindClass              = by_test_jni_FindClass
+,   .ExceptionOccurred      = by_test_jni_ExceptionOccurred
+,   .ExceptionClear         = by_test_jni_ExceptionClear
+,   .ExceptionCheck         = by_test_jni_ExceptionCheck
+,   .GetObjectClass         = by_test_jni_GetObjectClass
+,   .GetMethodID            = by_test_jni_GetMethodID
+,   .GetStaticMethodID      = by_test_jni_GetStaticMethodID
+,   .CallVoidMethod         = by_test_jni_CallVoidMethod
+,   .CallObjectMethod       = by_test_jni_CallObjectMethod
+,   .CallStaticVoidMethod   = by_test_jni_CallStaticVoidMethod
+,   .PushLocalFrame         = by_test_jni_PushLocalFrame
+,   .PopLocalFrame          = by_test_jni_PopLocalFrame
+,   .NewGlobalRef           = by_test_jni_NewGlobalRef
+,   .DeleteGlobalRef        = by_test_jni_DeleteGlobalRef
+,   .DeleteLocalRef         = by_test_jni_DeleteLocalRef
+,   .NewStringUTF           = by_test_jni_NewStringUTF
+,   .NewObjectArray         = by_test_jni_NewObjectArray
+,   .SetObjectArrayElement  = by_test_jni_SetObjectArrayElement
+,   .GetJavaVM              = by_test_jni_GetJavaVM
+};
+static JNIEnv g_env = &g_env_funcs;
+
+// the fake java vms, they share the same jni environment, and only the main thread is attached at first
+static jint by_test_jni_GetEnv(JavaVM* vm, by_pointer_t* penv, jint version)
+{
+    by_test_jni_call(GetEnv);
+    if (!pthread_equal(pthread_self(), g_main) && !g_attached)
+    {
+        *penv = by_null;
+        return JNI_EDETACHED;
+    }
+    *penv = &g_env;
+    return JNI_OK;
+}
+static jint by_test_jni_AttachCurrentThread(JavaVM* vm, JNIEnv** penv, by_pointer_t args)
+{
+    by_test_jni_call(AttachCurrentThread);
+    g_attached = by_true;
+    *penv = &g_env;
+    return JNI_OK;
+}
+static jint by_test_jni_DetachCurrentThread(JavaVM* vm)
+{
+    by_test_jni_call(DetachCurrentThread);
+    g_attached = by_false;
+    return JNI_OK;
+}
+static struct JNIInvokeInterface const g_vm_funcs =
+{
+    .AttachCurrentThread    = by_test_jni_AttachCurrentThread
+,   .DetachCurrentThread    = by_test_jni_DetachCurrentThread
+,   .GetEnv                 = by_test_jni_GetEnv
+};
+static JavaVM g_vm1 = &g_vm_funcs;
+static JavaVM g_vm2 = &g_vm_funcs;
+
+// load the library and count the jni calls
+static by_void_t by_test_jni_load()
+{
+    memset(g_calls, 0, sizeof(g_calls));
+    g_loaded[0] = '\0';
+    by_pointer_t handle = by_dlopen(BY_TEST_JNI_LIBPATH, BY_RTLD_NOW);
+    if (handle) by_dlclose(handle);
+}
+
+// the next loadings only call the cached System.load via reflection
+static by_bool_t by_test_jni_check_cached()
+{
+    by_test_check(!strcmp(g_loaded, BY_TEST_JNI_LIBPATH));
+    by_test_check(!g_calls[BY_TEST_JNI_FindClass] && !g_calls[BY_TEST_JNI_GetMethodID] && !g_calls[BY_TEST_JNI_GetStaticMethodID]);
+    by_test_check(!g_calls[BY_TEST_JNI_NewGlobalRef] && !g_calls[BY_TEST_JNI_DeleteGlobalRef] && !g_calls[BY_TEST_JNI_GetJavaVM]);
+
+    // the library path strings of the app and reflected System.load, and only load.invoke() is called
+    by_test_check(g_calls[BY_TEST_JNI_NewStringUTF] == 2);
+    by_test_check(g_calls[BY_TEST_JNI_CallStaticVoidMethod] == 1);
+    by_test_check(g_calls[BY_TEST_JNI_NewObjectArray] == 1);
+    by_test_check(g_calls[BY_TEST_JNI_CallObjectMethod] == 1);
+    return by_true;
+}
+
+// the first loading of the java vm resolves and caches all classes and methods
+static by_bool_t by_test_jni_check_first()
+{
+    by_test_check(!strcmp(g_loaded, BY_TEST_JNI_LIBPATH));
+    by_test_check(g_calls[BY_TEST_JNI_GetJavaVM] == 1);
+
+    // Class, Object, String, System, Method and Class[]
+    by_test_check(g_calls[BY_TEST_JNI_FindClass] == 6);
+
+    // the global references of the four classes, getDeclaredMethod and load, the references of the old vm are not deleted
+    by_test_check(g_calls[BY_TEST_JNI_NewGlobalRef] == 6);
+    by_test_check(!g_calls[BY_TEST_JNI_DeleteGlobalRef]);
+
+    // getDeclaredMethod(), getDeclaredMethod.invoke() and load.invoke()
+    by_test_check(g_calls[BY_TEST_JNI_CallObjectMethod] == 3);
+    return by_true;
+}
+
+// the worker thread, it loads the library twice and exits
+static by_pointer_t by_test_jni_worker(by_pointer_t udata)
+{
+    for (by_size_t i = 0; i < 2; i++)
+    {
+        g_loaded[0] = '\0';
+        by_pointer_t handle = by_dlopen(BY_TEST_JNI_LIBPATH, BY_RTLD_NOW);
+        if (handle) by_dlclose(handle);
+        if (strcmp(g_loaded, BY_TEST_JNI_LIBPATH)) return by_null;
+    }
+    return (by_pointer_t)(by_size_t)g_attached;
+}
+
+/* the non-java worker threads are attached once and detached when they exit
+ *
+ * we run them one by one, because the fake java vm and objects are not thread-safe.
+ */
+static by_bool_t by_test_jni_workers()
+{
+    memset(g_calls, 0, sizeof(g_calls));
+    for (by_size_t i = 0; i < BY_TEST_JNI_WORKERS; i++)
+    {
+        pthread_t    thread;
+        by_pointer_t attached = by_null;
+        by_test_check(!pthread_create(&thread, by_null, by_test_jni_worker, by_null));
+        pthread_join(thread, &attached);
+        by_test_check(attached);
+
+        // the second loading uses the cached jni environment, so GetEnv() is not called again
+        by_test_check(g_calls[BY_TEST_JNI_GetEnv] == i + 1);
+        by_test_check(g_calls[BY_TEST_JNI_AttachCurrentThread] == i + 1);
+        by_test_check(g_calls[BY_TEST_JNI_DetachCurrentThread] == i + 1);
+    }
+
+    // the main thread is not attached again
+    by_test_jni_load();
+    by_test_check(by_test_jni_check_cached());
+    by_test_check(!g_calls[BY_TEST_JNI_GetEnv] && !g_calls[BY_TEST_JNI_AttachCurrentThread] && !g_calls[BY_TEST_JNI_DetachCurrentThread]);
+    return by_true;
+}
+
+// test the jni cache of the System.load fallback
+static by_bool_t by_test_jni()
+{
+    // only the main thread is attached at first
+    g_main = pthread_self();
+
+    // set the java vm
+    g_vm = &g_vm1;
+    by_jni_javavm_set(g_vm, JNI_VERSION_1_4);
+
+    // the failed Class.getDeclaredMethod() is not cached, so it will be retried by System.loadLibrary and the next loading
+    g_fail_getDeclaredMethod = by_true;
+    by_test_jni_load();
+    by_test_check(!g_loaded[0] && !g_pending);
+    by_test_check(g_calls[BY_TEST_JNI_CallObjectMethod] == 2);
+    g_fail_getDeclaredMethod = by_false;
+    by_test_jni_load();
+    by_test_check(!strcmp(g_loaded, BY_TEST_JNI_LIBPATH));
+    by_test_check(g_calls[BY_TEST_JNI_GetMethodID] == 1 && g_calls[BY_TEST_JNI_CallObjectMethod] == 3);
+    by_test_check(!g_calls[BY_TEST_JNI_GetJavaVM] && !g_calls[BY_TEST_JNI_GetStaticMethodID]);
+
+    // the next loadings use the cache
+    by_test_jni_load();
+    by_test_check(by_test_jni_check_cached());
+
+    // the cache is kept for the same java vm
+    by_jni_javavm_set(g_vm, JNI_VERSION_1_4);
+    by_test_jni_load();
+    by_test_check(by_test_jni_check_cached());
+
+    // the cache is dropped for the new java vm
+    g_vm = &g_vm2;
+    by_jni_javavm_set(g_vm, JNI_VERSION_1_4);
+    by_test_jni_load();
+    by_test_check(by_test_jni_check_first());
+    by_test_jni_load();
+    by_test_check(by_test_jni_check_cached());
+
+    // load it in the non-java threads
+    by_test_check(by_test_jni_workers());
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * main
+ */
+by_int_t main(by_int_t argc, by_char_t** argv)
+{
+    by_bool_t ok = by_test_jni();
+    printf("[%s] jni\n", ok? "ok" : "failed");
+    return ok? 0 : -1;
+}
@@ -0,0 +1,53 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        lines.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+
+// get the return address, it's in the line of the caller
+static __attribute__((noinline)) void* by_test_lines_pc(void)
+{
+    return __builtin_return_address(0);
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+void* by_test_lines_first(unsigned long* pline)
+{
+    // the call instruction is at the next line, and the barrier keeps it from being a tail call
+    *pline = __LINE__ + 1;
+    void* pc = by_test_lines_pc();
+    __asm__ __volatile__("" : "+r"(pc));
+    return pc;
+}
+void* by_test_lines_second(unsigned long* pline)
+{
+    void* pc = 0;
+    if (pline)
+    {
+        *pline = __LINE__ + 1;
+        pc = by_test_lines_pc();
+    }
+    __asm__ __volatile__("" : "+r"(pc));
+    return pc;
+}
@@ -0,0 +1,101 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the test case type
+typedef struct _by_test_case_t
+{
+    // the case name
+    by_char_t const*    name;
+
+    // the case function
+    by_bool_t           (*func)(by_char_t const* dir);
+
+}by_test_case_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the test cases
+static by_test_case_t   g_cases[] =
+{
+    {"zip",             by_test_zip             }
+,   {"tls",             by_test_tls             }
+,   {"remote",          by_test_remote          }
+,   {"macho",           by_test_macho           }
+,   {"macho_images",    by_test_macho_images    }
+,   {"backtrace",       by_test_backtrace       }
+,   {"compact",         by_test_compact         }
+,   {"libc",            by_test_libc            }
+,   {"dlshare",         by_test_dlshare         }
+,   {"dlnotify",        by_test_dlnotify        }
+,   {"addr2line",       by_test_addr2line       }
+};
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * main
+ */
+by_int_t main(by_int_t argc, by_char_t** argv)
+{
+    // parse arguments
+    by_char_t const* dir = "/tmp";
+    by_char_t const* name = by_null;
+    for (by_int_t i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else if (argv[i][0] != '-' && !name) name = argv[i];
+        else
+        {
+            printf("usage: %s [--dir tmpdir] [case]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    // run the given case or all cases
+    by_size_t run = 0;
+    by_size_t failed = 0;
+    for (by_size_t i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]); i++)
+    {
+        by_test_case_t const* test = &g_cases[i];
+        if (name && strcmp(name, test->name)) continue;
+
+        by_bool_t ok = test->func(dir);
+        printf("[%s] %s\n", ok? "ok" : "failed", test->name);
+        if (!ok) failed++;
+        run++;
+    }
+    if (!run)
+    {
+        printf("unknown case: %s\n", name);
+        return -1;
+    }
+    printf("%lu/%lu passed\n", (by_ulong_t)(run - failed), (by_ulong_t)run);
+    return failed? -1 : 0;
+}
@@ -0,0 +1,143 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test.h
+ *
+ */
+#ifndef BY_TEST_H
+#define BY_TEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "byopen.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// check the condition, report and fail the current test case if it's false
+#define by_test_check(x) \
+    do \
+    { \
+        if (!(x)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+            return by_false; \
+        } \
+    } while (0)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * interfaces
+ */
+
+/*! test the stored library entries of the zip archive, e.g. base.apk!/lib/arm64-v8a/libfoo.so
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_zip(by_char_t const* dir);
+
+/*! test the thread-local symbols of the test library in the main and new threads
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_tls(by_char_t const* dir);
+
+/*! test the library handles of the forked child process
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_remote(by_char_t const* dir);
+
+/*! test the mach-o parser with the thin, truncated and corrupted fixtures
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_macho(by_char_t const* dir);
+
+/*! test the image table with the stub image provider
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_macho_images(by_char_t const* dir);
+
+/*! test the backtrace and its symbols of the interrupted frame in the signal handler
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_backtrace(by_char_t const* dir);
+
+/*! test the full and compact handles of the library which has the local and global symbols with the same name
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_compact(by_char_t const* dir);
+
+/*! test the default, versioned and ifunc symbols of glibc against dlsym() and dlvsym()
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_libc(by_char_t const* dir);
+
+/*! test the shared symbol index in the forked child process and reject the unsealed memfd
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_dlshare(by_char_t const* dir);
+
+/*! test the library loaded listeners with the pending, loaded and canceled libraries
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_dlnotify(by_char_t const* dir);
+
+/*! test the source lines of the library with debug information and its copy with the truncated .debug_line
+ *
+ * @param dir       the temporary directory
+ *
+ * @return          by_true on success
+ */
+by_bool_t           by_test_addr2line(by_char_t const* dir);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,201 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_addr2line.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include <dlfcn.h>
+#include <link.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the test library name, it's built by the bytest_lines target with debug information in the same directory of the test program
+#define BY_TEST_ADDR2LINE_LIBNAME   "libbytest_lines.so"
+
+// the source file name of the test library
+#define BY_TEST_ADDR2LINE_SRCNAME   "lines.c"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the function type of the test library, it returns the calling address and its line
+typedef by_pointer_t (*by_test_addr2line_func_t)(by_ulong_t* pline);
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+
+// is it the source file of the test library?
+static by_bool_t by_test_addr2line_is_source(by_char_t const* file)
+{
+    by_size_t n = file? strlen(file) : 0;
+    by_size_t m = sizeof(BY_TEST_ADDR2LINE_SRCNAME) - 1;
+    return n >= m && !strcmp(file + n - m, BY_TEST_ADDR2LINE_SRCNAME) && (n == m || file[n - m - 1] == '/');
+}
+
+// get the calling addresses of the test library and their lines, the address is in the call instruction
+static by_bool_t by_test_addr2line_addrs(by_pointer_t syshandle, by_cpointer_t* addrs, by_size_t* lines)
+{
+    by_char_t const* names[] = {"by_test_lines_first", "by_test_lines_second"};
+    for (by_size_t i = 0; i < 2; i++)
+    {
+        by_ulong_t               line = 0;
+        by_test_addr2line_func_t func = (by_test_addr2line_func_t)dlsym(syshandle, names[i]);
+        by_byte_t const*         pc = func? (by_byte_t const*)func(&line) : by_null;
+        by_test_check(pc && line);
+        addrs[i] = pc - 1;
+        lines[i] = (by_size_t)line;
+    }
+    return by_true;
+}
+
+// check the lines of the test library
+static by_bool_t by_test_addr2line_check(by_pointer_t handle, by_pointer_t syshandle)
+{
+    by_cpointer_t addrs[2];
+    by_size_t     lines[2];
+    by_test_check(by_test_addr2line_addrs(syshandle, addrs, lines));
+
+    // find them one by one
+    for (by_size_t i = 0; i < 2; i++)
+    {
+        by_char_t const* file = by_null;
+        by_size_t        line = 0;
+        by_test_check(by_addr2line(handle, addrs[i], &file, &line));
+        by_test_check(by_test_addr2line_is_source(file) && line == lines[i]);
+    }
+
+    // find them in batch, the addresses are not sorted and the libc address is not in this library
+    by_cpointer_t    batch[3] = {addrs[1], (by_cpointer_t)&getpid, addrs[0]};
+    by_char_t const* files[3];
+    by_size_t        plines[3];
+    by_test_check(by_addr2line_batch(handle, batch, files, plines, 3) == 2);
+    by_test_check(by_test_addr2line_is_source(files[0]) && plines[0] == lines[1]);
+    by_test_check(!files[1] && !plines[1]);
+    by_test_check(by_test_addr2line_is_source(files[2]) && plines[2] == lines[0]);
+    return by_true;
+}
+
+// copy the test library and truncate its .debug_line section, the unit length will be out of the section
+static by_bool_t by_test_addr2line_truncate(by_char_t const* libpath, by_char_t const* outpath)
+{
+    // read the library
+    struct stat st;
+    by_test_check(!stat(libpath, &st) && st.st_size > (off_t)sizeof(ElfW(Ehdr)));
+    by_size_t  size = (by_size_t)st.st_size;
+    by_byte_t* data = malloc(size);
+    by_test_check(data);
+    by_int_t  fd = open(libpath, O_RDONLY);
+    by_bool_t ok = fd >= 0 && read(fd, data, size) == (ssize_t)size;
+    if (fd >= 0) close(fd);
+
+    // find .debug_line and truncate it in the section header
+    ElfW(Ehdr)* elf = (ElfW(Ehdr)*)data;
+    if (ok) ok = elf->e_shoff && elf->e_shentsize == sizeof(ElfW(Shdr)) && elf->e_shstrndx < elf->e_shnum
+        && elf->e_shoff + (by_size_t)elf->e_shnum * sizeof(ElfW(Shdr)) <= size;
+    ElfW(Shdr)* shdr = by_null;
+    if (ok)
+    {
+        ElfW(Shdr)* shdrs = (ElfW(Shdr)*)(data + elf->e_shoff);
+        ElfW(Shdr)* strs = shdrs + elf->e_shstrndx;
+        for (by_size_t i = 0; i < elf->e_shnum && !shdr; i++)
+        {
+            if (strs->sh_offset + shdrs[i].sh_name < size && !strcmp((by_char_t const*)data + strs->sh_offset + shdrs[i].sh_name, ".debug_line"))
+                shdr = shdrs + i;
+        }
+        ok = shdr && shdr->sh_size > 16;
+    }
+    if (ok) shdr->sh_size /= 2;
+
+    // write the copy
+    fd = ok? open(outpath, O_WRONLY | O_CREAT | O_TRUNC, 0755) : -1;
+    if (ok) ok = fd >= 0 && write(fd, data, size) == (ssize_t)size;
+    if (fd >= 0) close(fd);
+    free(data);
+    by_test_check(ok);
+    return by_true;
+}
+
+// the truncated line table cannot be parsed, so nothing is found
+static by_bool_t by_test_addr2line_check_truncated(by_char_t const* libpath)
+{
+    by_pointer_t syshandle = dlopen(libpath, RTLD_NOW);
+    by_test_check(syshandle);
+    by_pointer_t  handle = by_dlopen(libpath, BY_RTLD_NOW);
+    by_cpointer_t addrs[2];
+    by_size_t     lines[2];
+    by_bool_t     ok = handle && by_test_addr2line_addrs(syshandle, addrs, lines);
+    if (ok)
+    {
+        by_char_t const* file = by_null;
+        by_size_t        line = 0;
+        by_char_t const* files[2];
+        by_size_t        plines[2];
+        ok = !by_addr2line(handle, addrs[0], &file, &line) && !by_addr2line_batch(handle, addrs, files, plines, 2);
+        if (ok) ok = !files[0] && !files[1] && !plines[0] && !plines[1];
+    }
+    if (handle) by_dlclose(handle);
+    dlclose(syshandle);
+    by_test_check(ok);
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_addr2line(by_char_t const* dir)
+{
+    // get the test library path
+    by_char_t libpath[512];
+    ssize_t   size = readlink("/proc/self/exe", libpath, sizeof(libpath) - sizeof(BY_TEST_ADDR2LINE_LIBNAME));
+    by_test_check(size > 0);
+    libpath[size] = '\0';
+    by_char_t* p = strrchr(libpath, '/');
+    by_test_check(p);
+    strcpy(p + 1, BY_TEST_ADDR2LINE_LIBNAME);
+
+    // load it to maps first, because by_dlopen only finds the loaded libraries
+    by_pointer_t syshandle = dlopen(libpath, RTLD_NOW);
+    if (!syshandle) fprintf(stderr, "dlopen %s failed: %s\n", libpath, dlerror());
+    by_test_check(syshandle);
+    by_pointer_t handle = by_dlopen(libpath, BY_RTLD_NOW);
+    by_bool_t    ok = handle && by_test_addr2line_check(handle, syshandle);
+    if (handle) by_dlclose(handle);
+    dlclose(syshandle);
+    by_test_check(ok);
+
+    // check the copy with the truncated .debug_line
+    by_char_t brokenpath[256];
+    snprintf(brokenpath, sizeof(brokenpath), "%s/libbytest_lines_truncated.so", dir);
+    by_test_check(by_test_addr2line_truncate(libpath, brokenpath));
+    ok = by_test_addr2line_check_truncated(brokenpath);
+    unlink(brokenpath);
+    by_test_check(ok);
+    return by_true;
+}
@@ -0,0 +1,140 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_backtrace.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include <signal.h>
+#include <ucontext.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the max frame count
+#define BY_TEST_BACKTRACE_MAXN      (32)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * declaration
+ */
+
+#if defined(BY_ARCH_x64) || defined(BY_ARCH_ARM64)
+/* the trapped function starts with an undefined instruction and it's placed right after the previous function,
+ * so the interrupted pc will be attributed to the previous function if it's looked up by pc - 1.
+ */
+#   if defined(BY_ARCH_x64)
+#       define BY_TEST_BACKTRACE_TRAP   "ud2\n\t"
+#       define BY_TEST_BACKTRACE_RET    "ret\n\t"
+#       define BY_TEST_BACKTRACE_SKIP   (2)
+#   else
+#       define BY_TEST_BACKTRACE_TRAP   "udf #0\n\t"
+#       define BY_TEST_BACKTRACE_RET    "ret\n\t"
+#       define BY_TEST_BACKTRACE_SKIP   (4)
+#   endif
+__asm__(
+    ".text\n\t"
+    ".globl by_test_backtrace_prev\n\t"
+    ".type by_test_backtrace_prev, %function\n"
+    "by_test_backtrace_prev:\n\t"
+    ".cfi_startproc\n\t"
+    BY_TEST_BACKTRACE_RET
+    ".cfi_endproc\n\t"
+    ".size by_test_backtrace_prev, .-by_test_backtrace_prev\n\t"
+    ".globl by_test_backtrace_trap\n\t"
+    ".type by_test_backtrace_trap, %function\n"
+    "by_test_backtrace_trap:\n\t"
+    ".cfi_startproc\n\t"
+    BY_TEST_BACKTRACE_TRAP
+    BY_TEST_BACKTRACE_RET
+    ".cfi_endproc\n\t"
+    ".size by_test_backtrace_trap, .-by_test_backtrace_trap\n");
+by_void_t by_test_backtrace_trap(by_void_t);
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the captured frames of the signal handler
+static by_pointer_t g_pcs[BY_TEST_BACKTRACE_MAXN];
+static by_bool_t    g_exacts[BY_TEST_BACKTRACE_MAXN];
+static by_size_t    g_count = 0;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+#if defined(BY_ARCH_x64) || defined(BY_ARCH_ARM64)
+static by_void_t by_test_backtrace_handler(by_int_t sig, siginfo_t* info, by_pointer_t context)
+{
+    // capture the interrupted frames
+    g_count = by_backtrace_context(context, g_pcs, g_exacts, BY_TEST_BACKTRACE_MAXN);
+
+    // skip the undefined instruction
+    ucontext_t* uc = (ucontext_t*)context;
+#   if defined(BY_ARCH_x64)
+    uc->uc_mcontext.gregs[REG_RIP] += BY_TEST_BACKTRACE_SKIP;
+#   else
+    uc->uc_mcontext.pc += BY_TEST_BACKTRACE_SKIP;
+#   endif
+}
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_backtrace(by_char_t const* dir)
+{
+#if defined(BY_ARCH_x64) || defined(BY_ARCH_ARM64)
+    // make the module table before installing the signal handler
+    by_pointer_t pcs[BY_TEST_BACKTRACE_MAXN];
+    by_bool_t    exacts[BY_TEST_BACKTRACE_MAXN];
+    by_size_t    count = by_backtrace(pcs, exacts, BY_TEST_BACKTRACE_MAXN);
+    by_test_check(count > 1 && !exacts[0]);
+
+    // the return addresses are symbolized by pc - 1
+    by_char_t const* names[BY_TEST_BACKTRACE_MAXN];
+    by_test_check(by_backtrace_symbols(pcs, exacts, names, by_null, count) && names[0] && !strcmp(names[0], "by_test_backtrace"));
+
+    // trap it
+    struct sigaction act;
+    struct sigaction old;
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = by_test_backtrace_handler;
+    act.sa_flags     = SA_SIGINFO;
+    by_test_check(!sigaction(SIGILL, &act, &old));
+    by_test_backtrace_trap();
+    sigaction(SIGILL, &old, by_null);
+
+    // the interrupted pc is exact, and the caller is the return address
+    by_test_check(g_count > 1 && g_pcs[0] == (by_pointer_t)by_test_backtrace_trap && g_exacts[0] && !g_exacts[1]);
+
+    // the exact pc is symbolized as is
+    by_size_t offsets[BY_TEST_BACKTRACE_MAXN];
+    by_test_check(by_backtrace_symbols(g_pcs, g_exacts, names, offsets, g_count) >= 2);
+    by_test_check(names[0] && !strcmp(names[0], "by_test_backtrace_trap") && !offsets[0]);
+    by_test_check(names[1] && !strcmp(names[1], "by_test_backtrace"));
+
+    // it will be attributed to the previous function if all pcs are considered as the return addresses
+    by_test_check(by_backtrace_symbols(g_pcs, by_null, names, by_null, g_count) && names[0] && !strcmp(names[0], "by_test_backtrace_prev"));
+#endif
+    return by_true;
+}
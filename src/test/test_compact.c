@@ -0,0 +1,92 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_compact.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include <dlfcn.h>
+#include <unistd.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the test library name, it's built by the bytest_dup target in the same directory of the test program
+#define BY_TEST_COMPACT_LIBNAME "libbytest_dup.so"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the duplicate symbol names, each one has a global symbol and a local symbol in the test library
+static by_char_t const* g_names[] = {"by_test_dup_first", "by_test_dup_second"};
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_bool_t by_test_compact_check(by_pointer_t syshandle, by_pointer_t handle, by_pointer_t compact, by_pointer_t wanted)
+{
+    for (by_size_t i = 0; i < sizeof(g_names) / sizeof(g_names[0]); i++)
+    {
+        // the global symbol is found by the system dlsym
+        by_int_t* addr = (by_int_t*)dlsym(syshandle, g_names[i]);
+        by_test_check(addr && *addr == 2);
+
+        // the full and compact handles find the same global symbol instead of the local one
+        by_test_check(by_dlsym(handle, g_names[i]) == addr);
+        by_test_check(by_dlsym(compact, g_names[i]) == addr);
+        by_test_check(by_dlsym(wanted, g_names[i]) == addr);
+    }
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_compact(by_char_t const* dir)
+{
+    // get the test library path
+    by_char_t libpath[512];
+    ssize_t   size = readlink("/proc/self/exe", libpath, sizeof(libpath) - sizeof(BY_TEST_COMPACT_LIBNAME));
+    by_test_check(size > 0);
+    libpath[size] = '\0';
+    by_char_t* p = strrchr(libpath, '/');
+    by_test_check(p);
+    strcpy(p + 1, BY_TEST_COMPACT_LIBNAME);
+
+    // load it to maps first, because by_dlopen only finds the loaded libraries
+    by_pointer_t syshandle = dlopen(libpath, RTLD_NOW);
+    if (!syshandle) fprintf(stderr, "dlopen %s failed: %s\n", libpath, dlerror());
+    by_test_check(syshandle);
+
+    // open the full, compact and wanted compact handles
+    by_pointer_t handle = by_dlopen(libpath, BY_RTLD_NOW);
+    by_pointer_t compact = by_dlopen(libpath, BY_RTLD_NOW | BY_RTLD_COMPACT);
+    by_pointer_t wanted = by_dlopen_compact(libpath, BY_RTLD_NOW, g_names, sizeof(g_names) / sizeof(g_names[0]));
+    by_bool_t    ok = handle && compact && wanted && by_test_compact_check(syshandle, handle, compact, wanted);
+    if (handle) by_dlclose(handle);
+    if (compact) by_dlclose(compact);
+    if (wanted) by_dlclose(wanted);
+    dlclose(syshandle);
+    by_test_check(ok);
+    return by_true;
+}
@@ -0,0 +1,166 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_dlnotify.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include <dlfcn.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the test library name, it's built by the bytest_tls target in the same directory of the test program
+#define BY_TEST_DLNOTIFY_LIBNAME    "libbytest_tls.so"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the listener type
+typedef struct _by_test_dlnotify_t
+{
+    // the listener id
+    by_size_t               id;
+
+    // the call count
+    by_size_t               called;
+
+    // the callback has been entered? has it returned?
+    by_bool_t               entered;
+    by_bool_t               done;
+
+    // the result of cancelling it in the callback or the other thread
+    by_bool_t               canceled;
+
+}by_test_dlnotify_t, *by_test_dlnotify_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+
+// count the call, the handle must be the matched library
+static by_void_t by_test_dlnotify_count(by_pointer_t handle, by_char_t const* filename, by_pointer_t udata)
+{
+    by_test_dlnotify_ref_t test = (by_test_dlnotify_ref_t)udata;
+    by_char_t const*       basename = strrchr(filename, '/');
+    if (handle && basename && !strcmp(basename + 1, BY_TEST_DLNOTIFY_LIBNAME))
+        __atomic_add_fetch(&test->called, 1, __ATOMIC_RELEASE);
+}
+
+// cancel itself in the callback, it cannot wait itself
+static by_void_t by_test_dlnotify_cancel_self(by_pointer_t handle, by_char_t const* filename, by_pointer_t udata)
+{
+    by_test_dlnotify_ref_t test = (by_test_dlnotify_ref_t)udata;
+    test->canceled = by_dlnotify_cancel(test->id);
+    by_test_dlnotify_count(handle, filename, udata);
+}
+
+// the slow callback, it will be canceled by the other thread while it's running
+static by_void_t by_test_dlnotify_slow(by_pointer_t handle, by_char_t const* filename, by_pointer_t udata)
+{
+    by_test_dlnotify_ref_t test = (by_test_dlnotify_ref_t)udata;
+    __atomic_store_n(&test->entered, by_true, __ATOMIC_RELEASE);
+    usleep(100000);
+    by_test_dlnotify_count(handle, filename, udata);
+    __atomic_store_n(&test->done, by_true, __ATOMIC_RELEASE);
+}
+
+// cancel the slow listener after its callback has been entered, it must wait for the callback to return
+static by_pointer_t by_test_dlnotify_canceler(by_pointer_t priv)
+{
+    by_test_dlnotify_ref_t test = (by_test_dlnotify_ref_t)priv;
+    while (!__atomic_load_n(&test->entered, __ATOMIC_ACQUIRE)) usleep(1000);
+    test->canceled = by_dlnotify_cancel(test->id);
+    return (by_pointer_t)(by_size_t)__atomic_load_n(&test->done, __ATOMIC_ACQUIRE);
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_dlnotify(by_char_t const* dir)
+{
+    // get the test library path
+    by_char_t libpath[512];
+    ssize_t   size = readlink("/proc/self/exe", libpath, sizeof(libpath) - sizeof(BY_TEST_DLNOTIFY_LIBNAME));
+    by_test_check(size > 0);
+    libpath[size] = '\0';
+    by_char_t* p = strrchr(libpath, '/');
+    by_test_check(p);
+    strcpy(p + 1, BY_TEST_DLNOTIFY_LIBNAME);
+
+    // it has not been loaded yet, the tls test has unloaded it
+    by_test_check(!dlopen(libpath, RTLD_NOW | RTLD_NOLOAD));
+
+    // register the listeners before loading it, they are not called now
+    by_test_dlnotify_t pending, removed, self, slow;
+    memset(&pending, 0, sizeof(pending));
+    memset(&removed, 0, sizeof(removed));
+    memset(&self, 0, sizeof(self));
+    memset(&slow, 0, sizeof(slow));
+    pending.id = by_on_library_loaded(BY_TEST_DLNOTIFY_LIBNAME, by_test_dlnotify_count, &pending);
+    removed.id = by_on_library_loaded("libbytest_tls*", by_test_dlnotify_count, &removed);
+    self.id    = by_on_library_loaded(BY_TEST_DLNOTIFY_LIBNAME, by_test_dlnotify_cancel_self, &self);
+    slow.id    = by_on_library_loaded(libpath, by_test_dlnotify_slow, &slow);
+    by_test_check(pending.id && removed.id && self.id && slow.id);
+    by_test_check(!pending.called && !removed.called && !self.called && !slow.called);
+    by_dlnotify_poll();
+    by_test_check(!pending.called && !self.called && !slow.called);
+
+    // the pending listener can be canceled before being called
+    by_test_check(by_dlnotify_cancel(removed.id));
+    by_test_check(!by_dlnotify_cancel(removed.id));
+
+    // load it and cancel the slow listener in the other thread while it's being called
+    by_pointer_t syshandle = dlopen(libpath, RTLD_NOW);
+    if (!syshandle) fprintf(stderr, "dlopen %s failed: %s\n", libpath, dlerror());
+    by_test_check(syshandle);
+    pthread_t    thread;
+    by_pointer_t done = by_null;
+    by_bool_t    ok = !pthread_create(&thread, by_null, by_test_dlnotify_canceler, &slow);
+    by_size_t    notified = by_dlnotify_poll();
+    if (ok) pthread_join(thread, &done);
+    else by_dlnotify_cancel(slow.id);
+
+    // they are notified exactly once, and the canceled listener is never notified
+    if (ok) ok = notified == 3 && !by_dlnotify_poll();
+    if (ok) ok = pending.called == 1 && self.called == 1 && slow.called == 1 && !removed.called;
+
+    // they cannot be canceled in the callback or during the callback, the canceler has waited for the callback to return
+    if (ok) ok = !self.canceled && !slow.canceled && done;
+    if (ok) ok = !by_dlnotify_cancel(pending.id) && !by_dlnotify_cancel(self.id) && !by_dlnotify_cancel(slow.id);
+
+    // the listener of the loaded library is called immediately
+    by_test_dlnotify_t loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    if (ok)
+    {
+        loaded.id = by_on_library_loaded("libbytest_tls.*", by_test_dlnotify_count, &loaded);
+        ok = loaded.id && loaded.called == 1 && !by_dlnotify_poll() && loaded.called == 1;
+        if (ok) ok = !by_dlnotify_cancel(loaded.id);
+    }
+    dlclose(syshandle);
+    by_test_check(ok);
+    return by_true;
+}
@@ -0,0 +1,165 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_dlshare.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include "elfgen.h"
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the symbol count of the library
+#define BY_TEST_DLSHARE_SYMBOLS (1000)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_size_t by_test_dlshare_index(by_size_t i)
+{
+    return i == 0? 0 : (i == 1? BY_TEST_DLSHARE_SYMBOLS / 2 : BY_TEST_DLSHARE_SYMBOLS - 1);
+}
+
+// the child process, it opens the library with the inherited shared index and reports the symbol addresses
+static by_void_t by_test_dlshare_child(by_pointer_t share, by_char_t const* libpath, by_int_t fd)
+{
+    by_pointer_t addrs[3] = {by_null};
+    by_pointer_t handle = by_dlopen_shared(share, libpath, BY_RTLD_NOW);
+    if (handle)
+    {
+        by_char_t name[64];
+        for (by_size_t i = 0; i < 3; i++)
+            addrs[i] = by_dlsym(handle, by_elfgen_name(name, sizeof(name), by_true, by_test_dlshare_index(i)));
+        by_dlclose(handle);
+    }
+    _exit(write(fd, addrs, sizeof(addrs)) == sizeof(addrs)? 0 : 1);
+}
+
+// check the shared index of the child process
+static by_bool_t by_test_dlshare_fork(by_pointer_t share, by_char_t const* libpath, by_pointer_t const* wanted)
+{
+    // fork the child process
+    by_int_t fds[2];
+    by_test_check(!pipe(fds));
+    pid_t pid = fork();
+    if (!pid)
+    {
+        close(fds[0]);
+        by_test_dlshare_child(share, libpath, fds[1]);
+    }
+    close(fds[1]);
+
+    // get the addresses of the child process
+    by_pointer_t addrs[3] = {by_null};
+    by_bool_t    ok = pid > 0 && read(fds[0], addrs, sizeof(addrs)) == sizeof(addrs);
+    close(fds[0]);
+    if (pid > 0) waitpid(pid, by_null, 0);
+    for (by_size_t i = 0; i < 3 && ok; i++)
+        ok = addrs[i] && addrs[i] == wanted[i];
+    by_test_check(ok);
+    return by_true;
+}
+
+// the unsealed copy of the shared index must be rejected
+static by_bool_t by_test_dlshare_unsealed(by_int_t fd)
+{
+#ifdef __NR_memfd_create
+    // read the sealed data
+    struct stat st;
+    by_test_check(!fstat(fd, &st) && st.st_size > 0);
+    by_byte_t* data = malloc((by_size_t)st.st_size);
+    by_test_check(data);
+    by_bool_t ok = pread(fd, data, (by_size_t)st.st_size, 0) == st.st_size;
+
+    // copy it to the unsealed memfd
+    by_int_t copy = ok? (by_int_t)syscall(__NR_memfd_create, "bytest-dlshare", 0) : -1;
+    if (copy >= 0)
+    {
+        ok = write(copy, data, (by_size_t)st.st_size) == st.st_size;
+        if (ok) ok = !by_dlshare_attach(copy);
+        close(copy);
+    }
+    free(data);
+    by_test_check(ok);
+#endif
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_dlshare(by_char_t const* dir)
+{
+    // generate and load the library, by_dlshare_init() only finds the loaded libraries
+    by_char_t libpath[256];
+    snprintf(libpath, sizeof(libpath), "%s/libbytest_dlshare.so", dir);
+    by_test_check(by_elfgen_make(libpath, BY_TEST_DLSHARE_SYMBOLS, BY_TEST_DLSHARE_SYMBOLS));
+    by_pointer_t syshandle = dlopen(libpath, RTLD_NOW);
+    if (!syshandle) unlink(libpath);
+    by_test_check(syshandle);
+
+    by_bool_t    ok = by_false;
+    by_pointer_t share = by_null;
+    by_pointer_t attached = by_null;
+    do
+    {
+        // get the wanted addresses
+        by_char_t        name[64];
+        by_pointer_t     wanted[3] = {by_null};
+        by_char_t const* filenames[] = {libpath};
+        for (by_size_t i = 0; i < 3; i++)
+            wanted[i] = dlsym(syshandle, by_elfgen_name(name, sizeof(name), by_true, by_test_dlshare_index(i)));
+        if (!wanted[0] || !wanted[1] || !wanted[2]) break;
+
+        // build the shared index and check it in the child process
+        share = by_dlshare_init(filenames, 1);
+        if (!share || !by_test_dlshare_fork(share, libpath, wanted)) break;
+
+        // the sealed memfd can be attached, but its unsealed copy cannot
+        by_int_t fd = by_dlshare_fd(share);
+        if (fd >= 0)
+        {
+            attached = by_dlshare_attach(fd);
+            if (!attached || !by_test_dlshare_fork(attached, libpath, wanted)) break;
+            if (!by_test_dlshare_unsealed(fd)) break;
+        }
+
+        // ok
+        ok = by_true;
+
+    } while (0);
+
+    // exit
+    if (attached) by_dlshare_exit(attached);
+    if (share) by_dlshare_exit(share);
+    dlclose(syshandle);
+    unlink(libpath);
+    by_test_check(ok);
+    return by_true;
+}
@@ -0,0 +1,118 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_libc.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include <dlfcn.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the libc symbol type
+typedef struct _by_test_libc_sym_t
+{
+    // the symbol name
+    by_char_t const*        name;
+
+    // the default and the old versions, they are null if we need not test the versioned lookup on this arch
+    by_char_t const*        versions[2];
+
+}by_test_libc_sym_t;
+
+// the memcpy function type
+typedef by_pointer_t        (*by_test_libc_memcpy_t)(by_pointer_t, by_cpointer_t, size_t);
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the versioned symbols of glibc, memcpy is an ifunc symbol and the others have the old compatible versions
+#if defined(BY_ARCH_x64)
+static by_test_libc_sym_t   g_syms[] =
+{
+    {"realpath",            {"GLIBC_2.3",   "GLIBC_2.2.5"}}
+,   {"pthread_cond_wait",   {"GLIBC_2.3.2", "GLIBC_2.2.5"}}
+,   {"sched_setaffinity",   {"GLIBC_2.3.4", "GLIBC_2.3.3"}}
+,   {"memcpy",              {"GLIBC_2.14",  "GLIBC_2.2.5"}}
+};
+#else
+static by_test_libc_sym_t   g_syms[] =
+{
+    {"realpath",            {by_null,       by_null}}
+,   {"pthread_cond_wait",   {by_null,       by_null}}
+,   {"sched_setaffinity",   {by_null,       by_null}}
+,   {"memcpy",              {by_null,       by_null}}
+};
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+#ifdef __GLIBC__
+static by_bool_t by_test_libc_check(by_pointer_t syshandle, by_pointer_t handle)
+{
+    for (by_size_t i = 0; i < sizeof(g_syms) / sizeof(g_syms[0]); i++)
+    {
+        // the default lookup, the ifunc symbol need be resolved to the implementation
+        by_test_libc_sym_t const* sym = &g_syms[i];
+        by_pointer_t              addr = dlsym(syshandle, sym->name);
+        by_test_check(addr && by_dlsym(handle, sym->name) == addr);
+
+        // the versioned lookups
+        for (by_size_t j = 0; j < 2 && sym->versions[j]; j++)
+        {
+            addr = dlvsym(syshandle, sym->name, sym->versions[j]);
+            by_test_check(addr && by_dlvsym(handle, sym->name, sym->versions[j]) == addr);
+        }
+    }
+
+    // the resolved memcpy can be called
+    by_char_t             data[16];
+    by_test_libc_memcpy_t func = (by_test_libc_memcpy_t)by_dlsym(handle, "memcpy");
+    by_test_check(func && func(data, "hello byopen", 13) == data && !strcmp(data, "hello byopen"));
+    return by_true;
+}
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_libc(by_char_t const* dir)
+{
+#ifdef __GLIBC__
+    // the libc has been loaded
+    by_pointer_t syshandle = dlopen("libc.so.6", RTLD_NOW | RTLD_NOLOAD);
+    by_test_check(syshandle);
+
+    // check the full and compact handles
+    by_pointer_t handle = by_dlopen("libc.so.6", BY_RTLD_NOW);
+    by_pointer_t compact = by_dlopen("libc.so.6", BY_RTLD_NOW | BY_RTLD_COMPACT);
+    by_bool_t    ok = handle && compact && by_test_libc_check(syshandle, handle) && by_test_libc_check(syshandle, compact);
+    if (handle) by_dlclose(handle);
+    if (compact) by_dlclose(compact);
+    dlclose(syshandle);
+    by_test_check(ok);
+#endif
+    return by_true;
+}
@@ -0,0 +1,244 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_macho.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include "byopen_macho_image.h"
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the mach-o fixtures directory
+#ifndef BY_TEST_FIXTURES
+#   define BY_TEST_FIXTURES         "fixtures"
+#endif
+
+// the max lookup count of each fixture
+#define BY_TEST_MACHO_LOOKUP_MAXN   (8)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the symbol lookup type
+typedef struct _by_test_macho_lookup_t
+{
+    // the symbol name
+    by_char_t const*        symbol;
+
+    // the expected address of by_macho_image_dlsym()
+    by_ulong_t              addr;
+
+    // the expected address of by_macho_image_dlsym_export()
+    by_ulong_t              exported;
+
+}by_test_macho_lookup_t;
+
+// the fixture type
+typedef struct _by_test_macho_fixture_t
+{
+    // the file name
+    by_char_t const*        filename;
+
+    // can be inited?
+    by_bool_t               inited;
+
+    // the expected nlist symbol count
+    by_uint32_t             symbols_num;
+
+    // has the export trie?
+    by_bool_t               trie;
+
+    // the lookups
+    by_test_macho_lookup_t  lookups[BY_TEST_MACHO_LOOKUP_MAXN];
+
+}by_test_macho_fixture_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+/* the fixtures, see fixtures/macho/README.md
+ *
+ * the exported symbols are found from the export trie first, and the local and private extern symbols from the nlist hash table.
+ */
+static by_test_macho_fixture_t g_fixtures[] =
+{
+    {   "x86_64", by_true, 4, by_true
+    ,   {   {"_main",                           0x100000f60,    0x100000f60 }
+        ,   {"main",                            0x100000f60,    0x100000f60 }
+        ,   {"__mh_execute_header",             0x100000000,    0x100000000 }
+        ,   {"_printf",                         0,              0           }}}
+,   {   "x86_64_nlist", by_true, 11, by_false
+    ,   {   {"_main",                           0x100000f6a,    0           }
+        ,   {"_NXArgc",                         0x100001018,    0           }
+        ,   {"dyld_stub_binding_helper",        0x100000f50,    0           }
+        ,   {"_exit",                           0,              0           }}}
+,   {   "i386", by_true, 12, by_false
+    ,   {   {"_main",                           0x1fca,         0           }
+        ,   {"_NXArgc",                         0x200c,         0           }
+        ,   {"dyld__mach_header",               0x2010,         0           }
+        ,   {"_exit",                           0,              0           }}}
+,   {   "arm64.dylib", by_true, 8, by_true
+    ,   {   {"_by_fixture_add",                 0x800,          0x800       }
+        ,   {"by_fixture_sub",                  0x808,          0x808       }
+        ,   {"__ZN6byopen7fixture4funcEv",      0x828,          0x828       }
+        ,   {"_by_fixture_abs",                 0x1234,         0x1234      }
+        ,   {"_by_fixture_hidden",              0x818,          0           }
+        ,   {"_by_fixture_local",               0x820,          0           }
+        ,   {"_by_fixture_tls",                 0,              0           }
+        ,   {"_by_fixture_reexport",            0,              0           }}}
+,   {   "x86_64_truncated_header", by_false, 0, by_false, {{0}}}
+,   {   "x86_64_truncated_cmds", by_false, 0, by_false, {{0}}}
+,   {   "x86_64_nlist_misaligned_symtab", by_true, 0, by_false
+    ,   {   {"_main",                           0,              0           }}}
+,   {   "arm64_truncated_linkedit.dylib", by_true, 0, by_true
+    ,   {   {"_by_fixture_add",                 0x800,          0x800       }
+        ,   {"_by_fixture_local",               0,              0           }}}
+,   {   "arm64_corrupted_trie.dylib", by_true, 8, by_true
+    ,   {   {"_by_fixture_add",                 0x800,          0           }
+        ,   {"_by_fixture_main",                0x810,          0           }
+        ,   {"_by_fixture_local",               0x820,          0           }
+        ,   {"_by_fixture_tls",                 0,              0           }}}
+,   {   "arm64_corrupted_trie_range.dylib", by_true, 8, by_false
+    ,   {   {"_by_fixture_add",                 0x800,          0           }
+        ,   {"_by_fixture_local",               0x820,          0           }}}
+,   {   "arm64_corrupted_nlist.dylib", by_true, 8, by_true
+    ,   {   {"_by_fixture_add",                 0x800,          0x800       }
+        ,   {"_by_fixture_local",               0x820,          0           }}}
+,   {   "arm64_corrupted_cmds.dylib", by_true, 0, by_false
+    ,   {   {"_by_fixture_add",                 0,              0           }}}
+,   {   "i386_corrupted_symtab", by_true, 0, by_false
+    ,   {   {"_main",                           0,              0           }}}
+};
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_byte_t* by_test_macho_read(by_char_t const* filename, by_size_t* psize)
+{
+    by_char_t filepath[512];
+    snprintf(filepath, sizeof(filepath), "%s/macho/%s", BY_TEST_FIXTURES, filename);
+    FILE* fp = fopen(filepath, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "open %s failed!\n", filepath);
+        return by_null;
+    }
+
+    // read it to the buffer with the exact size, so the overreads can be detected by the address sanitizer
+    fseek(fp, 0, SEEK_END);
+    by_size_t  size = (by_size_t)ftell(fp);
+    by_byte_t* data = (by_byte_t*)malloc(size);
+    fseek(fp, 0, SEEK_SET);
+    if (data && fread(data, 1, size, fp) != size)
+    {
+        free(data);
+        data = by_null;
+    }
+    fclose(fp);
+    *psize = size;
+    return data;
+}
+static by_bool_t by_test_macho_fixture(by_test_macho_fixture_t const* fixture, by_byte_t const* data, by_size_t size)
+{
+    // init image
+    by_macho_image_t image;
+    by_bool_t        inited = by_macho_image_init(&image, data, size, 0);
+    by_test_check(inited == fixture->inited);
+    by_check_return_val(inited, by_true);
+
+    // the out-of-range symtab and export trie are dropped
+    by_bool_t ok = image.symbols_num == fixture->symbols_num && (image.trie != by_null) == fixture->trie;
+    for (by_size_t i = 0; i < BY_TEST_MACHO_LOOKUP_MAXN && ok && fixture->lookups[i].symbol; i++)
+    {
+        by_test_macho_lookup_t const* lookup = &fixture->lookups[i];
+        by_ulong_t addr = (by_ulong_t)by_macho_image_dlsym(&image, lookup->symbol);
+        by_ulong_t exported = (by_ulong_t)by_macho_image_dlsym_export(&image, lookup->symbol);
+        if (addr != lookup->addr || exported != lookup->exported)
+        {
+            fprintf(stderr, "%s: %s: %lx (%lx), exported %lx (%lx)\n", fixture->filename, lookup->symbol, addr, lookup->addr, exported, lookup->exported);
+            ok = by_false;
+        }
+    }
+    by_macho_image_exit(&image);
+    by_test_check(ok);
+    return by_true;
+}
+
+// the nlist value of _by_fixture_add is changed, but the export trie is walked first
+static by_bool_t by_test_macho_corrupted_nlist(by_byte_t const* data, by_size_t size)
+{
+    by_macho_image_t image;
+    by_test_check(by_macho_image_init(&image, data, size, 0));
+    by_ulong_t       value = 0;
+    by_char_t const* name = by_macho_image_symbol(&image, 3, by_null, &value);
+    by_bool_t        ok = name && !strcmp(name, "_by_fixture_add") && value == 0x7777;
+    by_macho_image_exit(&image);
+    by_test_check(ok);
+    return by_true;
+}
+
+// all truncated images must be rejected or parsed in bounds
+static by_void_t by_test_macho_truncate(by_byte_t const* data, by_size_t size)
+{
+    for (by_size_t n = 1; n < size; n += 7)
+    {
+        by_byte_t* copy = (by_byte_t*)malloc(n);
+        memcpy(copy, data, n);
+        by_macho_image_t image;
+        if (by_macho_image_init(&image, copy, n, 0))
+        {
+            by_macho_image_dlsym(&image, "_by_fixture_add");
+            by_macho_image_dlsym(&image, "_by_fixture_local");
+            by_macho_image_dlsym(&image, "_main");
+            by_macho_image_exit(&image);
+        }
+        free(copy);
+    }
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_macho(by_char_t const* dir)
+{
+    by_bool_t ok = by_true;
+    for (by_size_t i = 0; i < sizeof(g_fixtures) / sizeof(g_fixtures[0]); i++)
+    {
+        by_test_macho_fixture_t const* fixture = &g_fixtures[i];
+        by_size_t  size = 0;
+        by_byte_t* data = by_test_macho_read(fixture->filename, &size);
+        if (!data)
+        {
+            ok = by_false;
+            continue;
+        }
+        if (!by_test_macho_fixture(fixture, data, size)) ok = by_false;
+        if (!strcmp(fixture->filename, "arm64_corrupted_nlist.dylib") && !by_test_macho_corrupted_nlist(data, size)) ok = by_false;
+        if (fixture->inited) by_test_macho_truncate(data, size);
+        free(data);
+    }
+    return ok;
+}
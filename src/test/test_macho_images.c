@@ -0,0 +1,250 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_macho_images.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include "byopen_macho_images.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the generated image count, it's enough to grow the initial buckets several times
+#define BY_TEST_MACHO_IMAGES_GENN   (600)
+
+// the fixed image count
+#define BY_TEST_MACHO_IMAGES_FIXN   (8)
+
+// the max image count
+#define BY_TEST_MACHO_IMAGES_MAXN   (BY_TEST_MACHO_IMAGES_FIXN + BY_TEST_MACHO_IMAGES_GENN + 1)
+
+// the thread count of racing on init
+#define BY_TEST_MACHO_IMAGES_THREADS (2)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the stub image type, it starts with the fields of the mach header
+typedef struct _by_test_macho_images_stub_t
+{
+    by_uint32_t             magic;
+    by_int32_t              cputype;
+    by_int32_t              cpusubtype;
+    by_uint32_t             filetype;
+
+    // the image path
+    by_char_t               path[64];
+
+}by_test_macho_images_stub_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the stub images, they are loaded in order
+static by_test_macho_images_stub_t  g_stubs[BY_TEST_MACHO_IMAGES_MAXN];
+static by_size_t                    g_stubs_num = 0;
+
+// the registered callbacks
+static by_macho_images_func_t       g_stub_add = by_null;
+static by_macho_images_func_t       g_stub_remove = by_null;
+
+// the delay of adding each existing image in microseconds, it makes the racing init threads overlap
+static by_uint_t                    g_stub_delay = 0;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+
+// the stub provider, the add callback is called for all existing images at once like dyld
+static by_void_t by_test_macho_images_register_add(by_macho_images_func_t func)
+{
+    g_stub_add = func;
+    for (by_size_t i = 0; i < g_stubs_num; i++)
+    {
+        func((struct mach_header const*)&g_stubs[i], (by_long_t)(i << 12));
+        if (g_stub_delay) usleep(g_stub_delay);
+    }
+}
+static by_void_t by_test_macho_images_register_remove(by_macho_images_func_t func)
+{
+    g_stub_remove = func;
+}
+static by_char_t const* by_test_macho_images_path(struct mach_header const* header)
+{
+    return ((by_test_macho_images_stub_t const*)header)->path;
+}
+static by_macho_images_provider_t const g_provider =
+{
+    by_test_macho_images_register_add
+,   by_test_macho_images_register_remove
+,   by_test_macho_images_path
+};
+
+// make a stub image
+static by_test_macho_images_stub_t* by_test_macho_images_make(by_uint32_t filetype, by_char_t const* path)
+{
+    by_test_macho_images_stub_t* stub = &g_stubs[g_stubs_num++];
+    stub->magic    = 0xfeedfacf;
+    stub->filetype = filetype;
+    snprintf(stub->path, sizeof(stub->path), "%s", path);
+    return stub;
+}
+
+// find the stub image by the given name
+static by_test_macho_images_stub_t* by_test_macho_images_find(by_char_t const* name)
+{
+    struct mach_header const* header = by_null;
+    return by_macho_images_find(name, &header, by_null)? (by_test_macho_images_stub_t*)header : by_null;
+}
+
+// the racing init thread, all existing images must have been added after init returns
+static by_pointer_t by_test_macho_images_race(by_pointer_t udata)
+{
+    by_bool_t ok = by_macho_images_init(&g_provider);
+    if (ok) ok = by_macho_images_count() == g_stubs_num - 1;
+    if (ok) ok = by_test_macho_images_find("UIKit") == &g_stubs[1];
+    if (ok) ok = by_test_macho_images_find(g_stubs[g_stubs_num - 1].path) == &g_stubs[g_stubs_num - 1];
+    return (by_pointer_t)(by_size_t)ok;
+}
+
+// init it in the racing threads
+static by_bool_t by_test_macho_images_init_race()
+{
+    by_size_t i = 0;
+    by_bool_t ok = by_true;
+    pthread_t threads[BY_TEST_MACHO_IMAGES_THREADS];
+    g_stub_delay = 100;
+    for (i = 0; i < BY_TEST_MACHO_IMAGES_THREADS; i++)
+    {
+        if (pthread_create(&threads[i], by_null, by_test_macho_images_race, by_null)) break;
+    }
+    by_size_t count = i;
+    for (i = 0; i < count; i++)
+    {
+        by_pointer_t result = by_null;
+        pthread_join(threads[i], &result);
+        if (!result) ok = by_false;
+    }
+    g_stub_delay = 0;
+    by_test_check(ok && count == BY_TEST_MACHO_IMAGES_THREADS);
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_macho_images(by_char_t const* dir)
+{
+    // make the fixed images, "libAb" and "libBA" have the same hash
+    g_stubs_num = 0;
+    by_test_macho_images_make(0x2, "/var/app/Main.app/Main");
+    by_test_macho_images_make(0x6, "/System/Library/Frameworks/UIKit.framework/UIKit");
+    by_test_macho_images_make(0x6, "/usr/lib/libz.1.dylib");
+    by_test_macho_images_make(0x6, "/System/Library/Frameworks/Foo.framework/Versions/A/Foo");
+    by_test_macho_images_make(0x6, "/System/Library/PrivateFrameworks/Bar.framework/Bar_debug");
+    by_test_macho_images_make(0x6, "/other/libz.1.dylib");
+    by_test_macho_images_make(0x6, "/usr/lib/libAb.dylib");
+    by_test_macho_images_make(0x6, "/usr/lib/libBA.dylib");
+
+    // make the generated images
+    for (by_size_t i = 0; i < BY_TEST_MACHO_IMAGES_GENN; i++)
+    {
+        by_char_t path[64];
+        snprintf(path, sizeof(path), "/usr/lib/libgen%lu.dylib", (by_ulong_t)i);
+        by_test_macho_images_make(0x6, path);
+    }
+
+    // init it twice, the second call is ignored
+    by_test_check(by_macho_images_init(&g_provider));
+    by_test_check(by_macho_images_init(&g_provider));
+    by_test_check(g_stub_add && g_stub_remove);
+
+    // the main executable is not indexed
+    by_test_check(by_macho_images_count() == g_stubs_num - 1);
+    by_test_check(!by_test_macho_images_find("/var/app/Main.app/Main") && !by_test_macho_images_find("Main"));
+
+    // find it by the full path, basename and framework name
+    by_test_check(by_test_macho_images_find("UIKit") == &g_stubs[1]);
+    by_test_check(by_test_macho_images_find("/System/Library/Frameworks/UIKit.framework/UIKit") == &g_stubs[1]);
+    by_test_check(by_test_macho_images_find("Foo") == &g_stubs[3]);
+    by_test_check(by_test_macho_images_find("Bar") == &g_stubs[4] && by_test_macho_images_find("Bar_debug") == &g_stubs[4]);
+    by_test_check(!by_test_macho_images_find("UIKi") && !by_test_macho_images_find("libz") && !by_test_macho_images_find("Frameworks"));
+
+    // the first loaded image is found for the same basename
+    by_test_check(by_test_macho_images_find("libz.1.dylib") == &g_stubs[2]);
+    by_test_check(by_test_macho_images_find("/other/libz.1.dylib") == &g_stubs[5]);
+
+    // the keys with the same hash are still distinguished
+    by_test_check(by_test_macho_images_find("libAb.dylib") == &g_stubs[6]);
+    by_test_check(by_test_macho_images_find("libBA.dylib") == &g_stubs[7]);
+    by_test_check(by_test_macho_images_find("/usr/lib/libBA.dylib") == &g_stubs[7]);
+
+    // all generated images are found after the buckets have been grown
+    for (by_size_t i = 0; i < BY_TEST_MACHO_IMAGES_GENN; i++)
+    {
+        by_test_macho_images_stub_t* stub = &g_stubs[BY_TEST_MACHO_IMAGES_FIXN + i];
+        by_test_check(by_test_macho_images_find(strrchr(stub->path, '/') + 1) == stub);
+        by_test_check(by_test_macho_images_find(stub->path) == stub);
+    }
+
+    // the vmaddr slide is returned
+    struct mach_header const* header = by_null;
+    by_long_t                 slide = 0;
+    by_test_check(by_macho_images_find("libgen7.dylib", &header, &slide));
+    by_test_check(slide == (by_long_t)((BY_TEST_MACHO_IMAGES_FIXN + 7) << 12));
+
+    // remove the first libz, the other one is found by the basename now
+    g_stub_remove((struct mach_header const*)&g_stubs[2], 0);
+    by_test_check(by_test_macho_images_find("libz.1.dylib") == &g_stubs[5]);
+    by_test_check(!by_test_macho_images_find("/usr/lib/libz.1.dylib"));
+
+    // remove one of the colliding keys
+    g_stub_remove((struct mach_header const*)&g_stubs[6], 0);
+    by_test_check(!by_test_macho_images_find("libAb.dylib") && by_test_macho_images_find("libBA.dylib") == &g_stubs[7]);
+
+    // the new loaded image is indexed by the add callback
+    by_test_macho_images_stub_t* stub = by_test_macho_images_make(0x6, "/System/Library/Frameworks/New.framework/New");
+    g_stub_add((struct mach_header const*)stub, 0);
+    by_test_check(by_test_macho_images_find("New") == stub);
+
+    // remove all generated images
+    for (by_size_t i = 0; i < BY_TEST_MACHO_IMAGES_GENN; i++)
+        g_stub_remove((struct mach_header const*)&g_stubs[BY_TEST_MACHO_IMAGES_FIXN + i], 0);
+    by_test_check(by_macho_images_count() == BY_TEST_MACHO_IMAGES_FIXN - 2 && !by_test_macho_images_find("libgen1.dylib"));
+    by_test_check(by_test_macho_images_find("UIKit") == &g_stubs[1]);
+
+    // the images are ignored after exiting
+    by_macho_images_exit();
+    by_test_check(!by_macho_images_count() && !by_test_macho_images_find("UIKit"));
+    g_stub_add((struct mach_header const*)&g_stubs[1], 0);
+    by_test_check(!by_test_macho_images_find("UIKit"));
+
+    // init it again in the racing threads, the later one cannot find the images before they are added
+    by_test_check(by_test_macho_images_init_race());
+    by_macho_images_exit();
+    return by_true;
+}
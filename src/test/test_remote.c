@@ -0,0 +1,187 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_remote.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include "elfgen.h"
+#include <dlfcn.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/auxv.h>
+#include <sys/wait.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the symbol count of the library
+#define BY_TEST_REMOTE_SYMBOLS  (1000)
+
+// the vdso symbol name
+#if defined(BY_ARCH_ARM64)
+#   define BY_TEST_REMOTE_VDSO  "__kernel_clock_gettime"
+#else
+#   define BY_TEST_REMOTE_VDSO  "__vdso_clock_gettime"
+#endif
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the addresses in the child process
+typedef struct _by_test_remote_addrs_t
+{
+    // the first, middle and last exported symbols of the library
+    by_pointer_t            exports[3];
+
+    // the vdso header
+    by_pointer_t            vdso;
+
+    // the libc symbol
+    by_pointer_t            getppid;
+
+}by_test_remote_addrs_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_size_t by_test_remote_index(by_size_t i)
+{
+    return i == 0? 0 : (i == 1? BY_TEST_REMOTE_SYMBOLS / 2 : BY_TEST_REMOTE_SYMBOLS - 1);
+}
+
+// the child process, it loads the library and reports the symbol addresses
+static by_void_t by_test_remote_child(by_char_t const* libpath, by_int_t fd)
+{
+    by_test_remote_addrs_t addrs;
+    memset(&addrs, 0, sizeof(addrs));
+    by_pointer_t handle = dlopen(libpath, RTLD_NOW);
+    if (handle)
+    {
+        by_char_t name[64];
+        for (by_size_t i = 0; i < 3; i++)
+            addrs.exports[i] = dlsym(handle, by_elfgen_name(name, sizeof(name), by_true, by_test_remote_index(i)));
+    }
+    addrs.vdso = (by_pointer_t)getauxval(AT_SYSINFO_EHDR);
+    addrs.getppid = dlsym(RTLD_DEFAULT, "getppid");
+    if (write(fd, &addrs, sizeof(addrs)) != sizeof(addrs)) _exit(1);
+
+    // wait to be killed
+    while (1) pause();
+}
+
+// check the library handle of the child process
+static by_bool_t by_test_remote_check(by_int_t pid, by_char_t const* libpath, by_int_t flag, by_test_remote_addrs_t const* addrs)
+{
+    by_pointer_t handle = by_dlopen_remote(pid, libpath, flag);
+    by_test_check(handle);
+
+    // lookup a batch of symbols with a missing symbol
+    by_char_t        names[4][64];
+    by_char_t const* symbols[4];
+    by_pointer_t     results[4];
+    for (by_size_t i = 0; i < 3; i++)
+        symbols[i] = by_elfgen_name(names[i], sizeof(names[i]), by_true, by_test_remote_index(i));
+    symbols[3] = "by_test_remote_missing";
+    by_size_t found = by_dlsym_remote(handle, symbols, results, 4);
+    by_bool_t ok = found == 3 && !results[3];
+    for (by_size_t i = 0; i < 3 && ok; i++)
+        ok = results[i] && results[i] == addrs->exports[i];
+
+    // the single lookup returns the remote address too
+    if (ok) ok = by_dlsym(handle, symbols[1]) == addrs->exports[1];
+    by_dlclose(handle);
+    by_test_check(ok);
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_remote(by_char_t const* dir)
+{
+    // generate the library, it's only loaded by the child process
+    by_char_t libpath[256];
+    snprintf(libpath, sizeof(libpath), "%s/libbytest_remote.so", dir);
+    by_test_check(by_elfgen_make(libpath, BY_TEST_REMOTE_SYMBOLS, BY_TEST_REMOTE_SYMBOLS));
+
+    // fork the child process
+    by_int_t fds[2];
+    by_test_check(!pipe(fds));
+    pid_t pid = fork();
+    if (!pid)
+    {
+        close(fds[0]);
+        by_test_remote_child(libpath, fds[1]);
+    }
+    close(fds[1]);
+
+    by_bool_t ok = by_false;
+    do
+    {
+        // get the addresses of the child process
+        by_test_remote_addrs_t addrs;
+        if (pid < 0 || read(fds[0], &addrs, sizeof(addrs)) != sizeof(addrs)) break;
+        if (!addrs.exports[0] || !addrs.getppid) break;
+
+        // check the full and compact handles
+        if (!by_test_remote_check(pid, libpath, BY_RTLD_NOW, &addrs)) break;
+        if (!by_test_remote_check(pid, libpath, BY_RTLD_COMPACT, &addrs)) break;
+
+        // check the libc of the child process
+        by_pointer_t handle = by_dlopen_remote(pid, "libc.so.6", BY_RTLD_NOW);
+        if (!handle) break;
+        by_pointer_t getppid_addr = by_dlsym(handle, "getppid");
+        by_dlclose(handle);
+        if (getppid_addr != addrs.getppid) break;
+
+        // check the vdso, it's read from the memory of the child process
+        if (addrs.vdso)
+        {
+            handle = by_dlopen_remote(pid, "[vdso]", BY_RTLD_NOW);
+            if (!handle) break;
+            by_byte_t* clock_gettime_addr = (by_byte_t*)by_dlsym(handle, BY_TEST_REMOTE_VDSO);
+            by_dlclose(handle);
+            if (clock_gettime_addr <= (by_byte_t*)addrs.vdso || clock_gettime_addr >= (by_byte_t*)addrs.vdso + 0x10000) break;
+        }
+
+        // the library is not loaded in the child process
+        if (by_dlopen_remote(pid, "libbytest_remote_missing.so", BY_RTLD_NOW)) break;
+
+        // ok
+        ok = by_true;
+
+    } while (0);
+
+    // kill the child process, it cannot be opened after it exited
+    close(fds[0]);
+    if (pid > 0)
+    {
+        kill(pid, SIGKILL);
+        waitpid(pid, by_null, 0);
+        if (ok && by_dlopen_remote(pid, libpath, BY_RTLD_NOW)) ok = by_false;
+    }
+    unlink(libpath);
+    by_test_check(ok);
+    return by_true;
+}
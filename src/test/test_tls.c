@@ -0,0 +1,153 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_tls.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include <dlfcn.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the test library name, it's built by the bytest_tls target in the same directory of the test program
+#define BY_TEST_TLS_LIBNAME     "libbytest_tls.so"
+
+// the thread count
+#define BY_TEST_TLS_THREADS     (4)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the tls test context type
+typedef struct _by_test_tls_t
+{
+    // the byopen and system handles
+    by_pointer_t            handle;
+    by_pointer_t            syshandle;
+
+    // the thread index
+    by_size_t               index;
+
+}by_test_tls_t, *by_test_tls_ref_t;
+
+// the tls address function type of the test library
+typedef by_pointer_t        (*by_test_tls_addr_t)(by_void_t);
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_bool_t by_test_tls_check(by_test_tls_ref_t test)
+{
+    by_test_tls_addr_t first_addr = (by_test_tls_addr_t)dlsym(test->syshandle, "by_test_tls_first_addr");
+    by_test_tls_addr_t counter_addr = (by_test_tls_addr_t)dlsym(test->syshandle, "by_test_tls_counter_addr");
+    by_test_tls_addr_t bss_addr = (by_test_tls_addr_t)dlsym(test->syshandle, "by_test_tls_bss_addr");
+    by_test_check(first_addr && counter_addr && bss_addr);
+
+    // resolve them before the library touches its tls block in this thread, so byopen has to allocate it
+    by_int_t*  first = (by_int_t*)by_dlsym_tls(test->handle, "by_test_tls_first");
+    by_long_t* counter = (by_long_t*)by_dlsym_tls(test->handle, "by_test_tls_counter");
+    by_char_t* bss = (by_char_t*)by_dlsym_tls(test->handle, "by_test_tls_bss");
+    by_test_check(first && counter && bss);
+
+    // the initial values of .tdata and .tbss
+    by_test_check(*first == 1 && counter[0] == 7 && counter[3] == 10);
+    for (by_size_t i = 0; i < 64; i++)
+        by_test_check(!bss[i]);
+
+    // they must be the instances of the calling thread used by the library itself
+    by_test_check(first == first_addr() && counter == counter_addr() && bss == bss_addr());
+
+    // the thread writes its own instances only
+    *first = (by_int_t)(test->index + 100);
+    counter[1] = (by_long_t)test->index;
+    by_test_check(*(by_int_t*)first_addr() == (by_int_t)(test->index + 100));
+    by_test_check(by_dlsym_tls(test->handle, "by_test_tls_counter") == counter);
+
+    // the normal and missing symbols are not tls symbols
+    by_test_check(!by_dlsym_tls(test->handle, "by_test_tls_normal"));
+    by_test_check(!by_dlsym_tls(test->handle, "by_test_tls_first_addr"));
+    by_test_check(!by_dlsym_tls(test->handle, "by_test_tls_missing"));
+    return by_true;
+}
+static by_pointer_t by_test_tls_thread(by_pointer_t priv)
+{
+    return by_test_tls_check((by_test_tls_ref_t)priv)? priv : by_null;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_tls(by_char_t const* dir)
+{
+    // get the test library path
+    by_char_t libpath[512];
+    ssize_t   size = readlink("/proc/self/exe", libpath, sizeof(libpath) - sizeof(BY_TEST_TLS_LIBNAME));
+    by_test_check(size > 0);
+    libpath[size] = '\0';
+    by_char_t* p = strrchr(libpath, '/');
+    by_test_check(p);
+    strcpy(p + 1, BY_TEST_TLS_LIBNAME);
+
+    // load it to maps first, because by_dlopen only finds the loaded libraries
+    by_test_tls_t tests[BY_TEST_TLS_THREADS + 1];
+    memset(tests, 0, sizeof(tests));
+    by_pointer_t syshandle = dlopen(libpath, RTLD_NOW);
+    if (!syshandle) fprintf(stderr, "dlopen %s failed: %s\n", libpath, dlerror());
+    by_test_check(syshandle);
+    by_pointer_t handle = by_dlopen(libpath, BY_RTLD_NOW);
+    by_bool_t    ok = handle != by_null;
+    if (ok)
+    {
+        // check the new threads
+        pthread_t threads[BY_TEST_TLS_THREADS];
+        by_size_t started = 0;
+        for (by_size_t i = 0; i <= BY_TEST_TLS_THREADS; i++)
+        {
+            tests[i].handle = handle;
+            tests[i].syshandle = syshandle;
+            tests[i].index = i;
+        }
+        for (; started < BY_TEST_TLS_THREADS; started++)
+        {
+            if (pthread_create(&threads[started], by_null, by_test_tls_thread, &tests[started + 1]))
+                break;
+        }
+        ok = started == BY_TEST_TLS_THREADS;
+        for (by_size_t i = 0; i < started; i++)
+        {
+            by_pointer_t result = by_null;
+            pthread_join(threads[i], &result);
+            if (!result) ok = by_false;
+        }
+
+        // check the main thread after the other threads have written their instances
+        if (!by_test_tls_check(&tests[0])) ok = by_false;
+        by_dlclose(handle);
+    }
+    dlclose(syshandle);
+    by_test_check(ok);
+    return by_true;
+}
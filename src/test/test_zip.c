@@ -0,0 +1,363 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        test_zip.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * includes
+ */
+#include "test.h"
+#include "elfgen.h"
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * macros
+ */
+
+// the zip signatures
+#define BY_TEST_ZIP_LOCAL_SIGN      (0x04034b50)
+#define BY_TEST_ZIP_CDIR_SIGN       (0x02014b50)
+#define BY_TEST_ZIP_EOCD_SIGN       (0x06054b50)
+
+// the zip header sizes
+#define BY_TEST_ZIP_LOCAL_SIZE      (30)
+#define BY_TEST_ZIP_CDIR_SIZE       (46)
+#define BY_TEST_ZIP_EOCD_SIZE       (22)
+
+// the zipalign extra field id
+#define BY_TEST_ZIP_ALIGN_ID        (0xd935)
+
+// the data alignment of the stored library, it's mapped by the linker directly
+#define BY_TEST_ZIP_ALIGN           (4096)
+
+// the library entry name
+#define BY_TEST_ZIP_ENTRY           "lib/test/libbytest_zip.so"
+
+// the symbol count of the library
+#define BY_TEST_ZIP_SYMBOLS         (100)
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * types
+ */
+
+// the test archive type
+typedef struct _by_test_zip_t
+{
+    // the archive data
+    by_byte_t*                  data;
+    by_size_t                   size;
+    by_size_t                   maxn;
+
+    // the local header and data offsets of the library entry
+    by_size_t                   local;
+    by_size_t                   offset;
+
+    // the central directory headers of the first entry and the library entry
+    by_size_t                   cdir_first;
+    by_size_t                   cdir;
+
+    // the end of central directory record offset
+    by_size_t                   eocd;
+
+}by_test_zip_t, *by_test_zip_ref_t;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the archive cases, the malformed central directories and local headers must be rejected
+static struct
+{
+    by_char_t const*            name;
+    by_bool_t                   found;
+
+}g_zip_cases[] =
+{
+    {"stored",              by_true     }
+,   {"comment",             by_true     }
+,   {"count_over",          by_true     }
+,   {"count_short",         by_false    }
+,   {"no_eocd",             by_false    }
+,   {"cdir_offset",         by_false    }
+,   {"cdir_size",           by_false    }
+,   {"cdir_sign",           by_false    }
+,   {"name_size",           by_false    }
+,   {"deflated",            by_false    }
+,   {"size_mismatch",       by_false    }
+,   {"local_offset",        by_false    }
+,   {"local_sign",          by_false    }
+,   {"entry_size",          by_false    }
+,   {"local_extra",         by_false    }
+,   {"missing",             by_false    }
+};
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * private implementation
+ */
+static by_void_t by_test_zip_set_u16(by_byte_t* p, by_uint32_t value)
+{
+    p[0] = (by_byte_t)value;
+    p[1] = (by_byte_t)(value >> 8);
+}
+static by_void_t by_test_zip_set_u32(by_byte_t* p, by_uint32_t value)
+{
+    by_test_zip_set_u16(p, value);
+    by_test_zip_set_u16(p + 2, value >> 16);
+}
+static by_byte_t* by_test_zip_put(by_test_zip_ref_t zip, by_cpointer_t data, by_size_t size)
+{
+    if (zip->size + size > zip->maxn)
+    {
+        zip->maxn = (zip->size + size) * 2;
+        zip->data = (by_byte_t*)realloc(zip->data, zip->maxn);
+    }
+    by_byte_t* p = zip->data + zip->size;
+    if (data) memcpy(p, data, size);
+    else memset(p, 0, size);
+    zip->size += size;
+    return p;
+}
+
+// put the local header and the stored data
+static by_size_t by_test_zip_put_local(by_test_zip_ref_t zip, by_char_t const* name, by_cpointer_t data, by_size_t size, by_size_t align)
+{
+    by_size_t namesize = strlen(name);
+    by_size_t local = zip->size;
+
+    // the zipalign padding in the extra field
+    by_size_t extrasize = 0;
+    if (align)
+    {
+        by_size_t offset = local + BY_TEST_ZIP_LOCAL_SIZE + namesize + 4;
+        extrasize = 4 + (align - offset % align) % align;
+    }
+
+    by_byte_t* p = by_test_zip_put(zip, by_null, BY_TEST_ZIP_LOCAL_SIZE);
+    by_test_zip_set_u32(p, BY_TEST_ZIP_LOCAL_SIGN);
+    by_test_zip_set_u16(p + 4, 10);
+    by_test_zip_set_u32(p + 18, (by_uint32_t)size);
+    by_test_zip_set_u32(p + 22, (by_uint32_t)size);
+    by_test_zip_set_u16(p + 26, (by_uint32_t)namesize);
+    by_test_zip_set_u16(p + 28, (by_uint32_t)extrasize);
+    by_test_zip_put(zip, name, namesize);
+    if (extrasize)
+    {
+        p = by_test_zip_put(zip, by_null, extrasize);
+        by_test_zip_set_u16(p, BY_TEST_ZIP_ALIGN_ID);
+        by_test_zip_set_u16(p + 2, (by_uint32_t)(extrasize - 4));
+    }
+    by_test_zip_put(zip, data, size);
+    return local;
+}
+
+// put the central directory header
+static by_size_t by_test_zip_put_cdir(by_test_zip_ref_t zip, by_char_t const* name, by_size_t size, by_size_t local)
+{
+    by_size_t  namesize = strlen(name);
+    by_size_t  cdir = zip->size;
+    by_byte_t* p = by_test_zip_put(zip, by_null, BY_TEST_ZIP_CDIR_SIZE);
+    by_test_zip_set_u32(p, BY_TEST_ZIP_CDIR_SIGN);
+    by_test_zip_set_u16(p + 4, 20);
+    by_test_zip_set_u16(p + 6, 10);
+    by_test_zip_set_u32(p + 20, (by_uint32_t)size);
+    by_test_zip_set_u32(p + 24, (by_uint32_t)size);
+    by_test_zip_set_u16(p + 28, (by_uint32_t)namesize);
+    by_test_zip_set_u32(p + 42, (by_uint32_t)local);
+    by_test_zip_put(zip, name, namesize);
+    return cdir;
+}
+
+// make the archive with a small resource entry and the page-aligned library entry
+static by_void_t by_test_zip_make(by_test_zip_ref_t zip, by_cpointer_t lib, by_size_t libsize, by_char_t const* comment)
+{
+    static by_char_t const dex[] = "dex\n035";
+
+    zip->size  = 0;
+    by_size_t first = by_test_zip_put_local(zip, "classes.dex", dex, sizeof(dex), 0);
+    zip->local = by_test_zip_put_local(zip, BY_TEST_ZIP_ENTRY, lib, libsize, BY_TEST_ZIP_ALIGN);
+    zip->offset = zip->size - libsize;
+
+    by_size_t cdir_offset = zip->size;
+    zip->cdir_first = by_test_zip_put_cdir(zip, "classes.dex", sizeof(dex), first);
+    zip->cdir = by_test_zip_put_cdir(zip, BY_TEST_ZIP_ENTRY, libsize, zip->local);
+
+    by_size_t  commentsize = comment? strlen(comment) : 0;
+    by_size_t  cdir_size = zip->size - cdir_offset;
+    zip->eocd = zip->size;
+    by_byte_t* p = by_test_zip_put(zip, by_null, BY_TEST_ZIP_EOCD_SIZE);
+    by_test_zip_set_u32(p, BY_TEST_ZIP_EOCD_SIGN);
+    by_test_zip_set_u16(p + 8, 2);
+    by_test_zip_set_u16(p + 10, 2);
+    by_test_zip_set_u32(p + 12, (by_uint32_t)cdir_size);
+    by_test_zip_set_u32(p + 16, (by_uint32_t)cdir_offset);
+    by_test_zip_set_u16(p + 20, (by_uint32_t)commentsize);
+    if (commentsize) by_test_zip_put(zip, comment, commentsize);
+}
+
+// corrupt the archive for the given case, and get the entry name to be loaded
+static by_char_t const* by_test_zip_corrupt(by_test_zip_ref_t zip, by_char_t const* name)
+{
+    by_byte_t* eocd = zip->data + zip->eocd;
+    by_byte_t* cdir = zip->data + zip->cdir;
+    if (!strcmp(name, "count_over")) by_test_zip_set_u16(eocd + 10, 0xffff);
+    else if (!strcmp(name, "count_short")) by_test_zip_set_u16(eocd + 10, 1);
+    else if (!strcmp(name, "no_eocd")) zip->size = zip->eocd;
+    else if (!strcmp(name, "cdir_offset")) by_test_zip_set_u32(eocd + 16, (by_uint32_t)zip->size);
+    else if (!strcmp(name, "cdir_size")) by_test_zip_set_u32(eocd + 12, 0xffffffff);
+    else if (!strcmp(name, "cdir_sign")) by_test_zip_set_u32(zip->data + zip->cdir_first, 0);
+    else if (!strcmp(name, "name_size")) by_test_zip_set_u16(cdir + 28, 0xffff);
+    else if (!strcmp(name, "deflated")) by_test_zip_set_u16(cdir + 10, 8);
+    else if (!strcmp(name, "size_mismatch")) by_test_zip_set_u32(cdir + 20, 100);
+    else if (!strcmp(name, "local_offset")) by_test_zip_set_u32(cdir + 42, (by_uint32_t)(zip->size - 4));
+    else if (!strcmp(name, "local_sign")) by_test_zip_set_u32(zip->data + zip->local, BY_TEST_ZIP_CDIR_SIGN);
+    else if (!strcmp(name, "entry_size"))
+    {
+        by_test_zip_set_u32(cdir + 20, 0xfffffff0);
+        by_test_zip_set_u32(cdir + 24, 0xfffffff0);
+    }
+    else if (!strcmp(name, "local_extra"))
+    {
+        by_byte_t* local = zip->data + zip->local;
+        by_test_zip_set_u16(local + 28, (local[28] | (local[29] << 8)) + BY_TEST_ZIP_ALIGN);
+    }
+    else if (!strcmp(name, "missing")) return "lib/test/libbytest_missing.so";
+    return BY_TEST_ZIP_ENTRY;
+}
+
+// get the symbol offset of the given handle
+static by_size_t by_test_zip_symbol(by_pointer_t handle, by_pointer_t base, by_bool_t exported, by_size_t index)
+{
+    by_char_t name[64];
+    by_elfgen_name(name, sizeof(name), exported, index);
+    by_pointer_t addr = by_dlsym(handle, name);
+    return addr? (by_size_t)((by_byte_t*)addr - (by_byte_t*)base) : 0;
+}
+
+// load the library entry of the archive case
+static by_bool_t by_test_zip_case(by_char_t const* dir, by_size_t index, by_test_zip_ref_t zip, by_cpointer_t lib, by_size_t libsize, by_pointer_t reference, by_pointer_t refbase)
+{
+    // make and corrupt the archive
+    by_char_t const* name = g_zip_cases[index].name;
+    by_test_zip_make(zip, lib, libsize, !strcmp(name, "comment")? "signed by the test" : by_null);
+    by_char_t const* entryname = by_test_zip_corrupt(zip, name);
+
+    // write the archive
+    by_char_t archivepath[256];
+    snprintf(archivepath, sizeof(archivepath), "%s/bytest_zip_%s.apk", dir, name);
+    FILE* fp = fopen(archivepath, "wb");
+    by_test_check(fp);
+    by_bool_t written = fwrite(zip->data, 1, zip->size, fp) == zip->size;
+    fclose(fp);
+    by_test_check(written);
+
+    // map the stored library at the data offset of its entry like the linker, so it's visible in the maps
+    by_int_t fd = open(archivepath, O_RDONLY | O_CLOEXEC);
+    by_test_check(fd >= 0);
+    by_pointer_t base = mmap(by_null, libsize, PROT_READ, MAP_PRIVATE, fd, zip->offset);
+    close(fd);
+    by_test_check(base != MAP_FAILED);
+
+    // load the entry
+    by_char_t filepath[512];
+    snprintf(filepath, sizeof(filepath), "%s!/%s", archivepath, entryname);
+    by_pointer_t handle = by_dlopen(filepath, BY_RTLD_NOW);
+    by_bool_t    found = handle != by_null;
+    by_bool_t    symbols = by_true;
+    if (handle)
+    {
+        // the exported and local symbols must be at the same offsets of the library loaded from file
+        for (by_size_t i = 0; i < BY_TEST_ZIP_SYMBOLS && symbols; i += 33)
+        {
+            by_size_t offset = by_test_zip_symbol(handle, base, by_true, i);
+            symbols = offset && offset == by_test_zip_symbol(reference, refbase, by_true, i);
+            offset = by_test_zip_symbol(handle, base, by_false, i);
+            symbols = symbols && offset && offset == by_test_zip_symbol(reference, refbase, by_false, i);
+        }
+        by_dlclose(handle);
+    }
+    munmap(base, libsize);
+    unlink(archivepath);
+    if (found != g_zip_cases[index].found || !symbols)
+        fprintf(stderr, "zip case(%s): %s\n", name, found? "found" : "not found");
+    by_test_check(found == g_zip_cases[index].found);
+    by_test_check(symbols);
+    return by_true;
+}
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+by_bool_t by_test_zip(by_char_t const* dir)
+{
+    by_char_t    libpath[256];
+    by_byte_t*   lib = by_null;
+    by_size_t    libsize = 0;
+    by_pointer_t syshandle = by_null;
+    by_pointer_t reference = by_null;
+    by_bool_t    ok = by_false;
+    by_test_zip_t zip;
+    memset(&zip, 0, sizeof(zip));
+    snprintf(libpath, sizeof(libpath), "%s/libbytest_zip.so", dir);
+    do
+    {
+        // generate the library
+        if (!by_elfgen_make(libpath, BY_TEST_ZIP_SYMBOLS, BY_TEST_ZIP_SYMBOLS)) break;
+
+        // read it
+        FILE* fp = fopen(libpath, "rb");
+        if (!fp) break;
+        fseek(fp, 0, SEEK_END);
+        libsize = (by_size_t)ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        lib = (by_byte_t*)malloc(libsize);
+        by_bool_t loaded = lib && fread(lib, 1, libsize, fp) == libsize;
+        fclose(fp);
+        if (!loaded) break;
+
+        // load it from file as the reference of the symbol offsets
+        syshandle = dlopen(libpath, RTLD_NOW);
+        if (!syshandle) break;
+        reference = by_dlopen(libpath, BY_RTLD_NOW);
+        if (!reference) break;
+        Dl_info info;
+        by_char_t name[64];
+        if (!dladdr(dlsym(syshandle, by_elfgen_name(name, sizeof(name), by_true, 0)), &info)) break;
+
+        // test all cases
+        ok = by_true;
+        for (by_size_t i = 0; i < sizeof(g_zip_cases) / sizeof(g_zip_cases[0]); i++)
+        {
+            if (!by_test_zip_case(dir, i, &zip, lib, libsize, reference, info.dli_fbase))
+                ok = by_false;
+        }
+
+    } while (0);
+
+    // exit
+    if (reference) by_dlclose(reference);
+    if (syshandle) dlclose(syshandle);
+    if (zip.data) free(zip.data);
+    if (lib) free(lib);
+    unlink(libpath);
+    return ok;
+}
@@ -0,0 +1,50 @@
+/*!A dlopen library that bypasses mobile system limitation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright (C) 2020-present, TBOOX Open Source Group.
+ *
+ * @author      ruki
+ * @file        tls.c
+ *
+ */
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * globals
+ */
+
+// the initialized tls variables in .tdata
+__thread int    by_test_tls_first = 1;
+__thread long   by_test_tls_counter[4] = {7, 8, 9, 10};
+
+// the zero-initialized tls variable in .tbss
+__thread char   by_test_tls_bss[64];
+
+// the normal variable
+int             by_test_tls_normal = 1;
+
+/* //////////////////////////////////////////////////////////////////////////////////////
+ * implementation
+ */
+void* by_test_tls_first_addr(void)
+{
+    return &by_test_tls_first;
+}
+void* by_test_tls_counter_addr(void)
+{
+    return by_test_tls_counter;
+}
+void* by_test_tls_bss_addr(void)
+{
+    return by_test_tls_bss;
+}
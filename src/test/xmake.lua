@@ -0,0 +1,46 @@
+-- the thread-local test library, it's loaded by dlopen to use the dynamic tls blocks
+target("bytest_tls")
+    set_kind("shared")
+    set_default(false)
+    add_files("tls/*.c")
+
+-- the duplicate symbol test library, each symbol name has a global symbol and a local symbol, so we need keep .symtab
+target("bytest_dup")
+    set_kind("shared")
+    set_default(false)
+    set_symbols("debug")
+    set_strip("none")
+    add_files("dup/*.c")
+
+-- the line table test library, it keeps .debug_line and the calls are not optimized out
+target("bytest_lines")
+    set_kind("shared")
+    set_default(false)
+    set_symbols("debug")
+    set_strip("none")
+    set_optimize("none")
+    add_files("lines/*.c")
+
+target("test")
+    set_kind("binary")
+    set_default(false)
+    add_deps("byopen")
+    add_deps("bytest_tls", {inherit = false})
+    add_deps("bytest_dup", {inherit = false})
+    add_deps("bytest_lines", {inherit = false})
+    add_files("*.c", "../bench/elfgen.c")
+    add_includedirs("../bench")
+    add_defines("BY_TEST_FIXTURES=\"$(scriptdir)/fixtures\"")
+    if is_plat("linux") then
+        add_syslinks("dl", "pthread")
+    end
+
+-- the host-side jni test, it builds the android backend with the fake jni and android headers in jni/
+target("test_jni")
+    set_kind("binary")
+    set_default(false)
+    add_files("jni/*.c")
+    add_files("../native/byopen_android.c", "../native/byopen_elf.c", "../native/byopen_unwind.c", "../native/byopen_remote.c", "../native/byopen_dlnotify.c", "../native/byopen_trace.c", "../native/byopen_pool.c", "../native/byopen_dwarf.c")
+    add_includedirs("jni", ".", "../native")
+    add_defines("__ANDROID__", "_GNU_SOURCE")
+    add_syslinks("dl", "pthread")
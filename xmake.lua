@@ -41,6 +41,12 @@ task("apk_test")
     end)
 
 includes("src/native", "src/demo")
+if is_plat("android", "linux") then
+    includes("src/bench")
+end
+if is_plat("linux") then
+    includes("src/test")
+end
 if is_plat("android") then
     includes("src/android/app/jni")
 end